@@ -48,6 +48,7 @@ typedef struct {
 	int max_recursion;
 	double angle_param;
 	double angle;
+	int nthreads;
 } opts_t;
 
 static char *fname;
@@ -59,6 +60,7 @@ static const char use_msg[] =
     -a t - max. turning angle [0-180] (40)\n\
     -c i - compatability measure; 0 : distance, 1: full (default)\n\
     -i iter: number of outer iterations/subdivisions (4)\n\
+    -j n - number of threads to use (1)\n\
     -k k - number of neighbors in the nearest neighbor graph of edges (10)\n\
     -K k - the force constant\n\
     -m method - method used. 0 (force directed), 1 (agglomerative ink saving, default), 2 (cluster+ink saving)\n\
@@ -115,8 +117,9 @@ static void init(int argc, char *argv[], opts_t &opts) {
 	opts.max_recursion = 100;
 	opts.angle_param = -1;
 	opts.angle = 40.0/180.0*M_PI;
+	opts.nthreads = 1;
 
-	while ((c = getopt(argc, argv, ":a:c:i:k:K:m:o:p:r:T:v:?")) != -1) {
+	while ((c = getopt(argc, argv, ":a:c:i:j:k:K:m:o:p:r:T:v:?")) != -1) {
 		switch (c) {
 		case 'a':
 			if (sscanf(optarg, "%lf", &s) > 0 && s >= 0)
@@ -138,6 +141,13 @@ static void init(int argc, char *argv[], opts_t &opts) {
 				std::cerr << "-i arg " << optarg << " must be a non-negative integer - "
 					"ignored\n";
 			break;
+		case 'j':
+			if (sscanf(optarg, "%d", &i) > 0 && i >= 1)
+				opts.nthreads =  i;
+			else
+				std::cerr << "-j arg " << optarg << " must be a positive integer - "
+					"ignored\n";
+			break;
 		case 'k':
 			if (sscanf(optarg, "%d", &i) > 0 && i >= 2)
 				opts.nneighbors =  i;
@@ -225,7 +235,8 @@ static void init(int argc, char *argv[], opts_t &opts) {
          << "  nneighbors = " << opts.nneighbors << '\n'
          << "  max_recursion = " <<  opts.max_recursion << '\n'
          << "  angle_param = " << std::setprecision(2) <<  opts.angle_param << '\n'
-         << "  angle = " << std::setprecision(2) << (180 * opts.angle / M_PI) << '\n';
+         << "  angle = " << std::setprecision(2) << (180 * opts.angle / M_PI) << '\n'
+         << "  nthreads = " << opts.nthreads << '\n';
     }
 }
 
@@ -436,7 +447,8 @@ static int bundle(Agraph_t *g, const opts_t &opts) {
 	if (Verbose)
 		std::cerr << "n = " << A->m << " nz = " << nz << '\n';
 
-	SparseMatrix B = nearest_neighbor_graph(nz, std::min(opts.nneighbors, nz), xx);
+	SparseMatrix B = nearest_neighbor_graph(nz, std::min(opts.nneighbors, nz), xx,
+	                                        opts.nthreads);
 
 	SparseMatrix_delete(A);
 	A = B;
@@ -445,7 +457,8 @@ static int bundle(Agraph_t *g, const opts_t &opts) {
 	std::vector<pedge> edges =
             edge_bundling(A, 2, xx, opts.outer_iter, opts.K, opts.method,
                           opts.nneighbors, opts.compatibility_method,
-                          opts.max_recursion, opts.angle_param, opts.angle);
+                          opts.max_recursion, opts.angle_param, opts.angle,
+                          opts.nthreads);
 
 	if (opts.fmt == FMT_GV) {
 	    	export_dot(outfile, A->m, edges, g);
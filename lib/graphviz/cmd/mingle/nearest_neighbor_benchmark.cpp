@@ -0,0 +1,154 @@
+/// \file
+/// \brief time mingle’s nearest neighbor graph searches against each other
+///
+/// This builds the nearest neighbor graph of random edges with the built in
+/// k-d tree at each thread count given, and with ANN when Graphviz was built
+/// with it, then reports how many of the queries found the same neighbors.
+/// Without ANN, only the k-d tree timings are reported.
+///
+/// usage: nearest_neighbor_benchmark edges [neighbors [threads...]]
+
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mingle/nearest_neighbor_graph_kd.h>
+#include <random>
+#include <utility>
+#include <vector>
+
+#ifdef HAVE_ANN
+#include <mingle/nearest_neighbor_graph_ann.h>
+#endif
+
+namespace {
+/// the output of one search
+struct graph_t {
+  int nz = 0;
+  std::vector<int> irn;
+  std::vector<int> jcn;
+  std::vector<double> val;
+
+  graph_t(int nPts, int k)
+      : irn(nPts * k * 2), jcn(nPts * k * 2), val(nPts * k * 2) {}
+
+  /// neighbors found for each query, keyed by sweep and query point
+  std::map<std::pair<int, int>, std::vector<int>> neighbors() const {
+    std::map<std::pair<int, int>, std::vector<int>> found;
+    int sweep = 0;
+    for (int i = 0; i < nz; ++i) {
+      if (i > 0 && irn[i] < irn[i - 1])
+        ++sweep;
+      found[{sweep, irn[i]}].push_back(jcn[i]);
+    }
+    for (auto &[query, js] : found)
+      std::sort(js.begin(), js.end());
+    return found;
+  }
+
+  /// distances found for each query, keyed by sweep and query point
+  std::map<std::pair<int, int>, std::vector<double>> distances() const {
+    std::map<std::pair<int, int>, std::vector<double>> found;
+    int sweep = 0;
+    for (int i = 0; i < nz; ++i) {
+      if (i > 0 && irn[i] < irn[i - 1])
+        ++sweep;
+      found[{sweep, irn[i]}].push_back(val[i]);
+    }
+    for (auto &[query, ds] : found)
+      std::sort(ds.begin(), ds.end());
+    return found;
+  }
+};
+} // namespace
+
+#ifdef HAVE_ANN
+/// do two sorted lists of squared distances agree, up to rounding?
+static bool same_distances(const std::vector<double> &a,
+                           const std::vector<double> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (std::abs(a[i] - b[i]) > 1e-9 * std::max(1.0, std::abs(a[i])))
+      return false;
+  }
+  return true;
+}
+#endif
+
+template <typename F> static double seconds(F f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s edges [neighbors [threads...]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int nPts = atoi(argv[1]);
+  const int k = argc > 2 ? atoi(argv[2]) : 10;
+  std::vector<int> threads;
+  for (int i = 3; i < argc; ++i)
+    threads.push_back(atoi(argv[i]));
+  if (threads.empty())
+    threads.push_back(1);
+
+  // edge end points, as mingle passes them
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> coord(0, 1000);
+  std::vector<double> x(4 * nPts);
+  for (double &v : x)
+    v = coord(rng);
+
+  graph_t kd(nPts, k);
+  for (int t : threads) {
+    const double s = seconds([&] {
+      nearest_neighbor_graph_kd(nPts, k, x, kd.nz, kd.irn, kd.jcn, kd.val, t);
+    });
+    printf("k-d tree, %d edges, %d neighbors, %d threads: %.3fs\n", nPts, k, t,
+           s);
+  }
+
+#ifdef HAVE_ANN
+  graph_t ann(nPts, k);
+  const double s = seconds([&] {
+    nearest_neighbor_graph_ann(nPts, k, x, ann.nz, ann.irn, ann.jcn, ann.val);
+  });
+  printf("ANN, %d edges, %d neighbors: %.3fs\n", nPts, k, s);
+
+  // queries can legitimately differ in which of several equidistant points
+  // they return, so count those separately from real disagreements
+  const auto kd_n = kd.neighbors(), ann_n = ann.neighbors();
+  const auto kd_d = kd.distances(), ann_d = ann.distances();
+  size_t same = 0, tied = 0, differ = 0;
+  for (const auto &[query, js] : kd_n) {
+    auto it = ann_n.find(query);
+    if (it != ann_n.end() && it->second == js) {
+      ++same;
+    } else if (it != ann_n.end() &&
+               same_distances(ann_d.at(query), kd_d.at(query))) {
+      ++tied;
+    } else {
+      ++differ;
+    }
+  }
+  for (const auto &[query, js] : ann_n) {
+    if (kd_n.count(query) == 0)
+      ++differ;
+  }
+  printf("queries with the same neighbors: %zu, equidistant alternatives: %zu, "
+         "different: %zu\n",
+         same, tied, differ);
+  return differ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+  printf("ANN comparison skipped: Graphviz was built without ANN\n");
+  return EXIT_SUCCESS;
+#endif
+}
@@ -24,6 +24,7 @@
 #include <getopt.h>
 #include <util/alloc.h>
 #include <util/exit.h>
+#include <util/gv_sssp.h>
 #include <util/unreachable.h>
 
 static char *CmdName;
@@ -38,11 +39,11 @@ static Agsym_t *len_sym;
 
 typedef struct {
     Agrec_t hdr;
-    double dist;		/* always positive for scanned nodes */
-    Agnode_t* prev;
-    bool done; ///< true if finished
+    size_t id; ///< index of the node in the search arrays
 } nodedata_t;
 
+#define getid(n) (((nodedata_t*)((n)->base.data))->id)
+
 static double getlength(Agedge_t * e)
 {
     double len;
@@ -59,88 +60,25 @@ static double getlength(Agedge_t * e)
     return len;
 }
 
-static double getdist(Agnode_t * n)
-{
-    nodedata_t *data;
-    data = (nodedata_t *) (n->base.data);
-    return data->dist;
-}
-
-static void setdist(Agnode_t * n, double dist)
-{
-    nodedata_t *data;
-    data = (nodedata_t *) (n->base.data);
-    data->dist = dist;
-}
-
-#define getprev(n) (((nodedata_t*)((n)->base.data))->prev)
-#define setprev(n,p) (((nodedata_t*)((n)->base.data))->prev = (p))
-#define isDone(n) (((nodedata_t*)((n)->base.data))->done)
-#define setDone(n) (((nodedata_t*)((n)->base.data))->done = true)
-
-static int cmpf(void *key1, void *key2) {
-    const double dist1 = getdist(key1);
-    const double dist2 = getdist(key2);
-    if (dist1 < dist2)
-	return -1;
-    if (dist1 > dist2)
-	return 1;
-    if (key1 < key2)
-	return -1;
-    if (key1 > key2)
-	return 1;
-    return 0;
-}
-
-static Dtdisc_t MyDisc = {
-    0,				/* int key */
-    0,				/* int size */
-    -1,				/* int link */
-    0,				/* Dtmake_f makef */
-    0,				/* Dtfree_f freef */
-    cmpf,			/* Dtcompar_f comparf */
-};
-
-static Agnode_t *extract_min(Dict_t * Q)
-{
-    Agnode_t *rv;
-    rv = dtfirst(Q);
-    dtdelete(Q, rv);
-    return rv;
-}
-
-static void update(Dict_t * Q, Agnode_t * dest, Agnode_t * src, double len)
-{
-    double newlen = getdist(src) + len;
-    double oldlen = getdist(dest);
-
-    if (oldlen == 0) {		/* first time to see dest */
-	setdist(dest, newlen);
-	if (doPath) setprev(dest, src);
-	dtinsert(Q, dest);
-    } else if (newlen < oldlen) {
-	dtdelete(Q, dest);
-	setdist(dest, newlen);
-	if (doPath) setprev(dest, src);
-	dtinsert(Q, dest);
-    }
-}
-
 static void pre(Agraph_t * g)
 {
     len_sym = agattr(g, AGEDGE, "len", NULL);
     aginit(g, AGNODE, "dijkstra", sizeof(nodedata_t), true);
 }
 
-static void post(Agraph_t * g)
+/* post:
+ * Record the distances found, and the predecessors if requested, as
+ * attributes of the nodes.
+ */
+static void post(Agraph_t * g, Agnode_t ** nodes, const double *dist,
+		 const size_t *pred, size_t source)
 {
     Agnode_t *v;
-    Agnode_t *prev;
     char buf[256];
     char dflt[256];
     Agsym_t *sym;
     Agsym_t *psym = NULL;
-    double dist, oldmax;
+    double oldmax;
     double maxdist = 0.0;	/* maximum "finite" distance */
 
     sym = agattr(g, AGNODE, "dist", "");
@@ -151,15 +89,14 @@ static void post(Agraph_t * g)
 	snprintf(dflt, sizeof(dflt), "%.3lf", HUGE_VAL);
 
     for (v = agfstnode(g); v; v = agnxtnode(g, v)) {
-	dist = getdist(v);
-	if (dist) {
-	    dist--;
-	    snprintf(buf, sizeof(buf), "%.3lf", dist);
+	const size_t i = getid(v);
+	if (dist[i] != HUGE_VAL) {
+	    snprintf(buf, sizeof(buf), "%.3lf", dist[i]);
 	    agxset(v, sym, buf);
-	    if (doPath && (prev = getprev(v)))
-		agxset(v, psym, agnameof(prev));
-	    if (maxdist < dist)
-		maxdist = dist;
+	    if (doPath && i != source)
+		agxset(v, psym, agnameof(nodes[pred[i]]));
+	    if (maxdist < dist[i])
+		maxdist = dist[i];
 	} else if (setall)
 	    agxset(v, sym, dflt);
     }
@@ -182,33 +119,66 @@ static void post(Agraph_t * g)
     }
 
     agclean(g, AGNODE, "dijkstra");
-    agclean(g, AGEDGE, "dijkstra");
 }
 
-static void dijkstra(Dict_t * Q, Agraph_t * G, Agnode_t * n)
+/* dijkstra:
+ * Copy the edges of G into compressed sparse row arrays, in both
+ * directions unless only forward edges are wanted, and search them
+ * from n.
+ */
+static void dijkstra(Agraph_t * G, Agnode_t * n)
 {
     Agnode_t *u;
     Agedge_t *e;
+    const size_t nn = (size_t)agnnodes(G);
 
     pre(G);
-    setdist(n, 1);
-    dtinsert(Q, n);
-    if (doDirected) {
-	while ((u = extract_min(Q))) {
-	    setDone (u);
+    Agnode_t **nodes = gv_calloc(nn, sizeof(Agnode_t *));
+    size_t i = 0;
+    for (u = agfstnode(G); u; u = agnxtnode(G, u)) {
+	getid(u) = i;
+	nodes[i++] = u;
+    }
+
+    size_t *off = gv_calloc(nn + 1, sizeof(size_t));
+    for (i = 0; i < nn; i++) {
+	u = nodes[i];
+	off[i + 1] = off[i] + (size_t)(doDirected ? agdegree(G, u, 0, 1)
+				       : agdegree(G, u, 1, 1));
+    }
+    size_t *adj = gv_calloc(off[nn], sizeof(size_t));
+    double *len = gv_calloc(off[nn], sizeof(double));
+    for (i = 0; i < nn; i++) {
+	size_t k = off[i];
+	u = nodes[i];
+	if (doDirected) {
 	    for (e = agfstout(G, u); e; e = agnxtout(G, e)) {
-		if (!isDone(e->node)) update(Q, e->node, u, getlength(e));
+		adj[k] = getid(aghead(e));
+		len[k++] = getlength(e);
 	    }
-	}
-    } else {
-	while ((u = extract_min(Q))) {
-	    setDone (u);
+	} else {
 	    for (e = agfstedge(G, u); e; e = agnxtedge(G, e, u)) {
-		if (!isDone(e->node)) update(Q, e->node, u, getlength(e));
+		adj[k] = getid(e->node);
+		len[k++] = getlength(e);
 	    }
 	}
+	off[i + 1] = k;
     }
-    post(G);
+
+    const gv_csr_t csr = {.n = nn, .off = off, .adj = adj};
+    gv_sssp_t *sssp = gv_sssp_new(nn);
+    double *dist = gv_calloc(nn, sizeof(double));
+    size_t *pred = doPath ? gv_calloc(nn, sizeof(size_t)) : NULL;
+    (void)gv_sssp_d(sssp, &csr, len, getid(n), dist, pred, NULL);
+    post(G, nodes, dist, pred, getid(n));
+
+    free(pred);
+    free(dist);
+    gv_sssp_free(sssp);
+    free(len);
+    free(adj);
+    free(off);
+    free(nodes);
 }
 
 static char *useString =
@@ -279,16 +249,13 @@ int main(int argc, char **argv)
     ingraph_state ig;
     size_t i = 0;
     int code = 0;
-    Dict_t *Q;
 
     init(argc, argv);
     newIngraph(&ig, Files);
 
-    Q = dtopen(&MyDisc, Dtoset);
     while ((g = nextGraph(&ig)) != 0) {
-	dtclear(Q);
 	if ((n = agnode(g, Nodes[i], 0)))
-	    dijkstra(Q, g, n);
+	    dijkstra(g, n);
 	else {
 	    fprintf(stderr, "%s: no node %s in graph %s in %s\n",
 		    CmdName, Nodes[i], agnameof(g), fileName(&ig));
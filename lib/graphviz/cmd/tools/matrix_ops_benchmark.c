@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief time neato’s packed matrix kernels
+ *
+ * This times the product of a packed symmetric matrix with one vector and with
+ * two, as stress majorization computes them, and the single precision inner
+ * product used by its conjugate gradient solver, on random data. These use
+ * SSE2 when the library was compiled for a target that has it and are scalar
+ * otherwise; the output says which.
+ *
+ * usage: matrix_ops_benchmark [nodes]
+ */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include "config.h"
+
+#include <neatogen/matrix_ops.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <util/alloc.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/// seconds on a monotonic wall clock
+static double wall_secs(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static float random_float(void) { return (float)rand() / (float)RAND_MAX; }
+
+/// repeat a kernel until it has run for half a second, and print the time per
+/// call
+#define TIME(name, call)                                                       \
+  do {                                                                         \
+    int reps = 0;                                                              \
+    const double start = wall_secs();                                          \
+    double elapsed;                                                            \
+    do {                                                                       \
+      call;                                                                    \
+      ++reps;                                                                  \
+    } while ((elapsed = wall_secs() - start) < 0.5);                           \
+    printf("%-28s %12.3f µs\n", name, elapsed / reps * 1e6);                   \
+  } while (0)
+
+int main(int argc, char **argv) {
+  const int n = argc > 1 ? atoi(argv[1]) : 2000;
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [nodes]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+#ifdef __SSE2__
+  printf("%d nodes, SSE2\n", n);
+#else
+  printf("%d nodes, scalar\n", n);
+#endif
+
+  const size_t packed_size = (size_t)n * (size_t)(n + 1) / 2;
+  float *packed = gv_calloc(packed_size, sizeof(float));
+  for (size_t i = 0; i < packed_size; ++i)
+    packed[i] = random_float();
+
+  float *vectors[2], *results[2];
+  for (int k = 0; k < 2; ++k) {
+    vectors[k] = gv_calloc((size_t)n, sizeof(float));
+    results[k] = gv_calloc((size_t)n, sizeof(float));
+    for (int i = 0; i < n; ++i)
+      vectors[k][i] = random_float();
+  }
+
+  volatile double sink = 0;
+  TIME("right_mult_with_vector_ff",
+       right_mult_with_vector_ff(packed, n, vectors[0], results[0]));
+  TIME("right_mult_with_vectors_ff",
+       right_mult_with_vectors_ff(packed, n, 2, vectors, results));
+  TIME("vectors_inner_productf",
+       sink += vectors_inner_productf(n, vectors[0], vectors[1]));
+  (void)sink;
+
+  for (int k = 0; k < 2; ++k) {
+    free(results[k]);
+    free(vectors[k]);
+  }
+  free(packed);
+
+  return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 
 #include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cgraph/cgraph.h>
@@ -35,6 +36,7 @@
 
 #include <getopt.h>
 #include "openFile.h"
+#include <util/alloc.h>
 #include <util/exit.h>
 #include <util/unreachable.h>
 
@@ -48,6 +50,7 @@ typedef struct Agraphinfo_t {
 typedef struct Agnodeinfo_t {
     Agrec_t h;
     unsigned int val;
+    size_t index; ///< position in node order
     Agraph_t *scc;
 } Agnodeinfo_t;
 
@@ -73,11 +76,30 @@ static unsigned getval(Agnode_t *n) {
 static void setval(Agnode_t *n, unsigned v) {
     ((Agnodeinfo_t *)n->base.data)->val = v;
 }
+static size_t getindex(Agnode_t *n) {
+    return ((Agnodeinfo_t *)n->base.data)->index;
+}
+
+DEFINE_LIST(index_stack, size_t)
+
+/// a DFS in progress at one node
+typedef struct {
+    size_t v;     ///< node being visited
+    size_t next;  ///< next out-edge to follow
+    unsigned min; ///< lowest number reached from v so far
+} frame_t;
+
+DEFINE_LIST(frame_stack, frame_t)
 
 typedef struct {
     unsigned Comp;
     unsigned ID;
     int N_nodes_in_nontriv_SCC;
+    Agnode_t **nodes; ///< nodes in node order
+    size_t *off;      ///< out-edges of node `i` are `head[off[i]]…head[off[i+1]-1]`
+    size_t *head;     ///< index of each out-edge’s head
+    unsigned *val;    ///< DFS number of each node, or `INF` once assigned
+    index_stack_t stack; ///< nodes not yet assigned to a component
 } sccstate;
 
 static int wantDegenerateComp;
@@ -109,45 +131,58 @@ static void nodeInduce(Agraph_t * g, Agraph_t* map)
     }
 }
 
-DEFINE_LIST(node_stack, Agnode_t *)
-
-static unsigned visit(Agnode_t *n, Agraph_t *map, node_stack_t *sp,
-                      sccstate *st) {
-    unsigned int m, min;
-    Agnode_t *t;
-    Agraph_t *subg;
-    Agedge_t *e;
-
-    min = ++st->ID;
-    setval(n, min);
-    node_stack_push_back(sp, n);
+/* Tarjan's algorithm, with the DFS kept on an explicit stack of frames so
+ * that deep graphs do not exhaust the call stack. The DFS runs over the edge
+ * arrays in st rather than cgraph's edge sets; a component, once found, is
+ * written out through cgraph.
+ */
+static void visit(size_t root, Agraph_t *map, sccstate *st) {
+    frame_stack_t frames = {0};
+
+    st->val[root] = ++st->ID;
+    index_stack_push_back(&st->stack, root);
+    frame_stack_push_back(&frames, (frame_t){root, st->off[root], st->ID});
+
+    while (!frame_stack_is_empty(&frames)) {
+	frame_t *f = frame_stack_back(&frames);
+	if (f->next < st->off[f->v + 1]) {
+	    const size_t t = st->head[f->next++];
+	    if (st->val[t] == 0) {
+		st->val[t] = ++st->ID;
+		index_stack_push_back(&st->stack, t);
+		frame_stack_push_back(&frames, (frame_t){t, st->off[t], st->ID});
+	    } else if (st->val[t] < f->min) {
+		f->min = st->val[t];
+	    }
+	    continue;
+	}
 
-    for (e = agfstout(n->root, n); e; e = agnxtout(n->root, e)) {
-	t = aghead(e);
-	if (getval(t) == 0)
-	    m = visit(t, map, sp, st);
-	else
-	    m = getval(t);
-	if (m < min)
-	    min = m;
-    }
+	const frame_t done = frame_stack_pop_back(&frames);
+	if (!frame_stack_is_empty(&frames)) {
+	    frame_t *parent = frame_stack_back(&frames);
+	    if (done.min < parent->min)
+		parent->min = done.min;
+	}
 
-    if (getval(n) == min) {
-	if (!wantDegenerateComp && *node_stack_back(sp) == n) {
-	    setval(n, INF);
-	    (void)node_stack_pop_back(sp);
+	const size_t n = done.v;
+	if (st->val[n] != done.min)
+	    continue;
+	if (!wantDegenerateComp && *index_stack_back(&st->stack) == n) {
+	    st->val[n] = INF;
+	    (void)index_stack_pop_back(&st->stack);
 	} else {
 	    char name[32];
-	    Agraph_t *G = agraphof(n);;
+	    Agraph_t *G = agraphof(st->nodes[n]);
 	    snprintf(name, sizeof(name), "cluster_%u", st->Comp++);
-	    subg = agsubg(G, name, 1);
+	    Agraph_t *subg = agsubg(G, name, 1);
 	    agbindrec(subg, "scc_graph", sizeof(Agraphinfo_t), true);
 	    setrep(subg, agnode(map, name, 1));
+	    size_t t;
 	    do {
-		t = node_stack_pop_back(sp);
-		agsubnode(subg, t, 1);
-		setval(t, INF);
-		setscc(t, subg);
+		t = index_stack_pop_back(&st->stack);
+		agsubnode(subg, st->nodes[t], 1);
+		st->val[t] = INF;
+		setscc(st->nodes[t], subg);
 		st->N_nodes_in_nontriv_SCC++;
 	    } while (t != n);
 	    nodeInduce(subg, map);
@@ -155,22 +190,32 @@ static unsigned visit(Agnode_t *n, Agraph_t *map, node_stack_t *sp,
 		agwrite(subg, outfp);
 	}
     }
-    return min;
+    frame_stack_free(&frames);
 }
 
+DEFINE_LIST(node_stack, Agnode_t *)
+
 static int label(Agnode_t * n, int nodecnt, int *edgecnt)
 {
     Agedge_t *e;
+    node_stack_t todo = {0};
 
     setval(n, 1);
-    nodecnt++;
-    for (e = agfstedge(n->root, n); e; e = agnxtedge(n->root, e, n)) {
-	*edgecnt += 1;
-	if (e->node == n)
-	    e = agopp(e);
-	if (!getval(e->node))
-	    nodecnt = label(e->node, nodecnt, edgecnt);
+    node_stack_push_back(&todo, n);
+    while (!node_stack_is_empty(&todo)) {
+	n = node_stack_pop_back(&todo);
+	nodecnt++;
+	for (e = agfstedge(n->root, n); e; e = agnxtedge(n->root, e, n)) {
+	    *edgecnt += 1;
+	    if (e->node == n)
+		e = agopp(e);
+	    if (!getval(e->node)) {
+		setval(e->node, 1);
+		node_stack_push_back(&todo, e->node);
+	    }
+	}
     }
+    node_stack_free(&todo);
     return nodecnt;
 }
 
@@ -220,22 +265,41 @@ static void process(Agraph_t * G)
     int nc = 0;
     float nontree_frac = 0;
     int Maxdegree = 0;
-    node_stack_t stack = {0};
-    sccstate state;
+    sccstate state = {0};
 
     aginit(G, AGRAPH, "scc_graph", sizeof(Agraphinfo_t), true);
     aginit(G, AGNODE, "scc_node", sizeof(Agnodeinfo_t), true);
-    state.Comp = state.ID = 0;
-    state.N_nodes_in_nontriv_SCC = 0;
 
     if (Verbose)
 	nc = countComponents(G, &Maxdegree, &nontree_frac);
 
+    /* number the nodes and copy out the edges */
+    const size_t nnodes = (size_t)agnnodes(G);
+    state.nodes = gv_calloc(nnodes, sizeof(Agnode_t *));
+    state.off = gv_calloc(nnodes + 1, sizeof(size_t));
+    state.val = gv_calloc(nnodes, sizeof(unsigned));
+    size_t i = 0;
+    for (n = agfstnode(G); n; n = agnxtnode(G, n), i++) {
+	((Agnodeinfo_t *)n->base.data)->index = i;
+	state.nodes[i] = n;
+	state.off[i + 1] = state.off[i] + (size_t)agdegree(G, n, 0, 1);
+    }
+    state.head = gv_calloc(state.off[nnodes], sizeof(size_t));
+    for (i = 0; i < nnodes; i++) {
+	size_t k = state.off[i];
+	for (Agedge_t *e = agfstout(G, state.nodes[i]); e; e = agnxtout(G, e))
+	    state.head[k++] = getindex(aghead(e));
+    }
+
     map = agopen("scc_map", Agdirected, (Agdisc_t *) 0);
-    for (n = agfstnode(G); n; n = agnxtnode(G, n))
-	if (getval(n) == 0)
-	    visit(n, map, &stack, &state);
-    node_stack_free(&stack);
+    for (i = 0; i < nnodes; i++)
+	if (state.val[i] == 0)
+	    visit(i, map, &state);
+    index_stack_free(&state.stack);
+    free(state.head);
+    free(state.val);
+    free(state.off);
+    free(state.nodes);
     if (!StatsOnly)
 	agwrite(map, outfp);
     agclose(map);
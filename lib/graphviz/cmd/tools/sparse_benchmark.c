@@ -0,0 +1,154 @@
+/**
+ * @file
+ * @brief time the sparse matrix products at different thread counts
+ *
+ * This reads matrices in <a href=https://math.nist.gov/MatrixMarket/>Matrix
+ * Market</a> format, as mm2gv does, and times the products that sfdp computes
+ * over ranges of rows on multiple threads: A·v, A·X for a dense X of two
+ * columns, A·A, and R·A·P for the coarsening P that pairs consecutive rows, as
+ * in a multilevel scheme. Each is timed with `GV_THREADS` set to each of 1 to
+ * the given maximum.
+ *
+ * Products with fewer nonzeros in A than the threshold in SparseMatrix.c are
+ * always computed on one thread, so for those every thread count should take
+ * the same time.
+ *
+ * usage: sparse_benchmark max_threads file.mtx...
+ */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include "config.h"
+
+#include <sparse/SparseMatrix.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <util/alloc.h>
+#include "matrix_market.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/// seconds on a monotonic wall clock
+static double wall_secs(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static void set_threads(int threads) {
+  char value[16];
+  snprintf(value, sizeof(value), "%d", threads);
+#ifdef _WIN32
+  _putenv_s("GV_THREADS", value);
+#else
+  setenv("GV_THREADS", value, 1);
+#endif
+}
+
+/// repeat a product until it has run for half a second, and print the time
+/// per call
+#define TIME(name, call)                                                       \
+  do {                                                                         \
+    int reps = 0;                                                              \
+    const double start = wall_secs();                                          \
+    double elapsed;                                                            \
+    do {                                                                       \
+      call;                                                                    \
+      ++reps;                                                                  \
+    } while ((elapsed = wall_secs() - start) < 0.5);                           \
+    printf("  %-6s %2d threads %12.1f µs\n", name, threads,                    \
+           elapsed / reps * 1e6);                                              \
+  } while (0)
+
+/// the coarsening that merges rows 2i and 2i + 1 of an `n` row matrix
+static SparseMatrix pairing(int n) {
+  int *irn = gv_calloc((size_t)n, sizeof(int));
+  int *jcn = gv_calloc((size_t)n, sizeof(int));
+  double *val = gv_calloc((size_t)n, sizeof(double));
+  for (int i = 0; i < n; ++i) {
+    irn[i] = i;
+    jcn[i] = i / 2;
+    val[i] = 1;
+  }
+  SparseMatrix P = SparseMatrix_from_coordinate_arrays(
+      n, n, (n + 1) / 2, irn, jcn, val, MATRIX_TYPE_REAL, sizeof(double));
+  free(val);
+  free(jcn);
+  free(irn);
+  return P;
+}
+
+static void benchmark(SparseMatrix A, int max_threads) {
+  const int n = A->n;
+  double *v = gv_calloc((size_t)n * 2, sizeof(double));
+  for (int i = 0; i < n * 2; ++i)
+    v[i] = (double)(i % 7) - 3;
+  double *res = NULL;
+  double *dense = gv_calloc((size_t)A->m * 2, sizeof(double));
+  SparseMatrix P = pairing(n);
+  SparseMatrix R = SparseMatrix_transpose(P);
+
+  for (int threads = 1; threads <= max_threads; ++threads) {
+    set_threads(threads);
+    TIME("A·v", SparseMatrix_multiply_vector(A, v, &res));
+    TIME("A·X", SparseMatrix_multiply_dense(A, v, dense, 2));
+    TIME("A·A", SparseMatrix_delete(SparseMatrix_multiply(A, A)));
+    TIME("R·A·P", SparseMatrix_delete(SparseMatrix_multiply3(R, A, P)));
+  }
+
+  SparseMatrix_delete(R);
+  SparseMatrix_delete(P);
+  free(dense);
+  free(res);
+  free(v);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3 || atoi(argv[1]) < 1) {
+    fprintf(stderr, "usage: %s max_threads file.mtx...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int max_threads = atoi(argv[1]);
+
+  for (int i = 2; i < argc; ++i) {
+    FILE *f = fopen(argv[i], "r");
+    if (f == NULL) {
+      fprintf(stderr, "%s: could not open %s\n", argv[0], argv[i]);
+      return EXIT_FAILURE;
+    }
+    SparseMatrix A = SparseMatrix_import_matrix_market(f);
+    fclose(f);
+    if (A == NULL || A->m != A->n) {
+      fprintf(stderr, "%s: %s is not a square matrix\n", argv[0], argv[i]);
+      SparseMatrix_delete(A);
+      return EXIT_FAILURE;
+    }
+    // sfdp takes these products of the adjacency matrix of the graph
+    SparseMatrix B = SparseMatrix_get_real_adjacency_matrix_symmetrized(A);
+    SparseMatrix_delete(A);
+
+    printf("%s: %d rows, %d nonzeros\n", argv[i], B->m, B->nz);
+    benchmark(B, max_threads);
+    SparseMatrix_delete(B);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,11 +1,14 @@
+#include <charconv>
 #include <stdexcept>
 #include <string>
 
 #include "AGraph.h"
+#include "graph_lock.h"
 
 namespace CGraph {
 
 AGraph::AGraph(const std::string &dot) {
+  const auto lock = lock_graphs();
   const auto g = agmemread(dot.c_str());
   if (!g) {
     throw std::runtime_error("Could not read graph");
@@ -13,10 +16,202 @@ AGraph::AGraph(const std::string &dot) {
   m_g = g;
 }
 
+AGraph::AGraph(const std::string &name, Agdesc_t kind) {
+  const auto lock = lock_graphs();
+  const auto g = agopen(const_cast<char *>(name.c_str()), kind, nullptr);
+  if (!g) {
+    throw std::runtime_error("Could not create graph");
+  }
+  m_g = g;
+}
+
 AGraph::~AGraph() {
   if (m_g) {
+    const auto lock = lock_graphs();
     agclose(m_g);
   }
 }
 
+Agnode_t *AGraph::add_node(const std::string &name) {
+  const auto n = agnode(m_g, const_cast<char *>(name.c_str()), 1);
+  if (!n) {
+    throw std::runtime_error("Could not create node " + name);
+  }
+  return n;
+}
+
+std::vector<Agnode_t *> AGraph::add_nodes(std::span<const std::string> names) {
+  agnodereserve(m_g, names.size());
+  std::vector<Agnode_t *> nodes;
+  nodes.reserve(names.size());
+  for (const auto &name : names) {
+    nodes.push_back(add_node(name));
+  }
+  return nodes;
+}
+
+std::vector<Agnode_t *> AGraph::add_nodes(std::size_t count) {
+  agnodereserve(m_g, count);
+  std::vector<Agnode_t *> nodes;
+  nodes.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto n = agnode(m_g, nullptr, 1);
+    if (!n) {
+      throw std::runtime_error("Could not create node");
+    }
+    nodes.push_back(n);
+  }
+  return nodes;
+}
+
+Agedge_t *AGraph::add_edge(Agnode_t *tail, Agnode_t *head) {
+  const auto e = agedge(m_g, tail, head, nullptr, 1);
+  if (!e) {
+    throw std::runtime_error("Could not create edge");
+  }
+  return AGMKOUT(e);
+}
+
+Agedge_t *AGraph::add_edge(const std::string &tail, const std::string &head) {
+  // create the tail first, like the DOT parser would
+  const auto t = add_node(tail);
+  return add_edge(t, add_node(head));
+}
+
+std::vector<Agedge_t *> AGraph::add_edges(std::span<Agnode_t *const> nodes,
+                                          std::span<const std::size_t> tails,
+                                          std::span<const std::size_t> heads) {
+  if (tails.size() != heads.size()) {
+    throw std::invalid_argument("tails and heads differ in length");
+  }
+  for (std::size_t i = 0; i < tails.size(); ++i) {
+    if (tails[i] >= nodes.size() || heads[i] >= nodes.size()) {
+      throw std::out_of_range("edge end is not one of the nodes");
+    }
+  }
+
+  // The edge sets are ordered trees, so unlike the node set they have no
+  // capacity to reserve. Edges are created in sequence order, which is the
+  // cheap case for their splay trees.
+  std::vector<Agedge_t *> edges;
+  edges.reserve(tails.size());
+  for (std::size_t i = 0; i < tails.size(); ++i) {
+    edges.push_back(add_edge(nodes[tails[i]], nodes[heads[i]]));
+  }
+  return edges;
+}
+
+Agraph_t *AGraph::add_subgraph(const std::string &name, Agraph_t *parent) {
+  const auto sg =
+      agsubg(parent ? parent : m_g, const_cast<char *>(name.c_str()), 1);
+  if (!sg) {
+    throw std::runtime_error("Could not create subgraph " + name);
+  }
+  return sg;
+}
+
+void AGraph::add_to_subgraph(Agraph_t *subgraph, Agnode_t *node) {
+  if (!agsubnode(subgraph, node, 1)) {
+    throw std::runtime_error("Could not add node to subgraph");
+  }
+}
+
+void AGraph::add_to_subgraph(Agraph_t *subgraph, Agedge_t *edge) {
+  if (!agsubedge(subgraph, edge, 1)) {
+    throw std::runtime_error("Could not add edge to subgraph");
+  }
+}
+
+Agsym_t *AGraph::declare_attr(int kind, const std::string &name,
+                              const std::string &default_value) {
+  const auto attr_name = const_cast<char *>(name.c_str());
+  if (const auto sym = agattr(m_g, kind, attr_name, nullptr)) {
+    return sym;
+  }
+  const auto sym = agattr(m_g, kind, attr_name, default_value.c_str());
+  if (!sym) {
+    throw std::runtime_error("Could not declare attribute " + name);
+  }
+  return sym;
+}
+
+Agsym_t *AGraph::declare_attr(void *obj, const std::string &name) {
+  // in-edges and out-edges share the edge attributes
+  const int kind = AGTYPE(obj);
+  return declare_attr(kind == AGINEDGE ? AGEDGE : kind, name);
+}
+
+void AGraph::set_attr(void *obj, Agsym_t *sym, std::string_view value) {
+  agxset(obj, sym, std::string{value}.c_str());
+}
+
+void AGraph::set_attr(void *obj, Agsym_t *sym, double value) {
+  // the shortest text that reads back as the same value
+  char buffer[32];
+  const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  (void)ec;
+  set_attr(obj, sym, std::string_view{buffer, end});
+}
+
+/// set one value on many objects, interning it only once
+template <typename T>
+static void set_all(Agraph_t *g, std::span<T *const> objs, Agsym_t *sym,
+                    std::string_view value) {
+  char *const interned = agstrdup(g, std::string{value}.c_str());
+  for (T *obj : objs) {
+    agxsetref(obj, sym, interned);
+  }
+  agstrfree(g, interned);
+}
+
+void AGraph::set_attr(std::span<Agnode_t *const> nodes, Agsym_t *sym,
+                      std::string_view value) {
+  set_all(m_g, nodes, sym, value);
+}
+
+void AGraph::set_attr(std::span<Agedge_t *const> edges, Agsym_t *sym,
+                      std::string_view value) {
+  set_all(m_g, edges, sym, value);
+}
+
+std::string_view AGraph::get_attr(void *obj, Agsym_t *sym) const {
+  return agxget(obj, sym);
+}
+
+std::optional<std::string_view>
+AGraph::get_attr(void *obj, const std::string &name) const {
+  const auto sym = agattrsym(obj, const_cast<char *>(name.c_str()));
+  if (!sym) {
+    return std::nullopt;
+  }
+  return get_attr(obj, sym);
+}
+
+std::string_view AGraph::name(void *obj) const {
+  // anonymous edges have no name
+  const char *const n = agnameof(obj ? obj : m_g);
+  return n ? n : "";
+}
+
+Agnode_t *AGraph::find_node(const std::string &name) const {
+  return agnode(m_g, const_cast<char *>(name.c_str()), 0);
+}
+
+Agedge_t *AGraph::find_edge(Agnode_t *tail, Agnode_t *head) const {
+  const auto e = agedge(m_g, tail, head, nullptr, 0);
+  return e ? AGMKOUT(e) : nullptr;
+}
+
+Agraph_t *AGraph::find_subgraph(const std::string &name) const {
+  return agsubg(m_g, const_cast<char *>(name.c_str()), 0);
+}
+
+std::size_t AGraph::num_nodes() const {
+  return static_cast<std::size_t>(agnnodes(m_g));
+}
+
+std::size_t AGraph::num_edges() const {
+  return static_cast<std::size_t>(agnedges(m_g));
+}
+
 } // namespace CGraph
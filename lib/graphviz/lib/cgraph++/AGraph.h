@@ -1,7 +1,14 @@
 #pragma once
 
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include "cgraph.h"
 
@@ -19,13 +26,110 @@
 
 namespace CGraph {
 
+/**
+ * @brief iterator over the nodes of a graph, in order of creation
+ */
+
+class NodeIterator {
+public:
+  using value_type = Agnode_t *;
+  using difference_type = std::ptrdiff_t;
+
+  NodeIterator() = default;
+  NodeIterator(Agraph_t *g, Agnode_t *n) : m_g(g), m_n(n) {}
+
+  Agnode_t *operator*() const { return m_n; }
+
+  NodeIterator &operator++() {
+    m_n = agnxtnode(m_g, m_n);
+    return *this;
+  }
+  NodeIterator operator++(int) {
+    auto previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  bool operator==(const NodeIterator &other) const { return m_n == other.m_n; }
+
+private:
+  Agraph_t *m_g = nullptr;
+  Agnode_t *m_n = nullptr;
+};
+
+/**
+ * @brief iterator over the edges of a graph, by tail in order of creation and
+ * then by the out-edges of each tail
+ */
+
+class EdgeIterator {
+public:
+  using value_type = Agedge_t *;
+  using difference_type = std::ptrdiff_t;
+
+  EdgeIterator() = default;
+  explicit EdgeIterator(Agraph_t *g) : m_g(g), m_n(agfstnode(g)) {
+    next_tail();
+  }
+
+  Agedge_t *operator*() const { return m_e; }
+
+  EdgeIterator &operator++() {
+    m_e = agnxtout(m_g, m_e);
+    if (m_e == nullptr) {
+      m_n = agnxtnode(m_g, m_n);
+      next_tail();
+    }
+    return *this;
+  }
+  EdgeIterator operator++(int) {
+    auto previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  bool operator==(const EdgeIterator &other) const { return m_e == other.m_e; }
+
+private:
+  // move to the first out-edge of `m_n` or a later node
+  void next_tail() {
+    for (; m_n != nullptr; m_n = agnxtnode(m_g, m_n)) {
+      if ((m_e = agfstout(m_g, m_n)) != nullptr) {
+        return;
+      }
+    }
+  }
+
+  Agraph_t *m_g = nullptr;
+  Agnode_t *m_n = nullptr;
+  Agedge_t *m_e = nullptr;
+};
+
 /**
  * @brief The AGraph class represents an abstract graph
+ *
+ * A graph can be parsed from DOT source or built up directly. Nodes, edges
+ * and subgraphs are handed out as pointers to the underlying C structures,
+ * which stay valid for the lifetime of the graph. Edges are always handed out
+ * as their out-edge, so pointers to the same edge compare equal.
+ *
+ * Parsing, creating and closing a graph go through state the C library shares
+ * between all graphs, so they take the same lock as the layouts of the C++
+ * API and may happen on any thread. Each graph must still be used by only one
+ * thread at a time.
  */
 
 class AGRAPH_API AGraph {
 public:
   explicit AGraph(const std::string &dot);
+
+  /// construct an empty graph
+  ///
+  /// @param name Name of the graph
+  /// @param kind One of `Agdirected`, `Agstrictdirected`, `Agundirected` or
+  ///   `Agstrictundirected`
+  AGraph(const std::string &name, Agdesc_t kind);
+
   ~AGraph();
 
   // delete copy since we manage a C struct using a raw pointer and the struct
@@ -44,7 +148,136 @@ public:
   // get a non-owning pointer to the underlying C data structure
   Agraph_t *c_struct() const { return m_g; }
 
+  /// @name building
+  /// Each of these throws `std::runtime_error` if the object cannot be
+  /// created, for example a loop in a strict graph.
+  /// @{
+
+  /// find or create the node of the given name
+  Agnode_t *add_node(const std::string &name);
+
+  /// create one node per name, or find those that exist already
+  std::vector<Agnode_t *> add_nodes(std::span<const std::string> names);
+
+  /// create `count` anonymous nodes
+  std::vector<Agnode_t *> add_nodes(std::size_t count);
+
+  /// create an edge, or find the existing one in a strict graph
+  Agedge_t *add_edge(Agnode_t *tail, Agnode_t *head);
+
+  /// create an edge between nodes found or created by name
+  Agedge_t *add_edge(const std::string &tail, const std::string &head);
+
+  /// create the edges `nodes[tails[i]]` → `nodes[heads[i]]`
+  ///
+  /// Throws `std::invalid_argument` if `tails` and `heads` differ in length
+  /// and `std::out_of_range` if an index is not within `nodes`, in either
+  /// case before creating any edge.
+  std::vector<Agedge_t *> add_edges(std::span<Agnode_t *const> nodes,
+                                    std::span<const std::size_t> tails,
+                                    std::span<const std::size_t> heads);
+
+  /// find or create a subgraph
+  ///
+  /// @param name Name of the subgraph
+  /// @param parent Graph to create it in, the root graph if null
+  Agraph_t *add_subgraph(const std::string &name, Agraph_t *parent = nullptr);
+
+  /// add an existing node to a subgraph, and to those between it and the root
+  void add_to_subgraph(Agraph_t *subgraph, Agnode_t *node);
+
+  /// add an existing edge, and its nodes, to a subgraph
+  void add_to_subgraph(Agraph_t *subgraph, Agedge_t *edge);
+
+  /// @}
+
+  /// @name attributes
+  /// @{
+
+  /// find or declare an attribute
+  ///
+  /// @param kind One of `AGRAPH`, `AGNODE` or `AGEDGE`
+  /// @param name Name of the attribute
+  /// @param default_value Default for objects that do not set it, used only
+  ///   when the attribute is not declared yet
+  Agsym_t *declare_attr(int kind, const std::string &name,
+                        const std::string &default_value = "");
+
+  /// set an attribute of a graph, node or edge
+  void set_attr(void *obj, Agsym_t *sym, std::string_view value);
+  void set_attr(void *obj, Agsym_t *sym, const char *value) {
+    set_attr(obj, sym, std::string_view{value});
+  }
+  void set_attr(void *obj, Agsym_t *sym, bool value) {
+    set_attr(obj, sym, value ? "true" : "false");
+  }
+  template <std::integral T>
+    requires(!std::same_as<T, bool>)
+  void set_attr(void *obj, Agsym_t *sym, T value) {
+    set_attr(obj, sym, std::string_view{std::to_string(value)});
+  }
+  void set_attr(void *obj, Agsym_t *sym, double value);
+
+  /// set an attribute by name, declaring it with an empty default if needed
+  template <typename T>
+  void set_attr(void *obj, const std::string &name, T value) {
+    set_attr(obj, declare_attr(obj, name), value);
+  }
+
+  /// set the same attribute value on many nodes or edges
+  ///
+  /// The value is interned once for all of them.
+  void set_attr(std::span<Agnode_t *const> nodes, Agsym_t *sym,
+                std::string_view value);
+  void set_attr(std::span<Agedge_t *const> edges, Agsym_t *sym,
+                std::string_view value);
+
+  /// get an attribute of a graph, node or edge
+  ///
+  /// The view is valid until the attribute is next set on this object.
+  std::string_view get_attr(void *obj, Agsym_t *sym) const;
+
+  /// get an attribute by name, or nothing if it is not declared
+  std::optional<std::string_view> get_attr(void *obj,
+                                           const std::string &name) const;
+
+  /// @}
+
+  /// @name reading
+  /// @{
+
+  /// name of the graph, or of a node, edge or subgraph of it
+  std::string_view name(void *obj = nullptr) const;
+
+  /// find a node, or null if there is none of that name
+  Agnode_t *find_node(const std::string &name) const;
+
+  /// find an edge from `tail` to `head`, or null if there is none
+  Agedge_t *find_edge(Agnode_t *tail, Agnode_t *head) const;
+
+  /// find a subgraph of the root graph, or null if there is none of that name
+  Agraph_t *find_subgraph(const std::string &name) const;
+
+  std::size_t num_nodes() const;
+  std::size_t num_edges() const;
+
+  /// nodes of the graph, or of one of its subgraphs
+  std::ranges::subrange<NodeIterator> nodes(Agraph_t *g = nullptr) const {
+    g = g ? g : m_g;
+    return {NodeIterator{g, agfstnode(g)}, NodeIterator{}};
+  }
+
+  /// edges of the graph, or of one of its subgraphs
+  std::ranges::subrange<EdgeIterator> edges(Agraph_t *g = nullptr) const {
+    return {EdgeIterator{g ? g : m_g}, EdgeIterator{}};
+  }
+
+  /// @}
+
 private:
+  // find or declare an attribute of the kind of `obj`
+  Agsym_t *declare_attr(void *obj, const std::string &name);
+
   // the underlying C data structure
   Agraph_t *m_g = nullptr;
 };
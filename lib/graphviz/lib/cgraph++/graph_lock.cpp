@@ -0,0 +1,12 @@
+#include <mutex>
+
+#include "graph_lock.h"
+
+namespace CGraph {
+
+std::unique_lock<std::mutex> lock_graphs() {
+  static std::mutex graph_mutex;
+  return std::unique_lock(graph_mutex);
+}
+
+} // namespace CGraph
@@ -0,0 +1,31 @@
+/// @file
+/// @brief serialization of calls into the C libraries
+
+#pragma once
+
+#include <mutex>
+
+#ifdef GVDLL
+#if cgraph___EXPORTS // CMake's substitution of cgraph++_EXPORTS
+#define GRAPH_LOCK_API __declspec(dllexport)
+#else
+#define GRAPH_LOCK_API __declspec(dllimport)
+#endif
+#endif
+
+#ifndef GRAPH_LOCK_API
+#define GRAPH_LOCK_API /* nothing */
+#endif
+
+namespace CGraph {
+
+/// lock that the C++ API holds around every use of shared C library state
+///
+/// The parser, `agopen`, `agclose`, the layout engines and the renderers keep
+/// state in process globals, so at most one graph can be parsed, opened,
+/// closed, laid out or rendered at a time regardless of which context it uses.
+GRAPH_LOCK_API std::unique_lock<std::mutex> lock_graphs();
+
+} // namespace CGraph
+
+#undef GRAPH_LOCK_API
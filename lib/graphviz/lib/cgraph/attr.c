@@ -197,8 +197,14 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 	    sz = MINATTR;
 	rec->str = agalloc(agraphof(obj), (size_t) sz * sizeof(char *));
 	/* doesn't call agxset() so no obj-modified callbacks occur */
-	for (sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym))
-	    rec->str[sym->id] = agstrdup(agraphof(obj), sym->defval);
+	if (agroot(context) == agroot(agraphof(obj))) {
+	    /* defaults are already interned in this graph's string dict */
+	    for (sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym))
+		rec->str[sym->id] = agstrref(sym->defval);
+	} else {
+	    for (sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym))
+		rec->str[sym->id] = agstrdup(agraphof(obj), sym->defval);
+	}
     } else {
 	assert(rec->dict == datadict);
     }
@@ -507,6 +513,20 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     return SUCCESS;
 }
 
+int agxsetref(void *obj, Agsym_t *sym, char *value) {
+    /* graphs also keep the value as their dictionary default */
+    if (AGTYPE(obj) == AGRAPH)
+	return agxset(obj, sym, value);
+
+    Agraph_t *g = agraphof(obj);
+    Agattr_t *data = agattrrec(obj);
+    assert(sym->id >= 0 && sym->id < topdictsize(obj));
+    agstrunref(g, data->str[sym->id]);
+    data->str[sym->id] = agstrref(value);
+    agmethod_upd(g, obj, sym);
+    return SUCCESS;
+}
+
 int agsafeset(void *obj, char *name, const char *value, const char *def) {
     Agsym_t *a;
 
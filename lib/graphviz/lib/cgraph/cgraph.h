@@ -471,6 +471,33 @@ CGRAPH_API Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc);
  */
 
 CGRAPH_API int agwrite(Agraph_t *g, void *chan);
+
+CGRAPH_API int agwritebin(Agraph_t *g, FILE *fp);
+/**< @brief writes a binary snapshot of the graph
+ *
+ * Snapshots store the graph with interned strings, columnar attribute values
+ * and numbered nodes and edges, so they can be loaded without the cost of
+ * lexing and parsing DOT. The root graph is always written in full.
+ *
+ * @return 0 on success, EOF on failure
+ */
+
+CGRAPH_API void *agsnapshot(Agraph_t *g, size_t *size);
+///< returns a binary snapshot as a malloc'ed buffer of \p size bytes
+
+CGRAPH_API Agraph_t *agreadbin(FILE *fp, Agdisc_t *disc);
+/**< @brief constructs a graph from a binary snapshot
+ *
+ * Reads exactly one snapshot, so several can be concatenated in one stream.
+ *
+ * @return the graph, or NULL at end of input or on error
+ */
+
+CGRAPH_API Agraph_t *agmemreadbin(const void *data, size_t size);
+///< constructs a graph from a binary snapshot in memory, e.g. a mapped file
+
+CGRAPH_API bool agisbin(FILE *fp);
+///< does the next graph in the stream look like a binary snapshot?
 CGRAPH_API int agisdirected(Agraph_t *g);
 CGRAPH_API int agisundirected(Agraph_t *g);
 CGRAPH_API int agisstrict(Agraph_t *g);
@@ -492,6 +519,8 @@ CGRAPH_API int agnodebefore(Agnode_t *u, Agnode_t *v); /* we have no shame */
 CGRAPH_API int agdelnode(Agraph_t *g, Agnode_t *arg_n);
 ///< removes a node from a graph or subgraph.
 CGRAPH_API int agrelabel_node(Agnode_t *n, char *newname);
+CGRAPH_API void agnodereserve(Agraph_t *g, size_t n);
+///< makes room to add @p n more nodes to a graph without growing its node set
 /// @}
 
 /** @defgroup cgraph_edge edges
@@ -714,6 +743,12 @@ CGRAPH_API char *agget(void *obj, char *name);
 CGRAPH_API char *agxget(void *obj, Agsym_t *sym);
 CGRAPH_API int agset(void *obj, char *name, const char *value);
 CGRAPH_API int agxset(void *obj, Agsym_t *sym, const char *value);
+CGRAPH_API int agxsetref(void *obj, Agsym_t *sym, char *value);
+///< @brief @ref agxset with a value returned by @ref agstrdup or
+///< @ref agstrdup_html for the same graph
+///
+/// The value takes another reference to the string rather than looking it up
+/// again, which makes setting one value on many objects cheaper.
 CGRAPH_API int agsafeset(void *obj, char *name, const char *value,
                          const char *def);
 ///< @brief ensures the given attribute is declared
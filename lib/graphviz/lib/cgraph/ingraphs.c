@@ -131,6 +131,8 @@ ingraph_state *newIngGraphs(ingraph_state *sp, Agraph_t **graphs,
 }
 
 static Agraph_t *dflt_read(void *fp) {
+  if (agisbin(fp))
+    return agreadbin(fp, NULL);
   return agread(fp, NULL);
 }
 
@@ -14,6 +14,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 #include <cgraph/cghdr.h>
 #include <cgraph/rdr.h>
 
@@ -38,34 +39,26 @@ static int ioflush(void *chan)
 
 Agiodisc_t AgIoDisc = { iofread, ioputstr, ioflush };
 
+/* Unlike the default `iofread`, which hands the scanner one line at a time,
+ * this passes over as much of the in-memory string as fits in the scanner's
+ * buffer. Whatever the scanner has buffered beyond the end of the graph is
+ * discarded by `agmemread0` once parsing finishes.
+ */
 static int
 memiofread(void *chan, char *buf, int bufsize)
 {
-    const char *ptr;
-    char *optr;
-    char c;
-    int l;
     rdr_t *s;
 
-    if (bufsize == 0) return 0;
+    if (bufsize <= 0) return 0;
     s = chan;
     if (s->cur >= s->len)
         return 0;
-    l = 0;
-    ptr = s->data + s->cur;
-    optr = buf;
-    /* We know we have at least one character */
-    c = *ptr++;
-    do {
-        *optr++ = c;
-        l++;
-	/* continue if c is not newline, we have space in buffer,
-	 * and next character is non-null (we are working with
-	 * null-terminated strings.
-	 */
-    } while (c != '\n' && l < bufsize && (c = *ptr++));
-    s->cur += (size_t)l;
-    return l;
+    size_t l = s->len - s->cur;
+    if (l > (size_t)bufsize)
+        l = (size_t)bufsize;
+    memcpy(buf, s->data + s->cur, l);
+    s->cur += l;
+    return (int)l;
 }
 
 static Agiodisc_t memIoDisc = {memiofread, 0, 0};
@@ -86,6 +79,10 @@ static Agraph_t *agmemread0(Agraph_t *arg_g, const char *cp)
     disc.io = &memIoDisc;  
     if (arg_g) g = agconcat(arg_g, &rdr, &disc);
     else g = agread (&rdr, &disc);
+    /* Drop any input the scanner read ahead from this string, so it is not
+     * mistaken for the start of the next graph read from another channel.
+     */
+    aglexbad();
     /* Null out filename and reset line number 
      * The name may have been set with a ppDirective, and
      * we want to reset line_num.
@@ -15,6 +15,7 @@
 #include <cgraph/cghdr.h>
 #include <cgraph/node_set.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <util/alloc.h>
 #include <util/unreachable.h>
@@ -396,9 +397,12 @@ node_set_t *node_set_new(void) { return gv_alloc(sizeof(node_set_t)); }
 /// implemented using linear probing, so steps sequentially through indices
 /// following this.
 ///
-/// If the suboptimal choice of using the ID here turns out to be bad for
-/// performance, this could be converted to a more sophisticated hashing
-/// algorithm. None of the callers depend on the exact implementation.
+/// IDs of named nodes are the addresses of their interned names, so their low
+/// bits are always zero. Using the ID directly would then leave most slots
+/// unreachable as a starting point and produce long probe sequences. Instead
+/// the bits are mixed (the 64-bit finalizer from MurmurHash3) before being
+/// reduced to an index. None of the callers depend on the exact
+/// implementation.
 ///
 /// @param self Set to compute with respect to
 /// @param item Element being sought/added
@@ -406,43 +410,59 @@ node_set_t *node_set_new(void) { return gv_alloc(sizeof(node_set_t)); }
 static size_t node_set_index(const node_set_t *self, IDTYPE id) {
   assert(self != NULL);
   assert(self->capacity != 0);
-  return (size_t)id % self->capacity;
+  uint64_t h = (uint64_t)id;
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  h *= UINT64_C(0xc4ceb9fe1a85ec53);
+  h ^= h >> 33;
+  return (size_t)(h % self->capacity);
+}
+
+/// a watermark ratio at which the set capacity should be expanded
+static const size_t OCCUPANCY_THRESHOLD_PERCENT = 70;
+
+/// move the elements of a set into a backing store of a new capacity
+///
+/// @param self Set to operate on
+/// @param new_c New capacity, which must leave room below the watermark
+static void node_set_rehash(node_set_t *self, size_t new_c) {
+  assert(self != NULL);
+  assert(100 * self->size < OCCUPANCY_THRESHOLD_PERCENT * new_c);
+
+  Agsubnode_t **new_slots = gv_calloc(new_c, sizeof(Agsubnode_t *));
+
+  // Construct a new set and copy everything into it. Note we need to rehash
+  // because capacity (and hence modulo wraparound behavior) has changed. This
+  // conveniently flushes out the tombstones too.
+  node_set_t new_self = {.slots = new_slots, .capacity = new_c};
+  for (size_t i = 0; i < self->capacity; ++i) {
+    // skip empty slots
+    if (self->slots[i] == NULL) {
+      continue;
+    }
+    // skip deleted slots
+    if (self->slots[i] == TOMBSTONE) {
+      continue;
+    }
+    node_set_add(&new_self, self->slots[i]);
+  }
+
+  // replace ourselves with this new set
+  free(self->slots);
+  *self = new_self;
 }
 
 void node_set_add(node_set_t *self, Agsubnode_t *item) {
   assert(self != NULL);
   assert(item != NULL);
 
-  // a watermark ratio at which the set capacity should be expanded
-  static const size_t OCCUPANCY_THRESHOLD_PERCENT = 70;
-
   // do we need to expand the backing store?
   const bool grow =
       100 * self->size >= OCCUPANCY_THRESHOLD_PERCENT * self->capacity;
 
   if (grow) {
-    const size_t new_c = self->capacity == 0 ? 1024 : self->capacity * 2;
-    Agsubnode_t **new_slots = gv_calloc(new_c, sizeof(Agsubnode_t *));
-
-    // Construct a new set and copy everything into it. Note we need to rehash
-    // because capacity (and hence modulo wraparound behavior) has changed. This
-    // conveniently flushes out the tombstones too.
-    node_set_t new_self = {.slots = new_slots, .capacity = new_c};
-    for (size_t i = 0; i < self->capacity; ++i) {
-      // skip empty slots
-      if (self->slots[i] == NULL) {
-        continue;
-      }
-      // skip deleted slots
-      if (self->slots[i] == TOMBSTONE) {
-        continue;
-      }
-      node_set_add(&new_self, self->slots[i]);
-    }
-
-    // replace ourselves with this new set
-    free(self->slots);
-    *self = new_self;
+    node_set_rehash(self, self->capacity == 0 ? 1024 : self->capacity * 2);
   }
 
   assert(self->capacity > self->size);
@@ -528,6 +548,28 @@ void node_set_remove(node_set_t *self, IDTYPE item) {
   }
 }
 
+void node_set_reserve(node_set_t *self, size_t additional) {
+  assert(self != NULL);
+
+  const size_t size = self->size + additional;
+  if (100 * size < OCCUPANCY_THRESHOLD_PERCENT * self->capacity) {
+    return;
+  }
+
+  // double from the usual starting size until the watermark clears `size`, so
+  // the set ends up as it would have grown anyway
+  size_t new_c = self->capacity == 0 ? 1024 : self->capacity;
+  while (100 * size >= OCCUPANCY_THRESHOLD_PERCENT * new_c) {
+    new_c *= 2;
+  }
+  node_set_rehash(self, new_c);
+}
+
+void agnodereserve(Agraph_t *g, size_t n) {
+  assert(g != NULL);
+  node_set_reserve(g->n_id, n);
+}
+
 size_t node_set_size(const node_set_t *self) {
   assert(self != NULL);
   return self->size;
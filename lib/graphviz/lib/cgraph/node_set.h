@@ -27,6 +27,14 @@ node_set_t *node_set_new(void);
 /// @param item Element to add
 void node_set_add(node_set_t *self, Agsubnode_t *item);
 
+/// make room for more items, so they can be added without rehashing
+///
+/// On allocation failure, `exit` is called.
+///
+/// @param self Set to operate on
+/// @param additional Number of items about to be added
+void node_set_reserve(node_set_t *self, size_t additional);
+
 /// lookup an existing item in a set
 ///
 /// @param self Set to search
@@ -55,7 +55,7 @@ static Dict_t *refdict(Agraph_t * g)
     else
 	dictref = &Refdict_default;
     if (*dictref == NULL) {
-	*dictref = agdtopen(g, &Refstrdisc, Dttree);
+	*dictref = agdtopen(g, &Refstrdisc, Dtset);
     }
     return *dictref;
 }
@@ -135,6 +135,40 @@ char *agstrdup_html(Agraph_t *g, const char *s) {
   return agstrdup_internal(g, s, true);
 }
 
+/* agstrref:
+ * Take another reference to s, which must have been returned by agstrdup
+ * or agstrdup_html for the same graph. Unlike agstrdup, this does not need
+ * to hash the string to find it.
+ */
+char *agstrref(char *s)
+{
+    refstr_t *key;
+
+    if (s == NULL)
+	return NULL;
+    key = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+    key->refcnt++;
+    return s;
+}
+
+/* agstrunref:
+ * Drop a reference to s, which must have been returned by agstrdup,
+ * agstrdup_html or agstrref for g. The string is only looked up in the
+ * dictionary when this is its last reference.
+ */
+void agstrunref(Agraph_t * g, char *s)
+{
+    refstr_t *key;
+
+    if (s == NULL)
+	return;
+    key = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+    if (key->refcnt > 1)
+	key->refcnt--;
+    else
+	agstrfree(g, s);
+}
+
 int agstrfree(Agraph_t * g, const char *s)
 {
     refstr_t *r;
@@ -0,0 +1,700 @@
+/**
+ * @file
+ * @brief binary graph snapshots: @ref agwritebin, @ref agsnapshot,
+ * @ref agreadbin and @ref agmemreadbin
+ *
+ * @ingroup cgraph_graph
+ * @ingroup cgraph_core
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* A snapshot is a fixed header followed by a payload:
+ *
+ *   header:  "\0GVB", a version byte, and the payload size as a 64-bit
+ *            little endian integer
+ *   payload: graph kind flags
+ *            string table (count, then length, HTML flag and bytes of each)
+ *            root graph name
+ *            attribute declarations for graphs, nodes and edges
+ *            node names, then one value column per node attribute
+ *            out-edges per node (degree, then head and key of each edge),
+ *            then one value column per edge attribute
+ *            subgraph tree (name, local declarations, node and edge
+ *            members, children)
+ *
+ * All integers in the payload are unsigned LEB128. Strings are referred to
+ * by their 1-based position in the string table, 0 meaning “no string”, or
+ * for attribute values “the declared default”. Nodes and edges are referred to
+ * by their position in the root graph.
+ *
+ * The leading NUL byte cannot start a DOT file, so readers can tell the two
+ * formats apart by peeking at the first byte of input.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cgraph/agxbuf.h>
+#include <cgraph/cghdr.h>
+#include <cgraph/list.h>
+#include <util/alloc.h>
+
+#define SNAPSHOT_MAGIC "\0GVB"
+#define SNAPSHOT_MAGIC_LEN 4
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_LEN (SNAPSHOT_MAGIC_LEN + 1 + 8)
+
+/* attribute declaration flags */
+#define SYM_PRINT 1
+#define SYM_FIXED 2
+
+DEFINE_LIST(strs, char *)
+DEFINE_LIST(edge_list, Agedge_t *)
+
+/*********************************************************************
+ * writing
+ *********************************************************************/
+
+/// strings interned by address, in order of first use
+typedef struct {
+  const char **keys;   ///< open addressing table of string addresses
+  uint64_t *ids;       ///< string table index of each key
+  size_t capacity;     ///< size of keys/ids, a power of 2
+  uint64_t count;      ///< number of strings seen
+  agxbuf table;        ///< encoded string table
+} strtab_t;
+
+typedef struct {
+  Agraph_t *root;
+  strtab_t strings;
+  agxbuf body;
+  uint64_t *node_index; ///< position of each node, indexed by sequence number
+  uint64_t *edge_index; ///< position of each edge, indexed by sequence number
+  strs_t held;          ///< names this writer had to intern itself
+} writer_t;
+
+static void put_uint(agxbuf *xb, uint64_t v) {
+  while (v >= 0x80) {
+    agxbputc(xb, (char)(v | 0x80));
+    v >>= 7;
+  }
+  agxbputc(xb, (char)v);
+}
+
+/// zigzag encode a difference between two positions
+static void put_delta(agxbuf *xb, uint64_t prev, uint64_t cur) {
+  const int64_t d = (int64_t)(cur - prev);
+  put_uint(xb, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+}
+
+static size_t str_slot(const strtab_t *st, const char *s) {
+  uint64_t h = (uint64_t)(uintptr_t)s;
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  size_t i = (size_t)h & (st->capacity - 1);
+  while (st->keys[i] != NULL && st->keys[i] != s)
+    i = (i + 1) & (st->capacity - 1);
+  return i;
+}
+
+/// table index for a reference counted string, adding it if necessary
+static uint64_t str_id(strtab_t *st, const char *s) {
+  if (s == NULL)
+    return 0;
+
+  if (st->count * 2 >= st->capacity) {
+    strtab_t bigger = *st;
+    bigger.capacity = st->capacity == 0 ? 1024 : st->capacity * 2;
+    bigger.keys = gv_calloc(bigger.capacity, sizeof(bigger.keys[0]));
+    bigger.ids = gv_calloc(bigger.capacity, sizeof(bigger.ids[0]));
+    for (size_t i = 0; i < st->capacity; ++i) {
+      if (st->keys[i] != NULL) {
+        const size_t j = str_slot(&bigger, st->keys[i]);
+        bigger.keys[j] = st->keys[i];
+        bigger.ids[j] = st->ids[i];
+      }
+    }
+    free(st->keys);
+    free(st->ids);
+    *st = bigger;
+  }
+
+  const size_t i = str_slot(st, s);
+  if (st->keys[i] == NULL) {
+    st->keys[i] = s;
+    st->ids[i] = ++st->count;
+    const size_t len = strlen(s);
+    put_uint(&st->table, len);
+    agxbputc(&st->table, aghtmlstr(s) ? 1 : 0);
+    agxbput_n(&st->table, s, len);
+  }
+  return st->ids[i];
+}
+
+/// table index for the name of a graph object, 0 if it is anonymous
+static uint64_t name_id(writer_t *w, void *obj) {
+  Agraph_t *g = agraphof(obj);
+  char *name = aginternalmapprint(g, AGTYPE(obj), AGID(obj));
+  if (name != NULL)
+    return str_id(&w->strings, name);
+
+  // names from a user supplied ID discipline are not necessarily reference
+  // counted strings, so intern a copy for the lifetime of the writer
+  if (AGDISC(g, id)->print != NULL) {
+    name = AGDISC(g, id)->print(AGCLOS(g, id), AGTYPE(obj), AGID(obj));
+    if (name != NULL && name[0] != LOCALNAMEPREFIX) {
+      name = agstrdup(w->root, name);
+      strs_append(&w->held, name);
+      return str_id(&w->strings, name);
+    }
+  }
+  return 0;
+}
+
+/// symbols of the root dictionary for one kind, ordered by ID
+static Agsym_t **root_syms(Agraph_t *root, int kind, size_t *count) {
+  Agdatadict_t *dd = agdatadict(root, false);
+  *count = 0;
+  if (dd == NULL)
+    return NULL;
+  Dict_t *dict = kind == AGRAPH ? dd->dict.g
+               : kind == AGNODE ? dd->dict.n : dd->dict.e;
+  *count = (size_t)dtsize(dict);
+  Agsym_t **syms = gv_calloc(*count, sizeof(syms[0]));
+  for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym)) {
+    assert(sym->id >= 0 && (size_t)sym->id < *count);
+    syms[sym->id] = sym;
+  }
+  return syms;
+}
+
+static void put_sym(writer_t *w, const Agsym_t *sym) {
+  put_uint(&w->body, str_id(&w->strings, sym->name));
+  put_uint(&w->body, str_id(&w->strings, sym->defval));
+  put_uint(&w->body, (sym->print ? SYM_PRINT : 0) | (sym->fixed ? SYM_FIXED : 0));
+}
+
+/// write the declarations made locally in a subgraph, without view pathing
+static void put_local_syms(writer_t *w, Dict_t *dict) {
+  Dict_t *view = dtview(dict, NULL);
+  put_uint(&w->body, (uint64_t)dtsize(dict));
+  for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym))
+    put_sym(w, sym);
+  dtview(dict, view);
+}
+
+/// write one attribute column, 0 standing for the declared default
+static void put_column(writer_t *w, void **objs, size_t n, const Agsym_t *sym) {
+  for (size_t i = 0; i < n; ++i) {
+    const Agattr_t *data = agattrrec(objs[i]);
+    const char *value = data == NULL ? sym->defval : data->str[sym->id];
+    put_uint(&w->body, value == sym->defval ? 0 : str_id(&w->strings, value));
+  }
+}
+
+static void put_subgraphs(writer_t *w, Agraph_t *g) {
+  put_uint(&w->body, (uint64_t)agnsubg(g));
+  for (Agraph_t *subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
+    put_uint(&w->body, name_id(w, subg));
+
+    Agdatadict_t *dd = agdatadict(subg, false);
+    if (dd == NULL) {
+      put_uint(&w->body, 0);
+      put_uint(&w->body, 0);
+      put_uint(&w->body, 0);
+    } else {
+      put_local_syms(w, dd->dict.g);
+      put_local_syms(w, dd->dict.n);
+      put_local_syms(w, dd->dict.e);
+    }
+
+    uint64_t prev = 0;
+    put_uint(&w->body, (uint64_t)agnnodes(subg));
+    for (Agnode_t *n = agfstnode(subg); n; n = agnxtnode(subg, n)) {
+      const uint64_t cur = w->node_index[AGSEQ(n)];
+      put_delta(&w->body, prev, cur);
+      prev = cur;
+    }
+
+    prev = 0;
+    put_uint(&w->body, (uint64_t)agnedges(subg));
+    for (Agnode_t *n = agfstnode(subg); n; n = agnxtnode(subg, n)) {
+      for (Agedge_t *e = agfstout(subg, n); e; e = agnxtout(subg, e)) {
+        const uint64_t cur = w->edge_index[AGSEQ(e)];
+        put_delta(&w->body, prev, cur);
+        prev = cur;
+      }
+    }
+
+    put_subgraphs(w, subg);
+  }
+}
+
+static void encode(writer_t *w, Agraph_t *g) {
+  Agraph_t *root = agroot(g);
+  put_uint(&w->body, name_id(w, root));
+
+  size_t ng, nn, ne;
+  Agsym_t **gsyms = root_syms(root, AGRAPH, &ng);
+  Agsym_t **nsyms = root_syms(root, AGNODE, &nn);
+  Agsym_t **esyms = root_syms(root, AGEDGE, &ne);
+  put_uint(&w->body, ng);
+  for (size_t i = 0; i < ng; ++i)
+    put_sym(w, gsyms[i]);
+  put_uint(&w->body, nn);
+  for (size_t i = 0; i < nn; ++i)
+    put_sym(w, nsyms[i]);
+  put_uint(&w->body, ne);
+  for (size_t i = 0; i < ne; ++i)
+    put_sym(w, esyms[i]);
+
+  // number nodes and edges in root traversal order
+  const size_t node_count = (size_t)agnnodes(root);
+  const size_t edge_count = (size_t)agnedges(root);
+  void **nodes = gv_calloc(node_count, sizeof(nodes[0]));
+  void **edges = gv_calloc(edge_count, sizeof(edges[0]));
+  uint64_t max_node_seq = 0, max_edge_seq = 0;
+  {
+    size_t i = 0, j = 0;
+    for (Agnode_t *n = agfstnode(root); n; n = agnxtnode(root, n)) {
+      nodes[i++] = n;
+      if (AGSEQ(n) > max_node_seq)
+        max_node_seq = AGSEQ(n);
+      for (Agedge_t *e = agfstout(root, n); e; e = agnxtout(root, e)) {
+        edges[j++] = e;
+        if (AGSEQ(e) > max_edge_seq)
+          max_edge_seq = AGSEQ(e);
+      }
+    }
+    assert(i == node_count && j == edge_count);
+  }
+  w->node_index = gv_calloc((size_t)max_node_seq + 1, sizeof(w->node_index[0]));
+  w->edge_index = gv_calloc((size_t)max_edge_seq + 1, sizeof(w->edge_index[0]));
+  for (size_t i = 0; i < node_count; ++i)
+    w->node_index[AGSEQ(nodes[i])] = i;
+  for (size_t i = 0; i < edge_count; ++i)
+    w->edge_index[AGSEQ(edges[i])] = i;
+
+  put_uint(&w->body, node_count);
+  for (size_t i = 0; i < node_count; ++i)
+    put_uint(&w->body, name_id(w, nodes[i]));
+  for (size_t i = 0; i < nn; ++i)
+    put_column(w, nodes, node_count, nsyms[i]);
+
+  for (size_t i = 0; i < node_count; ++i) {
+    put_uint(&w->body, (uint64_t)agdegree(root, nodes[i], 0, 1));
+    for (Agedge_t *e = agfstout(root, nodes[i]); e; e = agnxtout(root, e)) {
+      put_uint(&w->body, w->node_index[AGSEQ(aghead(e))]);
+      put_uint(&w->body, name_id(w, e));
+    }
+  }
+  for (size_t i = 0; i < ne; ++i)
+    put_column(w, edges, edge_count, esyms[i]);
+
+  put_subgraphs(w, root);
+
+  free(nodes);
+  free(edges);
+  free(gsyms);
+  free(nsyms);
+  free(esyms);
+}
+
+/// encode a graph, returning the complete snapshot in \p out
+static void snapshot(Agraph_t *g, agxbuf *out) {
+  writer_t w = {.root = agroot(g)};
+  encode(&w, g);
+
+  agxbuf payload = {0};
+  const Agdesc_t desc = w.root->desc;
+  put_uint(&payload, (desc.directed ? 1 : 0) | (desc.strict ? 2 : 0) |
+                     (desc.no_loop ? 4 : 0) | (desc.no_write ? 8 : 0));
+  put_uint(&payload, w.strings.count);
+  agxbput_n(&payload, agxbstart(&w.strings.table), agxblen(&w.strings.table));
+  agxbput_n(&payload, agxbstart(&w.body), agxblen(&w.body));
+
+  uint64_t size = agxblen(&payload);
+  agxbput_n(out, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+  agxbputc(out, SNAPSHOT_VERSION);
+  for (int i = 0; i < 8; ++i) {
+    agxbputc(out, (char)(size & 0xff));
+    size >>= 8;
+  }
+  agxbput_n(out, agxbstart(&payload), agxblen(&payload));
+
+  agxbfree(&payload);
+  for (size_t i = 0; i < strs_size(&w.held); ++i)
+    agstrfree(w.root, strs_get(&w.held, i));
+  strs_free(&w.held);
+  free(w.node_index);
+  free(w.edge_index);
+  free(w.strings.keys);
+  free(w.strings.ids);
+  agxbfree(&w.strings.table);
+  agxbfree(&w.body);
+}
+
+void *agsnapshot(Agraph_t *g, size_t *size) {
+  agxbuf xb = {0};
+  snapshot(g, &xb);
+  *size = agxblen(&xb);
+  char *buf = gv_alloc(*size);
+  memcpy(buf, agxbstart(&xb), *size);
+  agxbfree(&xb);
+  return buf;
+}
+
+int agwritebin(Agraph_t *g, FILE *fp) {
+  agxbuf xb = {0};
+  snapshot(g, &xb);
+  const size_t len = agxblen(&xb);
+  const size_t written = fwrite(agxbstart(&xb), 1, len, fp);
+  agxbfree(&xb);
+  if (written != len)
+    return EOF;
+  return 0;
+}
+
+/*********************************************************************
+ * reading
+ *********************************************************************/
+
+typedef struct {
+  const unsigned char *p;   ///< next unread byte
+  const unsigned char *end; ///< end of payload
+  bool error;               ///< was the payload malformed?
+  Agraph_t *root;
+  char **strings;           ///< interned string table, [0] is NULL
+  uint64_t string_count;
+  Agnode_t **nodes;
+  uint64_t node_count;
+  Agedge_t **edges;
+  uint64_t edge_count;
+} reader_t;
+
+static uint64_t get_uint(reader_t *r) {
+  uint64_t v = 0;
+  for (unsigned shift = 0; r->p < r->end && shift < 64; shift += 7) {
+    const unsigned char b = *r->p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return v;
+  }
+  r->error = true;
+  return 0;
+}
+
+/// read a count of items each taking at least one byte
+static uint64_t get_count(reader_t *r) {
+  const uint64_t n = get_uint(r);
+  if (n > (uint64_t)(r->end - r->p)) {
+    r->error = true;
+    return 0;
+  }
+  return n;
+}
+
+static char *get_str(reader_t *r) {
+  const uint64_t i = get_uint(r);
+  if (i > r->string_count) {
+    r->error = true;
+    return NULL;
+  }
+  return r->strings[i];
+}
+
+static uint64_t get_index(reader_t *r, uint64_t limit) {
+  const uint64_t i = get_uint(r);
+  if (i >= limit) {
+    r->error = true;
+    return 0;
+  }
+  return i;
+}
+
+static uint64_t get_delta(reader_t *r, uint64_t prev, uint64_t limit) {
+  const uint64_t z = get_uint(r);
+  const uint64_t i = prev + ((z >> 1) ^ (uint64_t)-(int64_t)(z & 1));
+  if (i >= limit) {
+    r->error = true;
+    return 0;
+  }
+  return i;
+}
+
+/// read and declare attributes of one kind in \p g
+static Agsym_t **get_syms(reader_t *r, Agraph_t *g, int kind, uint64_t *count) {
+  const uint64_t n = get_count(r);
+  Agsym_t **syms = gv_calloc((size_t)n, sizeof(syms[0]));
+  for (uint64_t i = 0; i < n && !r->error; ++i) {
+    char *name = get_str(r);
+    char *defval = get_str(r);
+    const uint64_t flags = get_uint(r);
+    if (name == NULL || defval == NULL) {
+      r->error = true;
+      break;
+    }
+    syms[i] = agattr(g, kind, name, defval);
+    if (syms[i] == NULL) {
+      r->error = true;
+      break;
+    }
+    syms[i]->print = (flags & SYM_PRINT) != 0;
+    syms[i]->fixed = (flags & SYM_FIXED) != 0;
+  }
+  if (count != NULL)
+    *count = n;
+  return syms;
+}
+
+static void get_column(reader_t *r, void **objs, uint64_t n, Agsym_t *sym) {
+  for (uint64_t i = 0; i < n && !r->error; ++i) {
+    // values come from the string table, so are already interned
+    char *value = get_str(r);
+    if (value != NULL && objs[i] != NULL)
+      (void)agxsetref(objs[i], sym, value);
+  }
+}
+
+static void get_subgraphs(reader_t *r, Agraph_t *g) {
+  const uint64_t n = get_count(r);
+  for (uint64_t i = 0; i < n && !r->error; ++i) {
+    Agraph_t *subg = agsubg(g, get_str(r), 1);
+    if (subg == NULL) {
+      r->error = true;
+      return;
+    }
+    free(get_syms(r, subg, AGRAPH, NULL));
+    free(get_syms(r, subg, AGNODE, NULL));
+    free(get_syms(r, subg, AGEDGE, NULL));
+
+    uint64_t prev = 0;
+    const uint64_t nn = get_count(r);
+    for (uint64_t j = 0; j < nn && !r->error; ++j) {
+      prev = get_delta(r, prev, r->node_count);
+      agsubnode(subg, r->nodes[prev], 1);
+    }
+
+    prev = 0;
+    const uint64_t ne = get_count(r);
+    for (uint64_t j = 0; j < ne && !r->error; ++j) {
+      prev = get_delta(r, prev, r->edge_count);
+      if (r->edges[prev] != NULL)
+        agsubedge(subg, r->edges[prev], 1);
+    }
+
+    if (!r->error)
+      get_subgraphs(r, subg);
+  }
+}
+
+static Agraph_t *decode(const unsigned char *data, size_t size, Agdisc_t *disc) {
+  reader_t r = {.p = data, .end = data + size};
+
+  const uint64_t flags = get_uint(&r);
+  Agdesc_t desc = {.directed = (flags & 1) != 0,
+                   .strict = (flags & 2) != 0,
+                   .no_loop = (flags & 4) != 0,
+                   .no_write = (flags & 8) != 0,
+                   .maingraph = true};
+
+  // locate the strings now, intern them once the graph exists
+  r.string_count = get_count(&r);
+  const unsigned char *table = r.p;
+  for (uint64_t i = 0; i < r.string_count && !r.error; ++i) {
+    const uint64_t len = get_uint(&r);
+    if (r.end - r.p < 1 || len > (uint64_t)(r.end - r.p - 1)) {
+      r.error = true;
+      break;
+    }
+    r.p += 1 + len;
+  }
+  if (r.error) {
+    agerrorf("malformed graph snapshot\n");
+    return NULL;
+  }
+  const unsigned char *body = r.p;
+
+  // the root name is needed before anything can be interned, so fetch it
+  // straight from the table
+  const uint64_t root_name = get_uint(&r);
+  if (r.error || root_name > r.string_count) {
+    agerrorf("malformed graph snapshot\n");
+    return NULL;
+  }
+  agxbuf name = {0};
+  r.p = table;
+  for (uint64_t i = 1; i <= r.string_count; ++i) {
+    const uint64_t len = get_uint(&r);
+    if (i == root_name)
+      agxbput_n(&name, (const char *)r.p + 1, (size_t)len);
+    r.p += 1 + len;
+  }
+  r.root = agopen(root_name == 0 ? NULL : agxbuse(&name), desc, disc);
+  agxbfree(&name);
+  if (r.root == NULL)
+    return NULL;
+
+  r.strings = gv_calloc((size_t)r.string_count + 1, sizeof(r.strings[0]));
+  r.p = table;
+  {
+    agxbuf s = {0};
+    for (uint64_t i = 1; i <= r.string_count; ++i) {
+      const uint64_t len = get_uint(&r);
+      const bool is_html = *r.p++ != 0;
+      agxbput_n(&s, (const char *)r.p, (size_t)len);
+      r.p += len;
+      r.strings[i] = is_html ? agstrdup_html(r.root, agxbuse(&s))
+                             : agstrdup(r.root, agxbuse(&s));
+    }
+    agxbfree(&s);
+  }
+  assert(r.p == body);
+  (void)body;
+  (void)get_uint(&r); // root name, already used
+
+  uint64_t nn, ne;
+  free(get_syms(&r, r.root, AGRAPH, NULL));
+  Agsym_t **nsyms = get_syms(&r, r.root, AGNODE, &nn);
+  Agsym_t **esyms = get_syms(&r, r.root, AGEDGE, &ne);
+
+  if (!r.error) {
+    r.node_count = get_count(&r);
+    r.nodes = gv_calloc((size_t)r.node_count, sizeof(r.nodes[0]));
+    for (uint64_t i = 0; i < r.node_count && !r.error; ++i) {
+      r.nodes[i] = agnode(r.root, get_str(&r), 1);
+      if (r.nodes[i] == NULL)
+        r.error = true;
+    }
+  }
+  for (uint64_t i = 0; i < nn && !r.error; ++i)
+    get_column(&r, (void **)r.nodes, r.node_count, nsyms[i]);
+
+  if (!r.error) {
+    edge_list_t edges = {0};
+    for (uint64_t i = 0; i < r.node_count && !r.error; ++i) {
+      const uint64_t degree = get_count(&r);
+      for (uint64_t j = 0; j < degree && !r.error; ++j) {
+        Agnode_t *h = r.nodes[get_index(&r, r.node_count)];
+        char *key = get_str(&r);
+        if (!r.error)
+          edge_list_append(&edges, agedge(r.root, r.nodes[i], h, key, 1));
+      }
+    }
+    r.edge_count = edge_list_size(&edges);
+    r.edges = edge_list_detach(&edges);
+  }
+  for (uint64_t i = 0; i < ne && !r.error; ++i)
+    get_column(&r, (void **)r.edges, r.edge_count, esyms[i]);
+
+  if (!r.error)
+    get_subgraphs(&r, r.root);
+
+  for (uint64_t i = 1; i <= r.string_count; ++i)
+    agstrunref(r.root, r.strings[i]);
+  free(r.strings);
+  free(r.nodes);
+  free(r.edges);
+  free(nsyms);
+  free(esyms);
+
+  if (r.error) {
+    agerrorf("malformed graph snapshot\n");
+    agclose(r.root);
+    return NULL;
+  }
+  return r.root;
+}
+
+/// validate a snapshot header, returning the payload size
+static bool read_header(const unsigned char *hdr, uint64_t *size) {
+  if (memcmp(hdr, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) != 0) {
+    agerrorf("not a graph snapshot\n");
+    return false;
+  }
+  if (hdr[SNAPSHOT_MAGIC_LEN] != SNAPSHOT_VERSION) {
+    agerrorf("unsupported graph snapshot version %d\n", hdr[SNAPSHOT_MAGIC_LEN]);
+    return false;
+  }
+  *size = 0;
+  for (int i = 7; i >= 0; --i)
+    *size = (*size << 8) | hdr[SNAPSHOT_MAGIC_LEN + 1 + i];
+  return true;
+}
+
+Agraph_t *agmemreadbin(const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  uint64_t payload;
+  if (size < SNAPSHOT_HEADER_LEN) {
+    agerrorf("truncated graph snapshot\n");
+    return NULL;
+  }
+  if (!read_header(bytes, &payload))
+    return NULL;
+  if (payload > size - SNAPSHOT_HEADER_LEN) {
+    agerrorf("truncated graph snapshot\n");
+    return NULL;
+  }
+  return decode(bytes + SNAPSHOT_HEADER_LEN, (size_t)payload, NULL);
+}
+
+Agraph_t *agreadbin(FILE *fp, Agdisc_t *disc) {
+  unsigned char hdr[SNAPSHOT_HEADER_LEN];
+  const size_t got = fread(hdr, 1, sizeof(hdr), fp);
+  if (got == 0) // end of input, not an error
+    return NULL;
+  uint64_t size;
+  if (got < sizeof(hdr)) {
+    agerrorf("truncated graph snapshot\n");
+    return NULL;
+  }
+  if (!read_header(hdr, &size))
+    return NULL;
+  if (size > SIZE_MAX) {
+    agerrorf("graph snapshot too large\n");
+    return NULL;
+  }
+
+  // the header size is not trusted for allocation, so read in chunks and only
+  // grow the buffer as data actually arrives
+  agxbuf payload = {0};
+  for (uint64_t left = size; left > 0;) {
+    char chunk[BUFSIZ];
+    const size_t want = left < sizeof(chunk) ? (size_t)left : sizeof(chunk);
+    const size_t n = fread(chunk, 1, want, fp);
+    agxbput_n(&payload, chunk, n);
+    left -= n;
+    if (n < want) {
+      agerrorf("malformed graph snapshot: %" PRIu64 " of %" PRIu64
+               " payload bytes present\n", size - left, size);
+      agxbfree(&payload);
+      return NULL;
+    }
+  }
+  const size_t len = agxblen(&payload);
+  Agraph_t *g = decode((const unsigned char *)agxbuse(&payload), len, disc);
+  agxbfree(&payload);
+  return g;
+}
+
+bool agisbin(FILE *fp) {
+  const int c = getc(fp);
+  if (c == EOF)
+    return false;
+  ungetc(c, fp);
+  return c == '\0';
+}
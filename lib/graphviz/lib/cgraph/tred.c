@@ -23,11 +23,14 @@
 #include <cgraph/cghdr.h>
 #include <cgraph/list.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <util/alloc.h>
+#include <util/gv_parallel.h>
 
 typedef struct {
   bool on_stack : 1;
@@ -177,8 +180,193 @@ static int dfs(Agnode_t *n, nodeinfo_t *ninfo, int warn,
   return warn;
 }
 
-/* Do a DFS for each vertex in graph g, so the time
- * complexity is O(|V||E|).
+/// upper bound on the memory for reachability bitsets, in bytes
+enum { REACH_BUDGET = 256 * 1024 * 1024 };
+
+/// a snapshot of an acyclic graph's edges, in topological order
+///
+/// Nodes are numbered by their position in a topological order, so every edge
+/// runs from a lower to a higher number. Self loops are left out.
+typedef struct {
+  size_t n;        ///< number of nodes
+  size_t *off;     ///< edges of node `i` are `head[off[i]]…head[off[i+1]-1]`
+  size_t *head;    ///< topological number of each edge’s head
+  bool *redundant; ///< is each edge implied by a longer path?
+  size_t words;    ///< 64-bit words of reachability tracked per block
+} dag_t;
+
+/// find the redundant edges whose heads are numbered in one block
+///
+/// The block is `[64 * words * b, 64 * words * (b + 1))`. Each node gets a
+/// bitset of the block’s nodes it can reach, computed from its successors’
+/// bitsets in reverse topological order. An edge into the block is redundant if
+/// its head can be reached from one of its tail’s successors. Only nodes
+/// numbered before the end of the block can reach into it.
+static void reduce_block(void *arg, size_t b) {
+  dag_t *dag = arg;
+  const size_t words = dag->words;
+  const size_t lo = 64 * words * b;
+  const size_t hi = lo + 64 * words < dag->n ? lo + 64 * words : dag->n;
+
+  uint64_t *reach = gv_calloc(hi * words, sizeof(uint64_t));
+  for (size_t v = hi; v-- > 0;) {
+    uint64_t *r = &reach[v * words];
+
+    // what the successors of v can reach
+    for (size_t i = dag->off[v]; i < dag->off[v + 1]; ++i) {
+      const size_t w = dag->head[i];
+      if (w >= hi)
+        continue;
+      const uint64_t *s = &reach[w * words];
+      for (size_t k = 0; k < words; ++k)
+        r[k] |= s[k];
+    }
+
+    // edges to anything reached that way are implied, and the rest are not
+    for (size_t i = dag->off[v]; i < dag->off[v + 1]; ++i) {
+      const size_t w = dag->head[i];
+      if (w < lo || w >= hi)
+        continue;
+      const size_t bit = w - lo;
+      if (r[bit / 64] >> (bit % 64) & 1)
+        dag->redundant[i] = true;
+    }
+    for (size_t i = dag->off[v]; i < dag->off[v + 1]; ++i) {
+      const size_t w = dag->head[i];
+      if (w < lo || w >= hi)
+        continue;
+      const size_t bit = w - lo;
+      r[bit / 64] |= UINT64_C(1) << (bit % 64);
+    }
+  }
+  free(reach);
+}
+
+/* Transitive reduction of an acyclic graph, using reachability bitsets
+ * instead of a DFS from every node. Blocks of target nodes are independent, so
+ * they are processed on multiple threads. The same edges are removed as by the
+ * DFS. Returns false, without changing the graph, if g has a cycle.
+ */
+static bool tred_dag(Agraph_t *g, const graphviz_tred_options_t *opts) {
+  const size_t n = (size_t)agnnodes(g);
+
+  // map sequence numbers to positions in node order
+  size_t max_seq = 0;
+  for (Agnode_t *v = agfstnode(g); v; v = agnxtnode(g, v))
+    max_seq = (size_t)AGSEQ(v) > max_seq ? (size_t)AGSEQ(v) : max_seq;
+  size_t *index = gv_calloc(max_seq + 1, sizeof(size_t));
+  Agnode_t **nodes = gv_calloc(n, sizeof(Agnode_t *));
+  {
+    size_t i = 0;
+    for (Agnode_t *v = agfstnode(g); v; v = agnxtnode(g, v), ++i) {
+      index[AGSEQ(v)] = i;
+      nodes[i] = v;
+    }
+  }
+
+  // sort topologically, counting in-edges
+  size_t *indeg = gv_calloc(n, sizeof(size_t));
+  size_t m = 0;
+  for (size_t i = 0; i < n; ++i) {
+    for (Agedge_t *e = agfstout(g, nodes[i]); e; e = agnxtout(g, e)) {
+      if (aghead(e) != nodes[i]) {
+        ++indeg[index[AGSEQ(aghead(e))]];
+        ++m;
+      }
+    }
+  }
+  size_t *order = gv_calloc(n, sizeof(size_t));
+  size_t *topo = gv_calloc(n, sizeof(size_t));
+  size_t sorted = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (indeg[i] == 0)
+      order[sorted++] = i;
+  }
+  for (size_t j = 0; j < sorted; ++j) {
+    const size_t i = order[j];
+    topo[i] = j;
+    for (Agedge_t *e = agfstout(g, nodes[i]); e; e = agnxtout(g, e)) {
+      if (aghead(e) != nodes[i] && --indeg[index[AGSEQ(aghead(e))]] == 0)
+        order[sorted++] = index[AGSEQ(aghead(e))];
+    }
+  }
+  free(indeg);
+  free(order);
+  if (sorted < n) {
+    free(topo);
+    free(nodes);
+    free(index);
+    return false;
+  }
+
+  // snapshot the edges, with tails and heads numbered topologically
+  dag_t dag = {.n = n};
+  dag.off = gv_calloc(n + 1, sizeof(size_t));
+  dag.head = gv_calloc(m, sizeof(size_t));
+  dag.redundant = gv_calloc(m, sizeof(bool));
+  for (size_t i = 0; i < n; ++i) {
+    for (Agedge_t *e = agfstout(g, nodes[i]); e; e = agnxtout(g, e)) {
+      if (aghead(e) != nodes[i])
+        ++dag.off[topo[i] + 1];
+    }
+  }
+  for (size_t i = 0; i < n; ++i)
+    dag.off[i + 1] += dag.off[i];
+  for (size_t i = 0; i < n; ++i) {
+    size_t k = dag.off[topo[i]];
+    for (Agedge_t *e = agfstout(g, nodes[i]); e; e = agnxtout(g, e)) {
+      if (aghead(e) != nodes[i])
+        dag.head[k++] = topo[index[AGSEQ(aghead(e))]];
+    }
+  }
+
+  // pick a block size that keeps the bitsets of all threads within budget
+  const size_t threads = gv_nthreads();
+  const size_t all_words = (n + 63) / 64;
+  dag.words = n == 0 ? 1 : REACH_BUDGET / threads / n / sizeof(uint64_t);
+  if (dag.words > all_words)
+    dag.words = all_words;
+  if (dag.words == 0)
+    dag.words = 1;
+  gv_parallel_for((n + 64 * dag.words - 1) / (64 * dag.words), reduce_block,
+                  &dag);
+
+  // remove the redundant edges, and duplicates, as the DFS would have
+  for (size_t i = 0; i < n; ++i) {
+    Agnode_t *oldhd = NULL;
+    size_t k = dag.off[topo[i]];
+    Agedge_t *f;
+    for (Agedge_t *e = agfstout(g, nodes[i]); e; e = f) {
+      f = agnxtout(g, e);
+      Agnode_t *hd = aghead(e);
+      const bool redundant = hd != nodes[i] && dag.redundant[k++];
+      bool do_delete = false;
+      if (oldhd == hd)
+        do_delete = true;
+      else {
+        oldhd = hd;
+        do_delete = redundant;
+      }
+      if (do_delete) {
+        if (opts->PrintRemovedEdges && opts->err != NULL)
+          fprintf(opts->err, "removed edge: %s: \"%s\" -> \"%s\"\n",
+                  agnameof(g), agnameof(aghead(e)), agnameof(agtail(e)));
+        agdelete(g, e);
+      }
+    }
+  }
+
+  free(dag.redundant);
+  free(dag.head);
+  free(dag.off);
+  free(topo);
+  free(nodes);
+  free(index);
+  return true;
+}
+
+/* Acyclic graphs are reduced with reachability bitsets. Otherwise, do a DFS
+ * for each vertex in graph g, so the time complexity is O(|V||E|).
  */
 void graphviz_tred(Agraph_t *g, const graphviz_tred_options_t *opts) {
   Agnode_t *n;
@@ -189,11 +377,24 @@ void graphviz_tred(Agraph_t *g, const graphviz_tred_options_t *opts) {
   nodeinfo_t *ninfo;
   size_t infosize;
 
+  if (opts->Verbose && opts->err != NULL)
+    fprintf(stderr, "Processing graph %s\n", agnameof(g));
+
+  {
+    const time_t start = time(NULL);
+    if (tred_dag(g, opts)) {
+      if (opts->Verbose && opts->err != NULL)
+        fprintf(opts->err, "Finished graph %s: %lld.00 secs.\n", agnameof(g),
+                (long long)(time(NULL) - start));
+      agwrite(g, opts->out);
+      fflush(opts->out);
+      return;
+    }
+  }
+
   infosize = (agnnodes(g) + 1) * sizeof(nodeinfo_t);
   ninfo = gv_alloc(infosize);
 
-  if (opts->Verbose && opts->err != NULL)
-    fprintf(stderr, "Processing graph %s\n", agnameof(g));
   for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
     memset(ninfo, 0, infosize);
     const time_t start = time(NULL);
@@ -12,9 +12,10 @@
 #include	<cgraph/agxbuf.h>
 #include	<circogen/blockpath.h>
 #include	<circogen/circular.h>
-#include	<circogen/edgelist.h>
+#include	<assert.h>
 #include	<stddef.h>
 #include	<stdbool.h>
+#include	<string.h>
 #include	<util/alloc.h>
 
 /* The code below lays out a single block on a circle.
@@ -404,51 +405,263 @@ static void block_graph(Agraph_t * g, block_t * sn)
     }
 }
 
-static int count_all_crossings(nodelist_t * list, Agraph_t * subg)
+/* Crossing counting.
+ * With the nodes of a block placed around a circle in list order, edges
+ * (a,b) and (c,d) with a < b and c < d by list position cross if and only if
+ * a < c < b < d or c < a < d < b. Edges sharing an endpoint never cross.
+ *
+ * The block is copied into a compact adjacency structure, with each node
+ * identified by its position in the initial list. POSITION holds this ID
+ * until layout_block assigns final positions.
+ *
+ * For the current order, a few indexes over list positions let the number of
+ * edges with one or both endpoints in any range of positions be found in
+ * logarithmic time.
+ */
+typedef struct {
+    size_t n;		/* number of nodes */
+    size_t *start;	/* neighbors of node i are adj[start[i]..start[i+1]) */
+    size_t *adj;	/* neighbor IDs */
+    size_t *pos;	/* current list position of each node ID */
+    size_t *at;		/* node ID at each list position */
+    size_t *nbrpos;	/* positions of the neighbors of each node, sorted */
+    size_t *degsum;	/* degsum[p]: sum of degrees at positions [0, p) */
+    size_t *closed;	/* closed[p]: edges with last endpoint before p */
+    size_t *bstart;	/* Fenwick tree node k holds bucket[bstart[k]..bstart[k+1]) */
+    size_t *bucket;	/* last endpoints of edges, grouped by first endpoint */
+} crossings_t;
+
+/// lowest set bit of a Fenwick tree index
+static size_t lowbit(size_t i)
 {
-    edgelist *openEdgeList = init_edgelist();
-    Agnode_t *n;
-    Agedge_t *e;
-    int crossings = 0;
-    int order = 1;
+    return i & (~i + 1);
+}
 
-    for (n = agfstnode(subg); n; n = agnxtnode(subg, n)) {
-	for (e = agfstout(subg, n); e; e = agnxtout(subg, e)) {
-	    EDGEORDER(e) = 0;
+/// rebuild the position indexes from pos and at
+static void crossings_index(crossings_t *c)
+{
+    const size_t n = c->n;
+
+    memset(c->bstart, 0, (n + 2) * sizeof(size_t));
+    for (size_t p = 0; p < n; ++p) {
+	const size_t v = c->at[p];
+	size_t last = 0;
+	for (size_t k = c->start[v]; k < c->start[v + 1]; ++k) {
+	    if (c->pos[c->adj[k]] > p) {
+		for (size_t b = p + 1; b <= n; b += lowbit(b))
+		    ++c->bstart[b + 1];
+	    } else {
+		++last;
+	    }
 	}
+	c->degsum[p + 1] = c->degsum[p] + c->start[v + 1] - c->start[v];
+	c->closed[p + 1] = c->closed[p] + last;
     }
-
-    for (size_t item = 0; item < nodelist_size(list); ++item) {
-	n = nodelist_get(list, item);
-
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) > 0) {
-		edgelistitem *eitem;
-		Agedge_t *ep;
-
-		for (eitem = dtfirst(openEdgeList); eitem;
-		     eitem = dtnext(openEdgeList, eitem)) {
-		    ep = eitem->edge;
-		    if (EDGEORDER(ep) > EDGEORDER(e)) {
-			if (aghead(ep) != n && agtail(ep) != n)
-			    crossings++;
-		    }
-		}
-		remove_edge(openEdgeList, e);
+    for (size_t b = 1; b <= n; ++b)
+	c->bstart[b + 1] += c->bstart[b];
+
+    /* visiting positions in order leaves every array filled here sorted */
+    size_t *fill = gv_calloc(n + 1, sizeof(size_t));
+    size_t *nfill = gv_calloc(n, sizeof(size_t));
+    for (size_t q = 0; q < n; ++q) {
+	const size_t v = c->at[q];
+	for (size_t k = c->start[v]; k < c->start[v + 1]; ++k) {
+	    const size_t u = c->adj[k];
+	    const size_t p = c->pos[u];
+	    c->nbrpos[c->start[u] + nfill[u]++] = q;
+	    if (p < q) {
+		for (size_t b = p + 1; b <= n; b += lowbit(b))
+		    c->bucket[c->bstart[b] + fill[b]++] = q;
 	    }
 	}
+    }
+    free(nfill);
+    free(fill);
+}
 
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) == 0) {
-		EDGEORDER(e) = order;
-		add_edge(openEdgeList, e);
-	    }
+static crossings_t crossings_new(nodelist_t *list, Agraph_t *subg)
+{
+    crossings_t c = {.n = nodelist_size(list)};
+    /* at this point, list holds every node in the block */
+    assert(c.n == (size_t)agnnodes(subg));
+
+    for (size_t i = 0; i < c.n; ++i)
+	POSITION(nodelist_get(list, i)) = (int)i;
+
+    const size_t nadj = 2 * (size_t)agnedges(subg);
+    c.start = gv_calloc(c.n + 1, sizeof(size_t));
+    c.adj = gv_calloc(nadj, sizeof(size_t));
+    c.pos = gv_calloc(c.n, sizeof(size_t));
+    c.at = gv_calloc(c.n, sizeof(size_t));
+    size_t k = 0;
+    for (size_t i = 0; i < c.n; ++i) {
+	Agnode_t *n = nodelist_get(list, i);
+	c.start[i] = k;
+	for (Agedge_t *e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
+	    Agnode_t *other = agtail(e) == n ? aghead(e) : agtail(e);
+	    c.adj[k++] = (size_t)POSITION(other);
+	}
+	c.pos[i] = i;
+	c.at[i] = i;
+    }
+    c.start[c.n] = k;
+
+    /* each edge sits in at most one bucket per level of the Fenwick tree */
+    size_t levels = 1;
+    for (size_t m = c.n; m > 1; m >>= 1)
+	++levels;
+    c.nbrpos = gv_calloc(nadj, sizeof(size_t));
+    c.degsum = gv_calloc(c.n + 1, sizeof(size_t));
+    c.closed = gv_calloc(c.n + 1, sizeof(size_t));
+    c.bstart = gv_calloc(c.n + 2, sizeof(size_t));
+    c.bucket = gv_calloc(nadj / 2 * levels, sizeof(size_t));
+    crossings_index(&c);
+    return c;
+}
+
+static void crossings_free(crossings_t *c)
+{
+    free(c->start);
+    free(c->adj);
+    free(c->pos);
+    free(c->at);
+    free(c->nbrpos);
+    free(c->degsum);
+    free(c->closed);
+    free(c->bstart);
+    free(c->bucket);
+}
+
+/// refresh node positions after the list has been reordered
+static void crossings_sync(crossings_t *c, nodelist_t *list)
+{
+    for (size_t i = 0; i < c->n; ++i) {
+	const size_t id = (size_t)POSITION(nodelist_get(list, i));
+	c->pos[id] = i;
+	c->at[i] = id;
+    }
+    crossings_index(c);
+}
+
+/// number of entries of the sorted array a[0..len) that are at most v
+static size_t count_upto(const size_t *a, size_t len, size_t v)
+{
+    size_t lo = 0, hi = len;
+    while (lo < hi) {
+	const size_t mid = lo + (hi - lo) / 2;
+	if (a[mid] <= v)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/// number of neighbors of node v at positions [lo, hi]
+static size_t neighbors_within(const crossings_t *c, size_t v, size_t lo,
+                               size_t hi)
+{
+    const size_t *a = c->nbrpos + c->start[v];
+    const size_t len = c->start[v + 1] - c->start[v];
+    const size_t below = lo == 0 ? 0 : count_upto(a, len, lo - 1);
+    return count_upto(a, len, hi) - below;
+}
+
+/// number of edges with both endpoints at positions [lo, hi]
+static size_t edges_within(const crossings_t *c, size_t lo, size_t hi)
+{
+    /* edges ending by hi, less those of them starting before lo */
+    size_t count = c->closed[hi + 1];
+    for (size_t b = lo; b > 0; b -= lowbit(b))
+	count -= count_upto(c->bucket + c->bstart[b],
+	                    c->bstart[b + 1] - c->bstart[b], hi);
+    return count;
+}
+
+/* count_all_crossings:
+ * Edge (a,b) crosses every edge with exactly one endpoint strictly between
+ * a and b. Summing this over all edges counts each crossing twice.
+ */
+static int count_all_crossings(const crossings_t *c)
+{
+    size_t twice = 0;
+
+    for (size_t a = 0; a < c->n; ++a) {
+	const size_t v = c->at[a];
+	for (size_t k = c->start[v]; k < c->start[v + 1]; ++k) {
+	    const size_t b = c->nbrpos[k];
+	    if (b <= a + 1)
+		continue;
+	    /* endpoints inside, less those of edges wholly inside, less
+	     * those of edges sharing an endpoint with (a,b)
+	     */
+	    twice += c->degsum[b] - c->degsum[a + 1]
+		- 2 * edges_within(c, a + 1, b - 1)
+		- neighbors_within(c, v, a + 1, b - 1)
+		- neighbors_within(c, c->at[b], a + 1, b - 1);
 	}
-	order++;
     }
+    return (int)(twice / 2);
+}
 
-    free_edgelist(openEdgeList);
-    return crossings;
+/// position of node v in the list with node x removed
+static size_t pos_without(const crossings_t *c, size_t x, size_t v)
+{
+    return c->pos[v] < c->pos[x] ? c->pos[v] : c->pos[v] - 1;
+}
+
+/* gap_cost:
+ * With node x removed from the list, there are n gaps it can be put back
+ * into, gap g lying before position g. Return the number of edges the edge
+ * (x,w) would cross with x put in gap g: those not touching x or w with
+ * exactly one endpoint strictly between the gap and w.
+ */
+static int gap_cost(const crossings_t *c, size_t x, size_t w, size_t g)
+{
+    const size_t pw = pos_without(c, x, w);
+    size_t first, last;
+
+    /* the positions between gap and w, in the list without x */
+    if (g <= pw) {
+	if (g == pw)
+	    return 0;
+	first = g;
+	last = pw - 1;
+    } else {
+	if (g == pw + 1)
+	    return 0;
+	first = pw + 1;
+	last = g - 1;
+    }
+
+    /* the same positions in the actual list, which may also include x */
+    const size_t px = c->pos[x];
+    const size_t lo = first < px ? first : first + 1;
+    const size_t hi = last < px ? last : last + 1;
+    const bool has_x = lo < px && px < hi;
+    const size_t deg_x = c->start[x + 1] - c->start[x];
+    const size_t x_nbrs = neighbors_within(c, x, lo, hi);
+
+    /* endpoints in range of edges not touching x */
+    size_t ends = c->degsum[hi + 1] - c->degsum[lo] - x_nbrs;
+    size_t inside = edges_within(c, lo, hi);
+    size_t w_nbrs = neighbors_within(c, w, lo, hi);
+    if (has_x) {
+	ends -= deg_x;
+	inside -= x_nbrs;
+	/* w's neighbors in range include x once per edge between them */
+	w_nbrs -= neighbors_within(c, w, px, px);
+    }
+    return (int)(ends - 2 * inside - w_nbrs);
+}
+
+/// crossings of all the edges of x with x put in gap g
+static int node_cost(const crossings_t *c, size_t x, size_t g)
+{
+    int cost = 0;
+    for (size_t k = c->start[x]; k < c->start[x + 1]; ++k)
+	cost += gap_cost(c, x, c->adj[k], g);
+    return cost;
 }
 
 #define CROSS_ITER 10
@@ -456,8 +669,14 @@ static int count_all_crossings(nodelist_t * list, Agraph_t * subg)
 /* Attempt to reduce edge crossings by moving nodes.
  * Original crossing count is in cnt; final count is returned there.
  * list is the original list; return the best list found.
+ *
+ * Moving a node only changes the crossings of its own edges, and the rest of
+ * the list stays in the same order whichever neighbor the node is moved
+ * next to. So each trial move only counts the crossings of the moved node's
+ * edges, without touching the list.
  */
-static nodelist_t reduce(nodelist_t list, Agraph_t *subg, int *cnt) {
+static nodelist_t reduce(nodelist_t list, Agraph_t *subg, crossings_t *c,
+                         int *cnt) {
     Agnode_t *curnode;
     Agedge_t *e;
     Agnode_t *neighbor;
@@ -466,6 +685,10 @@ static nodelist_t reduce(nodelist_t list, Agraph_t *subg, int *cnt) {
     crossings = *cnt;
     for (curnode = agfstnode(subg); curnode;
 	 curnode = agnxtnode(subg, curnode)) {
+	const size_t x = (size_t)POSITION(curnode);
+	/* crossings not involving curnode */
+	const int rest = crossings - node_cost(c, x, c->pos[x]);
+
 	/*  move curnode next to its neighbors */
 	for (e = agfstedge(subg, curnode); e;
 	     e = agnxtedge(subg, e, curnode)) {
@@ -474,19 +697,16 @@ static nodelist_t reduce(nodelist_t list, Agraph_t *subg, int *cnt) {
 		neighbor = aghead(e);
 
 	    for (j = 0; j < 2; j++) {
-		nodelist_t listCopy = nodelist_copy(&list);
-		insertNodelist(&list, curnode, neighbor, j);
-		newCrossings = count_all_crossings(&list, subg);
+		const size_t gap = pos_without(c, x, (size_t)POSITION(neighbor)) + (size_t)j;
+		newCrossings = rest + node_cost(c, x, gap);
 		if (newCrossings < crossings) {
 		    crossings = newCrossings;
-		    nodelist_free(&listCopy);
+		    insertNodelist(&list, curnode, neighbor, j);
+		    crossings_sync(c, &list);
 		    if (crossings == 0) {
 			*cnt = 0;
 			return list;
 		    }
-		} else {
-		    nodelist_free(&list);
-		    list = listCopy;
 		}
 	    }
 	}
@@ -497,18 +717,22 @@ static nodelist_t reduce(nodelist_t list, Agraph_t *subg, int *cnt) {
 
 static nodelist_t reduce_edge_crossings(nodelist_t list, Agraph_t *subg) {
     int i, crossings, origCrossings;
+    crossings_t c = crossings_new(&list, subg);
 
-    crossings = count_all_crossings(&list, subg);
-    if (crossings == 0)
+    crossings = count_all_crossings(&c);
+    if (crossings == 0) {
+	crossings_free(&c);
 	return list;
+    }
 
     for (i = 0; i < CROSS_ITER; i++) {
 	origCrossings = crossings;
-	list = reduce(list, subg, &crossings);
+	list = reduce(list, subg, &c, &crossings);
 	/* return if no crossings or no improvement */
 	if (origCrossings == crossings || crossings == 0)
-	    return list;
+	    break;
     }
+    crossings_free(&c);
     return list;
 }
 
@@ -0,0 +1,154 @@
+// basic unit tester for the crossing counts in blockpath.c
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// include the implementation directly so this can be compiled standalone
+#include <circogen/blockpath.c>
+#include <circogen/nodelist.c>
+
+/// a small pseudo random number generator, so runs are reproducible
+static unsigned next_random(unsigned *state) {
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+
+/// crossings of the current order, by checking every pair of edges
+static int count_pairs(const crossings_t *c) {
+  int count = 0;
+  for (size_t u = 0; u < c->n; ++u) {
+    for (size_t k = c->start[u]; k < c->start[u + 1]; ++k) {
+      const size_t v = c->adj[k];
+      if (v < u)
+        continue;
+      size_t a = c->pos[u], b = c->pos[v];
+      if (a > b) {
+        const size_t t = a;
+        a = b;
+        b = t;
+      }
+      for (size_t x = u + 1; x < c->n; ++x) {
+        for (size_t l = c->start[x]; l < c->start[x + 1]; ++l) {
+          const size_t y = c->adj[l];
+          if (y < x)
+            continue;
+          size_t p = c->pos[x], q = c->pos[y];
+          if (p > q) {
+            const size_t t = p;
+            p = q;
+            q = t;
+          }
+          if ((a < p && p < b && b < q) || (p < a && a < q && q < b))
+            ++count;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/// a cycle through all nodes, with chords added at random, some of which
+/// may duplicate an existing edge
+static Agraph_t *random_block(int nodes, int chords, unsigned seed) {
+  Agraph_t *g = agopen("g", Agundirected, NULL);
+  agbindrec(g, "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+  Agnode_t **ns = gv_calloc((size_t)nodes, sizeof(Agnode_t *));
+  for (int i = 0; i < nodes; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i);
+    ns[i] = agnode(g, name, 1);
+    agbindrec(ns[i], "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);
+    ND_alg(ns[i]) = gv_alloc(sizeof(cdata));
+  }
+  for (int i = 0; i < nodes; ++i)
+    agedge(g, ns[i], ns[(i + 1) % nodes], NULL, 1);
+  for (int i = 0; i < chords; ++i) {
+    const int u = (int)(next_random(&seed) % (unsigned)nodes);
+    const int v = (int)(next_random(&seed) % (unsigned)nodes);
+    if (u != v)
+      agedge(g, ns[u], ns[v], NULL, 1);
+  }
+  free(ns);
+  return g;
+}
+
+static void free_block(Agraph_t *g) {
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+    free(ND_alg(n));
+  agclose(g);
+}
+
+/// the crossing count predicted for each trial move should match a full
+/// recount after the move is made
+static void check_block(int nodes, int chords, unsigned seed) {
+  Agraph_t *g = random_block(nodes, chords, seed);
+
+  // start from a shuffled order
+  nodelist_t list = {0};
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+    nodelist_append(&list, n);
+  for (size_t i = nodelist_size(&list); i > 1; --i) {
+    const size_t j = next_random(&seed) % i;
+    Agnode_t *t = nodelist_get(&list, i - 1);
+    nodelist_set(&list, i - 1, nodelist_get(&list, j));
+    nodelist_set(&list, j, t);
+  }
+
+  crossings_t c = crossings_new(&list, g);
+  int crossings = count_all_crossings(&c);
+  assert(crossings == count_pairs(&c));
+
+  for (int trial = 0; trial < 50; ++trial) {
+    Agnode_t *cur = nodelist_get(&list, next_random(&seed) % c.n);
+    const size_t x = (size_t)POSITION(cur);
+    Agedge_t *e = agfstedge(g, cur);
+    Agnode_t *neighbor = agtail(e) == cur ? aghead(e) : agtail(e);
+    const int j = (int)(next_random(&seed) % 2);
+
+    const int rest = crossings - node_cost(&c, x, c.pos[x]);
+    const size_t gap =
+        pos_without(&c, x, (size_t)POSITION(neighbor)) + (size_t)j;
+    const int predicted = rest + node_cost(&c, x, gap);
+
+    insertNodelist(&list, cur, neighbor, j);
+    crossings_sync(&c, &list);
+    crossings = count_all_crossings(&c);
+    assert(crossings == predicted);
+    assert(crossings == count_pairs(&c));
+  }
+
+  crossings_free(&c);
+  nodelist_free(&list);
+  free_block(g);
+}
+
+static void test_crossings(void) {
+  check_block(3, 0, 1);
+  check_block(8, 6, 2);
+  check_block(10, 30, 3);
+  check_block(40, 60, 4);
+  check_block(100, 150, 5);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(crossings);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
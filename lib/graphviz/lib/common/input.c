@@ -530,7 +530,10 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	    agsetfile(fn ? fn : "<stdin>");
 	    oldfp = fp;
 	}
-	g = agread(fp,NULL);
+	if (agisbin(fp))
+	    g = agreadbin(fp, NULL);
+	else
+	    g = agread(fp,NULL);
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
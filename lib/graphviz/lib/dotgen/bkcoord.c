@@ -0,0 +1,602 @@
+/// @file
+/// @brief Brandes–Köpf horizontal coordinate assignment
+///
+/// An alternative to positioning nodes by network simplex on the auxiliary
+/// constraint graph, selected with `xalgo=bk`. Following U. Brandes and
+/// B. Köpf, “Fast and Simple Horizontal Coordinate Assignment”, each node is
+/// aligned with a median neighbor in four ways: with its upper or its lower
+/// neighbors, scanning ranks leftwards or rightwards. Aligned nodes form
+/// vertical blocks, which are compacted against each other by a longest path
+/// pass over a graph of minimum separations. The four results are aligned to
+/// the narrowest, and each node is placed at the average of its two median
+/// coordinates. A few sweeps then pull nodes towards their neighbors, which
+/// undoes some of the spread that rigid blocks cause. All of this takes time
+/// linear in the size of the fast graph.
+///
+/// Edge weights, ports and `group` are not taken into account. Graphs with
+/// clusters, labeled flat edges or `ratio=compress` are left to network
+/// simplex.
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <assert.h>
+#include <dotgen/dot.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+
+/// a minimum separation between two nodes of a rank
+typedef struct {
+    size_t left;  ///< index of the node on the left
+    size_t right; ///< index of the node on the right
+    double sep;   ///< least distance between their centers
+} flatsep_t;
+
+DEFINE_LIST(flatseps, flatsep_t)
+
+/// number of passes over the ranks made by `refine`
+enum { REFINE_SWEEPS = 8 };
+
+/// the fast graph with its nodes numbered rank by rank, left to right
+typedef struct {
+    size_t n;           ///< number of nodes
+    node_t **node;      ///< node of each index
+    size_t *first;      ///< index of the first node of each node’s rank
+    size_t *last;       ///< index of the last node of each node’s rank
+    size_t *rank_first; ///< index of the first node of each rank, and `n`
+    int nranks;         ///< number of ranks
+
+    /// Edges between adjacent ranks. Edge `i` runs from `top[i]` down to
+    /// `bottom[i]`, and `marked[i]` is set if the edge crosses an inner segment.
+    size_t *top;
+    size_t *bottom;
+    bool *marked;
+    size_t *up_off;     ///< first entry of each node in `up`
+    size_t *up;         ///< edges to each node’s upper neighbors, left to right
+    size_t *down_off;   ///< first entry of each node in `down`
+    size_t *down;       ///< edges to each node’s lower neighbors, left to right
+
+    double *gap;        ///< separation from each node to its right neighbor
+    flatseps_t flat;    ///< separations between non-adjacent nodes
+} layering_t;
+
+/// scratch space, reused for each of the four layouts
+typedef struct {
+    size_t *root;     ///< root of each node’s block
+    size_t *align;    ///< next node in each node’s block, cyclically
+    size_t *off;      ///< first edge of each block in `adj`
+    size_t *adj;      ///< successor blocks in the separation graph
+    double *sep;      ///< separation from a block to each successor
+    size_t *indeg;    ///< number of unplaced predecessors of each block
+    size_t *topo;     ///< blocks in topological order
+    double *x;        ///< coordinate of each block
+} scratch_t;
+
+static void layering_free(layering_t *L) {
+    flatseps_free(&L->flat);
+    free(L->gap);
+    free(L->down);
+    free(L->down_off);
+    free(L->up);
+    free(L->up_off);
+    free(L->marked);
+    free(L->bottom);
+    free(L->top);
+    free(L->rank_first);
+    free(L->last);
+    free(L->first);
+    free(L->node);
+}
+
+/// index of a node, which must be in the layering
+static size_t idx(const layering_t *L, int r, node_t *v) {
+    const size_t i = L->rank_first[r] + (size_t)ND_order(v);
+    assert(L->node[i] == v);
+    return i;
+}
+
+/// build the edge lists in one direction, ordered by the far end
+static void build_adj(layering_t *L, size_t m, const size_t *near,
+                      const size_t *far, size_t **off, size_t **adj) {
+    *off = gv_calloc(L->n + 1, sizeof(size_t));
+    *adj = gv_calloc(m, sizeof(size_t));
+    size_t *fill = gv_calloc(L->n + 1, sizeof(size_t));
+    for (size_t i = 0; i < m; i++)
+	(*off)[near[i] + 1]++;
+    for (size_t v = 0; v < L->n; v++)
+	(*off)[v + 1] += (*off)[v];
+    // visiting edges in order of their far end sorts each list, as indices
+    // follow the left to right order within a rank
+    size_t *byfar = gv_calloc(m, sizeof(size_t));
+    for (size_t i = 0; i < m; i++)
+	fill[far[i] + 1]++;
+    for (size_t v = 0; v < L->n; v++)
+	fill[v + 1] += fill[v];
+    for (size_t i = 0; i < m; i++)
+	byfar[fill[far[i]]++] = i;
+    for (size_t v = 0; v < L->n; v++)
+	fill[v] = (*off)[v];
+    for (size_t k = 0; k < m; k++) {
+	const size_t i = byfar[k];
+	(*adj)[fill[near[i]]++] = i;
+    }
+    free(byfar);
+    free(fill);
+}
+
+/// separations between nodes of a rank, as made by `make_LR_constraints`
+static void make_gaps(graph_t *g, layering_t *L) {
+    int sep[2];
+    if (GD_has_labels(g->root) & EDGE_LABEL) {
+	sep[0] = GD_nodesep(g);
+	sep[1] = 5;
+    } else {
+	sep[1] = sep[0] = GD_nodesep(g);
+    }
+
+    L->gap = gv_calloc(L->n, sizeof(double));
+    for (int r = 0; r < L->nranks; r++) {
+	const int rank = GD_minrank(g) + r;
+	for (size_t i = L->rank_first[r]; i + 1 < L->rank_first[r + 1]; i++)
+	    L->gap[i] = ND_rw(L->node[i]) + ND_lw(L->node[i + 1]) + sep[rank & 1];
+    }
+
+    for (size_t i = 0; i < L->n; i++) {
+	node_t *u = L->node[i];
+	for (size_t k = 0; k < ND_flat_out(u).size; k++) {
+	    edge_t *e = ND_flat_out(u).list[k];
+	    node_t *t0 = agtail(e);
+	    node_t *h0 = aghead(e);
+	    if (ND_order(t0) > ND_order(h0)) {
+		node_t *tmp = t0;
+		t0 = h0;
+		h0 = tmp;
+	    }
+	    const int r = ND_rank(u) - GD_minrank(g);
+	    const size_t l = idx(L, r, t0);
+	    const size_t h = idx(L, r, h0);
+	    const double width = ND_rw(t0) + ND_lw(h0);
+	    double m0 = ED_minlen(e) * GD_nodesep(g) + width;
+	    if (h == l + 1) {
+		m0 = fmax(m0, width + GD_nodesep(g) + ROUND(ED_dist(e)));
+		L->gap[l] = fmax(L->gap[l], m0);
+	    } else if (h > l) {
+		flatseps_append(&L->flat,
+		                (flatsep_t){.left = l, .right = h, .sep = m0});
+	    }
+	}
+    }
+}
+
+static layering_t layering_new(graph_t *g) {
+    layering_t L = {0};
+    rank_t *rank = GD_rank(g);
+
+    L.nranks = GD_maxrank(g) - GD_minrank(g) + 1;
+    L.rank_first = gv_calloc((size_t)L.nranks + 1, sizeof(size_t));
+    for (int r = 0; r < L.nranks; r++)
+	L.rank_first[r + 1] = L.rank_first[r] + (size_t)rank[GD_minrank(g) + r].n;
+    L.n = L.rank_first[L.nranks];
+
+    L.node = gv_calloc(L.n, sizeof(node_t *));
+    L.first = gv_calloc(L.n, sizeof(size_t));
+    L.last = gv_calloc(L.n, sizeof(size_t));
+    size_t m = 0;
+    for (int r = 0; r < L.nranks; r++) {
+	for (size_t i = L.rank_first[r]; i < L.rank_first[r + 1]; i++) {
+	    node_t *v = rank[GD_minrank(g) + r].v[i - L.rank_first[r]];
+	    L.node[i] = v;
+	    L.first[i] = L.rank_first[r];
+	    L.last[i] = L.rank_first[r + 1] - 1;
+	    m += ND_out(v).size;
+	}
+    }
+
+    L.top = gv_calloc(m, sizeof(size_t));
+    L.bottom = gv_calloc(m, sizeof(size_t));
+    L.marked = gv_calloc(m, sizeof(bool));
+    m = 0;
+    for (int r = 0; r + 1 < L.nranks; r++) {
+	for (size_t i = L.rank_first[r]; i < L.rank_first[r + 1]; i++) {
+	    node_t *v = L.node[i];
+	    for (size_t k = 0; k < ND_out(v).size; k++) {
+		node_t *w = aghead(ND_out(v).list[k]);
+		if (ND_rank(w) != ND_rank(v) + 1)
+		    continue;
+		L.top[m] = i;
+		L.bottom[m] = idx(&L, r + 1, w);
+		m++;
+	    }
+	}
+    }
+    build_adj(&L, m, L.bottom, L.top, &L.up_off, &L.up);
+    build_adj(&L, m, L.top, L.bottom, &L.down_off, &L.down);
+
+    make_gaps(g, &L);
+    return L;
+}
+
+/// is this the lower end of an edge between two virtual nodes?
+static bool inner_segment(const layering_t *L, size_t v, size_t *upper) {
+    if (ND_node_type(L->node[v]) != VIRTUAL)
+	return false;
+    for (size_t k = L->up_off[v]; k < L->up_off[v + 1]; k++) {
+	const size_t u = L->top[L->up[k]];
+	if (ND_node_type(L->node[u]) == VIRTUAL) {
+	    *upper = u;
+	    return true;
+	}
+    }
+    return false;
+}
+
+/// mark edges that cross an inner segment, so alignment can ignore them and
+/// long edges stay straight (Brandes and Köpf, algorithm 1)
+static void mark_conflicts(layering_t *L) {
+    for (int r = 1; r < L->nranks; r++) {
+	const size_t lo = L->rank_first[r];
+	const size_t hi = L->rank_first[r + 1];
+	const size_t upper_first = L->rank_first[r - 1];
+	const size_t upper_n = lo - upper_first;
+	if (upper_n == 0)
+	    continue;
+	size_t k0 = 0;
+	size_t l = lo;
+	for (size_t l1 = lo; l1 < hi; l1++) {
+	    size_t upper;
+	    const bool inner = inner_segment(L, l1, &upper);
+	    if (l1 + 1 != hi && !inner)
+		continue;
+	    const size_t k1 = inner ? upper - upper_first : upper_n - 1;
+	    for (; l <= l1; l++) {
+		for (size_t k = L->up_off[l]; k < L->up_off[l + 1]; k++) {
+		    const size_t e = L->up[k];
+		    const size_t pos = L->top[e] - upper_first;
+		    if (pos < k0 || pos > k1) {
+			size_t other;
+			// inner segments are never marked
+			if (!(inner_segment(L, l, &other) && other == L->top[e]))
+			    L->marked[e] = true;
+		    }
+		}
+	    }
+	    k0 = k1;
+	}
+    }
+}
+
+/// lay out the graph in one of the four directions
+///
+/// @param downward Align nodes with their upper neighbors, working down the
+///   ranks, rather than with their lower neighbors, working up
+/// @param rightward Scan ranks from left to right, and compact to the left
+/// @param x [out] Coordinate of each node
+static void place(const layering_t *L, scratch_t *S, bool downward,
+                  bool rightward, double *x) {
+    const size_t n = L->n;
+    for (size_t v = 0; v < n; v++)
+	S->root[v] = S->align[v] = v;
+
+    // position of a node in the scan order of its rank
+    #define POS(v) (rightward ? (v) - L->first[v] : L->last[v] - (v))
+
+    // vertical alignment
+    for (int k = 1; k < L->nranks; k++) {
+	const int r = downward ? k : L->nranks - 1 - k;
+	const size_t lo = L->rank_first[r];
+	const size_t hi = L->rank_first[r + 1];
+	const size_t *nb_off = downward ? L->up_off : L->down_off;
+	const size_t *nb = downward ? L->up : L->down;
+	const size_t *far = downward ? L->top : L->bottom;
+	size_t bound = 0; // one past the position of the last aligned neighbor
+	for (size_t j = lo; j < hi; j++) {
+	    const size_t v = rightward ? j : lo + hi - 1 - j;
+	    const size_t d = nb_off[v + 1] - nb_off[v];
+	    if (d == 0)
+		continue;
+	    for (size_t m = (d - 1) / 2; m <= d / 2; m++) {
+		if (S->align[v] != v)
+		    break;
+		const size_t e = nb[nb_off[v] + (rightward ? m : d - 1 - m)];
+		const size_t u = far[e];
+		if (!L->marked[e] && bound <= POS(u)) {
+		    S->align[u] = v;
+		    S->root[v] = S->root[u];
+		    S->align[v] = S->root[v];
+		    bound = POS(u) + 1;
+		}
+	    }
+	}
+    }
+
+    // separation graph between blocks, directed in the scan order
+    size_t *off = S->off;
+    for (size_t v = 0; v <= n; v++)
+	off[v] = 0;
+    for (size_t v = 0; v < n; v++) {
+	if (v != L->last[v])
+	    off[S->root[rightward ? v : v + 1] + 1]++;
+    }
+    for (size_t i = 0; i < flatseps_size(&L->flat); i++) {
+	const flatsep_t f = flatseps_get(&L->flat, i);
+	off[S->root[rightward ? f.left : f.right] + 1]++;
+    }
+    for (size_t v = 0; v < n; v++)
+	off[v + 1] += off[v];
+    for (size_t v = 0; v < n; v++)
+	S->indeg[v] = off[v]; // fill pointer, for now
+    for (size_t v = 0; v < n; v++) {
+	if (v == L->last[v])
+	    continue;
+	const size_t a = S->root[rightward ? v : v + 1];
+	const size_t b = S->root[rightward ? v + 1 : v];
+	S->adj[S->indeg[a]] = b;
+	S->sep[S->indeg[a]++] = L->gap[v];
+    }
+    for (size_t i = 0; i < flatseps_size(&L->flat); i++) {
+	const flatsep_t f = flatseps_get(&L->flat, i);
+	const size_t a = S->root[rightward ? f.left : f.right];
+	const size_t b = S->root[rightward ? f.right : f.left];
+	S->adj[S->indeg[a]] = b;
+	S->sep[S->indeg[a]++] = f.sep;
+    }
+
+    // topological order of the blocks
+    for (size_t v = 0; v < n; v++)
+	S->indeg[v] = 0;
+    for (size_t i = 0; i < off[n]; i++)
+	S->indeg[S->adj[i]]++;
+    size_t head = 0, tail = 0;
+    size_t nroots = 0;
+    for (size_t v = 0; v < n; v++) {
+	if (S->root[v] != v)
+	    continue;
+	nroots++;
+	if (S->indeg[v] == 0)
+	    S->topo[tail++] = v;
+    }
+    while (head < tail) {
+	const size_t a = S->topo[head++];
+	for (size_t i = off[a]; i < off[a + 1]; i++) {
+	    if (--S->indeg[S->adj[i]] == 0)
+		S->topo[tail++] = S->adj[i];
+	}
+    }
+    const size_t nblocks = tail;
+    // blocks never cross, so separations cannot form a cycle
+    assert(nblocks == nroots);
+    (void)nroots;
+
+    // place each block as early as its predecessors allow, then pull it as
+    // late as its successors allow
+    for (size_t v = 0; v < n; v++)
+	S->x[v] = 0;
+    for (size_t k = 0; k < nblocks; k++) {
+	const size_t a = S->topo[k];
+	for (size_t i = off[a]; i < off[a + 1]; i++)
+	    S->x[S->adj[i]] = fmax(S->x[S->adj[i]], S->x[a] + S->sep[i]);
+    }
+    for (size_t k = nblocks; k-- > 0;) {
+	const size_t a = S->topo[k];
+	if (off[a] == off[a + 1])
+	    continue;
+	double least = HUGE_VAL;
+	for (size_t i = off[a]; i < off[a + 1]; i++)
+	    least = fmin(least, S->x[S->adj[i]] - S->sep[i]);
+	S->x[a] = fmax(S->x[a], least);
+    }
+
+    for (size_t v = 0; v < n; v++)
+	x[v] = rightward ? S->x[S->root[v]] : -S->x[S->root[v]];
+
+    #undef POS
+}
+
+static int cmp_double(const void *a, const void *b) {
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    if (x < y)
+	return -1;
+    if (x > y)
+	return 1;
+    return 0;
+}
+
+/* bk_unsupported:
+ * Return what in g needs the auxiliary graph, or NULL if nothing does.
+ */
+static const char *bk_unsupported(graph_t *g) {
+    if (GD_n_cluster(g) > 0)
+	return "clusters";
+    if (GD_drawing(g)->ratio_kind == R_COMPRESS
+	&& GD_drawing(g)->size.x * GD_drawing(g)->size.y > 1)
+	return "ratio=compress";
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (int i = 0; i < GD_rank(g)[r].n; i++) {
+	    if (ND_alg(GD_rank(g)[r].v[i]))
+		return "labels on flat edges";
+	}
+    }
+    return NULL;
+}
+
+
+/// least squares fit of a rank to targets, keeping the nodes apart
+///
+/// Minimizes the sum of `(x[i] - t[i])²` subject to `x[i + 1] - x[i] >= gap[i]`
+/// by pool adjacent violators: with `x[i] = y[i] + offset of i`, the
+/// constraints say `y` is nondecreasing, and each pool of violators takes the
+/// mean of its targets.
+static void fit_rank(size_t n, const double *gap, const double *t, double *x,
+                     double *mean, size_t *count) {
+    size_t pools = 0;
+    double c = 0;
+    for (size_t i = 0; i < n; i++) {
+	if (i > 0)
+	    c += gap[i - 1];
+	double m = t[i] - c;
+	size_t k = 1;
+	while (pools > 0 && mean[pools - 1] >= m) {
+	    pools--;
+	    m = (mean[pools] * (double)count[pools] + m * (double)k)
+	        / (double)(count[pools] + k);
+	    k += count[pools];
+	}
+	mean[pools] = m;
+	count[pools++] = k;
+    }
+    c = 0;
+    for (size_t p = 0, i = 0; p < pools; p++) {
+	for (size_t j = 0; j < count[p]; j++, i++) {
+	    if (i > 0)
+		c += gap[i - 1];
+	    x[i] = mean[p] + c;
+	}
+    }
+}
+
+/// move nodes towards the mean of their neighbors, a rank at a time
+///
+/// Blocks found by alignment are rigid, so a few long vertical blocks can hold
+/// the nodes between them far apart. Sweeping the ranks alternately downwards
+/// and upwards, each rank is refitted to where its neighbors would have it.
+/// Ranks with separations between non-adjacent nodes are left alone.
+static void refine(const layering_t *L, double *x) {
+    bool *fixed = gv_calloc((size_t)L->nranks, sizeof(bool));
+    for (size_t i = 0; i < flatseps_size(&L->flat); i++) {
+	const size_t v = flatseps_get(&L->flat, i).left;
+	for (int r = 0; r < L->nranks; r++) {
+	    if (L->rank_first[r] == L->first[v])
+		fixed[r] = true;
+	}
+    }
+    double *t = gv_calloc(L->n, sizeof(double));
+    double *mean = gv_calloc(L->n, sizeof(double));
+    size_t *count = gv_calloc(L->n, sizeof(size_t));
+    for (int s = 0; s < REFINE_SWEEPS; s++) {
+	const bool down = s % 2 == 0;
+	for (int k = 0; k < L->nranks; k++) {
+	    const int r = down ? k : L->nranks - 1 - k;
+	    if (fixed[r])
+		continue;
+	    const size_t lo = L->rank_first[r];
+	    const size_t hi = L->rank_first[r + 1];
+	    for (size_t v = lo; v < hi; v++) {
+		double sum = 0;
+		for (size_t i = L->up_off[v]; i < L->up_off[v + 1]; i++)
+		    sum += x[L->top[L->up[i]]];
+		for (size_t i = L->down_off[v]; i < L->down_off[v + 1]; i++)
+		    sum += x[L->bottom[L->down[i]]];
+		const size_t d = L->up_off[v + 1] - L->up_off[v]
+		               + L->down_off[v + 1] - L->down_off[v];
+		t[v] = d == 0 ? x[v] : sum / (double)d;
+	    }
+	    fit_rank(hi - lo, L->gap + lo, t + lo, x + lo, mean, count);
+	}
+    }
+    free(count);
+    free(mean);
+    free(t);
+    free(fixed);
+}
+
+bool dot_position_bk(graph_t *g) {
+    const char *unsupported = bk_unsupported(g);
+    if (unsupported != NULL) {
+	agwarningf("xalgo=bk does not support %s, using network simplex\n",
+	           unsupported);
+	return false;
+    }
+
+    // room for self loops, as in make_LR_constraints
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (int i = 0; i < GD_rank(g)[r].n; i++) {
+	    node_t *u = GD_rank(g)[r].v[i];
+	    edge_t *e;
+	    ND_mval(u) = ND_rw(u);
+	    if (ND_other(u).size > 0) {
+		double sw = 0; // self width
+		for (size_t k = 0; (e = ND_other(u).list[k]); k++) {
+		    if (agtail(e) == aghead(e))
+			sw += selfRightSpace(e);
+		}
+		ND_rw(u) += sw;
+	    }
+	}
+    }
+
+    layering_t L = layering_new(g);
+    mark_conflicts(&L);
+
+    const size_t n = L.n;
+    scratch_t S = {
+	.root = gv_calloc(n, sizeof(size_t)),
+	.align = gv_calloc(n, sizeof(size_t)),
+	.off = gv_calloc(n + 1, sizeof(size_t)),
+	.adj = gv_calloc(n + flatseps_size(&L.flat), sizeof(size_t)),
+	.sep = gv_calloc(n + flatseps_size(&L.flat), sizeof(double)),
+	.indeg = gv_calloc(n, sizeof(size_t)),
+	.topo = gv_calloc(n, sizeof(size_t)),
+	.x = gv_calloc(n, sizeof(double)),
+    };
+
+    double *xs[4];
+    double lo[4], hi[4];
+    size_t narrowest = 0;
+    for (size_t k = 0; k < 4; k++) {
+	xs[k] = gv_calloc(n, sizeof(double));
+	place(&L, &S, k < 2, k % 2 == 0, xs[k]);
+	lo[k] = HUGE_VAL;
+	hi[k] = -HUGE_VAL;
+	for (size_t v = 0; v < n; v++) {
+	    lo[k] = fmin(lo[k], xs[k][v] - ND_lw(L.node[v]));
+	    hi[k] = fmax(hi[k], xs[k][v] + ND_rw(L.node[v]));
+	}
+	if (hi[k] - lo[k] < hi[narrowest] - lo[narrowest])
+	    narrowest = k;
+    }
+
+    // align the layouts compacted to the left with the left side of the
+    // narrowest, and those compacted to the right with its right side
+    for (size_t k = 0; k < 4; k++) {
+	const double shift = k % 2 == 0 ? lo[narrowest] - lo[k]
+	                                : hi[narrowest] - hi[k];
+	for (size_t v = 0; v < n; v++)
+	    xs[k][v] += shift;
+    }
+
+    double least = HUGE_VAL;
+    for (size_t v = 0; v < n; v++) {
+	double c[4] = {xs[0][v], xs[1][v], xs[2][v], xs[3][v]};
+	qsort(c, 4, sizeof(c[0]), cmp_double);
+	S.x[v] = (c[1] + c[2]) / 2;
+    }
+    refine(&L, S.x);
+    for (size_t v = 0; v < n; v++)
+	least = fmin(least, S.x[v]);
+    for (size_t v = 0; v < n; v++)
+	ND_coord(L.node[v]).x = round(S.x[v] - least);
+
+    for (size_t k = 0; k < 4; k++)
+	free(xs[k]);
+    free(S.x);
+    free(S.topo);
+    free(S.indeg);
+    free(S.sep);
+    free(S.adj);
+    free(S.off);
+    free(S.align);
+    free(S.root);
+    layering_free(&L);
+    return true;
+}
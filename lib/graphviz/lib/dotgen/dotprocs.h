@@ -74,9 +74,14 @@ DEFINE_LIST(node_queue, Agnode_t *)
     extern void dot_concentrate(Agraph_t *);
     extern void dot_mincross(Agraph_t *);
     extern void dot_position(Agraph_t *);
+    extern bool dot_position_bk(Agraph_t *);
+    extern bool dot_prior_x(Agnode_t *, bool, double *);
     extern void dot_rank(Agraph_t *);
     extern void dot_sameports(Agraph_t *);
     extern void dot_splines(Agraph_t *);
+    extern void dot_warm_start(Agraph_t *);
+    extern void dot_warm_rank(Agraph_t *, int, int);
+    extern void dot_warm_xcoords(Agraph_t *);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@
 #include <cgraph/list.h>
 #include <dotgen/dot.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,6 +55,8 @@ static void init_mccomp(graph_t *g, size_t c);
 static void cleanup2(graph_t * g, int nc);
 static int mincross_clust(graph_t *g, ints_t *scratch);
 static int mincross(graph_t *g, int startpass, ints_t *scratch);
+static int mincross_warm(graph_t *g, ints_t *scratch);
+static void warm_order_components(graph_t *g);
 static void mincross_step(graph_t * g, int pass);
 static void mincross_options(graph_t * g);
 static void save_best(graph_t * g);
@@ -368,13 +371,16 @@ void dot_mincross(graph_t *g) {
     }
 
     init_mincross(g);
+    const bool warm = GD_flags(g) & WARM_START;
+    if (warm)
+	warm_order_components(g);
 
     ints_t scratch = {0};
 
     size_t comp;
     for (nc = 0, comp = 0; comp < GD_comp(g).size; comp++) {
 	init_mccomp(g, comp);
-	nc += mincross(g, 0, &scratch);
+	nc += warm ? mincross_warm(g, &scratch) : mincross(g, 0, &scratch);
     }
 
     merge2(g);
@@ -1293,6 +1299,112 @@ void build_ranks(graph_t *g, int pass, ints_t *scratch) {
     node_queue_free(&q);
 }
 
+/// a node, or the first node of a component, and the key to sort it by
+typedef struct {
+    node_t *n;
+    double key;
+    size_t seq; ///< position in the input, to break ties
+} warm_node_t;
+
+static int warmnodecmpf(const void *x, const void *y) {
+    const warm_node_t *a = x;
+    const warm_node_t *b = y;
+    if (ND_rank(a->n) != ND_rank(b->n))
+	return ND_rank(a->n) < ND_rank(b->n) ? -1 : 1;
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+static int warmcompcmpf(const void *x, const void *y) {
+    const warm_node_t *a = x;
+    const warm_node_t *b = y;
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+/* warm_order_components:
+ * With warmstart=true, put components in the order of the previous x
+ * coordinates of their leftmost nodes, so merge2 places them as before.
+ */
+static void warm_order_components(graph_t *g) {
+    const size_t size = GD_comp(g).size;
+    warm_node_t *comps = gv_calloc(size, sizeof(warm_node_t));
+    for (size_t c = 0; c < size; c++) {
+	comps[c] = (warm_node_t){.n = GD_comp(g).list[c], .key = HUGE_VAL,
+	                         .seq = c};
+	for (node_t *n = comps[c].n; n; n = ND_next(n)) {
+	    double x;
+	    if (dot_prior_x(n, false, &x) && x < comps[c].key)
+		comps[c].key = x;
+	}
+    }
+    qsort(comps, size, sizeof(comps[0]), warmcompcmpf);
+    for (size_t c = 0; c < size; c++)
+	GD_comp(g).list[c] = comps[c].n;
+    free(comps);
+}
+
+/* build_ranks_warm:
+ * Install the nodes of a component in the order of their previous x
+ * coordinates. A node without one follows the mean of its neighbors on the
+ * rank above, or goes at the end of its rank.
+ */
+static void build_ranks_warm(graph_t *g) {
+    size_t size = 0;
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n))
+	size++;
+    warm_node_t *nodes = gv_calloc(size, sizeof(warm_node_t));
+    size = 0;
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n)) {
+	nodes[size] = (warm_node_t){.n = n, .seq = size};
+	size++;
+    }
+
+    // sort by rank, so the neighbors above a node have keys before it does
+    qsort(nodes, size, sizeof(nodes[0]), warmnodecmpf);
+    for (size_t i = 0; i < size; i++) {
+	node_t *n = nodes[i].n;
+	double key;
+	if (!dot_prior_x(n, false, &key)) {
+	    double sum = 0;
+	    int count = 0;
+	    for (size_t j = 0; j < ND_in(n).size; j++) {
+		const double above = ND_mval(agtail(ND_in(n).list[j]));
+		if (above != HUGE_VAL) {
+		    sum += above;
+		    count++;
+		}
+	    }
+	    key = count > 0 ? sum / count : HUGE_VAL;
+	}
+	nodes[i].key = ND_mval(n) = key;
+    }
+    qsort(nodes, size, sizeof(nodes[0]), warmnodecmpf);
+
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	GD_rank(g)[r].n = 0;
+    for (size_t i = 0; i < size; i++)
+	install_in_rank(g, nodes[i].n);
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	GD_rank(Root)[r].valid = false;
+    free(nodes);
+}
+
+/* mincross_warm:
+ * With warmstart=true, start from the previous order and only make the swaps
+ * of neighbors that remove crossings, rather than searching from scratch.
+ */
+static int mincross_warm(graph_t *g, ints_t *scratch) {
+    build_ranks_warm(g);
+    flat_breakcycles(g);
+    flat_reorder(g);
+    if (ncross(scratch) > 0)
+	transpose(g, false);
+    return ncross(scratch);
+}
+
 void enqueue_neighbors(node_queue_t *q, node_t *n0, int pass) {
     edge_t *e;
 
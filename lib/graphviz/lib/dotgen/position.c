@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <util/alloc.h>
+#include <util/strcasecmp.h>
 
 static int nsiter2(graph_t * g);
 static void create_aux_edges(graph_t * g);
@@ -36,6 +37,7 @@ static void expand_leaves(graph_t * g);
 static void make_lrvn(graph_t * g);
 static void contain_nodes(graph_t * g);
 static bool idealsize(graph_t * g, double);
+static bool use_bk(graph_t * g);
 
 #if defined(DEBUG) && DEBUG > 1
 static void
@@ -132,7 +134,13 @@ void dot_position(graph_t *g) {
     expand_leaves(g);
     if (flat_edges(g))
 	set_ycoords(g);
+    if (use_bk(g) && dot_position_bk(g)) {
+	set_aspect(g);
+	return;
+    }
     create_aux_edges(g);
+    if (GD_flags(g) & WARM_START)
+	dot_warm_xcoords(g);
     if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
 	connectGraph (g);
 	const int rank_result = rank(g, 2, nsiter2(g));
@@ -146,6 +154,13 @@ void dot_position(graph_t *g) {
 				 */
 }
 
+/// has Brandes-Köpf positioning been asked for with `xalgo=bk`?
+static bool use_bk(graph_t * g)
+{
+    const char *s = agget(g, "xalgo");
+    return s != NULL && strcasecmp(s, "bk") == 0;
+}
+
 static int nsiter2(graph_t * g)
 {
     int maxiter = INT_MAX;
@@ -379,7 +379,10 @@ void rank1(graph_t * g)
 	maxiter = scale_clamp(agnnodes(g), atof(s));
     for (size_t c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
-	rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+	if (GD_flags(g) & WARM_START)
+	    dot_warm_rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);
+	else
+	    rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
     }
 }
 
@@ -447,6 +450,7 @@ static void dot1_rank(graph_t *g)
 }
 
 void dot_rank(graph_t *g) {
+    dot_warm_start(g);
     if (mapbool(agget(g, "newrank"))) {
 	GD_flags(g) |= NEW_RANK;
 	dot2_rank(g);
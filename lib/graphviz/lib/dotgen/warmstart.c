@@ -0,0 +1,419 @@
+/// @file
+/// @brief seeding a layout from a previous one, with `warmstart=true`
+///
+/// When a graph is laid out again after a small edit, starting from scratch
+/// throws away the previous ranks and orders, so the drawing can change far
+/// from the edit and each phase repeats all of its work. Instead, the `pos` of
+/// each node, as written by an earlier run of dot, is used as the starting
+/// point of each phase: ranks are seeded from the previous rank of each node,
+/// mincross starts from the previous order and only tries swaps of neighbors,
+/// and x coordinates are seeded from the previous ones.
+///
+/// Network simplex accepts any feasible starting solution. A seed may violate
+/// the constraints of the edited graph, so it is repaired by a longest path
+/// pass that only ever moves a node away from its predecessors. Nodes without
+/// a previous position take the smallest or largest value that the nodes
+/// around them allow. As many solutions are often optimal, each node is also
+/// held at its previous value by edges of small weight, so that ties are
+/// settled in favor of the previous layout.
+///
+/// Graphs with clusters, and `newrank=true`, are laid out from scratch.
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <dotgen/dot.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+#include <util/unreachable.h>
+
+DEFINE_LIST(nodes, node_t *)
+
+/// largest difference in the previous coordinates of two nodes of one rank
+static const double RANK_TOLERANCE = 1.0;
+
+/// clusters are only found while ranking, so look for them here
+static bool has_clusters(graph_t *g) {
+    for (graph_t *subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
+	if (is_a_cluster(subg) || has_clusters(subg))
+	    return true;
+    }
+    return false;
+}
+
+static const char *warm_unsupported(graph_t *g) {
+    if (has_clusters(g))
+	return "clusters";
+    if (mapbool(agget(g, "newrank")))
+	return "newrank";
+    return NULL;
+}
+
+void dot_warm_start(graph_t *g) {
+    if (!mapbool(agget(g, "warmstart")))
+	return;
+    const char *unsupported = warm_unsupported(g);
+    if (unsupported != NULL) {
+	agwarningf("warmstart does not support %s, laying out from scratch\n",
+	           unsupported);
+	return;
+    }
+    GD_flags(g) |= WARM_START;
+}
+
+/// undo the rotation of `translate_drawing`
+///
+/// This gives a coordinate `rank` that grows from one rank to the next, and
+/// the x coordinate that positioning assigns.
+static void unrotate(graph_t *g, double px, double py, double *rank,
+                     double *x) {
+    switch (GD_rankdir(g)) {
+    case RANKDIR_TB:
+	*rank = -py;
+	*x = px;
+	break;
+    case RANKDIR_LR:
+	*rank = px;
+	*x = py;
+	break;
+    case RANKDIR_BT:
+	*rank = py;
+	*x = px;
+	break;
+    case RANKDIR_RL:
+	*rank = -px;
+	*x = py;
+	break;
+    default:
+	UNREACHABLE();
+    }
+}
+
+/// the position of a real node in the previous layout
+static bool prior_pos(node_t *n, double *rank, double *x) {
+    if (ND_node_type(n) != NORMAL)
+	return false;
+    const char *pos = agget(n, "pos");
+    double px, py;
+    if (pos == NULL || sscanf(pos, "%lf,%lf", &px, &py) != 2)
+	return false;
+    unrotate(agroot(n), px, py, rank, x);
+    return true;
+}
+
+/// where the previous spline of an edge crossed the rank coordinate `rank`
+///
+/// The control points of the spline are taken as a polyline, which is close
+/// enough to order the nodes of a rank.
+static bool spline_x(edge_t *e, double rank, double *x) {
+    while (ED_to_orig(e))
+	e = ED_to_orig(e);
+    if (ED_edge_type(e) != NORMAL)
+	return false;
+    const char *pos = agget(e, "pos");
+    if (pos == NULL)
+	return false;
+
+    bool have_prev = false;
+    double prev_rank = 0, prev_x = 0;
+    for (const char *p = pos; *p != '\0';) {
+	double px, py;
+	int used;
+	if (sscanf(p, " %lf,%lf%n", &px, &py, &used) == 2) {
+	    double r, cx;
+	    unrotate(agroot(e), px, py, &r, &cx);
+	    if (have_prev && (prev_rank - rank) * (r - rank) <= 0 &&
+	        prev_rank != r) {
+		*x = prev_x + (cx - prev_x) * (rank - prev_rank) / (r - prev_rank);
+		return true;
+	    }
+	    have_prev = true;
+	    prev_rank = r;
+	    prev_x = cx;
+	    p += used;
+	}
+	// skip anything else, such as the end points of arrowheads
+	p += strcspn(p, " ");
+	p += strspn(p, " ");
+    }
+    return false;
+}
+
+bool dot_prior_x(node_t *n, bool aux, double *x) {
+    if (ND_node_type(n) == NORMAL) {
+	double rank;
+	return prior_pos(n, &rank, x);
+    }
+    if (ND_node_type(n) != VIRTUAL)
+	return false;
+
+    // find the real nodes at the ends of a chain
+    node_t *top = n, *bottom = n;
+    int above = 0, below = 0;
+    for (; ND_node_type(top) == VIRTUAL; ++above) {
+	const elist in = aux ? ND_save_in(top) : ND_in(top);
+	if (in.size != 1)
+	    return false;
+	top = agtail(in.list[0]);
+    }
+    for (; ND_node_type(bottom) == VIRTUAL; ++below) {
+	const elist out = aux ? ND_save_out(bottom) : ND_out(bottom);
+	if (out.size != 1)
+	    return false;
+	bottom = aghead(out.list[0]);
+    }
+    double rank0, x0, rank1, x1;
+    if (!prior_pos(top, &rank0, &x0) || !prior_pos(bottom, &rank1, &x1))
+	return false;
+
+    // follow the previous route of the edge if there is one, or else
+    // interpolate between its ends
+    const double t = (double)above / (above + below);
+    const elist out = aux ? ND_save_out(n) : ND_out(n);
+    if (spline_x(out.list[0], rank0 + (rank1 - rank0) * t, x))
+	return true;
+    *x = x0 + (x1 - x0) * t;
+    return true;
+}
+
+/// weight of the edges that hold a node at its previous value
+enum { ANCHOR_WEIGHT = 1 };
+
+/// previous values of `ND_rank`, for ranking or for x coordinates
+typedef struct {
+    /// the previous value of a node, if it has one
+    bool (*prior)(node_t *n, const void *context, int *value);
+    const void *context;
+    node_t *origin;   ///< node that anchored nodes are held relative to
+    int origin_value; ///< previous value of `origin`
+    nodes_t added;    ///< nodes made for anchors, including `origin`
+} seeds_t;
+
+static bool seed(const seeds_t *seeds, node_t *n, int *value) {
+    if (n == seeds->origin) {
+	*value = seeds->origin_value;
+	return true;
+    }
+    return seeds->prior(n, seeds->context, value);
+}
+
+/* add_anchors:
+ * Network simplex is free to pick any of many optimal solutions, so without
+ * more constraints even an unchanged graph could move. Hold each real node
+ * that has a previous value at its previous offset from a new origin node,
+ * by a pair of edges from a slack node like those of make_edge_pairs.
+ */
+static void add_anchors(graph_t *g, seeds_t *seeds) {
+    int least = INT_MAX;
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n)) {
+	int value;
+	if (ND_node_type(n) == NORMAL && seeds->prior(n, seeds->context, &value))
+	    least = MIN(least, value);
+    }
+    if (least == INT_MAX)
+	return;
+
+    seeds->origin = virtual_node(g);
+    ND_node_type(seeds->origin) = SLACKNODE;
+    seeds->origin_value = least;
+    nodes_append(&seeds->added, seeds->origin);
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n)) {
+	int value;
+	if (ND_node_type(n) != NORMAL || !seeds->prior(n, seeds->context, &value))
+	    continue;
+	node_t *sn = virtual_node(g);
+	ND_node_type(sn) = SLACKNODE;
+	nodes_append(&seeds->added, sn);
+	make_aux_edge(sn, seeds->origin, 0, ANCHOR_WEIGHT);
+	make_aux_edge(sn, n, value - least, ANCHOR_WEIGHT);
+    }
+}
+
+/// remove the nodes and edges made by `add_anchors`
+static void remove_anchors(graph_t *g, seeds_t *seeds) {
+    // the edges of every slack node lead into `origin`, so all edges go before
+    // any node is freed
+    for (size_t i = 0; i < nodes_size(&seeds->added); i++) {
+	node_t *n = nodes_get(&seeds->added, i);
+	edge_t *e;
+	while ((e = ND_out(n).list[0])) {
+	    delete_fast_edge(e);
+	    free(e->base.data);
+	    free(e);
+	}
+    }
+    for (size_t i = 0; i < nodes_size(&seeds->added); i++) {
+	node_t *n = nodes_get(&seeds->added, i);
+	delete_fast_node(g, n);
+	free_list(ND_in(n));
+	free_list(ND_out(n));
+	free(n->base.data);
+	free(n);
+    }
+    nodes_free(&seeds->added);
+    seeds->origin = NULL;
+}
+
+/* seed_feasible:
+ * Set ND_rank of the nodes of GD_nlist(g) to a feasible solution for network
+ * simplex that is close to seeds. In topological order, each node goes to its
+ * seed, or further if one of its edges needs it. Nodes that have neither a
+ * seed nor a placed predecessor then go as far as their successors allow, in
+ * reverse order. Returns false, without changing ND_rank, if the graph has
+ * a cycle.
+ */
+static bool seed_feasible(graph_t *g, const seeds_t *seeds) {
+    nodes_t order = {0};
+    size_t n_nodes = 0;
+    edge_t *e;
+
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_priority(n) = 0;
+	for (size_t i = 0; ND_in(n).list[i]; i++)
+	    ND_priority(n)++;
+	if (ND_priority(n) == 0)
+	    nodes_append(&order, n);
+	n_nodes++;
+    }
+    for (size_t k = 0; k < nodes_size(&order); k++) {
+	node_t *n = nodes_get(&order, k);
+	for (size_t i = 0; (e = ND_out(n).list[i]); i++) {
+	    if (--ND_priority(aghead(e)) == 0)
+		nodes_append(&order, aghead(e));
+	}
+    }
+    if (nodes_size(&order) != n_nodes) {
+	nodes_free(&order);
+	return false;
+    }
+
+    for (size_t k = 0; k < n_nodes; k++) {
+	node_t *n = nodes_get(&order, k);
+	int value;
+	bool placed = seed(seeds, n, &value);
+	for (size_t i = 0; (e = ND_in(n).list[i]); i++) {
+	    if (!ND_mark(agtail(e)))
+		continue;
+	    const int least = ND_rank(agtail(e)) + ED_minlen(e);
+	    if (!placed || least > value)
+		value = least;
+	    placed = true;
+	}
+	ND_mark(n) = placed;
+	if (placed)
+	    ND_rank(n) = value;
+    }
+    for (size_t k = n_nodes; k-- > 0;) {
+	node_t *n = nodes_get(&order, k);
+	if (ND_mark(n))
+	    continue;
+	int value = 0;
+	for (size_t i = 0; (e = ND_out(n).list[i]); i++) {
+	    const int most = ND_rank(aghead(e)) - ED_minlen(e);
+	    if (i == 0 || most < value)
+		value = most;
+	}
+	ND_rank(n) = value;
+	ND_mark(n) = true;
+    }
+
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n))
+	ND_mark(n) = false;
+    nodes_free(&order);
+    return true;
+}
+
+/// the distinct previous rank coordinates of a component, and their ranks
+typedef struct {
+    double *coord; ///< sorted previous rank coordinates of nodes
+    int *rank;     ///< rank of each coordinate, counting from 0
+    size_t size;
+} rank_table_t;
+
+static int cmp_double(const void *x, const void *y) {
+    const double a = *(const double *)x;
+    const double b = *(const double *)y;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static bool prior_rank(node_t *n, const void *context, int *value) {
+    const rank_table_t *table = context;
+    double coord, x;
+    if (!prior_pos(n, &coord, &x))
+	return false;
+    const double *found = bsearch(&coord, table->coord, table->size,
+                                  sizeof(table->coord[0]), cmp_double);
+    if (found == NULL)
+	return false;
+    *value = table->rank[found - table->coord];
+    return true;
+}
+
+void dot_warm_rank(graph_t *g, int balance, int maxiter) {
+    rank_table_t table = {0};
+    size_t n_nodes = 0;
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n))
+	n_nodes++;
+    table.coord = gv_calloc(n_nodes, sizeof(table.coord[0]));
+    table.rank = gv_calloc(n_nodes, sizeof(table.rank[0]));
+
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n)) {
+	double x;
+	if (prior_pos(n, &table.coord[table.size], &x))
+	    table.size++;
+    }
+    qsort(table.coord, table.size, sizeof(table.coord[0]), cmp_double);
+
+    // nodes of a previous rank share a coordinate, give or take rounding
+    for (size_t i = 1; i < table.size; i++) {
+	table.rank[i] = table.rank[i - 1];
+	if (table.coord[i] - table.coord[i - 1] > RANK_TOLERANCE)
+	    table.rank[i]++;
+    }
+
+    seeds_t seeds = {.prior = prior_rank, .context = &table};
+    add_anchors(g, &seeds);
+    (void)seed_feasible(g, &seeds);
+    rank(g, balance, maxiter);
+    remove_anchors(g, &seeds);
+
+    // the slack nodes of anchors may have been below every other node
+    int least = INT_MAX;
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n))
+	least = MIN(least, ND_rank(n));
+    for (node_t *n = GD_nlist(g); n; n = ND_next(n))
+	ND_rank(n) -= least;
+
+    free(table.rank);
+    free(table.coord);
+}
+
+static bool prior_x(node_t *n, const void *context, int *value) {
+    (void)context;
+    double x;
+    if (!dot_prior_x(n, true, &x))
+	return false;
+    *value = (int)lround(x);
+    return true;
+}
+
+void dot_warm_xcoords(graph_t *g) {
+    seeds_t seeds = {.prior = prior_x};
+    add_anchors(g, &seeds);
+    (void)seed_feasible(g, &seeds);
+    // the nodes of anchors are slack nodes, removed by remove_aux_edges
+    nodes_free(&seeds.added);
+}
@@ -8,6 +8,7 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <cgraph/list.h>
 #include <sparse/general.h>
 #include <math.h>
 #include <stdbool.h>
@@ -21,24 +22,19 @@
 #include <sparse/QuadTree.h>
 #include <util/alloc.h>
 
-static int splines_intersect(size_t dim,
-			     double cos_critical, int check_edges_with_same_endpoint, 
-			     char *xsplines1, char *xsplines2){
-  /* cos_critical: cos of critical angle
-     check_edges_with_same_endpoint: whether need to treat two splines from
-     .     the same end point specially in ignoring splines that exit/enter the same end pont at around 180
-     xsplines1,xsplines2: the first and second splines corresponding to two edges
+/// an edge route, as the control points of its splines
+typedef struct {
+  double *x; ///< coordinates, dim per point
+  size_t n;  ///< number of points
+} route_t;
 
-  */
-  size_t len1 = 100, len2 = 100;
-  size_t ns1 = 0, ns2 = 0;
-  int iter1 = 0, iter2 = 0;
-  double cos_a, tmp[2];
-  int endp1 = 0, endp2 = 0;
-
-  tmp[0] = tmp[1] = 0;
-  double *x1 = gv_calloc(len1, sizeof(double));
-  double *x2 = gv_calloc(len2, sizeof(double));
+static route_t parse_splines(size_t dim, char *xsplines) {
+  size_t len = 100;
+  size_t ns = 0;
+  int iter = 0;
+  double tmp[2] = {0};
+  int endp = 0;
+  double *x = gv_calloc(len, sizeof(double));
 
   assert(dim <= 3);
 
@@ -47,96 +43,238 @@ static int splines_intersect(size_t dim,
      2. of the form "e,x,y" followed by 3n points, where x,y is really padded to the end of the 3n points
      3. of the form "s,x,y" followed by 3n points, where x,y is padded to the start of the 3n points
   */
-  if (xsplines1){
-    if(strstr(xsplines1, "e,")){
-      endp1 = 1;
-      xsplines1 = strstr(xsplines1, "e,") + 2;
-    } else if (strstr(xsplines1, "s,")){
-      xsplines1 = strstr(xsplines1, "s,") + 2;
+  if (xsplines){
+    if(strstr(xsplines, "e,")){
+      endp = 1;
+      xsplines = strstr(xsplines, "e,") + 2;
+    } else if (strstr(xsplines, "s,")){
+      xsplines = strstr(xsplines, "s,") + 2;
     }
   }
-  while (xsplines1 && sscanf(xsplines1,"%lf,%lf", &(x1[ns1*dim]), &x1[ns1*dim + 1]) == 2){
-    if (endp1 && iter1 == 0){
-      tmp[0] = x1[ns1*dim]; tmp[1] = x1[ns1*dim + 1];
+  while (xsplines && sscanf(xsplines,"%lf,%lf", &(x[ns*dim]), &x[ns*dim + 1]) == 2){
+    if (endp && iter == 0){
+      tmp[0] = x[ns*dim]; tmp[1] = x[ns*dim + 1];
     } else {
-      ns1++;
+      ns++;
     }
-    iter1++;
-    xsplines1 = strchr(xsplines1, ' ');
-    if (!xsplines1) break;
-    xsplines1++;
-    if (ns1*dim >= len1){
-      size_t new_len1 = ns1 * dim + MAX(10u, ns1 * dim / 5);
-      x1 = gv_recalloc(x1, len1, new_len1, sizeof(double));
-      len1 = new_len1;
+    iter++;
+    xsplines = strchr(xsplines, ' ');
+    if (!xsplines) break;
+    xsplines++;
+    if (ns*dim >= len){
+      size_t new_len = ns * dim + MAX(10u, ns * dim / 5);
+      x = gv_recalloc(x, len, new_len, sizeof(double));
+      len = new_len;
     }
   }
-  if (endp1){/* pad the end point at the last position */
-    ns1++;
-    if (ns1*dim >= len1){
-      size_t new_len1 = ns1 * dim + MAX(10u, ns1 * dim / 5);
-      x1 = gv_recalloc(x1, len1, new_len1, sizeof(double));
-      len1 = new_len1;
+  if (endp){/* pad the end point at the last position */
+    ns++;
+    if (ns*dim >= len){
+      size_t new_len = ns * dim + MAX(10u, ns * dim / 5);
+      x = gv_recalloc(x, len, new_len, sizeof(double));
+      len = new_len;
     }
-    x1[(ns1-1)*dim] = tmp[0];  x1[(ns1-1)*dim + 1] = tmp[1]; 
+    x[(ns-1)*dim] = tmp[0];  x[(ns-1)*dim + 1] = tmp[1]; 
   }
 
+  return (route_t){.x = x, .n = ns};
+}
+
+static int splines_intersect(size_t dim,
+			     double cos_critical, int check_edges_with_same_endpoint, 
+			     const route_t *route1, const route_t *route2){
+  /* cos_critical: cos of critical angle
+     check_edges_with_same_endpoint: whether need to treat two splines from
+     .     the same end point specially in ignoring splines that exit/enter the same end pont at around 180
+     route1,route2: the first and second splines corresponding to two edges
 
-  /* splines could be a list of 
-     1. 3n points
-     2. of the form "e,x,y" followed by 3n points, where x,y is really padded to the end of the 3n points
-     3. of the form "s,x,y" followed by 3n points, where x,y is padded to the start of the 3n points
   */
-  if (xsplines2){
-    if(strstr(xsplines2, "e,")){
-      endp2 = 1;
-      xsplines2 = strstr(xsplines2, "e,") + 2;
-    } else if (strstr(xsplines2, "s,")){
-      xsplines2 = strstr(xsplines2, "s,") + 2;
+  double cos_a;
+  double *x1 = route1->x, *x2 = route2->x;
+
+  for (size_t i = 0; i + 1 < route1->n; i++) {
+    for (size_t j = 0; j + 1 < route2->n; j++) {
+      cos_a = intersection_angle(&(x1[dim*i]), &(x1[dim*(i + 1)]), &(x2[dim*j]), &(x2[dim*(j+1)]));
+      if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = fabs(cos_a);
+      if (cos_a > cos_critical) {
+	return 1;
+      }
+
     }
   }
-  while (xsplines2 && sscanf(xsplines2,"%lf,%lf", &(x2[ns2*dim]), &x2[ns2*dim + 1]) == 2){
-    if (endp2 && iter2 == 0){
-      tmp[0] = x2[ns2*dim]; tmp[1] = x2[ns2*dim + 1];
+
+  return 0;
+}
+
+/* Broad phase of edge collision detection.
+ * Two segments are only ever reported as conflicting by intersection_angle if
+ * they cross or come within INTERSECTION_CLOSE of the longer one's length.
+ * Growing the bounding box of every segment by that fraction of its own
+ * length, two edges can then only conflict if their boxes overlap.
+ */
+typedef struct {
+  double ll[2], ur[2];
+} bbox_t;
+
+/// bounding box of segment p--q, grown by how close another may come to it
+static bbox_t segment_box(const double *p, const double *q) {
+  const double margin = INTERSECTION_CLOSE * hypot(q[0] - p[0], q[1] - p[1]);
+  bbox_t b;
+  for (int k = 0; k < 2; k++) {
+    b.ll[k] = MIN(p[k], q[k]) - margin;
+    b.ur[k] = MAX(p[k], q[k]) + margin;
+  }
+  return b;
+}
+
+static void box_merge(bbox_t *b, const bbox_t *other) {
+  for (int k = 0; k < 2; k++) {
+    b->ll[k] = MIN(b->ll[k], other->ll[k]);
+    b->ur[k] = MAX(b->ur[k], other->ur[k]);
+  }
+}
+
+static bbox_t route_box(size_t dim, const route_t *route) {
+  bbox_t b = {{0, 0}, {0, 0}};
+  for (size_t i = 0; i + 1 < route->n; i++) {
+    const bbox_t s = segment_box(&route->x[dim * i], &route->x[dim * (i + 1)]);
+    if (i == 0) {
+      b = s;
     } else {
-      ns2++;
+      box_merge(&b, &s);
     }
-    iter2++;
-    xsplines2 = strchr(xsplines2, ' ');
-    if (!xsplines2) break;
-    xsplines2++;
-    if (ns2*dim >= len2){
-      size_t new_len2 = ns2 * dim + MAX(10u, ns2 * dim / 5);
-      x2 = gv_recalloc(x2, len2, new_len2, sizeof(double));
-      len2 = new_len2;
+  }
+  return b;
+}
+
+static bool box_overlap(const bbox_t *a, const bbox_t *b) {
+  return a->ll[0] <= b->ur[0] && b->ll[0] <= a->ur[0] &&
+         a->ll[1] <= b->ur[1] && b->ll[1] <= a->ur[1];
+}
+
+typedef struct {
+  int i, j;
+} edge_pair_t;
+
+DEFINE_LIST(edge_pairs, edge_pair_t)
+
+static int edge_pair_cmp(const edge_pair_t *a, const edge_pair_t *b) {
+  if (a->i != b->i)
+    return a->i < b->i ? -1 : 1;
+  return a->j < b->j ? -1 : a->j > b->j;
+}
+
+/// boxes covering more grid cells than this are tested against every box
+#define GRID_BIG_BOX 64
+
+/// cell of a uniform grid, with origin o and cell size h, holding coordinate v
+static size_t grid_cell(double v, double o, double h, size_t cells) {
+  const double c = (v - o) / h;
+  if (!(c > 0))
+    return 0;
+  return MIN((size_t)c, cells - 1);
+}
+
+/* overlapping_boxes:
+ * Return every pair i < j of overlapping boxes, in increasing order.
+ * Boxes are put into each cell of a uniform grid they cover, and only
+ * boxes sharing a cell are compared. A pair sharing several cells is only
+ * reported from the cell holding the lower left corner of their overlap.
+ * The few boxes much larger than a cell are compared against all others.
+ */
+static edge_pairs_t overlapping_boxes(int n, const bbox_t *boxes) {
+  edge_pairs_t pairs = {0};
+  if (n < 2)
+    return pairs;
+
+  bbox_t all = boxes[0];
+  double extent = 0;
+  for (int i = 0; i < n; i++) {
+    box_merge(&all, &boxes[i]);
+    extent += MAX(boxes[i].ur[0] - boxes[i].ll[0], boxes[i].ur[1] - boxes[i].ll[1]);
+  }
+  const double width = all.ur[0] - all.ll[0];
+  const double height = all.ur[1] - all.ll[1];
+
+  /* cells about the size of an average box, but not many more than boxes */
+  double h = extent / n;
+  h = MAX(h, sqrt(width * height / (4.0 * n)));
+  h = MAX(h, MAX(width, height) / 1024);
+  if (!(h > 0))
+    h = 1;
+  const size_t gx = (size_t)(width / h) + 1;
+  const size_t gy = (size_t)(height / h) + 1;
+
+  size_t *start = gv_calloc(gx * gy + 1, sizeof(size_t));
+  bool *big = gv_calloc((size_t)n, sizeof(bool));
+  for (int i = 0; i < n; i++) {
+    const size_t x0 = grid_cell(boxes[i].ll[0], all.ll[0], h, gx);
+    const size_t x1 = grid_cell(boxes[i].ur[0], all.ll[0], h, gx);
+    const size_t y0 = grid_cell(boxes[i].ll[1], all.ll[1], h, gy);
+    const size_t y1 = grid_cell(boxes[i].ur[1], all.ll[1], h, gy);
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) > GRID_BIG_BOX) {
+      big[i] = true;
+      continue;
+    }
+    for (size_t y = y0; y <= y1; y++) {
+      for (size_t x = x0; x <= x1; x++) {
+        start[y * gx + x + 1]++;
+      }
     }
   }
-  if (endp2){/* pad the end point at the last position */
-    ns2++;
-    if (ns2*dim >= len2){
-      size_t new_len2 = ns2 * dim + MAX(10u, ns2 * dim / 5);
-      x2 = gv_recalloc(x2, len2, new_len2, sizeof(double));
-      len2 = new_len2;
+  for (size_t c = 0; c < gx * gy; c++)
+    start[c + 1] += start[c];
+
+  /* filled in increasing box order, so each cell lists i before j */
+  int *cell = gv_calloc(start[gx * gy], sizeof(int));
+  size_t *fill = gv_calloc(gx * gy, sizeof(size_t));
+  for (int i = 0; i < n; i++) {
+    if (big[i])
+      continue;
+    const size_t x0 = grid_cell(boxes[i].ll[0], all.ll[0], h, gx);
+    const size_t x1 = grid_cell(boxes[i].ur[0], all.ll[0], h, gx);
+    const size_t y0 = grid_cell(boxes[i].ll[1], all.ll[1], h, gy);
+    const size_t y1 = grid_cell(boxes[i].ur[1], all.ll[1], h, gy);
+    for (size_t y = y0; y <= y1; y++) {
+      for (size_t x = x0; x <= x1; x++) {
+        const size_t c = y * gx + x;
+        cell[start[c] + fill[c]++] = i;
+      }
     }
-    x2[(ns2-1)*dim] = tmp[0];  x2[(ns2-1)*dim + 1] = tmp[1]; 
   }
+  free(fill);
 
-  for (size_t i = 0; i < ns1 - 1; i++) {
-    for (size_t j = 0; j < ns2 - 1; j++) {
-      cos_a = intersection_angle(&(x1[dim*i]), &(x1[dim*(i + 1)]), &(x2[dim*j]), &(x2[dim*(j+1)]));
-      if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = fabs(cos_a);
-      if (cos_a > cos_critical) {
-	free(x1);
-	free(x2);
-	return 1;
+  for (size_t c = 0; c < gx * gy; c++) {
+    for (size_t a = start[c]; a < start[c + 1]; a++) {
+      const bbox_t *ba = &boxes[cell[a]];
+      for (size_t b = a + 1; b < start[c + 1]; b++) {
+        const bbox_t *bb = &boxes[cell[b]];
+        if (!box_overlap(ba, bb))
+          continue;
+        const size_t x = grid_cell(MAX(ba->ll[0], bb->ll[0]), all.ll[0], h, gx);
+        const size_t y = grid_cell(MAX(ba->ll[1], bb->ll[1]), all.ll[1], h, gy);
+        if (y * gx + x == c)
+          edge_pairs_append(&pairs, (edge_pair_t){cell[a], cell[b]});
       }
+    }
+  }
 
+  for (int i = 0; i < n; i++) {
+    if (!big[i])
+      continue;
+    for (int j = 0; j < n; j++) {
+      if (j == i || (big[j] && j < i))
+        continue;
+      if (box_overlap(&boxes[i], &boxes[j]))
+        edge_pairs_append(&pairs, (edge_pair_t){MIN(i, j), MAX(i, j)});
     }
   }
 
-  free(x1);
-  free(x2);
-  return 0;
+  free(cell);
+  free(big);
+  free(start);
+  edge_pairs_sort(&pairs, edge_pair_cmp);
+  return pairs;
 }
 
 Agraph_t *edge_distinct_coloring(const char *color_scheme, int *lightness,
@@ -182,15 +320,27 @@ Agraph_t *edge_distinct_coloring(const char *color_scheme, int *lightness,
 #endif
     assert(ne == nz2);
     cos_a = 1.;/* for splines we exit conflict check as soon as we find an conflict, so the anle may not be representitive, hence set to constant */
+    route_t *routes = gv_calloc((size_t)nz2, sizeof(route_t));
+    bbox_t *boxes = gv_calloc((size_t)nz2, sizeof(bbox_t));
     for (i = 0; i < nz2; i++){
-      for (j = i+1; j < nz2; j++){
-	if (splines_intersect((size_t)dim, cos_critical,
-	                      check_edges_with_same_endpoint, xsplines[i],
-	                      xsplines[j])) {
-	  B = SparseMatrix_coordinate_form_add_entry(B, i, j, &cos_a);
-	}
+      routes[i] = parse_splines((size_t)dim, xsplines[i]);
+      boxes[i] = route_box((size_t)dim, &routes[i]);
+    }
+    edge_pairs_t pairs = overlapping_boxes(nz2, boxes);
+    for (size_t k = 0; k < edge_pairs_size(&pairs); k++){
+      const edge_pair_t p = edge_pairs_get(&pairs, k);
+      if (splines_intersect((size_t)dim, cos_critical,
+                            check_edges_with_same_endpoint, &routes[p.i],
+                            &routes[p.j])) {
+        B = SparseMatrix_coordinate_form_add_entry(B, p.i, p.j, &cos_a);
       }
     }
+    edge_pairs_free(&pairs);
+    for (i = 0; i < nz2; i++){
+      free(routes[i].x);
+    }
+    free(routes);
+    free(boxes);
 #ifdef TIME
     fprintf(stderr, "cpu for dual graph =%10.3f", ((double) (clock() - start))/CLOCKS_PER_SEC);
 #endif
@@ -202,17 +352,24 @@ Agraph_t *edge_distinct_coloring(const char *color_scheme, int *lightness,
 #endif
     
     
+    bbox_t *boxes = gv_calloc((size_t)nz2, sizeof(bbox_t));
     for (i = 0; i < nz2; i++){
+      boxes[i] = segment_box(&x[dim*irn[i]], &x[dim*jcn[i]]);
+    }
+    edge_pairs_t pairs = overlapping_boxes(nz2, boxes);
+    for (size_t k = 0; k < edge_pairs_size(&pairs); k++){
+      i = edge_pairs_get(&pairs, k).i;
+      j = edge_pairs_get(&pairs, k).j;
       u1 = irn[i]; v1 = jcn[i];
-      for (j = i+1; j < nz2; j++){
-	u2 = irn[j]; v2 = jcn[j];
-	cos_a = intersection_angle(&(x[dim*u1]), &(x[dim*v1]), &(x[dim*u2]), &(x[dim*v2]));
-	if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = fabs(cos_a);
-	if (cos_a > cos_critical) {
-	  B = SparseMatrix_coordinate_form_add_entry(B, i, j, &cos_a);
-	}
+      u2 = irn[j]; v2 = jcn[j];
+      cos_a = intersection_angle(&(x[dim*u1]), &(x[dim*v1]), &(x[dim*u2]), &(x[dim*v2]));
+      if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = fabs(cos_a);
+      if (cos_a > cos_critical) {
+	B = SparseMatrix_coordinate_form_add_entry(B, i, j, &cos_a);
       }
     }
+    edge_pairs_free(&pairs);
+    free(boxes);
 #ifdef TIME
     fprintf(stderr, "cpu for dual graph (splines) =%10.3f\n", ((double) (clock() - start))/CLOCKS_PER_SEC);
 #endif
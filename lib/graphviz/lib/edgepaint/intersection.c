@@ -129,7 +129,7 @@ double intersection_angle(double *p1, double *p2, double *q1, double *q2){
   double rnorm = 0, snorm = 0, b, t, u;
   // double epsilon = sqrt(MACHINEACC), close = 0.01;
   //this may be better. Apply to ngk10_4 and look at double edge between 28 and 43.  double epsilon = sin(10/180.), close = 0.1;
-  double epsilon = sin(1/180.), close = 0.01;
+  double epsilon = sin(1/180.), close = INTERSECTION_CLOSE;
   int line_dist_close;
   int i;
   double res;
@@ -10,4 +10,8 @@
 
 #pragma once
 
+/// segments closer than this fraction of the longer one’s length are treated
+/// as intersecting
+#define INTERSECTION_CLOSE 0.01
+
 double intersection_angle(double *p1, double *p2, double *q1, double *q2);
@@ -1409,10 +1409,19 @@ static Extype_t eval(Expr_t *ex, Exnode_t *exnode, void *env) {
 		v.integer = scan(ex, exnode, env, NULL);
 		return v;
 	case SPRINTF: {
-		FILE *buffer = tmpfile();
+		// creating a temporary file costs far more than formatting a short
+		// string, so one is kept for reuse; a sprintf in the arguments of
+		// this one finds it taken and opens its own
+		FILE *buffer = ex->sprintf_buf;
+		ex->sprintf_buf = NULL;
 		if (buffer == NULL) {
-			fprintf(stderr, "out of memory\n");
-			graphviz_exit(EXIT_FAILURE);
+			buffer = tmpfile();
+			if (buffer == NULL) {
+				fprintf(stderr, "out of memory\n");
+				graphviz_exit(EXIT_FAILURE);
+			}
+		} else {
+			rewind(buffer);
 		}
 		print(ex, exnode, env, buffer);
 		size_t size = (size_t)ftell(buffer);
@@ -1421,13 +1430,17 @@ static Extype_t eval(Expr_t *ex, Exnode_t *exnode, void *env) {
 		if (v.string == NULL) {
 			v.string = exnospace();
 		} else {
-			if (fread(v.string, size, 1, buffer) < 1) {
+			if (size > 0 && fread(v.string, size, 1, buffer) < 1) {
 				fprintf(stderr, "failed to read back temporary file\n");
 				graphviz_exit(EXIT_FAILURE);
 			}
 			v.string[size] = '\0';
 		}
-		fclose(buffer);
+		if (ex->sprintf_buf == NULL) {
+			ex->sprintf_buf = buffer;
+		} else {
+			fclose(buffer);
+		}
 		return v;
 	}
 	case '=':
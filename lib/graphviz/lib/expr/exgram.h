@@ -910,6 +910,8 @@ exclose(Expr_t* p, int all)
 			if (p->symbols)
 				dtclose(p->symbols);
 			agxbfree(&p->tmp);
+			if (p->sprintf_buf)
+				fclose(p->sprintf_buf);
 			while ((in = p->input))
 			{
 				free(in->pushback);
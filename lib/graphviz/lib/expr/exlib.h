@@ -104,6 +104,7 @@ typedef struct Print_s			/* compiled printf arg node	*/
 	Exinput_t*	input;		/* input stack			*/ \
 	Expr_t*		program;	/* previous program on stack	*/ \
 	agxbuf		tmp;		/* tmp string buffer		*/ \
+	FILE*		sprintf_buf;	/* stream kept for sprintf	*/ \
 	Extype_t	loopret;	/* return value			*/ \
 	Exid_t		main;		/* main procedure		*/ \
 	char		line[512];	/* last few input tokens	*/ \
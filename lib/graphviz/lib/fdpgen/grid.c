@@ -16,188 +16,53 @@
  * Support for grid to speed up layout. On each pass, nodes are
  * put into grid cells. Given a node, repulsion is only computed 
  * for nodes in one of that nodes 9 adjacent grids.
+ *
+ * Nodes are identified by number. Once all nodes are added, sortGrid
+ * buckets them by cell into a flat array. If the occupied cells are
+ * dense enough, this is a counting sort over the bounding box of the
+ * cells, which then serves as the lookup table for findGrid. Otherwise,
+ * the nodes are sorted and cells are found by binary search.
  */
 
-/* uses PRIVATE interface for NOTUSED */
-#define FDP_PRIVATE 1
-
-#include <fdpgen/fdp.h>
+#include <assert.h>
 #include <fdpgen/grid.h>
 #include <common/macros.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <util/alloc.h>
+#include <util/prisize_t.h>
+#include <util/sort.h>
 
-  /* structure for maintaining a free list of cells */
-typedef struct _block {
-    cell *mem;			/* block of cells */
-    cell *cur;			/* next available cell */
-    cell *endp;			/* after last cell */
-    struct _block *next;	/* next memory block */
-} block_t;
-
-/* newBlock:
- * Create new block of size cells
- */
-static block_t *newBlock(int size)
-{
-    block_t *newb = gv_alloc(sizeof(block_t));
-    newb->next = 0;
-    newb->mem = gv_calloc(size, sizeof(cell));
-    newb->endp = newb->mem + size;
-    newb->cur = newb->mem;
-
-    return newb;
-}
-
-/* freeBlock:
- * Free malloc'ed memory and block.
- * Recurse to next block
- */
-static void freeBlock(block_t * b)
-{
-    if (b) {
-	block_t *next = b->next;
-	free(b->mem);
-	free(b);
-	freeBlock(next);
-    }
-}
-
-struct _grid {
-    Dt_t *data;			/* cells indexed by (i,j) */
-    block_t *cellMem;		/* list of memory blocks for cells */
-    block_t *cellCur;		/* current block */
-    int listSize;		/* memory of nodes */
-    node_list *listMem;		/* list of memory for node items */
-    node_list *listCur;		/* next node item */
-};
-
-/* getCell:
- * Create a new cell using memory blocks.
+/* maximum number of index entries per node before switching to
+ * sorting and binary search
  */
-static cell *getCell(Grid * g)
-{
-    cell *cp;
-    block_t *bp = g->cellCur;	/* current block */
-
-    if (bp->cur == bp->endp) {	/* current block is full */
-	if (bp->next == 0) {
-	    bp->next = newBlock(2 * (bp->endp - bp->mem));
-	}
-	bp = g->cellCur = bp->next;
-	bp->cur = bp->mem;
-    }
-    cp = bp->cur++;
-    return cp;
-}
-
-static int ijcmpf(void *point1, void *point2) {
-    const gridpt *p1 = point1;
-    const gridpt *p2 = point2;
-    if (p1->i < p2->i) {
-        return -1;
-    }
-    if (p1->i > p2->i) {
-        return 1;
-    }
-    if (p1->j < p2->j) {
-        return -1;
-    }
-    if (p1->j > p2->j) {
-        return 1;
-    }
-    return 0;
-}
-
-static Grid _grid; // hack because can't attach info. to Dt_t
-
-/* newCell:
- * Allocate a new cell from free store and initialize its indices
- * This is used by the grid discipline to create cells.
- */
-static void *newCell(void *obj, Dtdisc_t *disc) {
-    cell *cellp = obj;
-    cell *newp;
-
-    (void)disc;
-    newp = getCell(&_grid);
-    newp->p.i = cellp->p.i;
-    newp->p.j = cellp->p.j;
-    newp->nodes = 0;
-
-    return newp;
-}
-
-/* newNode:
- * Allocate a new node item from free store. 
- * Set node value and hook into list.
- * A grid assumes the memory allocated in adjustGrid
- * will be enough more all nodes added.
- */
-static node_list *newNode(Grid * g, Agnode_t * n, node_list * nxt)
-{
-    node_list *newp;
-
-    newp = g->listCur++;
-    newp->node = n;
-    newp->next = nxt;
-
-    return newp;
-}
-
-static Dtdisc_t gridDisc = {
-    offsetof(cell, p),
-    sizeof(gridpt),
-    offsetof(cell, link),
-    newCell,
-    NULL,
-    ijcmpf,
-};
+#define DENSITY 4
 
 /* mkGrid:
- * Create grid data structure.
- * cellHint provides rough idea of how many cells
- * may be needed.
+ * Create grid data structure, able to hold up to nnodes nodes.
  */
-Grid *mkGrid(int cellHint)
+Grid *mkGrid(size_t nnodes)
 {
-    Grid *g = &_grid;
-    memset(g, 0, sizeof(*g)); // see comment above
-    g->data = dtopen(&gridDisc, Dtoset);
-    g->cellMem = newBlock(cellHint);
+    Grid *g = gv_alloc(sizeof(Grid));
+    size_t n = MAX(nnodes, 1);
+
+    g->nsize = n;
+    g->nodes = gv_calloc(n, sizeof(size_t));
+    g->cells = gv_calloc(n, sizeof(cell));
+    g->added = gv_calloc(n, sizeof(size_t));
+    g->pts = gv_calloc(n, sizeof(gridpt));
     return g;
 }
 
-/* adjustGrid:
- * Set up node list for grid. Make sure the list
- * can handle nnodes nodes.
- * It is assumed no more than nnodes will be added
- * to the grid.
- */
-void adjustGrid(Grid * g, int nnodes)
-{
-    int nsize;
-
-    if (nnodes > g->listSize) {
-	nsize = MAX(nnodes, 2 * g->listSize);
-	if (g->listMem)
-	    free(g->listMem);
-	g->listMem = gv_calloc(nsize, sizeof(node_list));
-	g->listSize = nsize;
-    }
-}
-
 /* clearGrid:
- * Reset grid. This clears the dictionary,
- * and reuses available memory.
+ * Reset grid, reusing available memory.
  */
 void clearGrid(Grid * g)
 {
-    dtclear(g->data);
-    g->listCur = g->listMem;
-    g->cellCur = g->cellMem;
-    g->cellCur->cur = g->cellCur->mem;
+    g->nnodes = 0;
+    g->ncells = 0;
 }
 
 /* delGrid:
@@ -205,65 +70,167 @@ void clearGrid(Grid * g)
  */
 void delGrid(Grid * g)
 {
-    dtclose(g->data);
-    freeBlock(g->cellMem);
-    free(g->listMem);
+    free(g->nodes);
+    free(g->cells);
+    free(g->added);
+    free(g->pts);
+    free(g->index);
+    free(g);
 }
 
 /* addGrid:
  * Add node n to cell (i,j) in grid g.
  */
-void addGrid(Grid * g, int i, int j, Agnode_t * n)
+void addGrid(Grid * g, int i, int j, size_t n)
 {
-    cell *cellp;
-    cell key;
-
-    key.p.i = i;
-    key.p.j = j;
-    cellp = dtinsert(g->data, &key);
-    cellp->nodes = newNode(g, n, cellp->nodes);
+    assert(g->nnodes < g->nsize && "more nodes added than grid was made for");
+    g->added[g->nnodes] = n;
+    g->pts[g->nnodes].i = i;
+    g->pts[g->nnodes].j = j;
+    g->nnodes++;
     if (Verbose >= 3) {
-	fprintf(stderr, "grid(%d,%d): %s\n", i, j, agnameof(n));
+	fprintf(stderr, "grid(%d,%d): %" PRISIZE_T "\n", i, j, n);
     }
 }
 
-typedef int (*walkfn_t)(void*, void*);
+/* ptcmp:
+ * Order added nodes by cell index. Within a cell, later nodes
+ * come first.
+ */
+static int ptcmp(const void *x, const void *y, void *arg)
+{
+    const gridpt *pts = arg;
+    const size_t a = *(const size_t *)x;
+    const size_t b = *(const size_t *)y;
+
+    if (pts[a].i != pts[b].i)
+	return pts[a].i < pts[b].i ? -1 : 1;
+    if (pts[a].j != pts[b].j)
+	return pts[a].j < pts[b].j ? -1 : 1;
+    if (a != b)
+	return a > b ? -1 : 1;
+    return 0;
+}
 
-/* walkGrid:
- * Apply function walkf to each cell in the grid.
- * The second argument to walkf is the cell; the
- * third argument is the grid. (The first argument
- * is the dictionary.) walkf must return 0.
+/* indexOf:
+ * Position of cell (i,j) in the dense index.
  */
-void walkGrid(Grid *g, int (*walkf)(cell*, Grid*))
+static size_t indexOf(const Grid * g, int i, int j)
 {
-    dtwalk(g->data, (walkfn_t) walkf, g);
+    return (size_t)((int64_t)i - g->min.i) * g->height +
+	(size_t)((int64_t)j - g->min.j);
 }
 
-/* findGrid;
- * Return the cell, if any, corresponding to
- * indices i,j
+/* sortGrid:
+ * Bucket the added nodes into cells. Cells are sorted by index and,
+ * within a cell, nodes are in the reverse of the order they were added.
  */
-cell *findGrid(Grid * g, int i, int j)
+void sortGrid(Grid * g)
 {
-    cell key;
+    size_t n = g->nnodes;
+    gridpt lo, hi;
+    size_t k;
+
+    g->ncells = 0;
+    g->width = g->height = 0;
+    if (n == 0)
+	return;
+
+    lo = hi = g->pts[0];
+    for (k = 1; k < n; k++) {
+	lo.i = MIN(lo.i, g->pts[k].i);
+	lo.j = MIN(lo.j, g->pts[k].j);
+	hi.i = MAX(hi.i, g->pts[k].i);
+	hi.j = MAX(hi.j, g->pts[k].j);
+    }
+
+    const uint64_t width = (uint64_t)((int64_t)hi.i - lo.i) + 1;
+    const uint64_t height = (uint64_t)((int64_t)hi.j - lo.j) + 1;
+    const uint64_t limit = DENSITY * (uint64_t)n + 16;
+
+    if (width <= limit && height <= limit / width) {
+	/* counting sort, with the index holding cell sizes */
+	size_t size = (size_t)(width * height);
+	size_t first = 0;
 
-    key.p.i = i;
-    key.p.j = j;
-    return dtsearch(g->data, &key);
+	if (size > g->isize) {
+	    g->index = gv_recalloc(g->index, g->isize, size, sizeof(size_t));
+	    g->isize = size;
+	}
+	g->min = lo;
+	g->width = (size_t)width;
+	g->height = (size_t)height;
+	memset(g->index, 0, size * sizeof(size_t));
+	for (k = 0; k < n; k++)
+	    g->index[indexOf(g, g->pts[k].i, g->pts[k].j)]++;
+
+	/* turn sizes into cells; the index then holds 1 + cell number */
+	for (k = 0; k < size; k++) {
+	    if (g->index[k] == 0)
+		continue;
+	    cell *cp = &g->cells[g->ncells];
+	    cp->p.i = lo.i + (int)(k / g->height);
+	    cp->p.j = lo.j + (int)(k % g->height);
+	    cp->first = first;
+	    cp->size = 0;
+	    first += g->index[k];
+	    g->index[k] = ++g->ncells;
+	}
+
+	for (k = n; k-- > 0;) {
+	    const size_t c = g->index[indexOf(g, g->pts[k].i, g->pts[k].j)];
+	    cell *cp = &g->cells[c - 1];
+	    g->nodes[cp->first + cp->size++] = k;
+	}
+    } else {
+	for (k = 0; k < n; k++)
+	    g->nodes[k] = k;
+	gv_sort(g->nodes, n, sizeof(size_t), ptcmp, g->pts);
+
+	for (k = 0; k < n; k++) {
+	    const gridpt p = g->pts[g->nodes[k]];
+	    cell *cp = g->ncells > 0 ? &g->cells[g->ncells - 1] : NULL;
+	    if (cp == NULL || cp->p.i != p.i || cp->p.j != p.j) {
+		cp = &g->cells[g->ncells++];
+		cp->p = p;
+		cp->first = k;
+		cp->size = 0;
+	    }
+	    cp->size++;
+	}
+    }
+
+    for (k = 0; k < n; k++)
+	g->nodes[k] = g->added[g->nodes[k]];
 }
 
-/* gLength:
- * Return the number of nodes in a cell.
+/* findGrid;
+ * Return the cell, if any, corresponding to
+ * indices i,j
  */
-int gLength(cell * p)
+cell *findGrid(Grid * g, int i, int j)
 {
-    int len = 0;
-    node_list *nodes = p->nodes;
+    if (g->width > 0) {
+	if (i < g->min.i || j < g->min.j)
+	    return NULL;
+	if ((uint64_t)((int64_t)i - g->min.i) >= g->width ||
+	    (uint64_t)((int64_t)j - g->min.j) >= g->height)
+	    return NULL;
+	const size_t c = g->index[indexOf(g, i, j)];
+	return c > 0 ? &g->cells[c - 1] : NULL;
+    }
 
-    while (nodes) {
-	len++;
-	nodes = nodes->next;
+    size_t lo = 0;
+    size_t hi = g->ncells;
+    while (lo < hi) {
+	size_t mid = lo + (hi - lo) / 2;
+	cell *cp = &g->cells[mid];
+	if (cp->p.i == i && cp->p.j == j)
+	    return cp;
+	if (cp->p.i < i || (cp->p.i == i && cp->p.j < j))
+	    lo = mid + 1;
+	else
+	    hi = mid;
     }
-    return len;
+    return NULL;
 }
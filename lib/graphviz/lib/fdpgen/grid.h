@@ -17,14 +17,8 @@ extern "C" {
 #include "config.h"
 
 #include <common/render.h>
-#include <cdt/cdt.h>
-
-    typedef struct _grid Grid;
-
-    typedef struct _node_list {
-	Agnode_t *node;
-	struct _node_list *next;
-    } node_list;
+#include <stdbool.h>
+#include <stddef.h>
 
     typedef struct {
 	int i, j;
@@ -32,18 +26,34 @@ extern "C" {
 
     typedef struct {
 	gridpt p;		/* index of cell */
-	node_list *nodes;	/* nodes in cell */
-	Dtlink_t link;		/* cdt data */
+	size_t first;		/* position of first node of cell in nodes */
+	size_t size;		/* number of nodes in cell */
     } cell;
 
-    extern Grid *mkGrid(int);
-    extern void adjustGrid(Grid * g, int nnodes);
+    /* Once sorted, a grid lists its nodes by cell, with the cells
+     * sorted by index, so the nodes of a cell are contiguous.
+     */
+    typedef struct {
+	size_t nnodes;		/* number of nodes in grid */
+	size_t nsize;		/* maximum number of nodes */
+	size_t *nodes;		/* nodes by cell */
+	cell *cells;		/* non-empty cells, sorted by index */
+	size_t ncells;		/* number of cells */
+	/* private */
+	size_t *added;		/* nodes in order added */
+	gridpt *pts;		/* cells of added nodes */
+	size_t *index;		/* dense map from cell index to cell */
+	size_t isize;		/* allocated size of index */
+	size_t width, height;	/* dimensions of index */
+	gridpt min;		/* smallest cell index in index */
+    } Grid;
+
+    extern Grid *mkGrid(size_t nnodes);
     extern void clearGrid(Grid *);
-    extern void addGrid(Grid *, int, int, Agnode_t *);
-    extern void walkGrid(Grid*, int (*)(cell*, Grid*));
+    extern void addGrid(Grid *, int, int, size_t);
+    extern void sortGrid(Grid *);
     extern cell *findGrid(Grid *, int, int);
     extern void delGrid(Grid *);
-    extern int gLength(cell * p);
 
 #ifdef __cplusplus
 }
@@ -48,6 +48,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <util/alloc.h>
+#include <util/gv_parallel.h>
 
 typedef struct {
     graph_t*  rootg;  /* logical root; graph passed in to fdp_layout */
@@ -470,7 +471,7 @@ static graph_t *deriveGraph(graph_t * g, layout_info * infop)
 	    hd = DNODE(aghead(e));
 	    if (hd == tl)
 		continue;
-	    if (hd > tl)
+	    if (AGSEQ(hd) > AGSEQ(tl))
 		de = agedge(dg, tl, hd, NULL,1);
 	    else
 		de = agedge(dg, hd, tl, NULL,1);
@@ -504,7 +505,7 @@ static graph_t *deriveGraph(graph_t * g, layout_info * infop)
 		dn = mkDeriveNode(dg, portName(g, pp));
 		sz++;
 		ND_id(dn) = id++;
-		if (dn > m)
+		if (AGSEQ(dn) > AGSEQ(m))
 		    de = agedge(dg, m, dn, NULL,1);
 		else
 		    de = agedge(dg, dn, m, NULL,1);
@@ -616,7 +617,7 @@ static erec *getEdgeList(node_t * n, graph_t * g)
  * Given list of edges with node n in derived graph, add corresponding
  * ports to port list pp, starting at index idx. Return next index.
  * If an edge in the derived graph corresponds to multiple real edges,
- * add them in order if address of n is smaller than other node address.
+ * add them in order if n was created before the other node.
  * Otherwise, reverse order.
  * Attach angles. The value bnd gives next angle after er->alpha.
  */
@@ -641,7 +642,7 @@ genPorts(node_t * n, erec * er, bport_t * pp, int idx, double bnd)
     delta = fmin((bnd - er->alpha) / cnt, ANG);
     angle = er->alpha;
 
-    if (n < other) {
+    if (AGSEQ(n) < AGSEQ(other)) {
 	i = idx;
 	inc = 1;
     } else {
@@ -780,49 +781,28 @@ setClustNodes(graph_t* root)
     }
 }
 
-/* layout:
- * Given g with ports:
- *  Derive g' from g by reducing clusters to points (deriveGraph)
- *  Compute connected components of g' (findCComp)
- *  For each cc of g': 
- *    Layout cc (tLayout)
- *    For each node n in cc of g' <-> cluster c in g:
- *      Add ports based on layout of cc to get c' (expandCluster)
- *      Layout c' (recursion)
- *    Remove ports from cc
- *    Expand nodes of cc to reflect size of c'  (xLayout)
- *  Pack connected components to get layout of g (putGraphs)
- *  Translate layout so that bounding box of layout + margin 
- *  has the origin as LL corner. 
- *  Set position of top level clusters and real nodes.
- *  Set bounding box of graph
- * 
- * TODO:
- * 
- * Possibly should modify so that only do connected components
- * on top-level derived graph. Unconnected parts of a cluster
- * could just rattle within cluster boundaries. This may mix
- * up components but give a tighter packing.
- * 
- * Add edges per components to get better packing, rather than
- * wait until the end.
+/* State of the layout of a graph between its phases. */
+typedef struct {
+    graph_t *g;
+    graph_t *dg;		/* derived graph of g */
+    graph_t **cc;		/* connected components of dg */
+    size_t c_cnt;		/* number of components */
+    int pinned;
+    xparams *xpms;		/* expansion parameters of components */
+} lstate_t;
+
+DEFINE_LIST(tlayouts, tlayout_t *)
+
+/* startLayout:
+ * Derive g' from g, and compute its connected components. Set up
+ * the layout of each component, appending it to tasks.
+ * Returns non-zero on error.
  */
-static int layout(graph_t * g, layout_info * infop)
+static int startLayout(graph_t * g, lstate_t * st, tlayouts_t * tasks,
+		       layout_info * infop)
 {
-    pointf *pts = NULL;
-    graph_t *dg;
-    node_t *dn;
     node_t *n;
-    graph_t *cg;
-    graph_t *sg;
-    graph_t **cc;
-    graph_t **pg;
-    int pinned;
-    xparams xpms;
 
-#ifdef DEBUG
-    incInd();
-#endif
     if (Verbose) {
 #ifdef DEBUG
 	prIndent();
@@ -833,25 +813,47 @@ static int layout(graph_t * g, layout_info * infop)
     for (n = agfstnode(g); n; n = agnxtnode(g, n))
 	DNODE(n) = 0;
 
-    dg = deriveGraph(g, infop);
-    if (dg == NULL) {
+    st->g = g;
+    st->dg = deriveGraph(g, infop);
+    if (st->dg == NULL) {
 	return -1;
     }
-    size_t c_cnt;
-    cc = pg = findCComp(dg, &c_cnt, &pinned);
+    st->cc = findCComp(st->dg, &st->c_cnt, &st->pinned);
+    st->xpms = gv_calloc(st->c_cnt, sizeof(xparams));
+    for (size_t i = 0; i < st->c_cnt; i++)
+	tlayouts_append(tasks, fdp_tLayoutInit(st->cc[i], &st->xpms[i]));
+    return 0;
+}
+
+static void runLayout(void *tasks, size_t i)
+{
+    fdp_tLayoutRun(tlayouts_get(tasks, i));
+}
+
+/* finishLayout:
+ * Given the layouts of the components of g' and of the clusters
+ * they contain, remove the ports, remove overlaps, and pack the
+ * components to get the layout of g.
+ */
+static void finishLayout(lstate_t * st, layout_info * infop)
+{
+    graph_t *g = st->g;
+    graph_t *dg = st->dg;
+    graph_t **cc = st->cc;
+    size_t c_cnt = st->c_cnt;
+    pointf *pts = NULL;
+    node_t *dn;
+    node_t *n;
+    graph_t *cg;
+    graph_t *sg;
 
-    while ((cg = *pg++)) {
+    for (size_t i = 0; i < c_cnt; i++) {
 	node_t* nxtnode;
-	fdp_tLayout(cg, &xpms);
+	cg = cc[i];
 	for (n = agfstnode(cg); n; n = nxtnode) {
 	    nxtnode = agnxtnode(cg, n);
-	    if (ND_clust(n)) {
+	    if ((sg = ND_clust(n))) {
 		pointf pt;
-		sg = expandCluster(n, cg);	/* attach ports to sg */
-		int r = layout(sg, infop);
-		if (r != 0) {
-                    return r;
-		}
 		ND_width(n) = BB(sg).UR.x;
 		ND_height(n) = BB(sg).UR.y;
 		pt.x = POINTS_PER_INCH * BB(sg).UR.x;
@@ -866,7 +868,7 @@ static int layout(graph_t * g, layout_info * infop)
 	if (agnnodes(cg) >= 2) {
 	    if (g == infop->rootg)
 		normalize (cg);
-	    fdp_xLayout(cg, &xpms);
+	    fdp_xLayout(cg, &st->xpms[i]);
 	}
     }
 
@@ -882,7 +884,7 @@ static int layout(graph_t * g, layout_info * infop)
      */
     if (c_cnt > 1) {
 	bool *bp;
-	if (pinned) {
+	if (st->pinned) {
 	    bp = gv_calloc(c_cnt, sizeof(bool));
 	    bp[0] = true;
 	} else
@@ -923,17 +925,110 @@ static int layout(graph_t * g, layout_info * infop)
     /* clean up temp graphs */
     freeDerivedGraph(dg, cc);
     free(cc);
+    free(st->xpms);
     if (Verbose) {
 #ifdef DEBUG
 	prIndent ();
 #endif
 	fprintf (stderr, "end %s\n", agnameof(g));
     }
+}
+
+/* layoutLevel:
+ * Lay out the graphs in graphs, which are siblings in the cluster tree
+ * or are otherwise unrelated. Their derived graphs are set up one at a
+ * time, but the initial layouts of all their components are computed
+ * concurrently. The clusters these contain only depend on the layouts
+ * of their parents, so they are then laid out the same way, a level
+ * of the cluster tree at a time, before the graphs are finished.
+ * Only the force-directed iterations run concurrently. On graphs made
+ * of many small clusters or components, the sequential work around
+ * them takes most of the time.
+ */
+static int layoutLevel(clist_t * graphs, layout_info * infop)
+{
+    const size_t n_graphs = clist_size(graphs);
+    lstate_t *states = gv_calloc(n_graphs, sizeof(lstate_t));
+    tlayouts_t tasks = {0};
+    clist_t children = {0};
+    int r = 0;
+
+#ifdef DEBUG
+    incInd();
+#endif
+    for (size_t i = 0; i < n_graphs && r == 0; i++)
+	r = startLayout(clist_get(graphs, i), &states[i], &tasks, infop);
+
+    gv_parallel_for(tlayouts_size(&tasks), runLayout, &tasks);
+    for (size_t i = 0; i < tlayouts_size(&tasks); i++)
+	fdp_tLayoutFinish(tlayouts_get(&tasks, i));
+    tlayouts_free(&tasks);
+
+    if (r == 0) {
+	for (size_t i = 0; i < n_graphs; i++) {
+	    for (size_t j = 0; j < states[i].c_cnt; j++) {
+		graph_t *cg = states[i].cc[j];
+		for (node_t *n = agfstnode(cg); n; n = agnxtnode(cg, n)) {
+		    if (ND_clust(n))	/* attach ports to cluster */
+			clist_append(&children, expandCluster(n, cg));
+		}
+	    }
+	}
+	if (clist_size(&children) > 0)
+	    r = layoutLevel(&children, infop);
+	clist_free(&children);
+    }
+
+    if (r == 0) {
+	for (size_t i = 0; i < n_graphs; i++)
+	    finishLayout(&states[i], infop);
+    }
+    free(states);
 #ifdef DEBUG
     decInd();
 #endif
 
-    return 0;
+    return r;
+}
+
+/* layout:
+ * Given g with ports:
+ *  Derive g' from g by reducing clusters to points (deriveGraph)
+ *  Compute connected components of g' (findCComp)
+ *  For each cc of g': 
+ *    Layout cc (tLayout)
+ *    For each node n in cc of g' <-> cluster c in g:
+ *      Add ports based on layout of cc to get c' (expandCluster)
+ *      Layout c' (recursion)
+ *    Remove ports from cc
+ *    Expand nodes of cc to reflect size of c'  (xLayout)
+ *  Pack connected components to get layout of g (putGraphs)
+ *  Translate layout so that bounding box of layout + margin 
+ *  has the origin as LL corner. 
+ *  Set position of top level clusters and real nodes.
+ *  Set bounding box of graph
+ *
+ * The recursion is done breadth first by layoutLevel, so the
+ * clusters at each level can be laid out in parallel.
+ * 
+ * TODO:
+ * 
+ * Possibly should modify so that only do connected components
+ * on top-level derived graph. Unconnected parts of a cluster
+ * could just rattle within cluster boundaries. This may mix
+ * up components but give a tighter packing.
+ * 
+ * Add edges per components to get better packing, rather than
+ * wait until the end.
+ */
+static int layout(graph_t * g, layout_info * infop)
+{
+    clist_t graphs = {0};
+
+    clist_append(&graphs, g);
+    int r = layoutLevel(&graphs, infop);
+    clist_free(&graphs);
+    return r;
 }
 
 /* setBB;
@@ -37,6 +37,12 @@
 #include <unistd.h>
 #endif
 #include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <fdpgen/dbg.h>
 #include <fdpgen/grid.h>
 #include <neatogen/neato.h>
@@ -47,6 +53,8 @@
 
 #include <fdpgen/tlayout.h>
 #include <common/globals.h>
+#include <util/alloc.h>
+#include <util/prisize_t.h>
 
 #define D_useGrid   (fdp_parms->useGrid)
 #define D_useNew    (fdp_parms->useNew)
@@ -105,9 +113,9 @@ static parms_t parms;
 #define DFLT_seed  1
 #define DFLT_smode INIT_RANDOM
 
-static double cool(int t)
+static double cool(const parms_t * P, int t)
 {
-    return T_T0 * (T_maxIters - t) / T_maxIters;
+    return P->T0 * (P->maxIters - t) / P->maxIters;
 }
 
 /* reset_params:
@@ -142,7 +150,7 @@ static int init_params(graph_t * g, xparams * xpms)
 	ret = 1;
     }
 
-    xpms->T0 = cool(T_pass1);
+    xpms->T0 = cool(&parms, T_pass1);
     xpms->K = T_K;
     xpms->C = T_C;
     xpms->numIters = T_maxIters - T_pass1;
@@ -204,178 +212,366 @@ void fdp_initParams(graph_t * g)
 #endif
 }
 
-static void
-doRep(node_t * p, node_t * q, double xdelta, double ydelta, double dist2)
+/* Node and edge data for the force computations. These are copied out
+ * of the graph for the duration of the layout, so the inner loops work
+ * on contiguous arrays instead of chasing node and edge pointers.
+ */
+typedef struct {
+    double *x, *y;		/* positions */
+    double *dx, *dy;		/* displacements */
+    bool *port;			/* which nodes are ports */
+} nodes_t;
+
+typedef struct {
+    parms_t parms;		/* parameters for this layout */
+    uint32_t rng;		/* state of jitter's random numbers */
+    size_t nnodes;
+    Agnode_t **nodes;		/* nodes in graph order */
+    nodes_t v;			/* node data in graph order */
+    bool *fixed;		/* which nodes are fixed */
+    size_t nedges;
+    size_t *tail, *head;	/* edge endpoints, sorted by tail */
+    double *factor, *dist;	/* ED_factor and ED_dist of edges */
+    Grid *grid;			/* if parms.useGrid */
+    nodes_t gv;			/* node data in grid order */
+} forces_t;
+
+static nodes_t mkNodes(size_t n)
 {
-    double force;
-    double dist;
+    nodes_t v;
+
+    v.x = gv_calloc(n, sizeof(double));
+    v.y = gv_calloc(n, sizeof(double));
+    v.dx = gv_calloc(n, sizeof(double));
+    v.dy = gv_calloc(n, sizeof(double));
+    v.port = gv_calloc(n, sizeof(bool));
+    return v;
+}
+
+static void freeNodes(nodes_t * v)
+{
+    free(v->x);
+    free(v->y);
+    free(v->dx);
+    free(v->dy);
+    free(v->port);
+}
+
+/* mkForces:
+ * Copy the nodes and edges of g, numbering the nodes in graph order,
+ * along with the current parameters. This relies on ND_id being distinct
+ * for the nodes of g, as it is in the derived graphs built by fdp.
+ */
+static forces_t mkForces(graph_t * g)
+{
+    forces_t f = {0};
+    size_t n = (size_t)agnnodes(g);
+    size_t m = (size_t)agnedges(g);
+    size_t *index;
+    size_t k = 0;
+    int maxid = 0;
+    Agnode_t *np;
+    Agedge_t *e;
 
-    while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
-	dist2 = xdelta * xdelta + ydelta * ydelta;
+    f.parms = parms;
+    f.rng = (uint32_t)T_seed;
+    f.nnodes = n;
+    f.nodes = gv_calloc(n, sizeof(Agnode_t *));
+    f.v = mkNodes(n);
+    f.fixed = gv_calloc(n, sizeof(bool));
+    f.tail = gv_calloc(m, sizeof(size_t));
+    f.head = gv_calloc(m, sizeof(size_t));
+    f.factor = gv_calloc(m, sizeof(double));
+    f.dist = gv_calloc(m, sizeof(double));
+
+    for (np = agfstnode(g); np; np = agnxtnode(g, np))
+	maxid = MAX(maxid, ND_id(np));
+    index = gv_calloc((size_t)maxid + 1, sizeof(size_t));
+    for (np = agfstnode(g); np; np = agnxtnode(g, np), k++) {
+	index[ND_id(np)] = k;
+	f.nodes[k] = np;
+	f.v.x[k] = ND_pos(np)[0];
+	f.v.y[k] = ND_pos(np)[1];
+	f.v.port[k] = IS_PORT(np);
+	f.fixed[k] = ND_pinned(np) & P_FIX;
     }
-    if (T_useNew) {
-	dist = sqrt(dist2);
-	force = T_K * T_K / (dist * dist2);
-    } else
-	force = T_K * T_K / dist2;
-    if (IS_PORT(p) && IS_PORT(q))
-	force *= 10.0;
-    DISP(q)[0] += xdelta * force;
-    DISP(q)[1] += ydelta * force;
-    DISP(p)[0] -= xdelta * force;
-    DISP(p)[1] -= ydelta * force;
+    for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	for (e = agfstout(g, np); e; e = agnxtout(g, e)) {
+	    if (np == aghead(e))
+		continue;
+	    f.tail[f.nedges] = index[ND_id(np)];
+	    f.head[f.nedges] = index[ND_id(aghead(e))];
+	    f.factor[f.nedges] = ED_factor(e);
+	    f.dist[f.nedges] = ED_dist(e);
+	    f.nedges++;
+	}
+    }
+    free(index);
+
+    if (f.parms.useGrid) {
+	f.grid = mkGrid(n);
+	f.gv = mkNodes(n);
+    }
+    return f;
 }
 
-/* applyRep:
- * Repulsive force = (K*K)/d
- *  or K*K/d*d
+/* freeForces:
+ * Store the computed positions in the nodes, and free f.
  */
-static void applyRep(Agnode_t * p, Agnode_t * q)
+static void freeForces(forces_t * f)
 {
-    double xdelta, ydelta;
+    for (size_t k = 0; k < f->nnodes; k++) {
+	ND_pos(f->nodes[k])[0] = f->v.x[k];
+	ND_pos(f->nodes[k])[1] = f->v.y[k];
+    }
+    free(f->nodes);
+    freeNodes(&f->v);
+    free(f->fixed);
+    free(f->tail);
+    free(f->head);
+    free(f->factor);
+    free(f->dist);
+    if (f->grid) {
+	delGrid(f->grid);
+	freeNodes(&f->gv);
+    }
+}
 
-    xdelta = ND_pos(q)[0] - ND_pos(p)[0];
-    ydelta = ND_pos(q)[1] - ND_pos(p)[1];
-    doRep(p, q, xdelta, ydelta, xdelta * xdelta + ydelta * ydelta);
+/* rnd:
+ * Next number in [0,32767] from the random number generator of f.
+ * Each layout has its own, so layouts running at the same time do not
+ * affect each other's results.
+ */
+static int rnd(forces_t * f)
+{
+    f->rng = f->rng * 1103515245u + 12345u;
+    return (int)((f->rng >> 16) & 0x7fff);
 }
 
-static void doNeighbor(Grid * grid, int i, int j, node_list * nodes)
+/* jitter:
+ * Pick a random, nonzero delta for nodes at the same position.
+ * Returns its squared length.
+ */
+static double jitter(forces_t * f, double *xdelta, double *ydelta)
 {
-    cell *cellp = findGrid(grid, i, j);
-    node_list *qs;
-    Agnode_t *p;
-    Agnode_t *q;
-    double xdelta, ydelta;
     double dist2;
 
-    if (cellp) {
+    do {
+	*xdelta = 5 - rnd(f) % 10;
+	*ydelta = 5 - rnd(f) % 10;
+	dist2 = *xdelta * *xdelta + *ydelta * *ydelta;
+    } while (dist2 == 0.0);
+    return dist2;
+}
+
+/* repForce:
+ * Repulsive force factor for nodes a squared distance dist2 > 0 apart.
+ */
+static double repForce(const parms_t * P, double dist2)
+{
+    if (P->useNew) {
+	double dist = sqrt(dist2);
+	return P->K * P->K / (dist * dist2);
+    }
+    return P->K * P->K / dist2;
+}
+
+/* number of nodes handled at a time by applyRep */
+#define REP_BATCH 32
+
+/* applyRep:
+ * Apply the repulsive force between node p and each of the size nodes
+ * starting at first, other than p itself. If cutoff is true, nodes
+ * further away than the cell size are skipped.
+ *  Repulsive force = (K*K)/d
+ *   or K*K/d*d
+ *
+ * The deltas and forces are computed a batch of nodes at a time, with
+ * SIMD if available, and then applied in order, so the results are the
+ * same as applying them one pair at a time.
+ */
+static void applyRep(forces_t * f, nodes_t * v, size_t p, size_t first,
+		     size_t size, bool cutoff)
+{
+    double xdelta[REP_BATCH], ydelta[REP_BATCH];
+    double dist2[REP_BATCH], force[REP_BATCH];
+    const double px = v->x[p];
+    const double py = v->y[p];
+    const parms_t *P = &f->parms;
+    const double K2 = P->K * P->K;
+    const double limit = P->Cell * P->Cell;
+
+    for (size_t base = 0; base < size; base += REP_BATCH) {
+	const double *qx = v->x + first + base;
+	const double *qy = v->y + first + base;
+	const size_t cnt = MIN(size - base, REP_BATCH);
+	size_t k = 0;
+
+#ifdef __SSE2__
+	const __m128d vpx = _mm_set1_pd(px);
+	const __m128d vpy = _mm_set1_pd(py);
+	const __m128d vK2 = _mm_set1_pd(K2);
+	for (; k + 2 <= cnt; k += 2) {
+	    __m128d xd = _mm_sub_pd(_mm_loadu_pd(qx + k), vpx);
+	    __m128d yd = _mm_sub_pd(_mm_loadu_pd(qy + k), vpy);
+	    __m128d d2 = _mm_add_pd(_mm_mul_pd(xd, xd), _mm_mul_pd(yd, yd));
+	    __m128d fk;
+	    if (P->useNew)
+		fk = _mm_div_pd(vK2, _mm_mul_pd(_mm_sqrt_pd(d2), d2));
+	    else
+		fk = _mm_div_pd(vK2, d2);
+	    _mm_storeu_pd(xdelta + k, xd);
+	    _mm_storeu_pd(ydelta + k, yd);
+	    _mm_storeu_pd(dist2 + k, d2);
+	    _mm_storeu_pd(force + k, fk);
+	}
+#endif
+	for (; k < cnt; k++) {
+	    xdelta[k] = qx[k] - px;
+	    ydelta[k] = qy[k] - py;
+	    dist2[k] = xdelta[k] * xdelta[k] + ydelta[k] * ydelta[k];
+	    if (P->useNew)
+		force[k] = K2 / (sqrt(dist2[k]) * dist2[k]);
+	    else
+		force[k] = K2 / dist2[k];
+	}
+
+	for (k = 0; k < cnt; k++) {
+	    const size_t q = first + base + k;
+	    double xd = xdelta[k];
+	    double yd = ydelta[k];
+	    double fk = force[k];
+
+	    if (q == p)
+		continue;
+	    if (cutoff && !(dist2[k] < limit))
+		continue;
+	    if (dist2[k] == 0.0)
+		fk = repForce(P, jitter(f, &xd, &yd));
+	    if (v->port[p] && v->port[q])
+		fk *= 10.0;
+	    v->dx[q] += xd * fk;
+	    v->dy[q] += yd * fk;
+	    v->dx[p] -= xd * fk;
+	    v->dy[p] -= yd * fk;
+	}
+    }
+}
+
+static void doNeighbor(forces_t * f, int i, int j, const cell * cellp)
+{
+    cell *nbr = findGrid(f->grid, i, j);
+
+    if (nbr) {
 #ifdef DEBUG
 	if (Verbose >= 3) {
 	    prIndent();
-	    fprintf(stderr, "  doNeighbor (%d,%d) : %d\n", i, j,
-		    gLength(cellp));
+	    fprintf(stderr, "  doNeighbor (%d,%d) : %" PRISIZE_T "\n", i, j,
+		    nbr->size);
 	}
 #endif
-	for (; nodes != 0; nodes = nodes->next) {
-	    p = nodes->node;
-	    for (qs = cellp->nodes; qs != 0; qs = qs->next) {
-		q = qs->node;
-		xdelta = (ND_pos(q))[0] - (ND_pos(p))[0];
-		ydelta = (ND_pos(q))[1] - (ND_pos(p))[1];
-		dist2 = xdelta * xdelta + ydelta * ydelta;
-		if (dist2 < T_Cell * T_Cell)
-		    doRep(p, q, xdelta, ydelta, dist2);
-	    }
-	}
+	for (size_t p = cellp->first; p < cellp->first + cellp->size; p++)
+	    applyRep(f, &f->gv, p, nbr->first, nbr->size, true);
     }
 }
 
-static int gridRepulse(cell *cellp, Grid *grid) {
-    node_list *nodes = cellp->nodes;
+static void gridRepulse(forces_t * f, const cell * cellp)
+{
     int i = cellp->p.i;
     int j = cellp->p.j;
-    node_list *p;
-    node_list *q;
 
 #ifdef DEBUG
     if (Verbose >= 3) {
 	prIndent();
-	fprintf(stderr, "gridRepulse (%d,%d) : %d\n", i, j,
-		gLength(cellp));
+	fprintf(stderr, "gridRepulse (%d,%d) : %" PRISIZE_T "\n", i, j,
+		cellp->size);
     }
 #endif
-    for (p = nodes; p != 0; p = p->next) {
-	for (q = nodes; q != 0; q = q->next)
-	    if (p != q)
-		applyRep(p->node, q->node);
-    }
-
-    doNeighbor(grid, i - 1, j - 1, nodes);
-    doNeighbor(grid, i - 1, j, nodes);
-    doNeighbor(grid, i - 1, j + 1, nodes);
-    doNeighbor(grid, i, j - 1, nodes);
-    doNeighbor(grid, i, j + 1, nodes);
-    doNeighbor(grid, i + 1, j - 1, nodes);
-    doNeighbor(grid, i + 1, j, nodes);
-    doNeighbor(grid, i + 1, j + 1, nodes);
-
-    return 0;
+    for (size_t p = cellp->first; p < cellp->first + cellp->size; p++)
+	applyRep(f, &f->gv, p, cellp->first, cellp->size, false);
+
+    doNeighbor(f, i - 1, j - 1, cellp);
+    doNeighbor(f, i - 1, j, cellp);
+    doNeighbor(f, i - 1, j + 1, cellp);
+    doNeighbor(f, i, j - 1, cellp);
+    doNeighbor(f, i, j + 1, cellp);
+    doNeighbor(f, i + 1, j - 1, cellp);
+    doNeighbor(f, i + 1, j, cellp);
+    doNeighbor(f, i + 1, j + 1, cellp);
 }
 
 /* applyAttr:
  * Attractive force = weight*(d*d)/K
  *  or        force = (d - L(e))*weight(e)
  */
-static void applyAttr(Agnode_t * p, Agnode_t * q, Agedge_t * e)
+static void applyAttr(forces_t * f, size_t e)
 {
+    const size_t p = f->tail[e];
+    const size_t q = f->head[e];
     double xdelta, ydelta;
     double force;
     double dist;
     double dist2;
 
-    xdelta = ND_pos(q)[0] - ND_pos(p)[0];
-    ydelta = ND_pos(q)[1] - ND_pos(p)[1];
+    xdelta = f->v.x[q] - f->v.x[p];
+    ydelta = f->v.y[q] - f->v.y[p];
     dist2 = xdelta * xdelta + ydelta * ydelta;
-    while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
-	dist2 = xdelta * xdelta + ydelta * ydelta;
-    }
+    if (dist2 == 0.0)
+	dist2 = jitter(f, &xdelta, &ydelta);
     dist = sqrt(dist2);
-    if (T_useNew)
-	force = ED_factor(e) * (dist - ED_dist(e)) / dist;
+    if (f->parms.useNew)
+	force = f->factor[e] * (dist - f->dist[e]) / dist;
     else
-	force = ED_factor(e) * dist / ED_dist(e);
-    DISP(q)[0] -= xdelta * force;
-    DISP(q)[1] -= ydelta * force;
-    DISP(p)[0] += xdelta * force;
-    DISP(p)[1] += ydelta * force;
+	force = f->factor[e] * dist / f->dist[e];
+    f->v.dx[q] -= xdelta * force;
+    f->v.dy[q] -= ydelta * force;
+    f->v.dx[p] += xdelta * force;
+    f->v.dy[p] += ydelta * force;
 }
 
-static void updatePos(Agraph_t * g, double temp, bport_t * pp)
+static void updatePos(forces_t * f, double temp, bport_t * pp)
 {
-    Agnode_t *n;
+    nodes_t *v = &f->v;
     double temp2;
     double len2;
     double x, y, d;
     double dx, dy;
 
     temp2 = temp * temp;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (ND_pinned(n) & P_FIX)
+    for (size_t n = 0; n < f->nnodes; n++) {
+	if (f->fixed[n])
 	    continue;
-	dx = DISP(n)[0];
-	dy = DISP(n)[1];
+	dx = v->dx[n];
+	dy = v->dy[n];
 	len2 = dx * dx + dy * dy;
 
 	/* limit by temperature */
 	if (len2 < temp2) {
-	    x = ND_pos(n)[0] + dx;
-	    y = ND_pos(n)[1] + dy;
+	    x = v->x[n] + dx;
+	    y = v->y[n] + dy;
 	} else {
 	    double fact = temp / sqrt(len2);
-	    x = ND_pos(n)[0] + dx * fact;
-	    y = ND_pos(n)[1] + dy * fact;
+	    x = v->x[n] + dx * fact;
+	    y = v->y[n] + dy * fact;
 	}
 
 	/* if ports, limit by boundary */
 	if (pp) {
-	    d = sqrt(x * x / (T_Wd * T_Wd) + y * y / (T_Ht * T_Ht));
-	    if (IS_PORT(n)) {
-		ND_pos(n)[0] = x / d;
-		ND_pos(n)[1] = y / d;
+	    d = sqrt(x * x / (f->parms.Wd * f->parms.Wd) +
+		     y * y / (f->parms.Ht * f->parms.Ht));
+	    if (v->port[n]) {
+		v->x[n] = x / d;
+		v->y[n] = y / d;
 	    } else if (d >= 1.0) {
-		ND_pos(n)[0] = 0.95 * x / d;
-		ND_pos(n)[1] = 0.95 * y / d;
+		v->x[n] = 0.95 * x / d;
+		v->y[n] = 0.95 * y / d;
 	    } else {
-		ND_pos(n)[0] = x;
-		ND_pos(n)[1] = y;
+		v->x[n] = x;
+		v->y[n] = y;
 	    }
 	} else {
-	    ND_pos(n)[0] = x;
-	    ND_pos(n)[1] = y;
+	    v->x[n] = x;
+	    v->y[n] = y;
 	}
     }
 }
@@ -383,60 +579,69 @@ static void updatePos(Agraph_t * g, double temp, bport_t * pp)
 #define FLOOR(d) ((int)floor(d))
 
 /* gAdjust:
+ * Nodes are bucketed into the grid, and their data gathered into
+ * grid order, so the nodes of each cell are contiguous for gridRepulse.
  */
-static void gAdjust(Agraph_t * g, double temp, bport_t * pp, Grid * grid)
+static void gAdjust(forces_t * f, double temp, bport_t * pp)
 {
-    Agnode_t *n;
-    Agedge_t *e;
+    Grid *grid = f->grid;
+    size_t k;
 
     if (temp <= 0.0)
 	return;
 
     clearGrid(grid);
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	DISP(n)[0] = DISP(n)[1] = 0;
-	addGrid(grid, FLOOR((ND_pos(n))[0] / T_Cell), FLOOR((ND_pos(n))[1] / T_Cell),
-		n);
+    for (k = 0; k < f->nnodes; k++) {
+	f->v.dx[k] = f->v.dy[k] = 0;
+	addGrid(grid, FLOOR(f->v.x[k] / f->parms.Cell),
+		FLOOR(f->v.y[k] / f->parms.Cell), k);
     }
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	for (e = agfstout(g, n); e; e = agnxtout(g, e))
-	    if (n != aghead(e))
-		applyAttr(n, aghead(e), e);
+    for (k = 0; k < f->nedges; k++)
+	applyAttr(f, k);
+
+    sortGrid(grid);
+    for (k = 0; k < f->nnodes; k++) {
+	const size_t n = grid->nodes[k];
+	f->gv.x[k] = f->v.x[n];
+	f->gv.y[k] = f->v.y[n];
+	f->gv.dx[k] = f->v.dx[n];
+	f->gv.dy[k] = f->v.dy[n];
+	f->gv.port[k] = f->v.port[n];
+    }
+    for (k = 0; k < grid->ncells; k++)
+	gridRepulse(f, &grid->cells[k]);
+    for (k = 0; k < f->nnodes; k++) {
+	const size_t n = grid->nodes[k];
+	f->v.dx[n] = f->gv.dx[k];
+	f->v.dy[n] = f->gv.dy[k];
     }
-    walkGrid(grid, gridRepulse);
-
 
-    updatePos(g, temp, pp);
+    updatePos(f, temp, pp);
 }
 
 /* adjust:
  */
-static void adjust(Agraph_t * g, double temp, bport_t * pp)
+static void adjust(forces_t * f, double temp, bport_t * pp)
 {
-    Agnode_t *n;
-    Agnode_t *n1;
-    Agedge_t *e;
+    size_t n;
+    size_t e = 0;
 
     if (temp <= 0.0)
 	return;
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	DISP(n)[0] = DISP(n)[1] = 0;
+    for (n = 0; n < f->nnodes; n++) {
+	f->v.dx[n] = f->v.dy[n] = 0;
     }
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	for (n1 = agnxtnode(g, n); n1; n1 = agnxtnode(g, n1)) {
-	    applyRep(n, n1);
-	}
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    if (n != aghead(e))
-		applyAttr(n, aghead(e), e);
-	}
+    for (n = 0; n < f->nnodes; n++) {
+	applyRep(f, &f->v, n, n + 1, f->nnodes - n - 1, false);
+	for (; e < f->nedges && f->tail[e] == n; e++)
+	    applyAttr(f, e);
     }
 
-    updatePos(g, temp, pp);
+    updatePos(f, temp, pp);
 }
 
 /* initPositions:
@@ -606,47 +811,76 @@ static pointf initPositions(graph_t * g, bport_t * pp)
     return ctr;
 }
 
-/* fdp_tLayout:
- * Given graph g with ports nodes, layout g respecting ports.
+/* A force-directed layout of a single graph, split into phases
+ * so the layouts of unrelated graphs can run at the same time.
+ */
+struct tlayout_s {
+    graph_t *g;
+    bport_t *pp;		/* ports of g */
+    pointf ctr;			/* center of the initial layout */
+    forces_t f;
+};
+
+/* fdp_tLayoutInit:
+ * Set up the layout of g with ports nodes, placing the nodes initially.
  * If some node have position information, it may be useful to
  * reset temperature and other parameters to reflect this.
  */
-void fdp_tLayout(graph_t * g, xparams * xpms)
+tlayout_t *fdp_tLayoutInit(graph_t * g, xparams * xpms)
 {
-    int i;
+    tlayout_t *t = gv_alloc(sizeof(tlayout_t));
     int reset;
-    bport_t *pp = PORTS(g);
-    double temp;
-    Grid *grid;
-    pointf ctr;
-    Agnode_t *n;
 
+    t->g = g;
+    t->pp = PORTS(g);
     reset = init_params(g, xpms);
-    temp = T_T0;
-
-    ctr = initPositions(g, pp);
+    t->ctr = initPositions(g, t->pp);
+    t->f = mkForces(g);
+    if (reset)
+	reset_params();
+    return t;
+}
 
-    if (T_useGrid) {
-	grid = mkGrid(agnnodes(g));
-	adjustGrid(grid, agnnodes(g));
-	for (i = 0; i < T_loopcnt; i++) {
-	    temp = cool(i);
-	    gAdjust(g, temp, pp, grid);
-	}
-	delGrid(grid);
-    } else {
-	for (i = 0; i < T_loopcnt; i++) {
-	    temp = cool(i);
-	    adjust(g, temp, pp);
-	}
+/* fdp_tLayoutRun:
+ * Run the force-directed iterations of layout t. This only touches
+ * data private to t, so layouts can run concurrently.
+ */
+void fdp_tLayoutRun(tlayout_t * t)
+{
+    forces_t *f = &t->f;
+
+    for (int i = 0; i < f->parms.loopcnt; i++) {
+	double temp = cool(&f->parms, i);
+	if (f->parms.useGrid)
+	    gAdjust(f, temp, t->pp);
+	else
+	    adjust(f, temp, t->pp);
     }
+}
 
-    if (ctr.x != 0.0 || ctr.y != 0.0) {
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	    ND_pos(n)[0] += ctr.x;
-	    ND_pos(n)[1] += ctr.y;
+/* fdp_tLayoutFinish:
+ * Store the positions computed by layout t in its graph, and free t.
+ */
+void fdp_tLayoutFinish(tlayout_t * t)
+{
+    Agnode_t *n;
+
+    freeForces(&t->f);
+    if (t->ctr.x != 0.0 || t->ctr.y != 0.0) {
+	for (n = agfstnode(t->g); n; n = agnxtnode(t->g, n)) {
+	    ND_pos(n)[0] += t->ctr.x;
+	    ND_pos(n)[1] += t->ctr.y;
 	}
     }
-    if (reset)
-	reset_params();
+    free(t);
+}
+
+/* fdp_tLayout:
+ * Given graph g with ports nodes, layout g respecting ports.
+ */
+void fdp_tLayout(graph_t * g, xparams * xpms)
+{
+    tlayout_t *t = fdp_tLayoutInit(g, xpms);
+    fdp_tLayoutRun(t);
+    fdp_tLayoutFinish(t);
 }
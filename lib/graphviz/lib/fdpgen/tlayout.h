@@ -17,8 +17,13 @@ extern "C" {
 #include <fdpgen/fdp.h>
 #include <fdpgen/xlayout.h>
 
+    typedef struct tlayout_s tlayout_t;
+
     extern void fdp_initParams(graph_t *);
     extern void fdp_tLayout(graph_t *, xparams *);
+    extern tlayout_t *fdp_tLayoutInit(graph_t *, xparams *);
+    extern void fdp_tLayoutRun(tlayout_t *);
+    extern void fdp_tLayoutFinish(tlayout_t *);
 
 #ifdef __cplusplus
 }
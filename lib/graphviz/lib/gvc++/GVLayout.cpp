@@ -8,6 +8,7 @@
 #include "GVLayout.h"
 #include "GVRenderData.h"
 #include <cgraph++/AGraph.h>
+#include <cgraph++/graph_lock.h>
 #include <gvc/gvc.h>
 
 namespace GVC {
@@ -16,6 +17,7 @@ GVLayout::GVLayout(const std::shared_ptr<GVContext> &gvc,
                    const std::shared_ptr<CGraph::AGraph> &g,
                    const std::string &engine)
     : m_gvc(gvc), m_g(g) {
+  const auto lock = CGraph::lock_graphs();
   if (gvLayoutDone(g->c_struct())) {
     gvFreeLayout(gvc->c_struct(), g->c_struct());
     throw std::runtime_error("Previous layout not yet destroyed");
@@ -46,12 +48,14 @@ GVLayout::~GVLayout() {
   if (!m_gvc || !m_g) {
     return;
   }
+  const auto lock = CGraph::lock_graphs();
   gvFreeLayout(m_gvc->c_struct(), m_g->c_struct());
 }
 
 GVRenderData GVLayout::render(const std::string &format) const {
   char *result = nullptr;
   unsigned int length = 0;
+  const auto lock = CGraph::lock_graphs();
   const auto rc = gvRenderData(m_gvc->c_struct(), m_g->c_struct(),
                                format.c_str(), &result, &length);
   if (rc) {
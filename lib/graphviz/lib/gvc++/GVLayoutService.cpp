@@ -0,0 +1,106 @@
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "GVContext.h"
+#include "GVLayoutService.h"
+#include "GVRenderData.h"
+#include <cgraph++/AGraph.h>
+#include <cgraph++/graph_lock.h>
+#include <gvc/gvc.h>
+
+namespace GVC {
+
+GVLayoutService::GVLayoutService(std::shared_ptr<GVContext> gvc)
+    : m_gvc(std::move(gvc)) {
+  m_worker = std::thread([this] { run(); });
+}
+
+GVLayoutService::~GVLayoutService() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_ready.notify_one();
+  m_worker.join();
+}
+
+std::future<GVRenderData>
+GVLayoutService::submit(std::shared_ptr<CGraph::AGraph> g,
+                        const std::string &engine, const std::string &format) {
+  return enqueue(Job{std::move(g), {}, engine, format, {}});
+}
+
+std::future<GVRenderData> GVLayoutService::submit(const std::string &dot,
+                                                  const std::string &engine,
+                                                  const std::string &format) {
+  return enqueue(Job{nullptr, dot, engine, format, {}});
+}
+
+std::future<GVRenderData> GVLayoutService::enqueue(Job job) {
+  auto result = job.result.get_future();
+  {
+    std::lock_guard lock(m_mutex);
+    m_jobs.push(std::move(job));
+  }
+  m_ready.notify_one();
+  return result;
+}
+
+void GVLayoutService::run() {
+  while (true) {
+    std::optional<Job> job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_ready.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_jobs.empty()) { // stopping, and nothing left to do
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop();
+    }
+    try {
+      job->result.set_value(process(*job));
+    } catch (...) {
+      job->result.set_exception(std::current_exception());
+    }
+  }
+}
+
+GVRenderData GVLayoutService::process(Job &job) const {
+  // The job gives up its reference, so if the caller has dropped theirs, or
+  // the graph was parsed here, it is closed on return. Parsing and closing
+  // take the lock themselves, so the graph is declared before it.
+  const auto graph = job.graph ? std::move(job.graph)
+                               : std::make_shared<CGraph::AGraph>(job.dot);
+  const auto lock = CGraph::lock_graphs();
+  GVC_t *const gvc = m_gvc->c_struct();
+  Agraph_t *const g = graph->c_struct();
+
+  if (gvLayoutDone(g)) {
+    throw std::runtime_error("Previous layout not yet destroyed");
+  }
+  if (gvLayout(gvc, g, job.engine.c_str())) {
+    throw std::runtime_error("Layout failed");
+  }
+
+  char *result = nullptr;
+  unsigned int length = 0;
+  const auto rc = gvRenderData(gvc, g, job.format.c_str(), &result, &length);
+  gvFreeLayout(gvc, g);
+  if (rc) {
+    if (result) {
+      gvFreeRenderData(result);
+    }
+    throw std::runtime_error("Rendering failed");
+  }
+
+  return GVRenderData(result, length);
+}
+
+} // namespace GVC
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+#include "AGraph.h"
+#include "GVContext.h"
+#include "GVRenderData.h"
+
+#ifdef GVDLL
+#if gvc___EXPORTS // CMake's substitution of gvc++_EXPORTS
+#define GVLAYOUTSERVICE_API __declspec(dllexport)
+#else
+#define GVLAYOUTSERVICE_API __declspec(dllimport)
+#endif
+#endif
+
+#ifndef GVLAYOUTSERVICE_API
+#define GVLAYOUTSERVICE_API /* nothing */
+#endif
+
+namespace GVC {
+
+/**
+ * @brief The GVLayoutService class is a serial queue of graphs to lay out and
+ * render in the background
+ *
+ * Jobs may be submitted from any number of threads. Each is laid out, rendered
+ * and has its layout freed again on a single worker thread owned by the
+ * service, and its result, or the exception that stopped it, is delivered
+ * through a future. All jobs share the service's context, so plugins are
+ * loaded only once.
+ *
+ * This is not a thread pool. The layout engines are not reentrant, so jobs run
+ * one at a time, in order of submission, and exclude any `GVLayout` and the
+ * construction and destruction of any `CGraph::AGraph` on other threads for as
+ * long as they run. Submitting jobs from several threads therefore does not
+ * make them finish sooner than submitting them from one; the service only
+ * moves the work off the calling threads.
+ */
+
+class GVLAYOUTSERVICE_API GVLayoutService {
+public:
+  explicit GVLayoutService(std::shared_ptr<GVContext> gvc);
+
+  /// finish all submitted jobs and stop the worker
+  ~GVLayoutService();
+
+  // neither copy nor move, since the worker refers to this object
+  GVLayoutService(const GVLayoutService &) = delete;
+  GVLayoutService &operator=(const GVLayoutService &) = delete;
+  GVLayoutService(GVLayoutService &&) = delete;
+  GVLayoutService &operator=(GVLayoutService &&) = delete;
+
+  /// lay out and render a graph
+  ///
+  /// The graph must not be laid out already, and must not be used by the
+  /// caller until the result is ready. It may be created and released on any
+  /// thread.
+  ///
+  /// @param g Graph to lay out
+  /// @param engine Name of the layout engine, e.g. "dot"
+  /// @param format Output format, e.g. "svg"
+  std::future<GVRenderData> submit(std::shared_ptr<CGraph::AGraph> g,
+                                   const std::string &engine,
+                                   const std::string &format);
+
+  /// parse, lay out and render a graph given as DOT source
+  ///
+  /// Parsing also happens on the worker.
+  std::future<GVRenderData> submit(const std::string &dot,
+                                   const std::string &engine,
+                                   const std::string &format);
+
+private:
+  /// a graph to lay out, either parsed already or as DOT source
+  struct Job {
+    std::shared_ptr<CGraph::AGraph> graph;
+    std::string dot;
+    std::string engine;
+    std::string format;
+    std::promise<GVRenderData> result;
+  };
+
+  std::future<GVRenderData> enqueue(Job job);
+  void run();
+  GVRenderData process(Job &job) const;
+
+  std::shared_ptr<GVContext> m_gvc;
+
+  std::mutex m_mutex; ///< guards `m_jobs` and `m_stopping`
+  std::condition_variable m_ready;
+  std::queue<Job> m_jobs;
+  bool m_stopping = false;
+
+  std::thread m_worker;
+};
+
+} // namespace GVC
+
+#undef GVLAYOUTSERVICE_API
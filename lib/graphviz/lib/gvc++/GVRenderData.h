@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <string_view>
+#include <utility>
 
 #ifdef GVDLL
 #if gvc___EXPORTS // CMake's substitution of gvc++_EXPORTS
@@ -18,6 +19,7 @@
 namespace GVC {
 
 class GVLayout;
+class GVLayoutService;
 
 /**
  * @brief The GVRenderData class represents a rendered layout in a specific text
@@ -33,10 +35,16 @@ public:
   GVRenderData(GVRenderData &) = delete;
   GVRenderData &operator=(GVRenderData &) = delete;
 
-  // delete move for now since we cannot use default because we manage a C
-  // string using a raw pointer
-  GVRenderData(GVRenderData &&) = delete;
-  GVRenderData &operator=(GVRenderData &&) = delete;
+  // implement move since we manage a C string using a raw pointer
+  GVRenderData(GVRenderData &&other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)),
+        m_length(std::exchange(other.m_length, 0)) {}
+  GVRenderData &operator=(GVRenderData &&other) noexcept {
+    using std::swap;
+    swap(m_data, other.m_data);
+    swap(m_length, other.m_length);
+    return *this;
+  }
 
   // get the rendered string as a C string. The string is null terminated, but
   // that is not useful for binary formats. Combine with the length method for
@@ -52,9 +60,11 @@ public:
   }
 
   friend GVLayout;
+  friend GVLayoutService;
 
 private:
-  // use GVLayout::render to constuct a GVRenderData object
+  // use GVLayout::render or GVLayoutService::submit to construct a
+  // GVRenderData object
   GVRenderData(char *rendered_data, std::size_t length);
 
   // the underlying C data structure
@@ -92,12 +92,14 @@ int gvRender(GVC_t *gvc, graph_t *g, const char *format, FILE *out)
     if (!r) {
         agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
                 format, gvplugin_list(gvc, API_device, format));
+        gvjobs_delete(gvc);
         return -1;
     }
 
     job->output_lang = gvrender_select(job, job->output_langname);
     if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
 	agerrorf( "Layout was not done\n");
+	gvjobs_delete(gvc);
 	return -1;
     }
     job->output_file = out;
@@ -122,12 +124,14 @@ int gvRenderFilename(GVC_t *gvc, graph_t *g, const char *format, const char *fil
     if (!r) {
 	agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
                 format, gvplugin_list(gvc, API_device, format));
+	gvjobs_delete(gvc);
 	return -1;
     }
 
     job->output_lang = gvrender_select(job, job->output_langname);
     if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
 	agerrorf( "Layout was not done\n");
+	gvjobs_delete(gvc);
 	return -1;
     }
     gvjobs_output_filename(gvc, filename);
@@ -151,12 +155,14 @@ int gvRenderContext(GVC_t *gvc, graph_t *g, const char *format, void *context)
     if (!r) {
 		agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
 			  format, gvplugin_list(gvc, API_device, format));
+		gvjobs_delete(gvc);
 		return -1;
     }
 	
     job->output_lang = gvrender_select(job, job->output_langname);
     if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
 	agerrorf( "Layout was not done\n");
+		gvjobs_delete(gvc);
 		return -1;
     }
 	
@@ -183,12 +189,14 @@ int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result, unsi
     if (!r) {
 	agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
                 format, gvplugin_list(gvc, API_device, format));
+	gvjobs_delete(gvc);
 	return -1;
     }
 
     job->output_lang = gvrender_select(job, job->output_langname);
     if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
 	agerrorf( "Layout was not done\n");
+	gvjobs_delete(gvc);
 	return -1;
     }
 
@@ -197,6 +205,7 @@ int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result, unsi
 
     if(!result || !(*result = malloc(OUTPUT_DATA_INITIAL_ALLOCATION))) {
 	agerrorf("failure malloc'ing for result string");
+	gvjobs_delete(gvc);
 	return -1;
     }
 
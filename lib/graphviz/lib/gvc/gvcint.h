@@ -82,6 +82,8 @@ extern "C" {
 
 	char *config_path;
 	bool config_found;
+	bool config_stale; /* config file was older than a plugin library */
+	double config_secs; /* wall clock time taken to configure plugins */
 
 	/* gvParseArgs */
 	char **input_filenames; /* null terminated array of input filenames */
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include	<string.h>
+#include <time.h>
 #include <unistd.h>
 #include <util/alloc.h>
 #include <util/exit.h>
@@ -56,6 +57,10 @@ static int glob (GVC_t * gvc, char*, int, int (*errfunc)(const char *, int), glo
 #include <mach-o/dyld.h>
 #endif
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include        <common/const.h>
 #include        <common/types.h>
 
@@ -67,6 +72,20 @@ static int glob (GVC_t * gvc, char*, int, int (*errfunc)(const char *, int), glo
 /* FIXME */
 extern void textfont_dict_open(GVC_t *gvc);
 
+/// seconds on a monotonic wall clock, for timing the plugin configuration
+static double wall_secs(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
 /*
     A config for gvrender is a text file containing a
     list of plugin libraries and their capabilities using a tcl-like
@@ -214,6 +233,49 @@ static int gvconfig_plugin_install_from_config(GVC_t * gvc, char *s)
     }
     return 1;
 }
+
+/* config_is_stale:
+ * Is a plugin library listed in the config text missing, or modified after
+ * the config file was written? If so, the config may not describe the
+ * libraries that would be loaded.
+ */
+static bool config_is_stale(GVC_t *gvc, const char *config_text,
+                            const struct stat *config_st)
+{
+    char *text = gv_strdup(config_text);
+    char *s = text;
+    int nest = 0;
+    bool stale = false;
+
+    separator(&nest, &s);
+    while (*s && !stale) {
+	const char *package_path = token(&nest, &s);
+	if (nest == 0)
+	    (void)token(&nest, &s); /* package name */
+	while (*s && nest > 0) /* skip the package's apis and types */
+	    (void)token(&nest, &s);
+
+	agxbuf fullpath = {0};
+#ifdef _WIN32
+	if (package_path[0] != '\0' && package_path[1] == ':') {
+#else
+	if (package_path[0] == '/') {
+#endif
+	    agxbput(&fullpath, package_path);
+	} else {
+	    agxbprint(&fullpath, "%s%s%s", gvconfig_libdir(gvc), DIRSEP,
+	              package_path);
+	}
+	struct stat lib_st;
+	if (stat(agxbuse(&fullpath), &lib_st) != 0
+	    || lib_st.st_mtime > config_st->st_mtime) {
+	    stale = true;
+	}
+	agxbfree(&fullpath);
+    }
+    free(text);
+    return stale;
+}
 #endif
 
 void gvconfig_plugin_install_from_library(GVC_t * gvc, char *package_path,
@@ -560,11 +622,13 @@ void gvconfig(GVC_t * gvc, bool rescan)
     char *config_file_name = GVPLUGIN_CONFIG_FILE;
 
 #endif
+    const double start = wall_secs();
     
     /* builtins don't require LTDL */
     gvconfig_plugin_install_builtins(gvc);
    
     gvc->config_found = false;
+    gvc->config_stale = false;
 #ifdef ENABLE_LTDL
     if (gvc->common.demand_loading) {
         /* see if there are any new plugins */
@@ -614,7 +678,17 @@ void gvconfig(GVC_t * gvc, bool rescan)
     	        else {
     	            gvc->config_found = true;
     	            config_text[sz] = '\0';  /* make input into a null terminated string */
-    	            rc = gvconfig_plugin_install_from_config(gvc, config_text);
+    	            /* A library installed or updated since the config was
+    	             * written may have different plugins. Rather than trust
+    	             * the config, find out what the libraries provide, as
+    	             * "dot -c" would, but without writing it out.
+    	             */
+    	            if (config_is_stale(gvc, config_text, &config_st)) {
+    	                gvc->config_stale = true;
+    	                config_rescan(gvc, NULL);
+    	            } else {
+    	                rc = gvconfig_plugin_install_from_config(gvc, config_text);
+    	            }
     	        }
     	        free(config_text);
     	    }
@@ -627,6 +701,7 @@ done:
 #endif
     gvtextlayout_select(gvc);   /* choose best available textlayout plugin immediately */
     textfont_dict_open(gvc);    /* initialize font dict */
+    gvc->config_secs = wall_secs() - start;
 }
 
 #ifdef ENABLE_LTDL
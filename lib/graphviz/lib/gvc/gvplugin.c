@@ -453,7 +453,10 @@ void gvplugin_write_status(GVC_t * gvc)
 #ifdef ENABLE_LTDL
     if (gvc->common.demand_loading) {
         fprintf(stderr, "The plugin configuration file:\n\t%s\n", gvc->config_path);
-        if (gvc->config_found)
+        if (gvc->config_stale)
+            fprintf(stderr, "\t\tis older than a plugin library, so the libraries were scanned instead.\n"
+                            "\t\tRun \"dot -c\" to update it.\n");
+        else if (gvc->config_found)
             fprintf(stderr, "\t\twas successfully loaded.\n");
         else
             fprintf(stderr, "\t\twas not found or not usable. No on-demand plugins.\n");
@@ -461,6 +464,7 @@ void gvplugin_write_status(GVC_t * gvc)
         fprintf(stderr, "Demand loading of plugins is disabled.\n");
     }
 #endif
+    fprintf(stderr, "Plugins configured in %.2f msec\n", gvc->config_secs * 1000);
 
     for (api = 0; api < (int)ARRAY_SIZE(api_names); api++) {
         if (gvc->common.verbose >= 2)
@@ -385,6 +385,29 @@ setattr (Agobj_t *objp, char* name, char* val)
     return agxset(objp, gsym, val);
 }
 
+/* attrSym:
+ * Return the attribute symbol named by id for objp, or NULL if the
+ * attribute is not declared. All objects of a given kind share the symbol
+ * dictionary of their root graph, so the result is cached per (id, root,
+ * kind) to avoid repeating the record and dictionary searches of agattrsym
+ * on every attribute reference.
+ */
+static Agsym_t *attrSym(Gpr_t *state, Agobj_t *objp, const Exid_t *id)
+{
+    Agraph_t *root = agroot(agraphof(objp));
+    const int kind = AGTYPE(objp);
+    const uintptr_t h = ((uintptr_t)id >> 4) ^ ((uintptr_t)root >> 4) ^ (uintptr_t)kind;
+    attrcache_t *entry = &state->attrcache[h % ATTR_CACHE_SIZE];
+
+    if (entry->id == id && entry->root == root && entry->kind == kind)
+	return entry->sym;
+
+    Agsym_t *gsym = agattrsym(objp, (char *)id->name);
+    if (gsym)
+	*entry = (attrcache_t){.id = id, .root = root, .kind = kind, .sym = gsym};
+    return gsym;
+}
+
 /* kindToStr:
  */
 static char*
@@ -419,7 +442,8 @@ kindOf (Agobj_t* objp)
  * Apply symbol to get field value of objp
  * Assume objp != NULL
  */
-static int lookup(Expr_t *pgm, Agobj_t *objp, Exid_t *sym, Extype_t * v) {
+static int lookup(Expr_t *pgm, Gpr_t *state, Agobj_t *objp, Exid_t *sym,
+                  Extype_t *v) {
     if (sym->lex == ID) {
 	switch (sym->index) {
 	case M_head:
@@ -535,7 +559,7 @@ static int lookup(Expr_t *pgm, Agobj_t *objp, Exid_t *sym, Extype_t * v) {
 	    break;
 	}
     } else {
-	Agsym_t *gsym = agattrsym(objp, sym->name);
+	Agsym_t *gsym = attrSym(state, objp, sym);
 	if (!gsym) {
 	    gsym = agattr(agroot(agraphof(objp)), AGTYPE(objp), sym->name, "");
 	    agxbuf tmp = {0};
@@ -1237,9 +1261,10 @@ getval(Expr_t * pgm, Exnode_t * node, Exid_t * sym, Exref_t * ref,
 		v.integer = agisstrict(gp);
 	    }
 	    break;
-	case F_delete:
+	case F_delete: {
 	    gp = int2ptr(args[0].integer);
 	    objp = int2ptr(args[1].integer);
+	    const bool is_graph = objp != NULL && AGTYPE(objp) == AGRAPH;
 	    if (!objp) {
 		error(ERROR_WARNING, "NULL object passed to delete()");
 		v.integer = 1;
@@ -1254,14 +1279,19 @@ getval(Expr_t * pgm, Exnode_t * node, Exid_t * sym, Exref_t * ref,
 		    state->curobj = NULL;
 	    } else
 		v.integer = deleteObj(gp, objp);
+	    if (is_graph)
+		flushAttrCache(state);
 	    break;
+	}
 	case F_lock:
 	    gp = int2ptr(args[0].integer);
 	    if (!gp) {
 		error(ERROR_WARNING, "NULL graph passed to lock()");
 		v.integer = -1;
-	    } else
+	    } else {
 		v.integer = lockGraph(gp, args[1].integer);
+		flushAttrCache(state);
+	    }
 	    break;
 	case F_nnodes:
 	    gp = int2ptr(args[0].integer);
@@ -1587,7 +1617,7 @@ getval(Expr_t * pgm, Exnode_t * node, Exid_t * sym, Exref_t * ref,
     }
 
     if (objp) {
-	if (lookup(pgm, objp, sym, &v)) {
+	if (lookup(pgm, state, objp, sym, &v)) {
 	    agxbuf xb = {0};
 	    exerror("in expression %s", deparse(pgm, node, &xb));
 	    agxbfree(&xb);
@@ -1684,7 +1714,10 @@ setval(Expr_t * pgm, Exnode_t * x, Exid_t * sym, Exref_t * ref,
     }
     
     assignable (objp, (unsigned char*)sym->name);
-    return setattr(objp, sym->name, v.string);
+    Agsym_t *gsym = attrSym(state, objp, sym);
+    if (!gsym)
+	gsym = agattr(agroot(agraphof(objp)), AGTYPE(objp), sym->name, "");
+    return agxset(objp, gsym, v.string);
 }
 
 static int codePhase;
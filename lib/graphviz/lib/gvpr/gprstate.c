@@ -31,6 +31,15 @@ void initGPRState(Gpr_t *state) {
   state->tgtname = strdup("gvpr_result");
 }
 
+/* flushAttrCache:
+ * Forget all resolved attribute symbols. This must be called whenever a
+ * root graph may have been closed, as a later graph could be allocated at
+ * the same address.
+ */
+void flushAttrCache(Gpr_t *state) {
+  memset(state->attrcache, 0, sizeof(state->attrcache));
+}
+
 Gpr_t *openGPRState(gpr_info* info)
 {
     Gpr_t *state;
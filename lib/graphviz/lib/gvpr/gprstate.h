@@ -31,6 +31,17 @@ extern "C" {
                    TV_prepostdfs, TV_prepostfwd, TV_prepostrev,
     } trav_type;
 
+/// a resolved attribute reference, see `attrSym` in compile.c
+typedef struct {
+  const Exid_t *id;   ///< program symbol naming the attribute
+  Agraph_t *root;     ///< root graph the attribute is declared in
+  int kind;           ///< object kind the attribute applies to
+  Agsym_t *sym;       ///< the attribute itself
+} attrcache_t;
+
+/// number of entries in the attribute symbol cache
+#define ATTR_CACHE_SIZE 64
+
     typedef struct {
 	Agraph_t *curgraph;
 	Agraph_t *nextgraph;
@@ -53,6 +64,7 @@ extern "C" {
 	int flags;
 	gvprbinding* bindings;
 	size_t n_bindings;
+	attrcache_t attrcache[ATTR_CACHE_SIZE];
 	jmp_buf jbuf;
     } Gpr_t;
 
@@ -70,6 +82,7 @@ extern "C" {
     extern gvprbinding* findBinding(Gpr_t* state, char*);
     extern void closeGPRState(Gpr_t* state);
     extern void initGPRState(Gpr_t *);
+    extern void flushAttrCache(Gpr_t *);
     extern bool validTVT(long long);
 
 #ifdef __cplusplus
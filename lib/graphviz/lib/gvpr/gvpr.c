@@ -1025,8 +1025,10 @@ static int gvpr_core(int argc, char *argv[], gvpropts *uopts,
 		    sfioWrite(gs->state->outgraph, gs->opts.outFile);
 	    }
 
-	    if (!incoreGraphs)
+	    if (!incoreGraphs) {
 		chkClose(gs->state->curgraph);
+		flushAttrCache(gs->state);
+	    }
 	    gs->state->target = 0;
 	    gs->state->outgraph = 0;
 	
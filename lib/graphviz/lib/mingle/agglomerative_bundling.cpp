@@ -329,7 +329,7 @@ static aib_t Agglomerative_Ink_Bundling_new(SparseMatrix A0,
 static void agglomerative_ink_bundling_internal(
     int dim, SparseMatrix A, std::vector<pedge> &edges, int nneighbors,
     int *recurse_level, int MAX_RECURSE_LEVEL, double angle_param, double angle,
-    double *current_ink, double *ink00) {
+    double *current_ink, double *ink00, int nthreads) {
 
   int i, j, jj, k;
   int *ia, *ja;
@@ -453,9 +453,9 @@ static void agglomerative_ink_bundling_internal(
       mid_edges[i] = pedge_wgt_new(2, dim, &xx.data()[i*4], wgt);
     }
 
-    A_mid = nearest_neighbor_graph(ne, std::min(nneighbors, ne), xx);
+    A_mid = nearest_neighbor_graph(ne, std::min(nneighbors, ne), xx, nthreads);
 
-    agglomerative_ink_bundling_internal(dim, A_mid, mid_edges, nneighbors, recurse_level, MAX_RECURSE_LEVEL, angle_param, angle, current_ink, ink00);
+    agglomerative_ink_bundling_internal(dim, A_mid, mid_edges, nneighbors, recurse_level, MAX_RECURSE_LEVEL, angle_param, angle, current_ink, ink00, nthreads);
     SparseMatrix_delete(A_mid);
 
     /* patching edges with the new mid-section */
@@ -503,14 +503,14 @@ static void agglomerative_ink_bundling_internal(
 void agglomerative_ink_bundling(int dim, SparseMatrix A,
                                 std::vector<pedge> &edges, int nneighbor,
                                 int MAX_RECURSE_LEVEL, double angle_param,
-                                double angle) {
+                                double angle, int nthreads) {
   int recurse_level = 0;
   double current_ink = -1, ink0;
 
   ink_count = 0;
   agglomerative_ink_bundling_internal(dim, A, edges, nneighbor, &recurse_level,
                                       MAX_RECURSE_LEVEL, angle_param, angle,
-                                      &current_ink, &ink0);
+                                      &current_ink, &ink0, nthreads);
 
   if (Verbose > 1)
     fprintf(stderr,"initial total ink = %f, final total ink = %f, inksaving = %f percent, total ink_calc = %f, avg ink_calc per edge = %f\n", ink0, current_ink, (ink0-current_ink)/ink0, ink_count,  ink_count/(double) A->m);
@@ -15,4 +15,4 @@
 void agglomerative_ink_bundling(int dim, SparseMatrix A,
                                 std::vector<pedge> &edges, int nneighbor,
                                 int max_recursion, double angle_param,
-                                double angle);
+                                double angle, int nthreads);
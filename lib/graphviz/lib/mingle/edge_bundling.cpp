@@ -20,6 +20,7 @@
 #include <mingle/ink.h>
 #include <mingle/agglomerative_bundling.h>
 #include <string.h>
+#include <util/gv_parallel.h>
 #include <vector>
 
 #define SMALL 1.e-10
@@ -399,48 +400,92 @@ static void edge_attraction_force(double similarity, const pedge &e1,
 
 }
 
+/// compute the new interior points of edge i, into xout
+static void edge_update(SparseMatrix A, const std::vector<pedge> &edges, int i,
+                        double step, double K, std::vector<double> &force_t,
+                        std::vector<double> &force_a, double *xout) {
+  const int *ia = A->ia, *ja = A->ja;
+  const double *a = (double*) A->a;
+  const pedge &e1 = edges[i];
+  const int np = e1.npoints, dim = e1.dim;
+  double fnorm_a, fnorm_t, edge_length;
+  int j, k;
+
+  for (j = 0; j < dim*np; j++) {
+    force_t[j] = 0.;
+    force_a[j] = 0.;
+  }
+  edge_tension_force(force_t, e1);
+  for (j = ia[i]; j < ia[i+1]; j++){
+    const pedge &e2 = edges[ja[j]];
+    edge_attraction_force(a[j], e1, e2, force_a);
+  }
+  fnorm_t = std::max(SMALL, norm(dim * (np - 2), &force_t.data()[dim]));
+  fnorm_a = std::max(SMALL, norm(dim * (np - 2), &force_a.data()[dim]));
+  edge_length = e1.edge_length;
+
+  for (j = 1; j <= np - 2; j++){
+    for (k = 0; k < dim; k++) {
+      xout[j * dim + k] = e1.x[j * dim + k] + step * edge_length
+                        * (force_t[j * dim + k] + K * force_a[j * dim+k])
+                        / hypot(fnorm_t, K * fnorm_a);
+    }
+  }
+}
+
+/// adapt a callable to the callback of `gv_parallel_for_n`
+template <typename F> static void call(void *f, size_t i) {
+  (*static_cast<F *>(f))(i);
+}
+
+/// edges moved by one work item, which share its scratch space
+enum { CHUNK_EDGES = 64 };
+
+/* force_directed_edge_bundling:
+ * With a single thread, edges are moved one at a time, each seeing the moves
+ * made before it (Gauss-Seidel). With more threads, all edges are moved at
+ * once from the positions of the previous iteration (Jacobi), which gives the
+ * same result whatever the number of threads.
+ */
 static void force_directed_edge_bundling(SparseMatrix A,
                                          std::vector<pedge> &edges, int maxit,
-                                         double step0, double K) {
-  int i, j, ne = A->n, k;
-  int *ia = A->ia, *ja = A->ja, iter = 0;
-  double *a = (double*) A->a;
+                                         double step0, double K, int nthreads) {
+  int i, ne = A->n, iter = 0;
   const int np = edges[0].npoints, dim = edges[0].dim;
   double step = step0;
-  double fnorm_a, fnorm_t, edge_length, start;
+  double start;
   
   if (Verbose > 1)
     fprintf(stderr, "total interaction pairs = %d out of %d, avg neighbors per edge = %f\n",A->nz, A->m*A->m, A->nz/(double) A->m);
 
   std::vector<double> force_t(dim * np);
   std::vector<double> force_a(dim * np);
+  std::vector<double> xnew;
+  if (nthreads > 1)
+    xnew.resize((size_t)ne * dim * np);
   while (step > 0.001 && iter < maxit){
     start = clock();
     iter++;
-    for (i = 0; i < ne; i++){
-      for (j = 0; j < dim*np; j++) {
-	force_t[j] = 0.;
-	force_a[j] = 0.;
-      }
-      pedge &e1 = edges[i];
-      std::vector<double> &x = e1.x;
-      edge_tension_force(force_t, e1);
-      for (j = ia[i]; j < ia[i+1]; j++){
-	const pedge &e2 = edges[ja[j]];
-	edge_attraction_force(a[j], e1, e2, force_a);
+    if (nthreads > 1) {
+      auto update = [&](size_t chunk) {
+        std::vector<double> ft(dim * np), fa(dim * np);
+        const int begin = (int)chunk * CHUNK_EDGES;
+        const int end = std::min(ne, begin + CHUNK_EDGES);
+        for (int l = begin; l < end; l++) {
+          edge_update(A, edges, l, step, K, ft, fa, &xnew[(size_t)l * dim * np]);
+        }
+      };
+      const size_t nchunks = ((size_t)ne + CHUNK_EDGES - 1) / CHUNK_EDGES;
+      gv_parallel_for_n((size_t)nthreads, nchunks, call<decltype(update)>,
+                        &update);
+      for (i = 0; i < ne; i++){
+        std::copy_n(&xnew[((size_t)i * np + 1) * dim], dim * (np - 2),
+                    &edges[i].x[dim]);
       }
-      fnorm_t = std::max(SMALL, norm(dim * (np - 2), &force_t.data()[dim]));
-      fnorm_a = std::max(SMALL, norm(dim * (np - 2), &force_a.data()[dim]));
-      edge_length = e1.edge_length;
-
-      for (j = 1; j <= np - 2; j++){
-	for (k = 0; k < dim; k++) {
-	  x[j * dim + k] += step * edge_length
-	                  * (force_t[j * dim + k] + K * force_a[j * dim+k])
-	                  / hypot(fnorm_t, K * fnorm_a);
-	}
+    } else {
+      for (i = 0; i < ne; i++){
+        edge_update(A, edges, i, step, K, force_t, force_a, edges[i].x.data());
       }
-      
     }
     step = step*0.9;
   if (Verbose > 1)
@@ -506,7 +551,8 @@ static void modularity_ink_bundling(int dim, int ne, SparseMatrix B,
 
 static SparseMatrix check_compatibility(SparseMatrix A, int ne,
                                         const std::vector<pedge> &edges,
-                                        int compatibility_method, double tol) {
+                                        int compatibility_method, double tol,
+                                        int nthreads) {
   /* go through the links and make sure edges are compatible */
   SparseMatrix B, C;
   int *ia, *ja, i, j, jj;
@@ -516,15 +562,27 @@ static SparseMatrix check_compatibility(SparseMatrix A, int ne,
   B = SparseMatrix_new(1, 1, 1, MATRIX_TYPE_REAL, FORMAT_COORD);
   ia = A->ia; ja = A->ja;
   start = clock();
+
+  /* compatibility of every link, computed independently */
+  std::vector<double> dists(ia[ne]);
+  auto compatibility = [&](size_t l) {
+    for (int m = ia[l]; m < ia[l+1]; m++) {
+      if ((int)l == ja[m]) continue;
+      if (compatibility_method == COMPATIBILITY_DIST){
+        dists[m] = edge_compatibility_full(edges[l], edges[ja[m]]);
+      } else if (compatibility_method == COMPATIBILITY_FULL){
+        dists[m] = edge_compatibility(edges[l], edges[ja[m]]);
+      }
+    }
+  };
+  gv_parallel_for_n((size_t)nthreads, (size_t)ne,
+                    call<decltype(compatibility)>, &compatibility);
+
   for (i = 0; i < ne; i++){
     for (j = ia[i]; j < ia[i+1]; j++){
       jj = ja[j];
       if (i == jj) continue;
-      if (compatibility_method == COMPATIBILITY_DIST){
-	dist = edge_compatibility_full(edges[i], edges[jj]);
-      } else if (compatibility_method == COMPATIBILITY_FULL){
-	dist = edge_compatibility(edges[i], edges[jj]);
-      } 
+      dist = dists[j];
 
       if (fabs(dist) > tol){
 	B = SparseMatrix_coordinate_form_add_entry(B, i, jj, &dist);
@@ -544,7 +602,8 @@ std::vector<pedge> edge_bundling(SparseMatrix A0, int dim,
                                  const std::vector<double> &x, int maxit_outer,
                                  double K, int method, int nneighbor,
                                  int compatibility_method, int max_recursion,
-                                 double angle_param, double angle) {
+                                 double angle_param, double angle,
+                                 int nthreads) {
   /* bundle edges.
      A: edge graph
      x: edge i is at {p,q}, 
@@ -556,6 +615,8 @@ std::vector<pedge> edge_bundling(SparseMatrix A0, int dim,
      nneighbor: number of neighbors to be used in forming nearest neighbor graph. Used only in agglomerative method
      compatibility_method: which method to use to calculate compatibility. Used only in force directed.
      max_recursion: used only in agglomerative method. Specify how many level of recursion to do to bundle bundled edges again
+     nthreads: number of threads for the compatibility check, nearest neighbor search and force directed bundling. With more than one,
+     .  force directed bundling moves all edges at once rather than one after the other
 
   */
   int ne = A0->m;
@@ -582,18 +643,18 @@ std::vector<pedge> edge_bundling(SparseMatrix A0, int dim,
   if (method == METHOD_INK){
 
     /* go through the links and make sure edges are compatible */
-    B = check_compatibility(A, ne, edges, compatibility_method, tol);
+    B = check_compatibility(A, ne, edges, compatibility_method, tol, nthreads);
 
     modularity_ink_bundling(dim, ne, B, edges, angle_param, angle);
 
   } else if (method == METHOD_INK_AGGLOMERATE){
     /* plan: merge a node with its neighbors if doing so improve. Form coarsening graph, repeat until no more ink saving */
     agglomerative_ink_bundling(dim, A, edges, nneighbor, max_recursion,
-                               angle_param, angle);
+                               angle_param, angle, nthreads);
   } else if (method == METHOD_FD){/* FD method */
     
     /* go through the links and make sure edges are compatible */
-    B = check_compatibility(A, ne, edges, compatibility_method, tol);
+    B = check_compatibility(A, ne, edges, compatibility_method, tol, nthreads);
 
 
     for (k = 0; k < maxit_outer; k++){
@@ -601,7 +662,7 @@ std::vector<pedge> edge_bundling(SparseMatrix A0, int dim,
 	pedge_double(edges[i]);
       }
       step0 /= 2;
-      force_directed_edge_bundling(B, edges, maxit, step0, K);
+      force_directed_edge_bundling(B, edges, maxit, step0, K, nthreads);
     }
     
   } else if (method == METHOD_NONE){
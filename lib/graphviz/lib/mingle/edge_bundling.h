@@ -27,7 +27,8 @@ std::vector<pedge> edge_bundling(SparseMatrix A, int dim,
                                  const std::vector<double> &x, int maxit_outer,
                                  double K, int method, int nneighbor,
                                  int compatibility_method, int max_recursion,
-                                 double angle_param, double angle);
+                                 double angle_param, double angle,
+                                 int nthreads);
 void pedge_delete(pedge &e);
 void pedge_wgts_realloc(pedge &e, int n);
 void pedge_export_gv(FILE *fp, int ne, const std::vector<pedge> &edges);
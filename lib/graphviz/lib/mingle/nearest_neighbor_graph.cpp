@@ -8,14 +8,18 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include "config.h"
+
 #include <sparse/general.h>
 #include <sparse/SparseMatrix.h>
 #include <mingle/nearest_neighbor_graph_ann.h>
+#include <mingle/nearest_neighbor_graph_kd.h>
 #include <mingle/nearest_neighbor_graph.h>
 #include <vector>
 
 SparseMatrix nearest_neighbor_graph(int nPts, int num_neighbors,
-                                    const std::vector<double> &x) {
+                                    const std::vector<double> &x,
+                                    int nthreads) {
   /* Gives a nearest neighbor graph of a list of dim-dimendional points. The result is a sparse matrix
      of nPts x nPts, with num_neigbors entries per row.
 
@@ -23,6 +27,7 @@ SparseMatrix nearest_neighbor_graph(int nPts, int num_neighbors,
     num_neighbors: number of neighbors needed
     dim: dimension == 4
     x: nPts*dim vector. The i-th point is x[i*dim : i*dim + dim - 1]
+    nthreads: number of threads to search with, if ANN is not used
 
   */
   int nz;
@@ -33,7 +38,13 @@ SparseMatrix nearest_neighbor_graph(int nPts, int num_neighbors,
   std::vector<int> jcn(nPts * k * 2);
   std::vector<double> val(nPts * k * 2);
 
+#ifdef HAVE_ANN
+  (void)nthreads;
   nearest_neighbor_graph_ann(nPts, num_neighbors, x, nz, irn, jcn, val);
+#else
+  nearest_neighbor_graph_kd(nPts, num_neighbors, x, nz, irn, jcn, val,
+                            nthreads);
+#endif
 
   return SparseMatrix_from_coordinate_arrays(nz, nPts, nPts, irn.data(),
                                              jcn.data(), val.data(),
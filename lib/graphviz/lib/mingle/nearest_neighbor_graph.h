@@ -13,4 +13,5 @@
 #include <vector>
 
 SparseMatrix nearest_neighbor_graph(int nPts, int num_neighbors,
-                                    const std::vector<double> &x);
+                                    const std::vector<double> &x,
+                                    int nthreads);
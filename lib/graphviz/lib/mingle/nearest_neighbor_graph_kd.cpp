@@ -0,0 +1,201 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <algorithm>
+#include <mingle/nearest_neighbor_graph_kd.h>
+#include <numeric>
+#include <util/gv_parallel.h>
+#include <utility>
+#include <vector>
+
+static const int dim = 4; // dimension
+
+/// subtrees with at most this many points are searched exhaustively
+static const int leaf_size = 8;
+
+/// queries made by one work item, which share its scratch space
+static const int chunk_size = 64;
+
+/// a candidate neighbor: squared distance, then point index
+typedef std::pair<double, int> neighbor_t;
+
+/// adapt a callable to the callback of `gv_parallel_for_n`
+template <typename F> static void call(void *f, size_t i) {
+  (*static_cast<F *>(f))(i);
+}
+
+namespace {
+/* A k-d tree kept as a permutation of the point indices. The points of the
+ * subtree over idx[begin, end) are split at m = (begin + end) / 2 along
+ * dimension split[m]: points in idx[begin, m) are no further along it than
+ * idx[m], and points in idx[m + 1, end) are no less far. The coordinates are
+ * copied into the same order, so a subtree's points are contiguous.
+ */
+struct kd_tree {
+  std::vector<int> idx;
+  std::vector<int> split;
+  std::vector<double> pts; ///< coordinates, in idx order
+
+  kd_tree(const std::vector<double> &points, int n)
+      : idx(n), split(n), pts((size_t)n * dim) {
+    std::iota(idx.begin(), idx.end(), 0);
+    build(points, 0, n);
+    for (int i = 0; i < n; i++) {
+      std::copy_n(&points[idx[i] * dim], dim, &pts[i * dim]);
+    }
+  }
+
+  double coord(int i, int d) const { return pts[i * dim + d]; }
+
+  void build(const std::vector<double> &points, int begin, int end) {
+    if (end - begin <= leaf_size)
+      return;
+    auto at = [&](int i, int d) { return points[i * dim + d]; };
+
+    /* split along the dimension in which the points are most spread */
+    double lo[dim], hi[dim];
+    for (int d = 0; d < dim; d++)
+      lo[d] = hi[d] = at(idx[begin], d);
+    for (int i = begin + 1; i < end; i++) {
+      for (int d = 0; d < dim; d++) {
+        lo[d] = std::min(lo[d], at(idx[i], d));
+        hi[d] = std::max(hi[d], at(idx[i], d));
+      }
+    }
+    int s = 0;
+    for (int d = 1; d < dim; d++) {
+      if (hi[d] - lo[d] > hi[s] - lo[s])
+        s = d;
+    }
+
+    const int m = begin + (end - begin) / 2;
+    std::nth_element(idx.begin() + begin, idx.begin() + m, idx.begin() + end,
+                     [&](int a, int b) { return at(a, s) < at(b, s); });
+    split[m] = s;
+    build(points, begin, m);
+    build(points, m + 1, end);
+  }
+
+  /// offer the point at position i as one of the k nearest to q, kept in a
+  /// max-heap
+  void consider(const double *q, int i, int k,
+                std::vector<neighbor_t> &heap) const {
+    double dist = 0;
+    for (int d = 0; d < dim; d++)
+      dist += (q[d] - coord(i, d)) * (q[d] - coord(i, d));
+    const neighbor_t candidate(dist, idx[i]);
+    if ((int)heap.size() < k) {
+      heap.push_back(candidate);
+      std::push_heap(heap.begin(), heap.end());
+    } else if (candidate < heap.front()) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = candidate;
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+
+  /* search:
+   * Search the subtree over positions [begin, end). Its region lies at a
+   * squared distance of at least rd from q, off[d] being the offset of q
+   * from the region along dimension d, as in Arya and Mount's incremental
+   * distance computation.
+   */
+  void search(const double *q, int begin, int end, int k, double rd,
+              double *off, std::vector<neighbor_t> &heap) const {
+    if (end - begin <= leaf_size) {
+      for (int i = begin; i < end; i++)
+        consider(q, i, k, heap);
+      return;
+    }
+
+    const int m = begin + (end - begin) / 2;
+    const int s = split[m];
+    consider(q, m, k, heap);
+
+    /* visit the side holding q first; the other can only help if its
+     * region is no further from q than the current k-th neighbor
+     */
+    const double diff = q[s] - coord(m, s);
+    const int near_begin = diff < 0 ? begin : m + 1;
+    const int near_end = diff < 0 ? m : end;
+    const int far_begin = diff < 0 ? m + 1 : begin;
+    const int far_end = diff < 0 ? end : m;
+    search(q, near_begin, near_end, k, rd, off, heap);
+
+    const double old_off = off[s];
+    const double far_rd = rd - old_off * old_off + diff * diff;
+    if ((int)heap.size() < k || far_rd <= heap.front().first) {
+      off[s] = diff;
+      search(q, far_begin, far_end, k, far_rd, off, heap);
+      off[s] = old_off;
+    }
+  }
+};
+} // namespace
+
+/// add the k nearest neighbors of every point to irn/jcn/val, with the
+/// endpoints of each edge first ordered on dimension a, ties broken on b
+static void knn(int nPts, int k, std::vector<double> pts, int a, int b,
+                int &nz, std::vector<int> &irn, std::vector<int> &jcn,
+                std::vector<double> &val, int nthreads) {
+  for (int i = 0; i < nPts; i++) {
+    double *p = &pts[i * dim];
+    if (p[a] < p[a + 2] || (p[a] == p[a + 2] && p[b] < p[b + 2]))
+      continue;
+    std::swap(p[0], p[2]);
+    std::swap(p[1], p[3]);
+  }
+
+  const kd_tree tree(pts, nPts);
+
+  /* every query fills its own k slots, so they can run in any order; going
+   * in tree order, consecutive queries visit much the same nodes
+   */
+  std::vector<neighbor_t> found((size_t)nPts * k);
+  auto query = [&](size_t chunk) {
+    std::vector<neighbor_t> heap;
+    heap.reserve(k);
+    const int begin = (int)chunk * chunk_size;
+    const int end = std::min(nPts, begin + chunk_size);
+    for (int i = begin; i < end; i++) {
+      const int ip = tree.idx[i];
+      double off[dim] = {0};
+      heap.clear();
+      tree.search(&tree.pts[i * dim], 0, nPts, k, 0, off, heap);
+      std::sort_heap(heap.begin(), heap.end());
+      std::copy(heap.begin(), heap.end(), &found[(size_t)ip * k]);
+    }
+  };
+  const size_t nchunks = ((size_t)nPts + chunk_size - 1) / chunk_size;
+  gv_parallel_for_n((size_t)nthreads, nchunks, call<decltype(query)>, &query);
+
+  for (int ip = 0; ip < nPts; ip++) {
+    for (int i = 0; i < k; i++) {
+      const neighbor_t &nb = found[(size_t)ip * k + i];
+      if (nb.second == ip)
+        continue;
+      val[nz] = nb.first;
+      irn[nz] = ip;
+      jcn[nz++] = nb.second;
+    }
+  }
+}
+
+void nearest_neighbor_graph_kd(int nPts, int k, const std::vector<double> &x,
+                               int &nz0, std::vector<int> &irn,
+                               std::vector<int> &jcn, std::vector<double> &val,
+                               int nthreads) {
+  /* as nearest_neighbor_graph_ann: once with edges going from left to right
+     in x-coordinate, then once going from bottom to top in y-coordinate */
+  int nz = 0;
+  knn(nPts, k, x, 0, 1, nz, irn, jcn, val, nthreads);
+  knn(nPts, k, x, 1, 0, nz, irn, jcn, val, nthreads);
+  nz0 = nz;
+}
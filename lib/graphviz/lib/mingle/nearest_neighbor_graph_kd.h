@@ -0,0 +1,23 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+/// nearest neighbor graph of 4-dimensional points, using a built in k-d tree
+///
+/// This gives the same graph as `nearest_neighbor_graph_ann`, for use when
+/// the ANN library is not available. The queries are spread over up to
+/// `nthreads` threads.
+void nearest_neighbor_graph_kd(int nPts, int k, const std::vector<double> &x,
+                               int &nz0, std::vector<int> &irn,
+                               std::vector<int> &jcn, std::vector<double> &val,
+                               int nthreads);
@@ -372,10 +372,8 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	}
 
 	/* Now compute b[] (L^(X(t))*X(t)) */
-	for (k = 0; k < dim; k++) {
-	    /* b[k] := lap1*coords[k] */
-	    right_mult_with_vector_ff(lap1, n, coords[k], b[k]);
-	}
+	/* b[k] := lap1*coords[k] */
+	right_mult_with_vectors_ff(lap1, n, dim, coords, b);
 
 	/* compute new stress
 	 * remember that the Laplacians are negated, so we subtract 
@@ -26,310 +26,157 @@
 #include <stdlib.h>
 #include <util/alloc.h>
 #include <util/bitarray.h>
-
-typedef DistType Word;
+#include <util/gv_sssp.h>
 
 #define MAX_DIST ((DistType)INT_MAX)
 
-/* This heap class is suited to the Dijkstra alg.
-   data[i]=vertexNum <==> index[vertexNum]=i
-*/
-
-#define left(i) (2*(i))
-#define right(i) (2*(i)+1)
-#define parent(i) ((i)/2)
-#define insideHeap(h,i) ((i)<h->heapSize)
-#define greaterPriority(h,i,j,dist) (dist[h->data[i]]<dist[h->data[j]])
-#define assign(h,i,j,index) {h->data[i]=h->data[j]; index[h->data[i]]=i;}
-#define exchange(h,i,j,index) {int temp; \
-		temp=h->data[i]; \
-		h->data[i]=h->data[j]; \
-		h->data[j]=temp; \
-		index[h->data[i]]=i; \
-		index[h->data[j]]=j; \
-}
-
-typedef struct {
-    int *data;
-    int heapSize;
-} heap;
-
-static void heapify(heap * h, int i, int index[], Word dist[])
-{
-    int l, r, largest;
-    while (1) {
-	l = left(i);
-	r = right(i);
-	if (insideHeap(h, l) && greaterPriority(h, l, i, dist))
-	    largest = l;
-	else
-	    largest = i;
-	if (insideHeap(h, r) && greaterPriority(h, r, largest, dist))
-	    largest = r;
-
-	if (largest == i)
-	    break;
-
-	exchange(h, largest, i, index);
-	i = largest;
-    }
-}
-
-static void freeHeap(heap * h)
-{
-    free(h->data);
-}
-
-static void
-initHeap(heap * h, int startVertex, int index[], Word dist[], int n)
+struct dijkstra_s {
+    gv_csr_t csr;      ///< view of the graph’s edges
+    size_t *off;       ///< storage for `csr.off`, if copied
+    size_t *adj;       ///< storage for `csr.adj`, if copied
+    const float *wf;   ///< edge lengths
+    float *wf_copy;    ///< storage for `wf`, if copied
+    unsigned *wu;      ///< edge lengths truncated to integers
+    gv_sssp_t *sssp;   ///< search state shared by all sources
+    unsigned *udist;   ///< distances found with `wu`
+    float *fdist;      ///< distances found with `wf`
+    size_t *order;     ///< vertices in the order they were reached
+};
+
+/* dijkstra_new:
+ * Copy the edges of graph, other than each vertex's leading self entry,
+ * into a CSR view for searches from any number of sources.
+ */
+dijkstra_t *dijkstra_new(vtx_data * graph, int n)
 {
-    int i, count;
-    int j;    /* We cannot use an unsigned value in this loop */
-    if (n == 1) h->data = NULL;
-    else h->data = gv_calloc(n - 1, sizeof(int));
-    h->heapSize = n - 1;
-
-    for (count = 0, i = 0; i < n; i++)
-	if (i != startVertex) {
-	    h->data[count] = i;
-	    index[i] = count;
-	    count++;
+    assert(n >= 0);
+    dijkstra_t *d = gv_alloc(sizeof(dijkstra_t));
+    const size_t nv = (size_t)n;
+
+    d->off = gv_calloc(nv + 1, sizeof(size_t));
+    for (size_t i = 0; i < nv; i++)
+	d->off[i + 1] = d->off[i] + graph[i].nedges - 1;
+    const size_t ne = d->off[nv];
+    d->adj = gv_calloc(ne, sizeof(size_t));
+    d->wf_copy = gv_calloc(ne, sizeof(float));
+    d->wu = gv_calloc(ne, sizeof(unsigned));
+    for (size_t i = 0; i < nv; i++) {
+	for (size_t j = 1; j < graph[i].nedges; j++) {
+	    const size_t k = d->off[i] + j - 1;
+	    d->adj[k] = (size_t)graph[i].edges[j];
+	    d->wf_copy[k] = graph[i].ewgts[j];
+	    // lengths are never negative
+	    const DistType w = (DistType)graph[i].ewgts[j];
+	    d->wu[k] = w < 0 ? 0 : (unsigned)w;
 	}
-
-    for (j = (n - 1) / 2; j >= 0; j--)
-	heapify(h, j, index, dist);
+    }
+    d->csr = (gv_csr_t){.n = nv, .off = d->off, .adj = d->adj};
+    d->wf = d->wf_copy;
+    d->sssp = gv_sssp_new(nv);
+    d->udist = gv_calloc(nv, sizeof(unsigned));
+    d->order = gv_calloc(nv, sizeof(size_t));
+    return d;
 }
 
-static bool extractMax(heap * h, int *max, int index[], Word dist[])
+/* dijkstra_new_sgd:
+ * Use the CSR arrays of graph directly.
+ */
+dijkstra_t *dijkstra_new_sgd(graph_sgd * graph)
 {
-    if (h->heapSize == 0)
-	return false;
-
-    *max = h->data[0];
-    h->data[0] = h->data[h->heapSize - 1];
-    index[h->data[0]] = 0;
-    h->heapSize--;
-    heapify(h, 0, index, dist);
-
-    return true;
+    dijkstra_t *d = gv_alloc(sizeof(dijkstra_t));
+    d->csr = (gv_csr_t){.n = graph->n, .off = graph->sources,
+                        .adj = graph->targets};
+    d->wf = graph->weights;
+    d->sssp = gv_sssp_new(graph->n);
+    d->fdist = gv_calloc(graph->n, sizeof(float));
+    d->order = gv_calloc(graph->n, sizeof(size_t));
+    return d;
 }
 
-static void
-increaseKey(heap * h, int increasedVertex, Word newDist, int index[],
-	    Word dist[])
+void dijkstra_free(dijkstra_t * d)
 {
-    int placeInHeap;
-    int i;
-
-    if (dist[increasedVertex] <= newDist)
+    if (d == NULL)
 	return;
-
-    placeInHeap = index[increasedVertex];
-
-    dist[increasedVertex] = newDist;
-
-    i = placeInHeap;
-    while (i > 0 && dist[h->data[parent(i)]] > newDist) {	/* can write here: greaterPriority(i,parent(i),dist) */
-	assign(h, i, parent(i), index);
-	i = parent(i);
-    }
-    h->data[i] = increasedVertex;
-    index[increasedVertex] = i;
+    free(d->order);
+    free(d->fdist);
+    free(d->udist);
+    gv_sssp_free(d->sssp);
+    free(d->wu);
+    free(d->wf_copy);
+    free(d->adj);
+    free(d->off);
+    free(d);
 }
 
-void dijkstra(int vertex, vtx_data * graph, int n, DistType * dist)
-{
-    heap H;
-    int closestVertex, neighbor;
-    DistType closestDist, prevClosestDist = MAX_DIST;
-
-    int *index = gv_calloc(n, sizeof(int));
-
-    /* initial distances with edge weights: */
-    for (int i = 0; i < n; i++)
-	dist[i] = MAX_DIST;
-    dist[vertex] = 0;
-    for (size_t i = 1; i < graph[vertex].nedges; i++)
-	dist[graph[vertex].edges[i]] = (DistType) graph[vertex].ewgts[i];
-
-    initHeap(&H, vertex, index, dist, n);
-
-    while (extractMax(&H, &closestVertex, index, dist)) {
-	closestDist = dist[closestVertex];
-	if (closestDist == MAX_DIST)
-	    break;
-	for (size_t i = 1; i < graph[closestVertex].nedges; i++) {
-	    neighbor = graph[closestVertex].edges[i];
-	    increaseKey(&H, neighbor, closestDist +
-			(DistType)graph[closestVertex].ewgts[i], index, dist);
-	}
-	prevClosestDist = closestDist;
-    }
-
-    /* For dealing with disconnected graphs: */
-    for (int i = 0; i < n; i++)
-	if (dist[i] == MAX_DIST)	/* 'i' is not connected to 'vertex' */
-	    dist[i] = prevClosestDist + 10;
-    freeHeap(&H);
-    free(index);
-}
-
-static void heapify_f(heap * h, int i, int index[], float dist[])
+/* dijkstra_run:
+ * Distances from vertex, with edge lengths truncated to integers.
+ * Vertices in other components are placed 10 beyond the furthest
+ * vertex reached.
+ */
+void dijkstra_run(dijkstra_t * d, int vertex, DistType * dist)
 {
-    int l, r, largest;
-    while (1) {
-	l = left(i);
-	r = right(i);
-	if (insideHeap(h, l) && greaterPriority(h, l, i, dist))
-	    largest = l;
+    assert(d->wu != NULL && "integer lengths are only kept by dijkstra_new");
+    const size_t reached = gv_sssp_u(d->sssp, &d->csr, d->wu, (size_t)vertex,
+                                     d->udist, NULL, d->order);
+
+    // the last vertex reached is the furthest
+    const unsigned furthest = d->udist[d->order[reached - 1]];
+    const DistType unreached = furthest >= (unsigned)MAX_DIST - 10
+	? MAX_DIST : (DistType)furthest + 10;
+    for (size_t i = 0; i < d->csr.n; i++) {
+	if (d->udist[i] >= (unsigned)MAX_DIST)
+	    dist[i] = unreached;
 	else
-	    largest = i;
-	if (insideHeap(h, r) && greaterPriority(h, r, largest, dist))
-	    largest = r;
-
-	if (largest == i)
-	    break;
-
-	exchange(h, largest, i, index);
-	i = largest;
+	    dist[i] = (DistType)d->udist[i];
     }
 }
 
-static void
-initHeap_f(heap * h, int startVertex, int index[], float dist[], int n)
-{
-    int i, count;
-    int j;			/* We cannot use an unsigned value in this loop */
-    h->data = gv_calloc(n - 1, sizeof(int));
-    h->heapSize = n - 1;
-
-    for (count = 0, i = 0; i < n; i++)
-	if (i != startVertex) {
-	    h->data[count] = i;
-	    index[i] = count;
-	    count++;
-	}
-
-    for (j = (n - 1) / 2; j >= 0; j--)
-	heapify_f(h, j, index, dist);
-}
-
-static bool extractMax_f(heap * h, int *max, int index[], float dist[])
+/* dijkstra_run_f:
+ * Weighted shortest paths from vertex.
+ * Assume graph is connected.
+ */
+void dijkstra_run_f(dijkstra_t * d, int vertex, float *dist)
 {
-    if (h->heapSize == 0)
-	return false;
-
-    *max = h->data[0];
-    h->data[0] = h->data[h->heapSize - 1];
-    index[h->data[0]] = 0;
-    h->heapSize--;
-    heapify_f(h, 0, index, dist);
-
-    return true;
+    (void)gv_sssp_f(d->sssp, &d->csr, d->wf, (size_t)vertex, dist, NULL, NULL);
 }
 
-static void
-increaseKey_f(heap * h, int increasedVertex, float newDist, int index[],
-	      float dist[])
+void dijkstra(int vertex, vtx_data * graph, int n, DistType * dist)
 {
-    int placeInHeap;
-    int i;
-
-    if (dist[increasedVertex] <= newDist)
-	return;
-
-    placeInHeap = index[increasedVertex];
-
-    dist[increasedVertex] = newDist;
-
-    i = placeInHeap;
-    while (i > 0 && dist[h->data[parent(i)]] > newDist) {	/* can write here: greaterPriority(i,parent(i),dist) */
-	assign(h, i, parent(i), index);
-	i = parent(i);
-    }
-    h->data[i] = increasedVertex;
-    index[increasedVertex] = i;
+    dijkstra_t *d = dijkstra_new(graph, n);
+    dijkstra_run(d, vertex, dist);
+    dijkstra_free(d);
 }
 
-/* dijkstra_f:
- * Weighted shortest paths from vertex.
- * Assume graph is connected.
- */
 void dijkstra_f(int vertex, vtx_data * graph, int n, float *dist)
 {
-    heap H;
-    int closestVertex = 0, neighbor;
-    float closestDist;
-    int *index = gv_calloc(n, sizeof(int));
-
-    /* initial distances with edge weights: */
-    for (int i = 0; i < n; i++)
-	dist[i] = FLT_MAX;
-    dist[vertex] = 0;
-    for (size_t i = 1; i < graph[vertex].nedges; i++)
-	dist[graph[vertex].edges[i]] = graph[vertex].ewgts[i];
-
-    initHeap_f(&H, vertex, index, dist, n);
-
-    while (extractMax_f(&H, &closestVertex, index, dist)) {
-	closestDist = dist[closestVertex];
-	if (closestDist == FLT_MAX)
-	    break;
-	for (size_t i = 1; i < graph[closestVertex].nedges; i++) {
-	    neighbor = graph[closestVertex].edges[i];
-	    increaseKey_f(&H, neighbor, closestDist + graph[closestVertex].ewgts[i],
-			  index, dist);
-	}
-    }
-
-    freeHeap(&H);
-    free(index);
+    dijkstra_t *d = dijkstra_new(graph, n);
+    dijkstra_run_f(d, vertex, dist);
+    dijkstra_free(d);
 }
 
 // single source shortest paths that also builds terms as it goes
-// mostly copied from dijkstra_f above
 // returns the number of terms built
-int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
-    heap h;
-    int *indices = gv_calloc(graph->n, sizeof(int));
-    float *dists = gv_calloc(graph->n, sizeof(float));
-    for (size_t i= 0; i < graph->n; i++) {
-        dists[i] = FLT_MAX;
-    }
-    dists[source] = 0;
-    for (size_t i = graph->sources[source]; i < graph->sources[source + 1];
-         i++) {
-        size_t target = graph->targets[i];
-        dists[target] = graph->weights[i];
-    }
+int dijkstra_sgd(graph_sgd *graph, dijkstra_t *d, int source,
+                 term_sgd *terms) {
+    float *dists = d->fdist;
     assert(graph->n <= INT_MAX);
-    initHeap_f(&h, source, indices, dists, (int)graph->n);
-
-    int closest = 0, offset = 0;
-    while (extractMax_f(&h, &closest, indices, dists)) {
-        float d = dists[closest];
-        if (d == FLT_MAX) {
-            break;
-        }
+    const size_t reached = gv_sssp_f(d->sssp, &d->csr, d->wf, (size_t)source,
+                                     dists, NULL, d->order);
+
+    int offset = 0;
+    // the source is reached first, and needs no term
+    for (size_t k = 1; k < reached; k++) {
+        const int closest = (int)d->order[k];
+        const float dd = dists[closest];
         // if the target is fixed then always create a term as shortest paths are not calculated from there
         // if not fixed then only create a term if the target index is lower
         if (bitarray_get(graph->pinneds, closest) || closest<source) {
             terms[offset].i = source;
             terms[offset].j = closest;
-            terms[offset].d = d;
-            terms[offset].w = 1 / (d*d);
+            terms[offset].d = dd;
+            terms[offset].w = 1 / (dd*dd);
             offset++;
         }
-        for (size_t i = graph->sources[closest]; i < graph->sources[closest + 1];
-             i++) {
-            size_t target = graph->targets[i];
-            float weight = graph->weights[i];
-            assert(target <= (size_t)INT_MAX);
-            increaseKey_f(&h, (int)target, d+weight, indices, dists);
-        }
     }
-    freeHeap(&h);
-    free(indices);
-    free(dists);
     return offset;
 }
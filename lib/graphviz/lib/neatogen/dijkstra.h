@@ -17,9 +17,18 @@ extern "C" {
 #include <neatogen/defs.h>
 #include <neatogen/sgd.h>
 
+    /// shortest path state reused across sources of one graph
+    typedef struct dijkstra_s dijkstra_t;
+
+    extern dijkstra_t *dijkstra_new(vtx_data *, int);
+    extern dijkstra_t *dijkstra_new_sgd(graph_sgd *);
+    extern void dijkstra_free(dijkstra_t *);
+    extern void dijkstra_run(dijkstra_t *, int, DistType *);
+    extern void dijkstra_run_f(dijkstra_t *, int, float *);
+
     extern void dijkstra(int, vtx_data *, int, DistType *);
     extern void dijkstra_f(int, vtx_data *, int, float *);
-    extern int dijkstra_sgd(graph_sgd *, int, term_sgd *);
+    extern int dijkstra_sgd(graph_sgd *, dijkstra_t *, int, term_sgd *);
 
 #ifdef __cplusplus
 }
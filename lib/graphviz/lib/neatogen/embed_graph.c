@@ -56,8 +56,9 @@ void embed_graph(vtx_data * graph, int n, int dim, DistType *** Coords,
     /* select the first pivot */
     node = rand() % n;
 
+    dijkstra_t *d = reweight_graph ? dijkstra_new(graph, n) : NULL;
     if (reweight_graph) {
-	dijkstra(node, graph, n, coords[0]);
+	dijkstra_run(d, node, coords[0]);
     } else {
 	bfs(node, graph, n, coords[0]);
     }
@@ -73,7 +74,7 @@ void embed_graph(vtx_data * graph, int n, int dim, DistType *** Coords,
     /* select other dim-1 nodes as pivots */
     for (i = 1; i < dim; i++) {
 	if (reweight_graph) {
-	    dijkstra(node, graph, n, coords[i]);
+	    dijkstra_run(d, node, coords[i]);
 	} else {
 	    bfs(node, graph, n, coords[i]);
 	}
@@ -87,6 +88,7 @@ void embed_graph(vtx_data * graph, int n, int dim, DistType *** Coords,
 	}
 
     }
+    dijkstra_free(d);
 
     free(dist);
 
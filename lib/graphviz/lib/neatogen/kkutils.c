@@ -59,9 +59,11 @@ static DistType **compute_apsp_dijkstra(vtx_data * graph, int n)
     for (i = 0; i < n; i++)
 	dij[i] = storage + i * n;
 
+    dijkstra_t *d = dijkstra_new(graph, n);
     for (i = 0; i < n; i++) {
-	dijkstra(i, graph, n, dij[i]);
+	dijkstra_run(d, i, dij[i]);
     }
+    dijkstra_free(d);
     return dij;
 }
 
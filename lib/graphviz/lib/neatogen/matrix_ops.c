@@ -8,6 +8,9 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <neatogen/matrix_ops.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -405,27 +408,64 @@ void orthog1f(int n, float *vec)
     }
 }
 
+/// add row `i` of a packed symmetric matrix, and the column mirroring it, times
+/// `vector` to `result`
+///
+/// @param row Row `i` of the matrix, starting at its diagonal entry
+static void mult_row_ff(const float *row, int i, int n, const float *vector,
+                        float *result) {
+    const float vector_i = vector[i];
+    int j = i + 1;
+
+    /* deal with main diag */
+    float res = row[0] * vector_i;
+    /* deal with off diag */
+    row -= i;
+#ifdef __SSE2__
+    const __m128 vi = _mm_set1_ps(vector_i);
+    __m128 acc = _mm_setzero_ps();
+    for (; j + 4 <= n; j += 4) {
+	const __m128 a = _mm_loadu_ps(row + j);
+	acc = _mm_add_ps(acc, _mm_mul_ps(a, _mm_loadu_ps(vector + j)));
+	_mm_storeu_ps(result + j,
+	              _mm_add_ps(_mm_loadu_ps(result + j), _mm_mul_ps(a, vi)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    res += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; j < n; j++) {
+	res += row[j] * vector[j];
+	result[j] += row[j] * vector_i;
+    }
+    result[i] += res;
+}
+
 void right_mult_with_vector_ff
     (float *packed_matrix, int n, float *vector, float *result) {
     /* packed matrix is the upper-triangular part of a symmetric matrix arranged in a vector row-wise */
-    int i, j, index;
-    float vector_i;
+    int i, index;
 
-    float res;
     for (i = 0; i < n; i++) {
 	result[i] = 0;
     }
-    for (index = 0, i = 0; i < n; i++) {
-	res = 0;
-	vector_i = vector[i];
-	/* deal with main diag */
-	res += packed_matrix[index++] * vector_i;
-	/* deal with off diag */
-	for (j = i + 1; j < n; j++, index++) {
-	    res += packed_matrix[index] * vector[j];
-	    result[j] += packed_matrix[index] * vector_i;
+    for (index = 0, i = 0; i < n; index += n - i, i++) {
+	mult_row_ff(packed_matrix + index, i, n, vector, result);
+    }
+}
+
+void right_mult_with_vectors_ff(float *packed_matrix, int n, int dim,
+                                float **vectors, float **results) {
+    int i, k, index;
+
+    for (k = 0; k < dim; k++) {
+	set_vector_valf(n, 0, results[k]);
+    }
+    /* each row is used for all the vectors while it is still in cache */
+    for (index = 0, i = 0; i < n; index += n - i, i++) {
+	for (k = 0; k < dim; k++) {
+	    mult_row_ff(packed_matrix + index, i, n, vectors[k], results[k]);
 	}
-	result[i] += res;
     }
 }
 
@@ -465,9 +505,23 @@ void copy_vectorf(int n, float *source, float *dest)
 
 double vectors_inner_productf(int n, float *vector1, float *vector2)
 {
-    int i;
+    int i = 0;
     double result = 0;
-    for (i = 0; i < n; i++) {
+#ifdef __SSE2__
+    /* products are taken in single precision and summed in double, as below */
+    __m128d lo = _mm_setzero_pd();
+    __m128d hi = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+	const __m128 p = _mm_mul_ps(_mm_loadu_ps(vector1 + i),
+	                            _mm_loadu_ps(vector2 + i));
+	lo = _mm_add_pd(lo, _mm_cvtps_pd(p));
+	hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(p, p)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(lo, hi));
+    result = lanes[0] + lanes[1];
+#endif
+    for (; i < n; i++) {
 	result += vector1[i] * vector2[i];
     }
 
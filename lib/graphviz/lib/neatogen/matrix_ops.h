@@ -57,6 +57,10 @@ extern "C" {
 
     extern void orthog1f(int n, float *vec);
     extern void right_mult_with_vector_ff(float *, int, float *, float *);
+    /// `results[k] := packed_matrix * vectors[k]` for each `k < dim`, in one
+    /// pass over the matrix
+    extern void right_mult_with_vectors_ff(float *packed_matrix, int n, int dim,
+                                           float **vectors, float **results);
     extern void vectors_subtractionf(int, float *, float *, float *);
     extern void vectors_additionf(int n, float *vector1, float *vector2,
 				  float *result);
@@ -1119,14 +1119,34 @@ void dumpOpts (ipsep_options* opp, int nv)
  *  weight
  * mode will be MODE_MAJOR, MODE_HIER or MODE_IPSEP
  */
-static void
-majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adjust_data* am)
+/* State of a majorization layout between its phases. */
+typedef struct {
+    graph_t *g;
+    vtx_data *gp;
+    node_t **nodes;
+    double **coords;
+    int nv;
+    int opts;
+    int model;
+    int maxi;
+    int havePinned;
+    bool solved;	/* stress has been minimized */
+    int rv;		/* result of layout, if solved */
+} major_t;
+
+/* majorizationStart:
+ * Set up the majorization layout of g. Unless defer is true, also
+ * compute the layout. Otherwise, if the stress minimization can be
+ * done on its own, that is left to majorizationRun.
+ */
+static major_t *
+majorizationStart(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adjust_data* am, bool defer)
 {
     int ne;
     int rv = 0;
-    node_t *v;
     vtx_data *gp;
     node_t** nodes;
+    major_t *m;
 #ifdef DIGCOLA
 #ifdef IPSEPCOLA
     expand_t margin;
@@ -1156,6 +1176,17 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
 	fprintf(stderr, "%d nodes %.2f sec\n", nv, elapsed_sec());
     }
 
+    m = gv_alloc(sizeof(major_t));
+    m->g = g;
+    m->gp = gp;
+    m->nodes = nodes;
+    m->coords = coords;
+    m->nv = nv;
+    m->opts = opts;
+    m->model = model;
+    m->maxi = MaxIter;
+    m->solved = true;
+
 #ifdef DIGCOLA
     if (mode != MODE_MAJOR) {
         double lgap = late_double(g, agfindgraphattr(g, "levelsgap"), 0.0, -DBL_MAX);
@@ -1204,7 +1235,7 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
 		fprintf(stderr,"gap=%f,%f\n",opt.gap.x,opt.gap.y);
             {
                 size_t i = 0;
-                for (v = agfstnode(g); v; v = agnxtnode(g, v),i++) {
+                for (node_t *v = agfstnode(g); v; v = agnxtnode(g, v),i++) {
                     nsize[i].x = ND_width(v);
                     nsize[i].y = ND_height(v);
                 }
@@ -1229,21 +1260,57 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     }
     else
 #endif
+    if (defer && !Verbose && model != MODEL_CIRCUIT) {
+	m->havePinned = stress_majorization_init(gp, nv, coords, nodes, Ndim,
+						 opts, model);
+	if (m->havePinned < 0)
+	    rv = -1;
+	else
+	    m->solved = false;
+    }
+    else
 	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts, model, MaxIter);
 
-    if (rv < 0) {
+    m->rv = rv;
+    return m;
+}
+
+/* majorizationRun:
+ * Minimize the stress of a layout deferred by majorizationStart.
+ * This can run concurrently with other layouts.
+ */
+static void majorizationRun(major_t *m)
+{
+    if (m->solved)
+	return;
+    m->rv = stress_majorization_solve(m->gp, m->nv, m->coords, m->nodes,
+				      Ndim, m->opts, m->model, m->maxi,
+				      m->havePinned);
+    m->solved = true;
+}
+
+/* majorizationFinish:
+ * Store the positions computed by layout m in the nodes, and free m.
+ */
+static void majorizationFinish(major_t *m)
+{
+    node_t *v;
+
+    majorizationRun(m);
+    if (m->rv < 0) {
 	agerr(AGPREV, "layout aborted\n");
     }
-    else for (v = agfstnode(g); v; v = agnxtnode(g, v)) { /* store positions back in nodes */
+    else for (v = agfstnode(m->g); v; v = agnxtnode(m->g, v)) { /* store positions back in nodes */
 	int idx = ND_id(v);
 	for (int i = 0; i < Ndim; i++) {
-	    ND_pos(v)[i] = coords[i][idx];
+	    ND_pos(v)[i] = m->coords[i][idx];
 	}
     }
-    freeGraphData(gp);
-    free(coords[0]);
-    free(coords);
-    free(nodes);
+    freeGraphData(m->gp);
+    free(m->coords[0]);
+    free(m->coords);
+    free(m->nodes);
+    free(m);
 }
 
 static void subset_model(Agraph_t * G, int nG)
@@ -1318,12 +1385,15 @@ static void kkNeato(Agraph_t * g, int nG, int model)
     solve_model(g, nG);
 }
 
-/* neatoLayout:
- * Use stress optimization to layout a single component
+/* neatoLayoutStart:
+ * Use stress optimization to layout a single component.
+ * For majorization, the layout is only set up if defer is true, and the
+ * rest is left to majorizationRun and majorizationFinish. Otherwise,
+ * returns NULL.
  */
-static void
-neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
-  adjust_data* am)
+static major_t *
+neatoLayoutStart(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
+  adjust_data* am, bool defer)
 {
     int nG;
     char *str;
@@ -1339,13 +1409,25 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
 
     nG = scan_graph_mode(g, layoutMode);
     if (nG < 2 || MaxIter < 0)
-	return;
+	return NULL;
     if (layoutMode == MODE_KK)
 	kkNeato(g, nG, layoutModel);
     else if (layoutMode == MODE_SGD)
 	sgd(g, layoutModel);
-    else
-	majorization(mg, g, nG, layoutMode, layoutModel, Ndim, am);
+    else {
+	major_t *m = majorizationStart(mg, g, nG, layoutMode, layoutModel, Ndim, am, defer);
+	if (defer)
+	    return m;
+	majorizationFinish(m);
+    }
+    return NULL;
+}
+
+static void
+neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
+  adjust_data* am)
+{
+    (void)neatoLayoutStart(mg, g, layoutMode, layoutModel, am, false);
 }
 
 /* addZ;
@@ -1390,6 +1472,41 @@ static void doEdges(Agraph_t* g)
     spline_edges0(g, true);
 }
 
+/* Parameters shared by the layouts of the components of a graph. */
+typedef struct {
+    graph_t *g;		/* root graph */
+    int layoutMode;
+    int layoutModel;
+    adjust_data *am;
+    bool noTranslate;
+} ccinfo_t;
+
+static void *ccLayoutStart(graph_t *gc, void *arg)
+{
+    ccinfo_t *info = arg;
+
+    (void)graphviz_node_induce(gc, NULL);
+    return neatoLayoutStart(info->g, gc, info->layoutMode, info->layoutModel,
+			    info->am, true);
+}
+
+static void ccLayoutRun(void *state)
+{
+    majorizationRun(state);
+}
+
+static void ccLayoutFinish(graph_t *gc, void *state, void *arg)
+{
+    ccinfo_t *info = arg;
+
+    if (state)
+	majorizationFinish(state);
+    removeOverlapWith(gc, info->am);
+    setEdgeType (gc, EDGETYPE_LINE);
+    if (info->noTranslate) doEdges(gc);
+    else spline_edges(gc);
+}
+
 /* neato_layout:
  */
 void neato_layout(Agraph_t * g)
@@ -1441,15 +1558,9 @@ void neato_layout(Agraph_t * g)
 
 	    if (n_cc > 1) {
 		bool *bp;
-		for (size_t i = 0; i < n_cc; i++) {
-		    gc = cc[i];
-		    (void)graphviz_node_induce(gc, NULL);
-		    neatoLayout(g, gc, layoutMode, model, &am);
-		    removeOverlapWith(gc, &am);
-		    setEdgeType (gc, EDGETYPE_LINE);
-		    if (noTranslate) doEdges(gc);
-		    else spline_edges(gc);
-		}
+		const pack_layout ccLayout = {ccLayoutStart, ccLayoutRun,
+		                              ccLayoutFinish};
+		ccinfo_t info = {g, layoutMode, model, &am, noTranslate};
 		if (pin) {
 		    bp = gv_calloc(n_cc, sizeof(bool));
 		    bp[0] = true;
@@ -1458,7 +1569,7 @@ void neato_layout(Agraph_t * g)
 		pinfo.margin = (unsigned)Pack;
 		pinfo.fixed = bp;
 		pinfo.doSplines = true;
-		packGraphs(n_cc, cc, g, &pinfo);
+		layoutAndPackGraphs(n_cc, cc, g, &pinfo, &ccLayout, &info);
 		free(bp);
 	    }
 	    else {
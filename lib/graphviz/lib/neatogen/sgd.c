@@ -169,11 +169,13 @@ void sgd(graph_t *G, /* input graph */
     // calculate term values through shortest paths
     int offset = 0;
     graph_sgd *graph = extract_adjacency(G, model);
+    dijkstra_t *d = dijkstra_new_sgd(graph);
     for (i=0; i<n; i++) {
         if (!isFixed(GD_neato_nlist(G)[i])) {
-            offset += dijkstra_sgd(graph, i, terms+offset);
+            offset += dijkstra_sgd(graph, d, i, terms+offset);
         }
     }
+    dijkstra_free(d);
     assert(offset == n_terms);
     free_adjacency(graph);
     if (Verbose) {
@@ -348,8 +348,9 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
     CenterIndex[node] = 0;
     invCenterIndex[0] = node;
 
+    dijkstra_t *d = reweight_graph ? dijkstra_new(graph, n) : NULL;
     if (reweight_graph) {
-	dijkstra(node, graph, n, Dij[0]);
+	dijkstra_run(d, node, Dij[0]);
     } else {
 	bfs(node, graph, n, Dij[0]);
     }
@@ -368,7 +369,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	CenterIndex[node] = i;
 	invCenterIndex[i] = node;
 	if (reweight_graph) {
-	    dijkstra(node, graph, n, Dij[i]);
+	    dijkstra_run(d, node, Dij[i]);
 	} else {
 	    bfs(node, graph, n, Dij[i]);
 	}
@@ -382,6 +383,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	    }
 	}
     }
+    dijkstra_free(d);
 
   after_pivots_selection:
 
@@ -650,12 +652,14 @@ static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
     float *Di = gv_calloc(n, sizeof(float));
 
     count = 0;
+    dijkstra_t *d = dijkstra_new(graph, n);
     for (i = 0; i < n; i++) {
-	dijkstra_f(i, graph, n, Di);
+	dijkstra_run_f(d, i, Di);
 	for (j = i; j < n; j++) {
 	    Dij[count++] = Di[j];
 	}
     }
+    dijkstra_free(d);
     free(Di);
     return Dij;
 }
@@ -795,17 +799,88 @@ static void dumpMatrix(float *Dij, int n)
  */
 #define DegType long double
 
-/* stress_majorization_kD_mkernel:
- * At present, if any nodes have pos set, smart_ini is false.
+/* stress_majorization_init:
+ * Set the initial positions of the nodes for
+ * stress_majorization_solve. At present, if any nodes have pos set,
+ * smart_ini is false.
+ * Returns 1 if some node is pinned, 0 if not, and -1 on error.
  */
-int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse representation */
-				   int n,	/* Number of nodes */
-				   double **d_coords,	/* coordinates of nodes (output layout) */
-				   node_t ** nodes,	/* original nodes */
-				   int dim,	/* dimemsionality of layout */
-				   int opts,    /* options */
-				   int model,	/* model */
-				   int maxi	/* max iterations */
+int stress_majorization_init(vtx_data * graph,	/* Input graph in sparse representation */
+			     int n,	/* Number of nodes */
+			     double **d_coords,	/* coordinates of nodes (output layout) */
+			     node_t ** nodes,	/* original nodes */
+			     int dim,	/* dimemsionality of layout */
+			     int opts,    /* options */
+			     int model	/* model */
+    )
+{
+    int i, j;
+    int smart_ini = opts & opt_smart_init;
+    int exp = opts & opt_exp_flag;
+    int havePinned;		/* some node is pinned */
+
+    if (Verbose) {
+	fprintf(stderr, "Setting initial positions");
+	start_timer();
+    }
+
+	/**************************
+	** Layout initialization **
+	**************************/
+
+    if (smart_ini && n > 1) {
+	havePinned = 0;
+	/* optimize layout quickly within subspace */
+	/* perform at most 50 iterations within 30-D subspace to 
+	   get an estimate */
+	if (sparse_stress_subspace_majorization_kD(graph, n,
+					       d_coords, dim, smart_ini, exp,
+					       model == MODEL_SUBSET, 50,
+					       num_pivots_stress) < 0) {
+	    return -1;
+	}
+
+	for (i = 0; i < dim; i++) {
+	    /* for numerical stability, scale down layout */
+	    double max = 1;
+	    for (j = 0; j < n; j++) {
+		if (fabs(d_coords[i][j]) > max) {
+		    max = fabs(d_coords[i][j]);
+		}
+	    }
+	    for (j = 0; j < n; j++) {
+		d_coords[i][j] /= max;
+	    }
+	    /* add small random noise */
+	    for (j = 0; j < n; j++) {
+		d_coords[i][j] += 1e-6 * (drand48() - 0.5);
+	    }
+	    orthog1(n, d_coords[i]);
+	}
+    } else {
+	havePinned = initLayout(n, dim, d_coords, nodes);
+    }
+    if (Verbose)
+	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
+    return havePinned;
+}
+
+/* stress_majorization_solve:
+ * Minimize the stress of the layout set up by stress_majorization_init.
+ * Unless Verbose is set or model is MODEL_CIRCUIT, which may warn, this
+ * only uses its arguments, so several layouts can be solved at the
+ * same time.
+ * Returns the number of iterations, or -1 on error.
+ */
+int stress_majorization_solve(vtx_data * graph,	/* Input graph in sparse representation */
+			      int n,	/* Number of nodes */
+			      double **d_coords,	/* coordinates of nodes (output layout) */
+			      node_t ** nodes,	/* original nodes */
+			      int dim,	/* dimemsionality of layout */
+			      int opts,    /* options */
+			      int model,	/* model */
+			      int maxi,	/* max iterations */
+			      int havePinned	/* some node is pinned */
     )
 {
     int iterations;		/* output: number of iteration of the process */
@@ -829,10 +904,11 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     float *tmp_coords = NULL;
     float *dist_accumulator = NULL;
     float *lap1 = NULL;
-    int smart_ini = opts & opt_smart_init;
     int exp = opts & opt_exp_flag;
     int len;
-    int havePinned;		/* some node is pinned */
+
+    if (n == 1 || maxi <= 0)
+	return 0;
 
 	/*************************************************
 	** Computation of full, dense, unrestricted k-D ** 
@@ -843,9 +919,6 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	** Compute the all-pairs-shortest-distances matrix **
 	****************************************************/
 
-    if (maxi < 0)
-	return 0;
-
     if (Verbose)
 	start_timer();
 
@@ -877,56 +950,6 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    Dij = compute_apsp_packed(graph, n);
     }
 
-    if (Verbose) {
-	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
-	fprintf(stderr, "Setting initial positions");
-	start_timer();
-    }
-
-	/**************************
-	** Layout initialization **
-	**************************/
-
-    if (smart_ini && n > 1) {
-	havePinned = 0;
-	/* optimize layout quickly within subspace */
-	/* perform at most 50 iterations within 30-D subspace to 
-	   get an estimate */
-	if (sparse_stress_subspace_majorization_kD(graph, n,
-					       d_coords, dim, smart_ini, exp,
-					       model == MODEL_SUBSET, 50,
-					       num_pivots_stress) < 0) {
-	    iterations = -1;
-	    goto finish1;
-	}
-
-	for (i = 0; i < dim; i++) {
-	    /* for numerical stability, scale down layout */
-	    double max = 1;
-	    for (j = 0; j < n; j++) {
-		if (fabs(d_coords[i][j]) > max) {
-		    max = fabs(d_coords[i][j]);
-		}
-	    }
-	    for (j = 0; j < n; j++) {
-		d_coords[i][j] /= max;
-	    }
-	    /* add small random noise */
-	    for (j = 0; j < n; j++) {
-		d_coords[i][j] += 1e-6 * (drand48() - 0.5);
-	    }
-	    orthog1(n, d_coords[i]);
-	}
-    } else {
-	havePinned = initLayout(n, dim, d_coords, nodes);
-    }
-    if (Verbose)
-	fprintf(stderr, ": %.2f sec", elapsed_sec());
-    if (n == 1 || maxi == 0) {
-	free(Dij);
-	return 0;
-    }
-
     if (Verbose) {
 	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
 	fprintf(stderr, "Setting up stress function");
@@ -1051,10 +1074,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	}
 
 	/* Now compute b[] */
-	for (k = 0; k < dim; k++) {
-	    /* b[k] := lap1*coords[k] */
-	    right_mult_with_vector_ff(lap1, n, coords[k], b[k]);
-	}
+	/* b[k] := lap1*coords[k] */
+	right_mult_with_vectors_ff(lap1, n, dim, coords, b);
 
 
 	/* compute new stress  */
@@ -1133,3 +1154,30 @@ finish1:
     free(lap1);
     return iterations;
 }
+
+/* stress_majorization_kD_mkernel:
+ * Full dense stress optimization, setting the initial layout and
+ * then solving it.
+ */
+int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse representation */
+				   int n,	/* Number of nodes */
+				   double **d_coords,	/* coordinates of nodes (output layout) */
+				   node_t ** nodes,	/* original nodes */
+				   int dim,	/* dimemsionality of layout */
+				   int opts,    /* options */
+				   int model,	/* model */
+				   int maxi	/* max iterations */
+    )
+{
+    int havePinned;
+
+    if (maxi < 0)
+	return 0;
+
+    havePinned = stress_majorization_init(graph, n, d_coords, nodes, dim,
+					  opts, model);
+    if (havePinned < 0)
+	return -1;
+    return stress_majorization_solve(graph, n, d_coords, nodes, dim, opts,
+				     model, maxi, havePinned);
+}
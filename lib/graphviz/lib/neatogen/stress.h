@@ -40,6 +40,15 @@ extern "C" {
 					      int maxi	/* max iterations */
 	);
 
+    /* The two halves of stress_majorization_kD_mkernel */
+    extern int stress_majorization_init(vtx_data * graph, int n,
+					double **coords, node_t **nodes,
+					int dim, int opts, int model);
+    extern int stress_majorization_solve(vtx_data * graph, int n,
+					 double **coords, node_t **nodes,
+					 int dim, int opts, int model,
+					 int maxi, int havePinned);
+
 extern float *compute_apsp_packed(vtx_data * graph, int n);
 extern float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n);
 extern float* circuitModel(vtx_data * graph, int nG);
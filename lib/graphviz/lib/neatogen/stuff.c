@@ -21,9 +21,16 @@
 #endif
 
 static double Epsilon2;
-static Agnode_t *choose_node(graph_t *, int);
+
+/* the node with the largest gradient found so far */
+typedef struct {
+    int index;			/* index into GD_neato_nlist, or -1 for none */
+    double max;			/* squared length of its gradient */
+} steepest_t;
+
+static Agnode_t *choose_node(graph_t *, steepest_t);
 static void make_spring(graph_t *, Agnode_t *, Agnode_t *, double);
-static void move_node(graph_t *, int, Agnode_t *);
+static steepest_t move_node(graph_t *, int, Agnode_t *);
 
 static double fpow32(double x)
 {
@@ -68,35 +75,40 @@ void free_array(double **rv)
 }
 
 
+/* new_3array:
+ * The entries are allocated in one block, and the rows in another, so
+ * neighboring entries share cache lines. Each block has a leading slot
+ * pointing to the next one, so free_3array can find them even when m or n
+ * is 0.
+ */
 static double ***new_3array(int m, int n, int p, double ival)
 {
     int i, j, k;
 
-    double ***rv = gv_calloc(m + 1, sizeof(double**));
+    double ***head = gv_calloc((size_t)m + 1, sizeof(double**));
+    double **rows = gv_calloc((size_t)m * n + 1, sizeof(double*));
+    double *mem = gv_calloc((size_t)m * n * p, sizeof(double));
+    head[0] = rows;
+    rows[0] = mem;
+    double ***rv = head + 1;
     for (i = 0; i < m; i++) {
-	rv[i] = gv_calloc(n + 1, sizeof(double*));
+	rv[i] = rows + 1 + (size_t)i * n;
 	for (j = 0; j < n; j++) {
-	    rv[i][j] = gv_calloc(p, sizeof(double));
+	    rv[i][j] = mem + ((size_t)i * n + j) * p;
 	    for (k = 0; k < p; k++)
 		rv[i][j][k] = ival;
 	}
-	rv[i][j] = NULL;	/* NULL terminate so we can clean up */
     }
-    rv[i] = NULL;
     return rv;
 }
 
 static void free_3array(double ***rv)
 {
-    int i, j;
-
     if (rv) {
-	for (i = 0; rv[i]; i++) {
-	    for (j = 0; rv[i][j]; j++)
-		free(rv[i][j]);
-	    free(rv[i]);
-	}
-	free(rv);
+	double ***head = rv - 1;
+	free(head[0][0]);
+	free(head[0]);
+	free(head);
     }
 }
 
@@ -429,14 +441,40 @@ static double total_e(graph_t * G, int nG)
     return e;
 }
 
+/* consider_node:
+ * Update s with node i if its gradient is larger.
+ * Ties go to the lower index, so the result does not depend on the order in
+ * which nodes are considered.
+ */
+static void consider_node(graph_t * G, int i, steepest_t * s)
+{
+    int k;
+    double m;
+
+    if (ND_pinned(GD_neato_nlist(G)[i]) > P_SET)
+	return;
+    for (m = 0.0, k = 0; k < Ndim; k++)
+	m += GD_sum_t(G)[i][k] * GD_sum_t(G)[i][k];
+    /* could set the color=energy of the node here */
+    if (m > s->max || (m == s->max && s->index >= 0 && i < s->index)) {
+	s->index = i;
+	s->max = m;
+    }
+}
+
 void solve_model(graph_t * G, int nG)
 {
     node_t *np;
+    steepest_t s = {-1, 0.0};
+    int i;
 
     Epsilon2 = Epsilon * Epsilon;
 
-    while ((np = choose_node(G, nG))) {
-	move_node(G, nG, np);
+    /* later choices are found while updating the gradients after each move */
+    for (i = 0; i < nG; i++)
+	consider_node(G, i, &s);
+    while ((np = choose_node(G, s))) {
+	s = move_node(G, nG, np);
     }
     if (Verbose) {
 	fprintf(stderr, "\nfinal e = %f", total_e(G, nG));
@@ -449,11 +487,19 @@ void solve_model(graph_t * G, int nG)
 	      MaxIter, agnameof(G));
 }
 
-static void update_arrays(graph_t * G, int nG, int i)
+/* update_arrays:
+ * Recompute the gradient terms of node i after it moved, and return the node
+ * with the largest gradient as a result.
+ * This is not split over threads. It takes tens of microseconds, which is
+ * about what a gv_parallel_for costs, and summing GD_sum_t(G)[i] in chunks
+ * would change the layout.
+ */
+static steepest_t update_arrays(graph_t * G, int nG, int i)
 {
     int j, k;
     double del[MAXDIM], dist, old;
     node_t *vi, *vj;
+    steepest_t s = {-1, 0.0};
 
     vi = GD_neato_nlist(G)[i];
     for (k = 0; k < Ndim; k++)
@@ -473,7 +519,10 @@ static void update_arrays(graph_t * G, int nG, int i)
 	    GD_t(G)[j][i][k] = -GD_t(G)[i][j][k];
 	    GD_sum_t(G)[j][k] += GD_t(G)[j][i][k] - old;
 	}
+	consider_node(G, j, &s);
     }
+    consider_node(G, i, &s);
+    return s;
 }
 
 #define Msub(i,j)  M[(i)*Ndim+(j)]
@@ -511,30 +560,16 @@ static void D2E(graph_t * G, int nG, int n, double *M)
 	    Msub(k, l) = Msub(l, k);
 }
 
-node_t *choose_node(graph_t * G, int nG)
+node_t *choose_node(graph_t * G, steepest_t s)
 {
-    int i, k;
-    double m, max;
-    node_t *choice, *np;
+    double max = s.max;
+    node_t *choice;
     static int cnt = 0;
 
     cnt++;
     if (GD_move(G) >= MaxIter)
 	return NULL;
-    max = 0.0;
-    choice = NULL;
-    for (i = 0; i < nG; i++) {
-	np = GD_neato_nlist(G)[i];
-	if (ND_pinned(np) > P_SET)
-	    continue;
-	for (m = 0.0, k = 0; k < Ndim; k++)
-	    m += GD_sum_t(G)[i][k] * GD_sum_t(G)[i][k];
-	/* could set the color=energy of the node here */
-	if (m > max) {
-	    choice = np;
-	    max = m;
-	}
-    }
+    choice = s.index >= 0 ? GD_neato_nlist(G)[s.index] : NULL;
     if (max < Epsilon2)
 	choice = NULL;
     else {
@@ -547,9 +582,10 @@ node_t *choose_node(graph_t * G, int nG)
     return choice;
 }
 
-void move_node(graph_t * G, int nG, node_t * n)
+steepest_t move_node(graph_t * G, int nG, node_t * n)
 {
     int i, m;
+    steepest_t s;
     double b[MAXDIM] = {0};
     double c[MAXDIM] = {0};
 
@@ -564,7 +600,7 @@ void move_node(graph_t * G, int nG, node_t * n)
 	ND_pos(n)[i] += b[i];
     }
     GD_move(G)++;
-    update_arrays(G, nG, m);
+    s = update_arrays(G, nG, m);
     if (test_toggle()) {
 	double sum = 0;
 	for (i = 0; i < Ndim; i++) {
@@ -574,6 +610,7 @@ void move_node(graph_t * G, int nG, node_t * n)
 	fprintf(stderr, "%s %.3f\n", agnameof(n), sum);
     }
     free(a);
+    return s;
 }
 
 static node_t **Heap;
@@ -18,10 +18,13 @@
 #include <assert.h>
 #include <common/render.h>
 #include <pack/pack.h>
-#include <common/pointset.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <util/alloc.h>
+#include <util/gv_parallel.h>
 #include <util/prisize_t.h>
 #include <util/sort.h>
 #include <util/startswith.h>
@@ -37,10 +40,173 @@
 /* Given grid cell size s, CELL(p:point,s:int) sets p to cell containing point p */
 #define CELL(p,s) ((p).x = CVAL((p).x,s), (p).y = CVAL((p).y,(s)))
 
+/// a set of grid cells, stored as a bitmap
+///
+/// Each row of the covered rectangle is a run of 64-bit words, with bit `i` of
+/// word `j` standing for the cell at column `x0 + 64 * j + i`. `x0` is kept a
+/// multiple of 64 so the rectangle can be grown without shifting rows. Testing
+/// a polyomino against the set of occupied cells is then an AND of words
+/// rather than a dictionary lookup per cell.
+typedef struct {
+    int x0, y0;     ///< column and row of the first bit of the bitmap
+    int width;      ///< words per row
+    int height;     ///< number of rows
+    uint64_t *bits;
+    int nc;         ///< number of cells in the set
+    int LLx, LLy, URx, URy; ///< bounding box of the cells in the set
+} cellset_t;
+
+/// round down to a multiple of 64
+static int floor64(int v) {
+    return v >= 0 ? v / 64 * 64 : -((-v + 63) / 64) * 64;
+}
+
+/// make room for the cells in the given rectangle
+static void cs_reserve(cellset_t *cs, int LLx, int LLy, int URx, int URy) {
+    if (cs->bits != NULL && LLx >= cs->x0 && LLy >= cs->y0 &&
+        URx < cs->x0 + 64 * cs->width && URy < cs->y0 + cs->height)
+	return;
+
+    if (cs->bits != NULL) {
+	// grow by at least the current size in each direction that overflows,
+	// to keep the cost of repeated growth linear
+	const int W = 64 * cs->width;
+	const int H = cs->height;
+	if (LLx >= cs->x0)
+	    LLx = cs->x0;
+	else if (LLx > cs->x0 - W)
+	    LLx = cs->x0 - W;
+	if (LLy >= cs->y0)
+	    LLy = cs->y0;
+	else if (LLy > cs->y0 - H)
+	    LLy = cs->y0 - H;
+	if (URx < cs->x0 + W)
+	    URx = cs->x0 + W - 1;
+	else if (URx < cs->x0 + 2 * W - 1)
+	    URx = cs->x0 + 2 * W - 1;
+	if (URy < cs->y0 + H)
+	    URy = cs->y0 + H - 1;
+	else if (URy < cs->y0 + 2 * H - 1)
+	    URy = cs->y0 + 2 * H - 1;
+    }
+
+    const int x0 = floor64(LLx);
+    const int width = (URx - x0) / 64 + 1;
+    const int height = URy - LLy + 1;
+    uint64_t *bits = gv_calloc((size_t)width * (size_t)height, sizeof(uint64_t));
+    if (cs->bits != NULL) {
+	const int shift = (cs->x0 - x0) / 64;
+	for (int r = 0; r < cs->height; r++)
+	    memcpy(bits + (size_t)(r + cs->y0 - LLy) * (size_t)width + shift,
+	           cs->bits + (size_t)r * (size_t)cs->width,
+	           (size_t)cs->width * sizeof(uint64_t));
+	free(cs->bits);
+    }
+    cs->x0 = x0;
+    cs->y0 = LLy;
+    cs->width = width;
+    cs->height = height;
+    cs->bits = bits;
+}
+
+/// add the cell `(x, y)` to the set
+static void cs_add(cellset_t *cs, int x, int y) {
+    cs_reserve(cs, x, y, x, y);
+    uint64_t *word = &cs->bits[(size_t)(y - cs->y0) * (size_t)cs->width +
+                               (size_t)((x - cs->x0) / 64)];
+    const uint64_t bit = UINT64_C(1) << ((x - cs->x0) % 64);
+    if (*word & bit)
+	return;
+    *word |= bit;
+    if (cs->nc == 0) {
+	cs->LLx = cs->URx = x;
+	cs->LLy = cs->URy = y;
+    } else {
+	cs->LLx = x < cs->LLx ? x : cs->LLx;
+	cs->LLy = y < cs->LLy ? y : cs->LLy;
+	cs->URx = x > cs->URx ? x : cs->URx;
+	cs->URy = y > cs->URy ? y : cs->URy;
+    }
+    cs->nc++;
+}
+
+/// is the cell `(x, y)` in the set?
+static bool cs_has(const cellset_t *cs, int x, int y) {
+    if (cs->nc == 0 || x < cs->LLx || x > cs->URx || y < cs->LLy ||
+        y > cs->URy)
+	return false;
+    const uint64_t word = cs->bits[(size_t)(y - cs->y0) * (size_t)cs->width +
+                                   (size_t)((x - cs->x0) / 64)];
+    return (word >> ((x - cs->x0) % 64)) & 1;
+}
+
+/// the 64 cells of row `y` starting at column `x`, as a word
+static uint64_t cs_word(const cellset_t *cs, int x, int y) {
+    if (y < cs->y0 || y >= cs->y0 + cs->height)
+	return 0;
+    const uint64_t *row = cs->bits + (size_t)(y - cs->y0) * (size_t)cs->width;
+    const int w = (floor64(x - cs->x0)) / 64;
+    const int s = x - cs->x0 - 64 * w;
+    const uint64_t lo = w >= 0 && w < cs->width ? row[w] : 0;
+    if (s == 0)
+	return lo;
+    const uint64_t hi = w + 1 >= 0 && w + 1 < cs->width ? row[w + 1] : 0;
+    return (lo >> s) | (hi << (64 - s));
+}
+
+/// does the set `poly`, translated by `(dx, dy)`, share a cell with `cs`?
+static bool cs_overlaps(const cellset_t *cs, const cellset_t *poly, int dx,
+                        int dy) {
+    if (cs->nc == 0 || poly->nc == 0)
+	return false;
+
+    // only the rows and columns where both bounding boxes meet need testing
+    const int LLx = poly->LLx + dx > cs->LLx ? poly->LLx + dx : cs->LLx;
+    const int URx = poly->URx + dx < cs->URx ? poly->URx + dx : cs->URx;
+    const int LLy = poly->LLy + dy > cs->LLy ? poly->LLy + dy : cs->LLy;
+    const int URy = poly->URy + dy < cs->URy ? poly->URy + dy : cs->URy;
+    if (LLx > URx || LLy > URy)
+	return false;
+
+    const int wlo = (LLx - dx - poly->x0) / 64;
+    const int whi = (URx - dx - poly->x0) / 64;
+    for (int y = LLy; y <= URy; y++) {
+	const uint64_t *row =
+	  poly->bits + (size_t)(y - dy - poly->y0) * (size_t)poly->width;
+	for (int w = wlo; w <= whi; w++) {
+	    if (row[w] != 0 && (row[w] & cs_word(cs, poly->x0 + 64 * w + dx, y)))
+		return true;
+	}
+    }
+    return false;
+}
+
+/// add the cells of `poly`, translated by `(dx, dy)`, to `cs`
+static void cs_union(cellset_t *cs, const cellset_t *poly, int dx, int dy) {
+    for (int y = poly->LLy; y <= poly->URy; y++)
+	for (int x = poly->LLx; x <= poly->URx; x++)
+	    if (cs_has(poly, x, y))
+		cs_add(cs, x + dx, y + dy);
+}
+
+static void cs_free(cellset_t *cs) {
+    free(cs->bits);
+    *cs = (cellset_t){0};
+}
+
+/// print the cells of a set, column by column
+static void dumpCells(const cellset_t *cs) {
+    if (cs->nc == 0)
+	return;
+    for (int x = cs->LLx; x <= cs->URx; x++)
+	for (int y = cs->LLy; y <= cs->URy; y++)
+	    if (cs_has(cs, x, y))
+		fprintf(stderr, "  %d %d cell\n", x, y);
+}
+
 typedef struct {
     int perim;			/* half size of bounding rectangle perimeter */
-    pointf *cells;		///< cells in covering polyomino
-    int nc;			/* no. of cells */
+    cellset_t cells;		///< cells in covering polyomino
     size_t index; ///<  index in original array
 } ginfo;
 
@@ -116,7 +282,7 @@ static int sgn(int x) {
 /* Mark cells crossed by line from cell p to cell q.
  * Bresenham's algorithm, from Graphics Gems I, pp. 99-100.
  */
-static void fillLine(pointf p, pointf q, PointSet * ps)
+static void fillLine(pointf p, pointf q, cellset_t *ps)
 {
     int x1 = ROUND(p.x);
     int y1 = ROUND(p.y);
@@ -136,7 +302,7 @@ static void fillLine(pointf p, pointf q, PointSet * ps)
     if (ax > ay) {              /* x dominant */
         d = ay - (ax >> 1);
         for (;;) {
-            addPS(ps, x, y);
+            cs_add(ps, x, y);
             if (x == x2)
                 return;
             if (d >= 0) {
@@ -149,7 +315,7 @@ static void fillLine(pointf p, pointf q, PointSet * ps)
     } else {                    /* y dominant */
         d = ax - (ay >> 1);
         for (;;) {
-            addPS(ps, x, y);
+            cs_add(ps, x, y);
             if (y == y2)
                 return;
             if (d >= 0) {
@@ -165,7 +331,7 @@ static void fillLine(pointf p, pointf q, PointSet * ps)
 /* It appears that spline_edges always have the start point at the
  * beginning and the end point at the end.
  */
-static void fillEdge(Agedge_t *e, pointf p, PointSet *ps, double dx, double dy,
+static void fillEdge(Agedge_t *e, pointf p, cellset_t *ps, double dx, double dy,
          int ssize, bool doS) {
     size_t k;
     bezier bz;
@@ -225,14 +391,13 @@ static void fillEdge(Agedge_t *e, pointf p, PointSet *ps, double dx, double dy,
  */
 static void genBox(boxf bb0, ginfo *info, int ssize, unsigned int margin,
                    pointf center, char *s) {
-    PointSet *ps;
+    cellset_t *ps = &info->cells;
     int W, H;
     pointf UR, LL;
     double x, y;
 
     const boxf bb = {.LL = {.x = round(bb0.LL.x), .y = round(bb0.LL.y)},
                      .UR = {.x = round(bb0.UR.x), .y = round(bb0.UR.y)}};
-    ps = newPS();
 
     LL.x = center.x - margin;
     LL.y = center.y - margin;
@@ -245,24 +410,17 @@ static void genBox(boxf bb0, ginfo *info, int ssize, unsigned int margin,
 
     for (x = LL.x; x <= UR.x; x++)
 	for (y = LL.y; y <= UR.y; y++)
-	    addPS(ps, x, y);
+	    cs_add(ps, (int)x, (int)y);
 
-    info->cells = pointsOf(ps);
-    info->nc = sizeOf(ps);
     W = GRID(bb0.UR.x - bb0.LL.x + 2 * margin, ssize);
     H = GRID(bb0.UR.y - bb0.LL.y + 2 * margin, ssize);
     info->perim = W + H;
 
     if (Verbose > 2) {
-	int i;
 	fprintf(stderr, "%s no. cells %d W %d H %d\n",
-		s, info->nc, W, H);
-	for (i = 0; i < info->nc; i++)
-	    fprintf(stderr, "  %.0f %.0f cell\n", info->cells[i].x,
-		    info->cells[i].y);
+		s, ps->nc, W, H);
+	dumpCells(ps);
     }
-
-    freePS(ps);
 }
 
 /* Generate polyomino info from graph.
@@ -276,7 +434,7 @@ static void genBox(boxf bb0, ginfo *info, int ssize, unsigned int margin,
  */
 static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
                    pack_info *pinfo, pointf center) {
-    PointSet *ps;
+    cellset_t *ps = &info->cells;
     int W, H;
     Agraph_t *eg;		/* graph containing edges */
     Agnode_t *n;
@@ -290,7 +448,6 @@ static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
     else
 	eg = g;
 
-    ps = newPS();
     const double dx = center.x - round(GD_bb(g).LL.x);
     const double dy = center.y - round(GD_bb(g).LL.y);
 
@@ -325,7 +482,7 @@ static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
 
 		for (double x = bb.LL.x; x <= bb.UR.x; x++)
 		    for (double y = bb.LL.y; y <= bb.UR.y; y++)
-			addPS(ps, x, y);
+			cs_add(ps, (int)x, (int)y);
 
 		/* note which nodes are in clusters */
 		for (n = agfstnode(subg); n; n = agnxtnode(subg, n))
@@ -350,7 +507,7 @@ static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
 
 		for (double x = LL.x; x <= UR.x; x++)
 		    for (double y = LL.y; y <= UR.y; y++)
-			addPS(ps, x, y);
+			cs_add(ps, (int)x, (int)y);
 
 		CELL(pt, ssize);
 		pt = (pointf){.x = round(pt.x), .y = round(pt.y)};
@@ -390,7 +547,7 @@ static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
 
 	    for (double x = LL.x; x <= UR.x; x++)
 		for (double y = LL.y; y <= UR.y; y++)
-		    addPS(ps, x, y);
+		    cs_add(ps, (int)x, (int)y);
 
 	    CELL(pt, ssize);
 	    pt = (pointf){.x = round(pt.x), .y = round(pt.y)};
@@ -399,59 +556,37 @@ static int genPoly(Agraph_t *root, Agraph_t *g, ginfo *info, int ssize,
 	    }
 	}
 
-    info->cells = pointsOf(ps);
-    info->nc = sizeOf(ps);
     W = GRID(GD_bb(g).UR.x - GD_bb(g).LL.x + 2 * margin, ssize);
     H = GRID(GD_bb(g).UR.y - GD_bb(g).LL.y + 2 * margin, ssize);
     info->perim = W + H;
 
     if (Verbose > 2) {
-	int i;
 	fprintf(stderr, "%s no. cells %d W %d H %d\n",
-		agnameof(g), info->nc, W, H);
-	for (i = 0; i < info->nc; i++)
-	    fprintf(stderr, "  %.0f %.0f cell\n", info->cells[i].x,
-		    info->cells[i].y);
+		agnameof(g), ps->nc, W, H);
+	dumpCells(ps);
     }
 
-    freePS(ps);
     return 0;
 }
 
 /* Check if polyomino fits at given point.
  * If so, add cells to pointset, store point in place and return true.
  */
-static int fits(int x, int y, ginfo *info, PointSet *ps, pointf *place,
+static int fits(int x, int y, ginfo *info, cellset_t *ps, pointf *place,
                 int step, boxf *bbs) {
-    pointf *cells = info->cells;
-    int n = info->nc;
-    int i;
-
-    for (i = 0; i < n; i++) {
-	pointf cell = *cells;
-	cell.x += x;
-	cell.y += y;
-	if (inPS(ps, cell))
-	    return 0;
-	cells++;
-    }
+    if (cs_overlaps(ps, &info->cells, x, y))
+	return 0;
 
     const pointf LL = {.x = round(bbs[info->index].LL.x),
                        .y = round(bbs[info->index].LL.y)};
     place->x = step * x - LL.x;
     place->y = step * y - LL.y;
 
-    cells = info->cells;
-    for (i = 0; i < n; i++) {
-	pointf cell = *cells;
-	cell.x += x;
-	cell.y += y;
-	insertPS(ps, cell);
-	cells++;
-    }
+    cs_union(ps, &info->cells, x, y);
 
     if (Verbose >= 2)
-	fprintf(stderr, "cc (%d cells) at (%d,%d) (%.0f,%.0f)\n", n, x, y,
+	fprintf(stderr, "cc (%d cells) at (%d,%d) (%.0f,%.0f)\n", info->cells.nc,
+		x, y,
 		place->x, place->y);
     return 1;
 }
@@ -460,21 +595,15 @@ static int fits(int x, int y, ginfo *info, PointSet *ps, pointf *place,
  * fill polyomino set. Note that polyomino set for the
  * graph is constructed where it will be.
  */
-static void placeFixed(ginfo *info, PointSet *ps, pointf *place,
+static void placeFixed(ginfo *info, cellset_t *ps, pointf *place,
                        pointf center) {
-    pointf *cells = info->cells;
-    int n = info->nc;
-    int i;
-
     place->x = -center.x;
     place->y = -center.y;
 
-    for (i = 0; i < n; i++) {
-	insertPS(ps, *cells++);
-    }
+    cs_union(ps, &info->cells, 0, 0);
 
     if (Verbose >= 2)
-	fprintf(stderr, "cc (%d cells) at (%.0f,%.0f)\n", n, place->x,
+	fprintf(stderr, "cc (%d cells) at (%.0f,%.0f)\n", info->cells.nc, place->x,
 		place->y);
 }
 
@@ -483,7 +612,7 @@ static void placeFixed(ginfo *info, PointSet *ps, pointf *place,
  * with bounding box origin at point.
  * First graph (i == 0) is centered on the origin if possible.
  */
-static void placeGraph(size_t i, ginfo *info, PointSet *ps, pointf *place,
+static void placeGraph(size_t i, ginfo *info, cellset_t *ps, pointf *place,
                        int step, unsigned int margin, boxf* bbs) {
     int x, y;
     int bnd;
@@ -546,13 +675,8 @@ static void placeGraph(size_t i, ginfo *info, PointSet *ps, pointf *place,
 #ifdef DEBUG
 void dumpp(ginfo * info, char *pfx)
 {
-    pointf *cells = info->cells;
-    int i, c_cnt = info->nc;
-
     fprintf(stderr, "%s\n", pfx);
-    for (i = 0; i < c_cnt; i++) {
-	fprintf(stderr, "%.0f %.0f box\n", cells[i].x, cells[i].y);
-    }
+    dumpCells(&info->cells);
 }
 #endif
 
@@ -701,7 +825,7 @@ static pointf *arrayRects(size_t ng, boxf *gs, pack_info *pinfo) {
 
 static pointf *polyRects(size_t ng, boxf *gs, pack_info *pinfo) {
     int stepSize;
-    Dict_t *ps;
+    cellset_t ps = {0};
 
     /* calculate grid size */
     stepSize = computeStep(ng, gs, pinfo->margin);
@@ -724,17 +848,16 @@ static pointf *polyRects(size_t ng, boxf *gs, pack_info *pinfo) {
     }
     qsort(sinfo, ng, sizeof(ginfo *), cmpf);
 
-    ps = newPS();
     pointf *places = gv_calloc(ng, sizeof(pointf));
     for (size_t i = 0; i < ng; i++)
-	placeGraph(i, sinfo[i], ps, places + sinfo[i]->index,
+	placeGraph(i, sinfo[i], &ps, places + sinfo[i]->index,
 		       stepSize, pinfo->margin, gs);
 
     free(sinfo);
     for (size_t i = 0; i < ng; i++)
-	free(info[i].cells);
+	cs_free(&info[i].cells);
     free(info);
-    freePS(ps);
+    cs_free(&ps);
 
     if (Verbose > 1)
 	for (size_t i = 0; i < ng; i++)
@@ -772,7 +895,7 @@ static pointf *polyGraphs(size_t ng, Agraph_t **gs, Agraph_t *root,
                           pack_info *pinfo) {
     int stepSize;
     ginfo *info;
-    Dict_t *ps;
+    cellset_t ps = {0};
     bool *fixed = pinfo->fixed;
     int fixed_cnt = 0;
     boxf fixed_bb = { {0, 0}, {0, 0} };
@@ -843,29 +966,28 @@ static pointf *polyGraphs(size_t ng, Agraph_t **gs, Agraph_t *root,
     }
     qsort(sinfo, ng, sizeof(ginfo *), cmpf);
 
-    ps = newPS();
     pointf *places = gv_calloc(ng, sizeof(pointf));
     if (fixed) {
 	for (size_t i = 0; i < ng; i++) {
 	    if (fixed[i])
-		placeFixed(sinfo[i], ps, places + sinfo[i]->index, center);
+		placeFixed(sinfo[i], &ps, places + sinfo[i]->index, center);
 	}
 	for (size_t i = 0; i < ng; i++) {
 	    if (!fixed[i])
-		placeGraph(i, sinfo[i], ps, places + sinfo[i]->index,
+		placeGraph(i, sinfo[i], &ps, places + sinfo[i]->index,
 			   stepSize, pinfo->margin, bbs);
 	}
     } else {
 	for (size_t i = 0; i < ng; i++)
-	    placeGraph(i, sinfo[i], ps, places + sinfo[i]->index,
+	    placeGraph(i, sinfo[i], &ps, places + sinfo[i]->index,
 		       stepSize, pinfo->margin, bbs);
     }
 
     free(sinfo);
     for (size_t i = 0; i < ng; i++)
-	free(info[i].cells);
+	cs_free(&info[i].cells);
     free(info);
-    freePS(ps);
+    cs_free(&ps);
     free (bbs);
 
     if (Verbose > 1)
@@ -1086,6 +1208,48 @@ int packGraphs(size_t ng, Agraph_t **gs, Agraph_t *root, pack_info *info) {
     return ret;
 }
 
+typedef struct {
+    const pack_layout *layout;
+    void **states;
+} run_t;
+
+static void runLayout(void *arg, size_t i) {
+    run_t *r = arg;
+    if (r->states[i])
+	r->layout->run(r->states[i]);
+}
+
+/* Lays out graphs, then packs them.
+ *  ng - number of graphs
+ *  gs - pointer to array of graphs
+ *  root - graph used to find edges
+ *  info - parameters used in packing
+ *  layout - how to lay out each graph
+ *  arg - passed to layout->start and layout->finish
+ * The layouts are set up for all graphs, then the run phases of the
+ * layouts are done concurrently, and then the layouts are finished.
+ * Finally, the graphs are packed as with packGraphs.
+ *
+ * Returns 0 on success.
+ */
+int layoutAndPackGraphs(size_t ng, Agraph_t **gs, Agraph_t *root,
+                        pack_info *info, const pack_layout *layout,
+                        void *arg) {
+    void **states = gv_calloc(ng, sizeof(void *));
+
+    for (size_t i = 0; i < ng; i++)
+	states[i] = layout->start(gs[i], arg);
+    if (layout->run) {
+	run_t r = {.layout = layout, .states = states};
+	gv_parallel_for(ng, runLayout, &r);
+    }
+    for (size_t i = 0; i < ng; i++)
+	layout->finish(gs[i], states[i], arg);
+    free(states);
+
+    return packGraphs(ng, gs, root, info);
+}
+
 /* Packs subgraphs of given root graph, then recalculates root's bounding box.
  * Note that it does not recompute subgraph bounding boxes.
  * Cluster bounding boxes are recomputed in shiftGraphs.
@@ -75,6 +75,21 @@ typedef unsigned int packval_t;
 	int flags;       
     } pack_info;
 
+/* Layout of a graph in three phases, for layoutAndPackGraphs.
+ *  start  - set up the layout of g, returning its state
+ *  run    - compute the layout from the state; may be NULL
+ *  finish - store the layout in g, and free the state
+ * start and finish are called for one graph at a time, in order, and may
+ * use anything. run is called for several graphs at the same time, on
+ * multiple threads, so it may only use its state and data that nothing
+ * modifies during the run phase.
+ */
+    typedef struct {
+	void *(*start)(Agraph_t *g, void *arg);
+	void (*run)(void *state);
+	void (*finish)(Agraph_t *g, void *state, void *arg);
+    } pack_layout;
+
 #ifdef GVDLL
 #ifdef GVC_EXPORTS
 #define PACK_API __declspec(dllexport)
@@ -93,6 +108,9 @@ typedef unsigned int packval_t;
     PACK_API pointf *putGraphs(size_t, Agraph_t **, Agraph_t *, pack_info *);
     PACK_API int packGraphs(size_t, Agraph_t **, Agraph_t *, pack_info *);
     PACK_API int packSubgraphs(size_t, Agraph_t **, Agraph_t *, pack_info *);
+    PACK_API int layoutAndPackGraphs(size_t ng, Agraph_t **gs, Agraph_t *root,
+                                     pack_info *info,
+                                     const pack_layout *layout, void *arg);
     PACK_API int pack_graph(size_t ng, Agraph_t **gs, Agraph_t *root, bool *fixed);
 
     PACK_API int shiftGraphs(size_t, Agraph_t **, pointf *, Agraph_t *, bool);
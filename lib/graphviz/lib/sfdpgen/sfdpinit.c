@@ -59,6 +59,23 @@ static void sfdp_init_graph(Agraph_t * g)
     sfdp_init_node_edge(g);
 }
 
+/* readPos:
+ * Read the nodes' pos attributes, for start=self.
+ */
+static void readPos(Agraph_t * g)
+{
+    attrsym_t *N_pos = agfindnodeattr(g, "pos");
+    const int nG = agnnodes(g);
+    double save_scale = PSinputscale;
+
+    if (N_pos == NULL)
+	return;
+    PSinputscale = get_inputscale(g);
+    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n))
+	user_pos(N_pos, NULL, n, nG);
+    PSinputscale = save_scale;
+}
+
 /* getPos:
  */
 static double *getPos(Agraph_t * g)
@@ -86,6 +103,7 @@ static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
                        pointf pad) {
     double *sizes;
     double *pos;
+    bool *placed = NULL;
     Agnode_t *n;
     int flag, i;
     int n_edge_label_nodes = 0, *edge_label_nodes = NULL;
@@ -100,8 +118,13 @@ static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
     else
 	sizes = NULL;
     pos = getPos(g);
+    if (!ctrl->random_start) {
+	placed = gv_calloc(agnnodes(g), sizeof(bool));
+	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	    placed[ND_id(n)] = hasPos(n);
+    }
 
-    multilevel_spring_electrical_embedding(Ndim, A, ctrl, sizes, pos, n_edge_label_nodes, edge_label_nodes, &flag);
+    multilevel_spring_electrical_embedding(Ndim, A, ctrl, sizes, pos, placed, n_edge_label_nodes, edge_label_nodes, &flag);
 
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	double *npos = pos + (Ndim * ND_id(n));
@@ -112,6 +135,7 @@ static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
 
     free(sizes);
     free(pos);
+    free(placed);
     SparseMatrix_delete (A);
     free(edge_label_nodes);
 }
@@ -205,10 +229,12 @@ tuneControl (graph_t* g, spring_electrical_control ctrl)
 
     seed = ctrl->random_seed;
     init = setSeed (g, INIT_RANDOM, &seed);
-    if (init != INIT_RANDOM) {
-        agwarningf("sfdp only supports start=random\n");
+    if (init == INIT_REGULAR) {
+        agwarningf("sfdp only supports start=random or start=self\n");
     }
     ctrl->random_seed = seed;
+    /* start=self refines the layout given by the nodes' pos */
+    ctrl->random_start = init != INIT_SELF;
 
     ctrl->K = late_double(g, agfindgraphattr(g, "K"), -1.0, 0.0);
     ctrl->p = -1.0*late_double(g, agfindgraphattr(g, "repulsiveforce"), -AUTOP, 0.0);
@@ -240,6 +266,8 @@ void sfdp_layout(graph_t * g)
 	spring_electrical_control ctrl = spring_electrical_control_new();
 
 	tuneControl (g, ctrl);
+	if (!ctrl->random_start)
+	    readPos(g);
 #if (defined(HAVE_GTS) || defined(HAVE_TRIANGLE))
 	graphAdjustMode(g, &am, "prism0");
 #else
@@ -45,6 +45,10 @@ static const double tol = 0.001;
 
 static const double cool = 0.90;
 
+/// initial step of a refinement, as a fraction of K. As the step cools by
+/// `cool` each iteration, no node moves more than ten times this in all.
+static const double refine_step = 0.05;
+
 spring_electrical_control spring_electrical_control_new(void){
   spring_electrical_control ctrl;
   ctrl = gv_alloc(sizeof(struct spring_electrical_control_struct));
@@ -863,6 +867,111 @@ static void prolongate(int dim, SparseMatrix A, SparseMatrix P, SparseMatrix R,
   }
 }
 
+/* mean_edge_length:
+ * Average length of the edges of A between nodes marked in placed, or of all
+ * of them if placed is NULL. Returns 0 if there are no such edges.
+ */
+static double mean_edge_length(int dim, SparseMatrix A, const bool *placed,
+                               double *x) {
+  int *ia = A->ia, *ja = A->ja, i, j, ne = 0;
+  double dist = 0;
+
+  for (i = 0; i < A->m; i++) {
+    if (placed && !placed[i]) continue;
+    for (j = ia[i]; j < ia[i+1]; j++) {
+      if (ja[j] == i || (placed && !placed[ja[j]])) continue;
+      dist += distance(x, dim, i, ja[j]);
+      ne++;
+    }
+  }
+  return ne > 0 ? dist / ne : 0;
+}
+
+/* place_new_nodes:
+ * Give coordinates to the nodes of A not marked in placed, working outwards
+ * from the placed ones. Each new node goes to the average of its neighbors
+ * placed so far, like interpolate_coord, jittered by up to half the average
+ * edge length K so that new leaves of one node do not coincide. Nodes with no
+ * path to a placed one are scattered around the centroid of the layout.
+ * Returns the average length of edges between placed nodes, or -1 if no node
+ * was placed.
+ */
+static double place_new_nodes(int dim, SparseMatrix A, const bool *placed,
+                              double *x) {
+  int n = A->m, *ia = A->ia, *ja = A->ja, i, j, k;
+  double K, dist;
+  int nplaced = 0;
+
+  double *center = gv_calloc(dim, sizeof(double));
+  for (i = 0; i < n; i++) {
+    if (!placed[i]) continue;
+    nplaced++;
+    for (k = 0; k < dim; k++) center[k] += x[i*dim+k];
+  }
+  if (nplaced == 0) {
+    free(center);
+    return -1;
+  }
+  for (k = 0; k < dim; k++) center[k] /= nplaced;
+  K = mean_edge_length(dim, A, placed, x);
+  if (K <= 0) K = 1;
+
+  bitarray_t done = bitarray_new(n);
+  ints_t queue = {0};
+  for (i = 0; i < n; i++) {
+    if (!placed[i]) continue;
+    bitarray_set(&done, i, true);
+    ints_append(&queue, i);
+  }
+
+  while (!ints_is_empty(&queue)) {
+    i = ints_pop_front(&queue);
+    for (j = ia[i]; j < ia[i+1]; j++) {
+      const int v = ja[j];
+      if (bitarray_get(done, v)) continue;
+      int nz = 0;
+      double *xv = &x[v*dim];
+      for (k = 0; k < dim; k++) xv[k] = 0;
+      for (int l = ia[v]; l < ia[v+1]; l++) {
+        if (ja[l] == v || !bitarray_get(done, ja[l])) continue;
+        nz++;
+        for (k = 0; k < dim; k++) xv[k] += x[ja[l]*dim+k];
+      }
+      dist = K / nz;
+      for (k = 0; k < dim; k++) xv[k] = xv[k] / nz + dist*(drand() - 0.5);
+      bitarray_set(&done, v, true);
+      ints_append(&queue, v);
+    }
+  }
+
+  for (i = 0; i < n; i++) {
+    if (bitarray_get(done, i)) continue;
+    for (k = 0; k < dim; k++) x[i*dim+k] = center[k] + K*(drand() - 0.5);
+  }
+
+  ints_free(&queue);
+  bitarray_reset(&done);
+  free(center);
+  return K;
+}
+
+/* embed:
+ * Run the force iterations on one level, with the quadtree scheme asked for.
+ */
+static void embed(int dim, SparseMatrix A, spring_electrical_control ctrl,
+                  double *x, int *flag) {
+  if (ctrl->tscheme == QUAD_TREE_NONE){
+    spring_electrical_embedding_slow(dim, A, ctrl, x, flag);
+  } else if (ctrl->tscheme == QUAD_TREE_FAST || (ctrl->tscheme == QUAD_TREE_HYBRID && A->m > QUAD_TREE_HYBRID_SIZE)){
+    if (ctrl->tscheme == QUAD_TREE_HYBRID && A->m > 10 && Verbose){
+      fprintf(stderr, "QUAD_TREE_HYBRID, size larger than %d, switch to fast quadtree", QUAD_TREE_HYBRID_SIZE);
+    }
+    spring_electrical_embedding_fast(dim, A, ctrl, x, flag);
+  } else {
+    spring_electrical_embedding(dim, A, ctrl, x, flag);
+  }
+}
+
 static bool power_law_graph(SparseMatrix A) {
   int m, max = 0, i, *ia = A->ia, *ja = A->ja, j, deg;
   bool res = false;
@@ -1081,12 +1190,13 @@ static SparseMatrix shorting_edge_label_nodes(SparseMatrix A, int n_edge_label_n
 void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
                                             spring_electrical_control ctrl,
                                             double *label_sizes, double *x,
+                                            const bool *placed,
                                             int n_edge_label_nodes,
                                             int *edge_label_nodes, int *flag) {
 
   int n;
   SparseMatrix A = A0, P = NULL;
-  Multilevel grid, grid0;
+  Multilevel grid, grid0 = NULL;
   double *xc = NULL, *xf = NULL;
   struct spring_electrical_control_struct ctrl0;
 #ifdef TIME
@@ -1117,7 +1227,9 @@ void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
 
     double *x2 = gv_calloc(A->m * dim, sizeof(double));
     A2 = shorting_edge_label_nodes(A, n_edge_label_nodes, edge_label_nodes);
-    multilevel_spring_electrical_embedding(dim, A2, ctrl, NULL, x2, 0, NULL, flag);
+    ctrl->random_start = true;
+    multilevel_spring_electrical_embedding(dim, A2, ctrl, NULL, x2, NULL, 0, NULL, flag);
+    ctrl->random_start = ctrl0.random_start;
 
     assert(!(*flag));
     attach_edge_label_coordinates(dim, A, n_edge_label_nodes, edge_label_nodes, x, x2);
@@ -1130,63 +1242,79 @@ void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
     return;
   }
 
-  Multilevel_control mctrl = {.maxlevel = ctrl->multilevels};
-  grid0 = Multilevel_new(A, mctrl);
-
-  grid = Multilevel_get_coarsest(grid0);
-  if (Multilevel_is_finest(grid)){
-    xc = x;
-  } else {
-    xc = gv_calloc(grid->n * dim, sizeof(double));
-  }
-
   const bool plg = power_law_graph(A);
   if (ctrl->p == AUTOP){
     ctrl->p = -1;
     if (plg) ctrl->p = -1.8;
   }
 
-  do {
-#ifdef DEBUG_PRINT
-    if (Verbose) {
-      print_padding(grid->level);
-      if (Multilevel_is_coarsest(grid)){
-	fprintf(stderr, "coarsest level -- %d, n = %d\n", grid->level, grid->n);
-      } else {
-	fprintf(stderr, "level -- %d, n = %d\n", grid->level, grid->n);
-      }
-    }
-#endif
-    if (ctrl->tscheme == QUAD_TREE_NONE){
-      spring_electrical_embedding_slow(dim, grid->A, ctrl, xc, flag);
-    } else if (ctrl->tscheme == QUAD_TREE_FAST || (ctrl->tscheme == QUAD_TREE_HYBRID && grid->A->m > QUAD_TREE_HYBRID_SIZE)){
-      if (ctrl->tscheme == QUAD_TREE_HYBRID && grid->A->m > 10 && Verbose){
-	fprintf(stderr, "QUAD_TREE_HYBRID, size larger than %d, switch to fast quadtree", QUAD_TREE_HYBRID_SIZE);
+  /* refinement: continue from the given layout at the finest level only,
+     moving nodes a fraction of an edge length at most */
+  bool refine = false;
+  if (!ctrl->random_start && placed) {
+    srand(ctrl->random_seed);
+    const double K = place_new_nodes(dim, A, placed, x);
+    refine = K > 0;
+    if (!refine) ctrl->random_start = true; /* nothing to start from */
+    else {
+      if (ctrl->K < 0) ctrl->K = K;
+      ctrl->adaptive_cooling = false;
+      ctrl->step = refine_step * ctrl->K;
+      embed(dim, A, ctrl, x, flag);
+      if (*flag) goto RETURN;
+      /* the forces balance at their own edge length, which need not be the
+         one given; keep the given scale so that refinements do not drift */
+      const double len = mean_edge_length(dim, A, NULL, x);
+      if (len > 0) {
+        for (int i = 0; i < n * dim; i++) x[i] *= K / len;
       }
-      spring_electrical_embedding_fast(dim, grid->A, ctrl, xc, flag);
-    } else {
-      spring_electrical_embedding(dim, grid->A, ctrl, xc, flag);
-    }
-    if (Multilevel_is_finest(grid)) break;
-    if (*flag) {
-      free(xc);
-      goto RETURN;
     }
-    P = grid->P;
-    grid = grid->prev;
+  }
+
+  if (!refine) {
+    Multilevel_control mctrl = {.maxlevel = ctrl->multilevels};
+    grid0 = Multilevel_new(A, mctrl);
+
+    grid = Multilevel_get_coarsest(grid0);
     if (Multilevel_is_finest(grid)){
-      xf = x;
+      xc = x;
     } else {
-      xf = gv_calloc(grid->n * dim, sizeof(double));
+      xc = gv_calloc(grid->n * dim, sizeof(double));
     }
-    prolongate(dim, grid->A, P, grid->R, xc, xf, (ctrl->K)*0.001);
-    free(xc);
-    xc = xf;
-    ctrl->random_start = false;
-    ctrl->K = ctrl->K * 0.75;
-    ctrl->adaptive_cooling = false;
-    ctrl->step = .1;
-  } while (grid);
+
+    do {
+#ifdef DEBUG_PRINT
+      if (Verbose) {
+        print_padding(grid->level);
+        if (Multilevel_is_coarsest(grid)){
+          fprintf(stderr, "coarsest level -- %d, n = %d\n", grid->level, grid->n);
+        } else {
+          fprintf(stderr, "level -- %d, n = %d\n", grid->level, grid->n);
+        }
+      }
+#endif
+      embed(dim, grid->A, ctrl, xc, flag);
+      if (Multilevel_is_finest(grid)) break;
+      if (*flag) {
+        free(xc);
+        goto RETURN;
+      }
+      P = grid->P;
+      grid = grid->prev;
+      if (Multilevel_is_finest(grid)){
+        xf = x;
+      } else {
+        xf = gv_calloc(grid->n * dim, sizeof(double));
+      }
+      prolongate(dim, grid->A, P, grid->R, xc, xf, (ctrl->K)*0.001);
+      free(xc);
+      xc = xf;
+      ctrl->random_start = false;
+      ctrl->K = ctrl->K * 0.75;
+      ctrl->adaptive_cooling = false;
+      ctrl->step = .1;
+    } while (grid);
+  }
 
 #ifdef TIME
   if (Verbose)
@@ -1198,11 +1326,12 @@ void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
 
   if (Verbose) fprintf(stderr, "ctrl->overlap=%d\n",ctrl->overlap);
 
-  /* rotation has to be done before overlap removal, since rotation could induce overlaps */
-  if (dim == 2){
+  /* rotation has to be done before overlap removal, since rotation could induce overlaps.
+     A refined layout keeps the orientation it was given. */
+  if (dim == 2 && !refine){
     pcp_rotate(n, dim, x);
   }
-  if (ctrl->rotation != 0) rotate(n, dim, x, ctrl->rotation);
+  if (ctrl->rotation != 0 && !refine) rotate(n, dim, x, ctrl->rotation);
 
 
   remove_overlap(dim, A, x, label_sizes, ctrl->overlap, ctrl->initial_scaling,
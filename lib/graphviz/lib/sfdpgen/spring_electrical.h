@@ -58,9 +58,17 @@ void spring_electrical_control_print(spring_electrical_control ctrl);
 void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *x, int *flag);
 void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *x, int *flag);
 
+/// lay out `A0` into `x`
+///
+/// If `ctrl->random_start` is false and `placed` is non-NULL, `x` already holds
+/// a layout of the nodes marked in `placed`. Rather than coarsening the graph
+/// and starting over, the other nodes are put beside their neighbors and the
+/// whole is refined at the finest level with small steps, keeping its
+/// orientation.
 void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
                                             spring_electrical_control ctrl,
                                             double *label_sizes, double *x,
+                                            const bool *placed,
                                             int n_edge_label_nodes,
                                             int *edge_label_nodes, int *flag);
 
@@ -17,7 +17,9 @@
 #include <sparse/SparseMatrix.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <util/alloc.h>
+#include <util/gv_parallel.h>
 
 static size_t size_of_matrix_type(int type){
   size_t size = 0;
@@ -829,48 +831,88 @@ SparseMatrix SparseMatrix_add(SparseMatrix A, SparseMatrix B){
   return C;
 }
 
+/// below this many nonzeros in the matrix on the left, a product is computed on
+/// the calling thread
+///
+/// Handing a loop to the waiting workers of `gv_parallel_for` costs a few
+/// microseconds. A matrix-vector product with this many nonzeros takes about
+/// 130 microseconds on one thread, so the hand-off is a few percent of it.
+/// Sparse matrix products take far longer for the same number of nonzeros.
+/// cmd/tools/sparse_benchmark.c times these products at each thread count.
+enum { PARALLEL_MIN_NZ = 1 << 16 };
+
+/// number of row ranges to split a product with `A` on the left into
+///
+/// Unlike the other uses of `gv_parallel_for`, products are only split when
+/// `GV_THREADS` is set. How far they speed up across cores has yet to be
+/// measured, so they stay on one thread by default.
+static size_t row_chunks(SparseMatrix A) {
+  if (A->nz < PARALLEL_MIN_NZ || A->m <= 1 || getenv("GV_THREADS") == NULL) {
+    return 1;
+  }
+  // a few ranges per thread, so rows of uneven length balance out
+  const size_t chunks = 4 * gv_nthreads();
+  return chunks < (size_t)A->m ? chunks : (size_t)A->m;
+}
+
+/// first row of range `chunk` out of `chunks` over `m` rows
+static int chunk_start(int m, size_t chunk, size_t chunks) {
+  return (int)((size_t)m * chunk / chunks);
+}
+
+/// a product of a sparse matrix and a dense vector or matrix
+typedef struct {
+  SparseMatrix A;
+  const double *v;
+  double *res;
+  int dim;
+  size_t chunks;
+} dense_product_t;
+
+static void multiply_dense_rows(void *arg, size_t chunk) {
+  const dense_product_t *p = arg;
+  const int *ia = p->A->ia, *ja = p->A->ja;
+  const double *a = p->A->a;
+  const double *v = p->v;
+  double *res = p->res;
+  const int dim = p->dim;
+  const int end = chunk_start(p->A->m, chunk + 1, p->chunks);
+
+  for (int i = chunk_start(p->A->m, chunk, p->chunks); i < end; i++){
+    for (int k = 0; k < dim; k++) res[i * dim + k] = 0;
+    for (int j = ia[i]; j < ia[i+1]; j++){
+      for (int k = 0; k < dim; k++) res[i * dim + k] += a[j] * v[ja[j] *dim + k];
+    }
+  }
+}
+
 void SparseMatrix_multiply_dense(SparseMatrix A, const double *v, double *res,
                                  int dim) {
   // A × V, with A dimension m × n, with V a dense matrix of dimension n × dim.
   // v[i×dim×j] gives V[i,j]. Result of dimension m × dim. Real only for now.
-  int i, j, k, *ia, *ja, m;
-  double *a;
-
   assert(A->format == FORMAT_CSR);
   assert(A->type == MATRIX_TYPE_REAL);
 
-  a = A->a;
-  ia = A->ia;
-  ja = A->ja;
-  m = A->m;
-
-  for (i = 0; i < m; i++){
-    for (k = 0; k < dim; k++) res[i * dim + k] = 0;
-    for (j = ia[i]; j < ia[i+1]; j++){
-      for (k = 0; k < dim; k++) res[i * dim + k] += a[j] * v[ja[j] *dim + k];
-    }
-  }
+  // rows are independent, so they are computed in ranges on multiple threads
+  dense_product_t p = {.A = A, .v = v, .res = res, .dim = dim,
+                       .chunks = row_chunks(A)};
+  gv_parallel_for(p.chunks, multiply_dense_rows, &p);
 }
 
-void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
-  /* A v or A^T v. Real only for now. */
-  int i, j, *ia, *ja, m;
-  double *a, *u = NULL;
-  int *ai;
-  assert(A->format == FORMAT_CSR);
-  assert(A->type == MATRIX_TYPE_REAL || A->type == MATRIX_TYPE_INTEGER);
-
-  ia = A->ia;
-  ja = A->ja;
-  m = A->m;
-  u = *res;
+static void multiply_vector_rows(void *arg, size_t chunk) {
+  const dense_product_t *p = arg;
+  const int *ia = p->A->ia, *ja = p->A->ja;
+  const double *v = p->v;
+  double *u = p->res;
+  const int start = chunk_start(p->A->m, chunk, p->chunks);
+  const int end = chunk_start(p->A->m, chunk + 1, p->chunks);
+  int i, j;
 
-  switch (A->type){
-  case MATRIX_TYPE_REAL:
-    a = A->a;
+  switch (p->A->type){
+  case MATRIX_TYPE_REAL: {
+    const double *a = p->A->a;
     if (v){
-      if (!u) u = gv_calloc((size_t)m, sizeof(double));
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
 	u[i] = 0.;
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  u[i] += a[j]*v[ja[j]];
@@ -878,8 +920,7 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
       }
     } else {
       /* v is assumed to be all 1's */
-      if (!u) u = gv_calloc((size_t)m, sizeof(double));
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
 	u[i] = 0.;
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  u[i] += a[j];
@@ -887,11 +928,11 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
       }
     }
     break;
-  case MATRIX_TYPE_INTEGER:
-    ai = A->a;
+  }
+  case MATRIX_TYPE_INTEGER: {
+    const int *ai = p->A->a;
     if (v){
-      if (!u) u = gv_calloc((size_t)m, sizeof(double));
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
 	u[i] = 0.;
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  u[i] += ai[j]*v[ja[j]];
@@ -899,8 +940,7 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
       }
     } else {
       /* v is assumed to be all 1's */
-      if (!u) u = gv_calloc((size_t)m, sizeof(double));
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
 	u[i] = 0.;
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  u[i] += ai[j];
@@ -908,73 +948,129 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
       }
     }
     break;
+  }
   default:
     assert(0);
-    u = NULL;
   }
-  *res = u;
-
 }
 
-SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
-  int m;
-  SparseMatrix C = NULL;
-  int *mask = NULL;
-  int *ia = A->ia, *ja = A->ja, *ib = B->ia, *jb = B->ja, *ic, *jc;
-  int i, j, k, jj, type, nz;
-
-  assert(A->format == B->format && A->format == FORMAT_CSR);/* other format not yet supported */
+void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res) {
+  /* A v or A^T v. Real only for now. */
+  double *u = *res;
+  assert(A->format == FORMAT_CSR);
+  assert(A->type == MATRIX_TYPE_REAL || A->type == MATRIX_TYPE_INTEGER);
 
-  m = A->m;
-  if (A->n != B->m) return NULL;
-  if (A->type != B->type){
-#ifdef DEBUG
-    printf("in SparseMatrix_multiply, the matrix types do not match, right now only multiplication of matrices of the same type is supported\n");
-#endif
-    return NULL;
+  if (A->type != MATRIX_TYPE_REAL && A->type != MATRIX_TYPE_INTEGER) {
+    *res = NULL;
+    return;
   }
-  type = A->type;
-  
-  mask = calloc((size_t)B->n, sizeof(int));
-  if (!mask) return NULL;
 
-  for (i = 0; i < B->n; i++) mask[i] = -1;
+  if (!u) u = gv_calloc((size_t)A->m, sizeof(double));
+  dense_product_t p = {.A = A, .v = v, .res = u, .chunks = row_chunks(A)};
+  gv_parallel_for(p.chunks, multiply_vector_rows, &p);
+  *res = u;
+}
 
-  nz = 0;
-  for (i = 0; i < m; i++){
+/// a product of two or three sparse matrices, computed in two passes over
+/// ranges of rows: one to count the nonzeros of each row of the result, and
+/// one to fill them in once the result is allocated
+typedef struct {
+  SparseMatrix A;
+  SparseMatrix B;
+  SparseMatrix C; ///< third factor, or NULL for a product of two
+  SparseMatrix D; ///< result, NULL during the first pass
+  int *counts;    ///< nonzeros per row of the result, from the first pass
+  size_t chunks;
+} sparse_product_t;
+
+/// mark of row `i` in the first pass’ masks
+static int counted(int i) { return -i - 2; }
+
+static void multiply_count_rows(void *arg, size_t chunk) {
+  const sparse_product_t *p = arg;
+  const SparseMatrix last = p->C ? p->C : p->B;
+  const int *ia = p->A->ia, *ja = p->A->ja, *ib = p->B->ia, *jb = p->B->ja;
+  const int *ic = p->C ? p->C->ia : NULL, *jc = p->C ? p->C->ja : NULL;
+  const int end = chunk_start(p->A->m, chunk + 1, p->chunks);
+  int *mask = gv_calloc((size_t)last->n, sizeof(int));
+  int j, k, l, jj, ll;
+
+  for (k = 0; k < last->n; k++) mask[k] = -1;
+
+  for (int i = chunk_start(p->A->m, chunk, p->chunks); i < end; i++){
+    int nz = 0;
     for (j = ia[i]; j < ia[i+1]; j++){
       jj = ja[j];
-      for (k = ib[jj]; k < ib[jj+1]; k++){
-	if (mask[jb[k]] != -i - 2){
-	  if ((nz+1) <= nz) {
-#ifdef DEBUG_PRINT
-	    fprintf(stderr,"overflow in SparseMatrix_multiply !!!\n");
-#endif
-	    free(mask);
-	    return NULL;
+      if (p->C){
+	for (l = ib[jj]; l < ib[jj+1]; l++){
+	  ll = jb[l];
+	  for (k = ic[ll]; k < ic[ll+1]; k++){
+	    if (mask[jc[k]] != counted(i)){
+	      nz++;
+	      mask[jc[k]] = counted(i);
+	    }
+	  }
+	}
+      } else {
+	for (k = ib[jj]; k < ib[jj+1]; k++){
+	  if (mask[jb[k]] != counted(i)){
+	    nz++;
+	    mask[jb[k]] = counted(i);
 	  }
-	  nz++;
-	  mask[jb[k]] = -i - 2;
 	}
       }
     }
+    p->counts[i] = nz;
   }
 
-  C = SparseMatrix_new(m, B->n, nz, type, FORMAT_CSR);
-  if (!C) goto RETURN;
-  ic = C->ia;
-  jc = C->ja;
-  
-  nz = 0;
+  free(mask);
+}
 
-  switch (type){
+/// allocate the result of a product from the first pass’ counts, or return
+/// NULL if it has too many nonzeros to index
+static SparseMatrix multiply_alloc(sparse_product_t *p, int n, int type) {
+  const int m = p->A->m;
+  size_t nz = 0;
+  for (int i = 0; i < m; i++) {
+    nz += (size_t)p->counts[i];
+  }
+  if (nz > INT_MAX) {
+#ifdef DEBUG_PRINT
+    fprintf(stderr,"overflow in SparseMatrix_multiply !!!\n");
+#endif
+    return NULL;
+  }
+
+  SparseMatrix D = SparseMatrix_new(m, n, (int)nz, type, FORMAT_CSR);
+  D->ia[0] = 0;
+  for (int i = 0; i < m; i++) {
+    D->ia[i + 1] = D->ia[i] + p->counts[i];
+  }
+  D->nz = (int)nz;
+  return D;
+}
+
+static void multiply_fill_rows(void *arg, size_t chunk) {
+  const sparse_product_t *p = arg;
+  const SparseMatrix A = p->A, B = p->B, C = p->D;
+  const int *ia = A->ia, *ja = A->ja, *ib = B->ia, *jb = B->ja, *ic = C->ia;
+  int *jc = C->ja;
+  const int start = chunk_start(A->m, chunk, p->chunks);
+  const int end = chunk_start(A->m, chunk + 1, p->chunks);
+  int *mask = gv_calloc((size_t)B->n, sizeof(int));
+  int i, j, k, jj, nz;
+
+  for (i = 0; i < B->n; i++) mask[i] = -1;
+
+  // mask entries left by earlier rows of this range point before `ic[i]`
+  switch (A->type){
   case MATRIX_TYPE_REAL:
     {
       double *a = A->a;
       double *b = B->a;
       double *c = C->a;
-      ic[0] = 0;
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
+	nz = ic[i];
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  jj = ja[j];
 	  for (k = ib[jj]; k < ib[jj+1]; k++){
@@ -989,7 +1085,7 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
 	    }
 	  }
 	}
-	ic[i+1] = nz;
+	assert(nz == ic[i+1]);
       }
     }
     break;
@@ -998,8 +1094,8 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
       double *a = A->a;
       double *b = B->a;
       double *c = C->a;
-      ic[0] = 0;
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
+	nz = ic[i];
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  jj = ja[j];
 	  for (k = ib[jj]; k < ib[jj+1]; k++){
@@ -1016,7 +1112,7 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
 	    }
 	  }
 	}
-	ic[i+1] = nz;
+	assert(nz == ic[i+1]);
       }
     }
     break;
@@ -1025,8 +1121,8 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
       int *a = A->a;
       int *b = B->a;
       int *c = C->a;
-      ic[0] = 0;
-      for (i = 0; i < m; i++){
+      for (i = start; i < end; i++){
+	nz = ic[i];
 	for (j = ia[i]; j < ia[i+1]; j++){
 	  jj = ja[j];
 	  for (k = ib[jj]; k < ib[jj+1]; k++){
@@ -1041,13 +1137,13 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
 	    }
 	  }
 	}
-	ic[i+1] = nz;
+	assert(nz == ic[i+1]);
       }
     }
     break;
   case MATRIX_TYPE_PATTERN:
-    ic[0] = 0;
-    for (i = 0; i < m; i++){
+    for (i = start; i < end; i++){
+      nz = ic[i];
       for (j = ia[i]; j < ia[i+1]; j++){
 	jj = ja[j];
 	for (k = ib[jj]; k < ib[jj+1]; k++){
@@ -1060,88 +1156,66 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
 	  }
 	}
       }
-      ic[i+1] = nz;
+      assert(nz == ic[i+1]);
     }
     break;
-  case MATRIX_TYPE_UNKNOWN:
   default:
-    SparseMatrix_delete(C);
-    C = NULL; goto RETURN;
-    break;
+    assert(0);
   }
-  
-  C->nz = nz;
 
- RETURN:
   free(mask);
-  return C;
 }
 
-
-
-SparseMatrix SparseMatrix_multiply3(SparseMatrix A, SparseMatrix B, SparseMatrix C){
-  int m;
-  SparseMatrix D = NULL;
-  int *mask = NULL;
-  int *ia = A->ia, *ja = A->ja, *ib = B->ia, *jb = B->ja, *ic = C->ia, *jc = C->ja, *id, *jd;
-  int i, j, k, l, ll, jj, type, nz;
-
+SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
   assert(A->format == B->format && A->format == FORMAT_CSR);/* other format not yet supported */
 
-  m = A->m;
   if (A->n != B->m) return NULL;
-  if (B->n != C->m) return NULL;
-
-  if (A->type != B->type || B->type != C->type){
+  if (A->type != B->type){
 #ifdef DEBUG
     printf("in SparseMatrix_multiply, the matrix types do not match, right now only multiplication of matrices of the same type is supported\n");
 #endif
     return NULL;
   }
-  type = A->type;
-
-  assert(type == MATRIX_TYPE_REAL);
+  switch (A->type){
+  case MATRIX_TYPE_REAL:
+  case MATRIX_TYPE_COMPLEX:
+  case MATRIX_TYPE_INTEGER:
+  case MATRIX_TYPE_PATTERN:
+    break;
+  default:
+    return NULL;
+  }
 
-  mask = calloc((size_t)C->n, sizeof(int));
-  if (!mask) return NULL;
+  // rows of the result are independent, so each pass is computed in ranges of
+  // rows on multiple threads, with the same result as a single range
+  sparse_product_t p = {.A = A, .B = B, .chunks = row_chunks(A)};
+  p.counts = gv_calloc((size_t)A->m, sizeof(int));
+  gv_parallel_for(p.chunks, multiply_count_rows, &p);
+  p.D = multiply_alloc(&p, B->n, A->type);
+  if (p.D) gv_parallel_for(p.chunks, multiply_fill_rows, &p);
 
-  for (i = 0; i < C->n; i++) mask[i] = -1;
+  free(p.counts);
+  return p.D;
+}
 
-  nz = 0;
-  for (i = 0; i < m; i++){
-    for (j = ia[i]; j < ia[i+1]; j++){
-      jj = ja[j];
-      for (l = ib[jj]; l < ib[jj+1]; l++){
-	ll = jb[l];
-	for (k = ic[ll]; k < ic[ll+1]; k++){
-	  if (mask[jc[k]] != -i - 2){
-	    if ((nz+1) <= nz) {
-#ifdef DEBUG_PRINT
-	      fprintf(stderr,"overflow in SparseMatrix_multiply !!!\n");
-#endif
-	      return NULL;
-	    }
-	    nz++;
-	    mask[jc[k]] = -i - 2;
-	  }
-	}
-      }
-    }
-  }
+static void multiply3_fill_rows(void *arg, size_t chunk) {
+  const sparse_product_t *p = arg;
+  const SparseMatrix A = p->A, B = p->B, C = p->C, D = p->D;
+  const int *ia = A->ia, *ja = A->ja, *ib = B->ia, *jb = B->ja, *ic = C->ia, *jc = C->ja, *id = D->ia;
+  int *jd = D->ja;
+  const int start = chunk_start(A->m, chunk, p->chunks);
+  const int end = chunk_start(A->m, chunk + 1, p->chunks);
+  int *mask = gv_calloc((size_t)C->n, sizeof(int));
+  int i, j, k, l, ll, jj, nz;
 
-  D = SparseMatrix_new(m, C->n, nz, type, FORMAT_CSR);
-  if (!D) goto RETURN;
-  id = D->ia;
-  jd = D->ja;
-  
-  nz = 0;
+  for (i = 0; i < C->n; i++) mask[i] = -1;
 
   double *a = A->a;
   double *b = B->a;
   double *c = C->a;
   double *d = D->a;
-  id[0] = 0;
-  for (i = 0; i < m; i++){
+  for (i = start; i < end; i++){
+    nz = id[i];
     for (j = ia[i]; j < ia[i+1]; j++){
       jj = ja[j];
       for (l = ib[jj]; l < ib[jj+1]; l++){
@@ -1159,14 +1233,35 @@ SparseMatrix SparseMatrix_multiply3(SparseMatrix A, SparseMatrix B, SparseMatrix
         }
       }
     }
-    id[i+1] = nz;
+    assert(nz == id[i+1]);
   }
-  
-  D->nz = nz;
 
- RETURN:
   free(mask);
-  return D;
+}
+
+SparseMatrix SparseMatrix_multiply3(SparseMatrix A, SparseMatrix B, SparseMatrix C){
+  assert(A->format == B->format && A->format == FORMAT_CSR);/* other format not yet supported */
+
+  if (A->n != B->m) return NULL;
+  if (B->n != C->m) return NULL;
+
+  if (A->type != B->type || B->type != C->type){
+#ifdef DEBUG
+    printf("in SparseMatrix_multiply, the matrix types do not match, right now only multiplication of matrices of the same type is supported\n");
+#endif
+    return NULL;
+  }
+
+  assert(A->type == MATRIX_TYPE_REAL);
+
+  sparse_product_t p = {.A = A, .B = B, .C = C, .chunks = row_chunks(A)};
+  p.counts = gv_calloc((size_t)A->m, sizeof(int));
+  gv_parallel_for(p.chunks, multiply_count_rows, &p);
+  p.D = multiply_alloc(&p, C->n, A->type);
+  if (p.D) gv_parallel_for(p.chunks, multiply3_fill_rows, &p);
+
+  free(p.counts);
+  return p.D;
 }
 
 SparseMatrix SparseMatrix_sum_repeat_entries(SparseMatrix A){
@@ -0,0 +1,186 @@
+// basic unit tester for the products in SparseMatrix.c
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// include the implementation directly so this can be compiled standalone
+#include <sparse/SparseMatrix.c>
+#include <sparse/SparseMatrix.h>
+#include <util/gv_parallel.c>
+
+static void set_threads(const char *threads) {
+#ifdef _WIN32
+  _putenv_s("GV_THREADS", threads);
+#else
+  setenv("GV_THREADS", threads, 1);
+#endif
+}
+
+// a pseudo random m × n matrix with about `per_row` entries per row
+static SparseMatrix random_matrix(int m, int n, int per_row, int type) {
+  unsigned state = 42;
+  SparseMatrix A = SparseMatrix_new(m, n, 1, type, FORMAT_COORD);
+  for (int i = 0; i < m; ++i) {
+    for (int k = 0; k < per_row; ++k) {
+      state = state * 1103515245 + 12345;
+      const int j = (int)((state >> 8) % (unsigned)n);
+      const double d = (double)(state >> 16 & 0xff) / 16 - 8;
+      const int v = (int)(state >> 16 & 0xff) - 128;
+      A = SparseMatrix_coordinate_form_add_entry(
+          A, i, j, type == MATRIX_TYPE_INTEGER ? (const void *)&v : &d);
+    }
+  }
+  SparseMatrix B = SparseMatrix_from_coordinate_format(A);
+  SparseMatrix_delete(A);
+  return B;
+}
+
+static bool same(SparseMatrix A, SparseMatrix B) {
+  if (A->m != B->m || A->n != B->n || A->nz != B->nz || A->type != B->type)
+    return false;
+  if (memcmp(A->ia, B->ia, sizeof(int) * (size_t)(A->m + 1)) != 0)
+    return false;
+  if (memcmp(A->ja, B->ja, sizeof(int) * (size_t)A->nz) != 0)
+    return false;
+  return A->a == NULL || memcmp(A->a, B->a, A->size * (size_t)A->nz) == 0;
+}
+
+// a product small enough to check by hand
+static void test_small(void) {
+  // [1 2]   [0 1]   [2 1]
+  // [0 3] × [1 0] = [3 0]
+  int ia[] = {0, 0, 1};
+  int ja[] = {0, 1, 1};
+  double a[] = {1, 2, 3};
+  SparseMatrix A = SparseMatrix_from_coordinate_arrays(
+      3, 2, 2, ia, ja, a, MATRIX_TYPE_REAL, sizeof(double));
+  int ib[] = {0, 1};
+  int jb[] = {1, 0};
+  double b[] = {1, 1};
+  SparseMatrix B = SparseMatrix_from_coordinate_arrays(
+      2, 2, 2, ib, jb, b, MATRIX_TYPE_REAL, sizeof(double));
+
+  SparseMatrix C = SparseMatrix_multiply(A, B);
+  assert(C != NULL);
+  assert(C->nz == 3);
+  double dense[4] = {0};
+  for (int i = 0; i < C->m; ++i) {
+    for (int j = C->ia[i]; j < C->ia[i + 1]; ++j) {
+      dense[i * 2 + C->ja[j]] = ((double *)C->a)[j];
+    }
+  }
+  assert(dense[0] == 2 && dense[1] == 1 && dense[2] == 3 && dense[3] == 0);
+
+  double v[] = {1, 1};
+  double *u = NULL;
+  SparseMatrix_multiply_vector(A, v, &u);
+  assert(u[0] == 3 && u[1] == 3);
+
+  free(u);
+  SparseMatrix_delete(C);
+  SparseMatrix_delete(B);
+  SparseMatrix_delete(A);
+}
+
+// products of matrices large enough to be computed on multiple threads do not
+// depend on the number of threads
+static void test_thread_counts(void) {
+  static const char *const threads[] = {"1", "2", "3", "8"};
+  enum { N = 3000, PER_ROW = 30, DIM = 2 };
+
+  SparseMatrix A = random_matrix(N, N, PER_ROW, MATRIX_TYPE_REAL);
+  SparseMatrix P = random_matrix(N, N / 4, 1, MATRIX_TYPE_REAL);
+  SparseMatrix R = SparseMatrix_transpose(P);
+  SparseMatrix I = random_matrix(N, N, PER_ROW, MATRIX_TYPE_INTEGER);
+  assert(A->nz >= PARALLEL_MIN_NZ);
+
+  double *v = gv_calloc(N * DIM, sizeof(double));
+  for (int i = 0; i < N * DIM; ++i) {
+    v[i] = i % 17 - 8.5;
+  }
+
+  SparseMatrix AA = NULL, RAP = NULL, II = NULL;
+  double *Av = NULL, *AV = NULL, *Iv = NULL;
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+    set_threads(threads[t]);
+
+    SparseMatrix AA_t = SparseMatrix_multiply(A, A);
+    SparseMatrix RAP_t = SparseMatrix_multiply3(R, A, P);
+    SparseMatrix II_t = SparseMatrix_multiply(I, I);
+    double *Av_t = NULL, *Iv_t = NULL;
+    SparseMatrix_multiply_vector(A, v, &Av_t);
+    SparseMatrix_multiply_vector(I, NULL, &Iv_t);
+    double *AV_t = gv_calloc(N * DIM, sizeof(double));
+    SparseMatrix_multiply_dense(A, v, AV_t, DIM);
+
+    if (t == 0) {
+      AA = AA_t;
+      RAP = RAP_t;
+      II = II_t;
+      Av = Av_t;
+      AV = AV_t;
+      Iv = Iv_t;
+      continue;
+    }
+
+    assert(same(AA, AA_t));
+    assert(same(RAP, RAP_t));
+    assert(same(II, II_t));
+    assert(memcmp(Av, Av_t, sizeof(double) * N) == 0);
+    assert(memcmp(AV, AV_t, sizeof(double) * N * DIM) == 0);
+    assert(memcmp(Iv, Iv_t, sizeof(double) * N) == 0);
+
+    SparseMatrix_delete(AA_t);
+    SparseMatrix_delete(RAP_t);
+    SparseMatrix_delete(II_t);
+    free(Av_t);
+    free(AV_t);
+    free(Iv_t);
+  }
+
+  // the Galerkin product agrees with multiplying twice
+  SparseMatrix RA = SparseMatrix_multiply(R, A);
+  SparseMatrix RAP2 = SparseMatrix_multiply(RA, P);
+  assert(RAP2->nz == RAP->nz);
+  assert(memcmp(RAP2->ia, RAP->ia, sizeof(int) * (size_t)(RAP->m + 1)) == 0);
+
+  SparseMatrix_delete(RAP2);
+  SparseMatrix_delete(RA);
+  SparseMatrix_delete(AA);
+  SparseMatrix_delete(RAP);
+  SparseMatrix_delete(II);
+  free(Av);
+  free(AV);
+  free(Iv);
+  free(v);
+  SparseMatrix_delete(I);
+  SparseMatrix_delete(R);
+  SparseMatrix_delete(P);
+  SparseMatrix_delete(A);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(small);
+  RUN(thread_counts);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
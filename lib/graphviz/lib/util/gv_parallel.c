@@ -0,0 +1,263 @@
+/// @file
+/// @brief C implementation of `gv_parallel_for`
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <util/gv_parallel.h>
+
+#ifdef GV_NO_THREADS
+// built without a thread library, so every loop runs on the calling thread
+
+size_t gv_nthreads(void) { return 1; }
+
+void gv_parallel_for(size_t n, void (*fn)(void *arg, size_t i), void *arg) {
+  gv_parallel_for_n(1, n, fn, arg);
+}
+
+void gv_parallel_for_n(size_t nthreads, size_t n,
+                       void (*fn)(void *arg, size_t i), void *arg) {
+  assert(fn != NULL);
+  (void)nthreads;
+  for (size_t i = 0; i < n; ++i) {
+    fn(arg, i);
+  }
+}
+
+#else
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+typedef SRWLOCK lock_t;
+typedef CONDITION_VARIABLE cond_t;
+#define LOCK_INIT SRWLOCK_INIT
+#define COND_INIT CONDITION_VARIABLE_INIT
+static void acquire(lock_t *l) { AcquireSRWLockExclusive(l); }
+static void release(lock_t *l) { ReleaseSRWLockExclusive(l); }
+static void await(cond_t *c, lock_t *l) {
+  SleepConditionVariableSRW(c, l, INFINITE, 0);
+}
+static void wake_all(cond_t *c) { WakeAllConditionVariable(c); }
+#else
+typedef pthread_mutex_t lock_t;
+typedef pthread_cond_t cond_t;
+#define LOCK_INIT PTHREAD_MUTEX_INITIALIZER
+#define COND_INIT PTHREAD_COND_INITIALIZER
+static void acquire(lock_t *l) { pthread_mutex_lock(l); }
+static void release(lock_t *l) { pthread_mutex_unlock(l); }
+static void await(cond_t *c, lock_t *l) { pthread_cond_wait(c, l); }
+static void wake_all(cond_t *c) { pthread_cond_broadcast(c); }
+#endif
+
+/// state of one `gv_parallel_for_n` call
+typedef struct {
+  size_t n;      ///< number of work items
+  size_t next;   ///< next work item to hand out
+  size_t limit;  ///< how many workers may join in
+  size_t joined; ///< how many workers have joined in
+  void (*fn)(void *arg, size_t i);
+  void *arg;
+} job_t;
+
+/// worker threads, started on first use and kept for the life of the process
+///
+/// Starting and joining threads for every loop costs tens of microseconds per
+/// thread, which is more than many of the loops take. Instead, workers wait
+/// for the next job once they are done with one. There is one job at a time.
+/// A loop that finds the pool in use, such as one nested in another loop's
+/// work item, runs on its calling thread.
+static struct {
+  lock_t lock;
+  cond_t wake;      ///< signaled when a job is posted
+  cond_t done;      ///< signaled when a worker leaves a job
+  size_t size;      ///< number of workers started
+  size_t cpus;      ///< number of online processors, once known
+  bool busy;        ///< is a loop using the pool?
+  job_t *job;       ///< job workers may join, or NULL
+  size_t posted;    ///< number of jobs posted so far
+  size_t active;    ///< workers in the current job
+#ifndef _WIN32
+  pid_t pid;        ///< process that started the workers
+#endif
+} pool = {.lock = LOCK_INIT, .wake = COND_INIT, .done = COND_INIT};
+
+/// number of online processors
+static size_t cpus(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  if (info.dwNumberOfProcessors > 0) {
+    return (size_t)info.dwNumberOfProcessors;
+  }
+#elif defined(_SC_NPROCESSORS_ONLN)
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0) {
+    return (size_t)n;
+  }
+#endif
+  return 1;
+}
+
+size_t gv_nthreads(void) {
+  const char *env = getenv("GV_THREADS");
+  if (env != NULL) {
+    char *end;
+    const long n = strtol(env, &end, 10);
+    if (end != env && *end == '\0' && n > 0) {
+      return (size_t)n;
+    }
+  }
+
+  // glibc reads the processor count from /sys on every query, so ask once
+  acquire(&pool.lock);
+  if (pool.cpus == 0) {
+    pool.cpus = cpus();
+  }
+  const size_t n = pool.cpus;
+  release(&pool.lock);
+  return n;
+}
+
+/// claim the next work item, returning false when there are none left
+static bool take(job_t *job, size_t *i) {
+  acquire(&pool.lock);
+  const bool found = job->next < job->n;
+  if (found) {
+    *i = job->next++;
+  }
+  release(&pool.lock);
+  return found;
+}
+
+/// process work items until there are none left
+static void work(job_t *job) {
+  size_t i;
+  while (take(job, &i)) {
+    job->fn(job->arg, i);
+  }
+}
+
+/// join in each job posted, for as long as the process lives
+static void serve(void) {
+  acquire(&pool.lock);
+  size_t seen = pool.posted;
+  for (;;) {
+    while (pool.posted == seen) {
+      await(&pool.wake, &pool.lock);
+    }
+    seen = pool.posted;
+    job_t *const job = pool.job;
+    if (job == NULL || job->joined == job->limit) {
+      continue;
+    }
+    ++job->joined;
+    ++pool.active;
+    release(&pool.lock);
+    work(job);
+    acquire(&pool.lock);
+    if (--pool.active == 0) {
+      wake_all(&pool.done);
+    }
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker(LPVOID ignored) {
+  (void)ignored;
+  serve();
+  return 0;
+}
+#else
+static void *worker(void *ignored) {
+  (void)ignored;
+  serve();
+  return NULL;
+}
+#endif
+
+/// start workers until there are `want`, returning how many there are
+///
+/// The caller must hold the pool lock.
+static size_t grow(size_t want) {
+#ifndef _WIN32
+  // workers are not inherited by a forked child
+  if (pool.size > 0 && pool.pid != getpid()) {
+    pool.size = 0;
+  }
+  pool.pid = getpid();
+#endif
+  for (; pool.size < want; ++pool.size) {
+#ifdef _WIN32
+    HANDLE t = CreateThread(NULL, 0, worker, NULL, 0, NULL);
+    if (t == NULL) {
+      break;
+    }
+    CloseHandle(t);
+#else
+    pthread_t t;
+    if (pthread_create(&t, NULL, worker, NULL) != 0) {
+      break;
+    }
+    pthread_detach(t);
+#endif
+  }
+  return pool.size < want ? pool.size : want;
+}
+
+void gv_parallel_for(size_t n, void (*fn)(void *arg, size_t i), void *arg) {
+  gv_parallel_for_n(gv_nthreads(), n, fn, arg);
+}
+
+void gv_parallel_for_n(size_t nthreads, size_t n,
+                       void (*fn)(void *arg, size_t i), void *arg) {
+  assert(fn != NULL);
+
+  if (nthreads > n) {
+    nthreads = n;
+  }
+
+  job_t job = {.n = n, .fn = fn, .arg = arg};
+  if (nthreads > 1) {
+    acquire(&pool.lock);
+    if (pool.busy) {
+      nthreads = 1;
+    } else {
+      pool.busy = true;
+      job.limit = grow(nthreads - 1);
+      pool.job = &job;
+      ++pool.posted;
+      wake_all(&pool.wake);
+    }
+    release(&pool.lock);
+  }
+
+  // with nothing to share, skip the pool entirely
+  if (nthreads <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      fn(arg, i);
+    }
+    return;
+  }
+
+  // the calling thread takes part, and picks up the slack if fewer workers
+  // could be started or woken than requested
+  work(&job);
+
+  // once every item is handed out, wait for workers still on one
+  acquire(&pool.lock);
+  pool.job = NULL;
+  while (pool.active > 0) {
+    await(&pool.done, &pool.lock);
+  }
+  pool.busy = false;
+  release(&pool.lock);
+}
+
+#endif
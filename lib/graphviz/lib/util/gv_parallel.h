@@ -0,0 +1,69 @@
+/// @file
+/// @brief running independent pieces of work on multiple threads
+
+#pragma once
+
+/// hide the symbols this header declares by default
+///
+/// See gv_fopen.h for the rationale.
+#ifndef UTIL_API
+#if !defined(__CYGWIN__) && defined(__GNUC__) && !defined(__MINGW32__)
+#define UTIL_API __attribute__((visibility("hidden")))
+#else
+#define UTIL_API /* nothing */
+#endif
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// number of threads to use for parallel work
+///
+/// This is the number of online processors, unless overridden by a positive
+/// integer in the environment variable `GV_THREADS`. It is always 1 when
+/// Graphviz was built without a thread library.
+///
+/// @return A thread count ≥ 1
+UTIL_API size_t gv_nthreads(void);
+
+/// call `fn(arg, i)` for each `i` in `[0, n)`, using up to `gv_nthreads()`
+/// threads
+///
+/// Indices are handed out one at a time to whichever thread is free, so work
+/// items of uneven size are balanced across threads. The calling thread takes
+/// part, and all calls have returned by the time this function does. If
+/// threads cannot be created, the remaining work is done by the caller.
+///
+/// The other threads are started on first use and then wait for the next
+/// loop, so a loop costs a few microseconds more than running it inline. Only
+/// one loop at a time uses them. A loop started while another is running,
+/// including from within one of its work items, runs on its calling thread.
+///
+/// The calls may run concurrently and in any order, so `fn` must only touch
+/// data that is private to index `i` or that no call modifies.
+///
+/// @param n Number of work items
+/// @param fn Function to process one work item
+/// @param arg Opaque argument passed through to `fn`
+UTIL_API void gv_parallel_for(size_t n, void (*fn)(void *arg, size_t i),
+                              void *arg);
+
+/// `gv_parallel_for`, using up to `nthreads` threads instead of
+/// `gv_nthreads()`
+///
+/// This is for callers that take a thread count from their own options.
+///
+/// @param nthreads Maximum number of threads, including the caller; 0 or 1
+///   does all the work on the calling thread
+/// @param n Number of work items
+/// @param fn Function to process one work item
+/// @param arg Opaque argument passed through to `fn`
+UTIL_API void gv_parallel_for_n(size_t nthreads, size_t n,
+                                void (*fn)(void *arg, size_t i), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,272 @@
+/// @file
+/// @brief C implementation of single-source shortest paths
+
+#include <assert.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+#include <util/gv_sssp.h>
+
+/// an entry in the 4-ary heap
+typedef struct {
+  double key;
+  size_t v;
+} entry_t;
+
+/// an entry in a radix heap bucket
+typedef struct {
+  unsigned key;
+  size_t v;
+} item_t;
+
+/// a radix heap bucket
+typedef struct {
+  item_t *items;
+  size_t size;
+  size_t capacity;
+} bucket_t;
+
+/// number of radix heap buckets: one per bit of the key, plus one for keys
+/// equal to the last removed
+enum { BUCKETS = sizeof(unsigned) * CHAR_BIT + 1 };
+
+struct gv_sssp_s {
+  size_t n;        ///< capacity in vertices
+  double *dist;    ///< working distances for the 4-ary heap searches
+  size_t *pos;     ///< index in `heap` of each queued vertex
+  entry_t *heap;   ///< 4-ary heap of queued vertices
+  size_t size;     ///< number of entries in `heap`
+  unsigned last;   ///< last key removed from the radix heap
+  bucket_t bucket[BUCKETS];
+};
+
+gv_sssp_t *gv_sssp_new(size_t n) {
+  gv_sssp_t *s = gv_alloc(sizeof(gv_sssp_t));
+  s->n = n;
+  s->dist = gv_calloc(n, sizeof(double));
+  s->pos = gv_calloc(n, sizeof(size_t));
+  s->heap = gv_calloc(n, sizeof(entry_t));
+  return s;
+}
+
+void gv_sssp_free(gv_sssp_t *s) {
+  if (s == NULL)
+    return;
+  for (size_t i = 0; i < BUCKETS; ++i)
+    free(s->bucket[i].items);
+  free(s->heap);
+  free(s->pos);
+  free(s->dist);
+  free(s);
+}
+
+/// does heap entry `a` come before `b`?
+static bool before(entry_t a, entry_t b) {
+  return a.key < b.key || (a.key == b.key && a.v < b.v);
+}
+
+/// move the entry at index `i` towards the root until the heap is ordered
+static void sift_up(gv_sssp_t *s, size_t i) {
+  const entry_t e = s->heap[i];
+  while (i > 0) {
+    const size_t parent = (i - 1) / 4;
+    if (!before(e, s->heap[parent]))
+      break;
+    s->heap[i] = s->heap[parent];
+    s->pos[s->heap[i].v] = i;
+    i = parent;
+  }
+  s->heap[i] = e;
+  s->pos[e.v] = i;
+}
+
+/// move the entry at index `i` towards the leaves until the heap is ordered
+static void sift_down(gv_sssp_t *s, size_t i) {
+  const entry_t e = s->heap[i];
+  for (;;) {
+    const size_t first = 4 * i + 1;
+    if (first >= s->size)
+      break;
+    size_t best = first;
+    const size_t end = first + 4 < s->size ? first + 4 : s->size;
+    for (size_t c = first + 1; c < end; ++c) {
+      if (before(s->heap[c], s->heap[best]))
+        best = c;
+    }
+    if (!before(s->heap[best], e))
+      break;
+    s->heap[i] = s->heap[best];
+    s->pos[s->heap[i].v] = i;
+    i = best;
+  }
+  s->heap[i] = e;
+  s->pos[e.v] = i;
+}
+
+/// Dijkstra’s algorithm with a 4-ary heap
+///
+/// Exactly one of `wf` and `wd` is non-null. With `wf`, sums are rounded to
+/// `float` after each addition. As a `double` holds more than twice the bits of
+/// a `float`, this gives the same result as adding in `float`.
+static size_t search_real(gv_sssp_t *s, const gv_csr_t *g, const float *wf,
+                          const double *wd, size_t source, size_t *pred,
+                          size_t *order) {
+  assert(g->n <= s->n);
+  assert(source < g->n);
+  assert((wf == NULL) != (wd == NULL));
+
+  double *dist = s->dist;
+  for (size_t v = 0; v < g->n; ++v)
+    dist[v] = HUGE_VAL;
+
+  size_t reached = 0;
+  dist[source] = 0;
+  s->heap[0] = (entry_t){.key = 0, .v = source};
+  s->pos[source] = 0;
+  s->size = 1;
+
+  while (s->size > 0) {
+    const entry_t top = s->heap[0];
+    --s->size;
+    if (s->size > 0) {
+      s->heap[0] = s->heap[s->size];
+      sift_down(s, 0);
+    }
+    const size_t u = top.v;
+    const double du = top.key;
+    if (order != NULL)
+      order[reached] = u;
+    ++reached;
+
+    for (size_t i = g->off[u]; i < g->off[u + 1]; ++i) {
+      const size_t v = g->adj[i];
+      double dv = du + (wf != NULL ? (double)wf[i] : wd[i]);
+      if (wf != NULL)
+        dv = (double)(float)dv;
+      if (!(dv < dist[v]))
+        continue;
+      if (pred != NULL)
+        pred[v] = u;
+      if (dist[v] == HUGE_VAL) {
+        dist[v] = dv;
+        s->heap[s->size] = (entry_t){.key = dv, .v = v};
+        sift_up(s, s->size++);
+      } else {
+        // v cannot have been settled, as weights are not negative
+        dist[v] = dv;
+        s->heap[s->pos[v]].key = dv;
+        sift_up(s, s->pos[v]);
+      }
+    }
+  }
+  return reached;
+}
+
+size_t gv_sssp_f(gv_sssp_t *s, const gv_csr_t *g, const float *w,
+                 size_t source, float *dist, size_t *pred, size_t *order) {
+  const size_t reached = search_real(s, g, w, NULL, source, pred, order);
+  for (size_t v = 0; v < g->n; ++v)
+    dist[v] = s->dist[v] == HUGE_VAL ? FLT_MAX : (float)s->dist[v];
+  return reached;
+}
+
+size_t gv_sssp_d(gv_sssp_t *s, const gv_csr_t *g, const double *w,
+                 size_t source, double *dist, size_t *pred, size_t *order) {
+  const size_t reached = search_real(s, g, NULL, w, source, pred, order);
+  for (size_t v = 0; v < g->n; ++v)
+    dist[v] = s->dist[v];
+  return reached;
+}
+
+/// the radix heap bucket for a key
+static size_t bucket_of(const gv_sssp_t *s, unsigned key) {
+  unsigned diff = key ^ s->last;
+  if (diff == 0)
+    return 0;
+#if defined(__GNUC__)
+  return (size_t)(sizeof(unsigned) * CHAR_BIT) - (size_t)__builtin_clz(diff);
+#else
+  size_t width = 0;
+  for (; diff != 0; diff >>= 1)
+    ++width;
+  return width;
+#endif
+}
+
+static void bucket_push(bucket_t *b, item_t item) {
+  if (b->size == b->capacity) {
+    const size_t c = b->capacity == 0 ? 16 : 2 * b->capacity;
+    b->items = gv_recalloc(b->items, b->capacity, c, sizeof(item_t));
+    b->capacity = c;
+  }
+  b->items[b->size++] = item;
+}
+
+/// remove an item with the least key from a non-empty radix heap
+static item_t radix_pop(gv_sssp_t *s) {
+  if (s->bucket[0].size == 0) {
+    // redistribute the first non-empty bucket around its least key, which
+    // sends every item to a lower bucket
+    size_t i = 1;
+    while (s->bucket[i].size == 0)
+      ++i;
+    bucket_t *b = &s->bucket[i];
+    unsigned least = b->items[0].key;
+    for (size_t j = 1; j < b->size; ++j)
+      least = b->items[j].key < least ? b->items[j].key : least;
+    s->last = least;
+    const size_t size = b->size;
+    b->size = 0;
+    for (size_t j = 0; j < size; ++j)
+      bucket_push(&s->bucket[bucket_of(s, b->items[j].key)], b->items[j]);
+  }
+  return s->bucket[0].items[--s->bucket[0].size];
+}
+
+size_t gv_sssp_u(gv_sssp_t *s, const gv_csr_t *g, const unsigned *w,
+                 size_t source, unsigned *dist, size_t *pred, size_t *order) {
+  assert(g->n <= s->n);
+  assert(source < g->n);
+
+  for (size_t v = 0; v < g->n; ++v)
+    dist[v] = UINT_MAX;
+
+  size_t reached = 0;
+  size_t queued = 1;
+  dist[source] = 0;
+  s->last = 0;
+  bucket_push(&s->bucket[0], (item_t){.key = 0, .v = source});
+
+  // vertices are queued again each time their distance improves, and entries
+  // made stale by a later improvement are skipped when they come out
+  while (queued > 0) {
+    const item_t top = radix_pop(s);
+    --queued;
+    const size_t u = top.v;
+    if (top.key != dist[u])
+      continue;
+    if (order != NULL)
+      order[reached] = u;
+    ++reached;
+
+    for (size_t i = g->off[u]; i < g->off[u + 1]; ++i) {
+      const size_t v = g->adj[i];
+      if (w[i] >= UINT_MAX - top.key)
+        continue;
+      const unsigned dv = top.key + w[i];
+      if (dv >= dist[v])
+        continue;
+      dist[v] = dv;
+      if (pred != NULL)
+        pred[v] = u;
+      bucket_push(&s->bucket[bucket_of(s, dv)], (item_t){.key = dv, .v = v});
+      ++queued;
+    }
+  }
+  return reached;
+}
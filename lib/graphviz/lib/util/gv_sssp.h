@@ -0,0 +1,93 @@
+/// @file
+/// @brief single-source shortest paths over a compressed sparse row graph
+///
+/// Searches share a `gv_sssp_t`, which holds the priority queues and index
+/// arrays between calls, so running from many sources in turn only allocates
+/// once. Edge weights must not be negative.
+
+#pragma once
+
+/// hide the symbols this header declares by default
+///
+/// See gv_fopen.h for the rationale.
+#ifndef UTIL_API
+#if !defined(__CYGWIN__) && defined(__GNUC__) && !defined(__MINGW32__)
+#define UTIL_API __attribute__((visibility("hidden")))
+#else
+#define UTIL_API /* nothing */
+#endif
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// a directed graph in compressed sparse row form
+///
+/// The edges leaving vertex `v` are `off[v]` to `off[v + 1] - 1`, and the head
+/// of edge `i` is `adj[i]`. Edge weights are kept in a separate array indexed
+/// the same way as `adj`.
+typedef struct {
+  size_t n;          ///< number of vertices
+  const size_t *off; ///< first edge of each vertex, `n + 1` entries
+  const size_t *adj; ///< head of each edge, `off[n]` entries
+} gv_csr_t;
+
+/// reusable state for shortest path searches
+typedef struct gv_sssp_s gv_sssp_t;
+
+/// create state for searching graphs of up to `n` vertices
+///
+/// @param n Maximum number of vertices of a searched graph
+/// @return State to pass to the search functions and later to `gv_sssp_free`
+UTIL_API gv_sssp_t *gv_sssp_new(size_t n);
+
+/// release state created by `gv_sssp_new`
+///
+/// @param s State to free, or `NULL`
+UTIL_API void gv_sssp_free(gv_sssp_t *s);
+
+/// shortest paths with `float` weights, using a 4-ary heap
+///
+/// Distances are summed in `float`. Vertices that cannot be reached get the
+/// distance `FLT_MAX`. Vertices at equal distance are settled in index order.
+///
+/// @param s Search state
+/// @param g Graph to search
+/// @param w Weight of each edge of `g`
+/// @param source Vertex to measure from
+/// @param dist [out] Distance of each vertex from `source`
+/// @param pred [out] Optional predecessor of each reached vertex other than
+///   `source` on a shortest path. Entries of other vertices are left untouched.
+/// @param order [out] Optional reached vertices, in the order they were settled
+/// @return Number of vertices reached, including `source`
+UTIL_API size_t gv_sssp_f(gv_sssp_t *s, const gv_csr_t *g, const float *w,
+                          size_t source, float *dist, size_t *pred,
+                          size_t *order);
+
+/// shortest paths with `double` weights, using a 4-ary heap
+///
+/// As for `gv_sssp_f`, with unreached vertices at distance `HUGE_VAL`.
+UTIL_API size_t gv_sssp_d(gv_sssp_t *s, const gv_csr_t *g, const double *w,
+                          size_t source, double *dist, size_t *pred,
+                          size_t *order);
+
+/// shortest paths with integer weights, using a radix heap
+///
+/// A radix heap buckets pending vertices by the highest bit in which their
+/// distance differs from the last settled one, giving constant time inserts
+/// and amortized logarithmic time removal in the size of the distances rather
+/// than of the queue. Unreached vertices are at distance `UINT_MAX`, and paths
+/// at least that long are ignored. Vertices at equal distance are settled in no
+/// particular order.
+///
+/// Otherwise as for `gv_sssp_f`.
+UTIL_API size_t gv_sssp_u(gv_sssp_t *s, const gv_csr_t *g, const unsigned *w,
+                          size_t source, unsigned *dist, size_t *pred,
+                          size_t *order);
+
+#ifdef __cplusplus
+}
+#endif
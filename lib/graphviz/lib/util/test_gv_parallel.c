@@ -0,0 +1,131 @@
+// basic unit tester for gv_parallel.h
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// include the implementation directly so this can be compiled standalone
+#include <util/alloc.h>
+#include <util/gv_parallel.c>
+#include <util/gv_parallel.h>
+
+// record each call in a per-index counter
+static void count(void *arg, size_t i) {
+  unsigned *counts = arg;
+  ++counts[i];
+}
+
+// every index is visited exactly once
+static void each_once(size_t n) {
+  unsigned *counts = gv_calloc(n, sizeof(unsigned));
+  gv_parallel_for(n, count, counts);
+  for (size_t i = 0; i < n; ++i)
+    assert(counts[i] == 1);
+  free(counts);
+}
+
+static void test_empty(void) { each_once(0); }
+static void test_single(void) { each_once(1); }
+static void test_small(void) { each_once(10); }
+static void test_large(void) { each_once(10000); }
+
+// results do not depend on the thread count
+static void test_thread_counts(void) {
+  static const char *const threads[] = {"1", "2", "3", "8", "64"};
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+#ifdef _WIN32
+    _putenv_s("GV_THREADS", threads[t]);
+#else
+    setenv("GV_THREADS", threads[t], 1);
+#endif
+    assert(gv_nthreads() == (size_t)atoi(threads[t]));
+    each_once(100);
+  }
+}
+
+// an explicit thread count is honored whatever the environment says
+static void test_explicit_count(void) {
+  static const size_t threads[] = {0, 1, 2, 5};
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+    unsigned *counts = gv_calloc(100, sizeof(unsigned));
+    gv_parallel_for_n(threads[t], 100, count, counts);
+    for (size_t i = 0; i < 100; ++i)
+      assert(counts[i] == 1);
+    free(counts);
+  }
+}
+
+// a loop inside a work item runs to completion rather than waiting for the
+// workers busy with the outer loop
+static void nested(void *arg, size_t i) {
+  unsigned *counts = arg;
+  gv_parallel_for(10, count, &counts[i * 10]);
+}
+
+static void test_nested(void) {
+#ifdef _WIN32
+  _putenv_s("GV_THREADS", "4");
+#else
+  setenv("GV_THREADS", "4", 1);
+#endif
+  unsigned *counts = gv_calloc(100 * 10, sizeof(unsigned));
+  gv_parallel_for(100, nested, counts);
+  for (size_t i = 0; i < 100 * 10; ++i)
+    assert(counts[i] == 1);
+  free(counts);
+}
+
+// the workers kept between loops pick up each new loop
+static void test_repeated(void) {
+#ifdef _WIN32
+  _putenv_s("GV_THREADS", "4");
+#else
+  setenv("GV_THREADS", "4", 1);
+#endif
+  for (size_t t = 0; t < 1000; ++t)
+    each_once(t % 17);
+}
+
+// nonsense overrides are ignored
+static void test_bad_override(void) {
+  static const char *const bad[] = {"", "0", "-2", "4x", "x"};
+  for (size_t t = 0; t < sizeof(bad) / sizeof(bad[0]); ++t) {
+#ifdef _WIN32
+    _putenv_s("GV_THREADS", bad[t]);
+#else
+    setenv("GV_THREADS", bad[t], 1);
+#endif
+    assert(gv_nthreads() >= 1);
+    each_once(100);
+  }
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(empty);
+  RUN(single);
+  RUN(small);
+  RUN(large);
+  RUN(thread_counts);
+  RUN(explicit_count);
+  RUN(nested);
+  RUN(repeated);
+  RUN(bad_override);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+// basic unit tester for gv_sssp.h
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// include the implementation directly so this can be compiled standalone
+#include <util/gv_sssp.c>
+#include <util/gv_sssp.h>
+
+/// a random graph with weights of each type
+typedef struct {
+  size_t n;
+  size_t *off;
+  size_t *adj;
+  unsigned *wu;
+  float *wf;
+  double *wd;
+  gv_csr_t csr;
+} graph_t;
+
+/// a small deterministic generator, so failures can be reproduced
+static unsigned long next(unsigned long *state) {
+  *state = *state * 6364136223846793005ul + 1442695040888963407ul;
+  return (*state >> 33) & 0x7fffffff;
+}
+
+/// create a graph of `n` vertices with about `degree` out-edges each, weighing
+/// from 1 to `max_weight` quarters, or all weighing 0 if `max_weight` is 0
+static graph_t make_graph(size_t n, size_t degree, unsigned max_weight,
+                          unsigned long seed) {
+  graph_t g = {.n = n};
+  g.off = gv_calloc(n + 1, sizeof(size_t));
+  for (size_t v = 0; v < n; ++v)
+    g.off[v + 1] = g.off[v] + next(&seed) % (2 * degree + 1);
+  const size_t m = g.off[n];
+  g.adj = gv_calloc(m, sizeof(size_t));
+  g.wu = gv_calloc(m, sizeof(unsigned));
+  g.wf = gv_calloc(m, sizeof(float));
+  g.wd = gv_calloc(m, sizeof(double));
+  for (size_t i = 0; i < m; ++i) {
+    g.adj[i] = next(&seed) % n;
+    g.wu[i] = max_weight == 0 ? 0 : 1 + (unsigned)(next(&seed) % max_weight);
+    g.wf[i] = (float)g.wu[i] / 4;
+    g.wd[i] = g.wu[i] / 4.0;
+  }
+  g.csr = (gv_csr_t){.n = n, .off = g.off, .adj = g.adj};
+  return g;
+}
+
+static void free_graph(graph_t *g) {
+  free(g->wd);
+  free(g->wf);
+  free(g->wu);
+  free(g->adj);
+  free(g->off);
+}
+
+/// quadratic Dijkstra’s algorithm to check against
+static void reference(const graph_t *g, size_t source, double *dist) {
+  bool *done = gv_calloc(g->n, sizeof(bool));
+  for (size_t v = 0; v < g->n; ++v)
+    dist[v] = HUGE_VAL;
+  dist[source] = 0;
+  for (;;) {
+    size_t u = SIZE_MAX;
+    for (size_t v = 0; v < g->n; ++v) {
+      if (done[v] || dist[v] == HUGE_VAL)
+        continue;
+      if (u == SIZE_MAX || dist[v] < dist[u])
+        u = v;
+    }
+    if (u == SIZE_MAX)
+      break;
+    done[u] = true;
+    for (size_t i = g->off[u]; i < g->off[u + 1]; ++i) {
+      if (dist[u] + g->wd[i] < dist[g->adj[i]])
+        dist[g->adj[i]] = dist[u] + g->wd[i];
+    }
+  }
+  free(done);
+}
+
+/// is there an edge from `u` to `v` of length `len`?
+static bool has_edge(const graph_t *g, size_t u, size_t v, double len) {
+  for (size_t i = g->off[u]; i < g->off[u + 1]; ++i) {
+    if (g->adj[i] == v && g->wd[i] == len)
+      return true;
+  }
+  return false;
+}
+
+/// check a search’s outputs against the reference distances
+///
+/// With positive weights, every vertex at a given distance is queued before the
+/// first of them is settled, so `index_ties` asks for them to come in order.
+static void check(const graph_t *g, size_t source, const double *expected,
+                  const double *dist, const size_t *pred, const size_t *order,
+                  size_t reached, bool index_ties) {
+  size_t n_reached = 0;
+  for (size_t v = 0; v < g->n; ++v) {
+    assert(dist[v] == expected[v]);
+    if (expected[v] == HUGE_VAL)
+      continue;
+    ++n_reached;
+    if (v != source) {
+      assert(pred[v] < g->n);
+      assert(has_edge(g, pred[v], v, dist[v] - dist[pred[v]]));
+    }
+  }
+  assert(reached == n_reached);
+  assert(order[0] == source);
+  for (size_t k = 1; k < reached; ++k) {
+    assert(dist[order[k - 1]] <= dist[order[k]]);
+    if (index_ties && dist[order[k - 1]] == dist[order[k]] && k > 1)
+      assert(order[k - 1] < order[k]);
+  }
+}
+
+/// search random graphs from many sources with each variant
+static void random_graphs(size_t n, size_t degree, unsigned max_weight) {
+  gv_sssp_t *s = gv_sssp_new(n);
+  double *expected = gv_calloc(n, sizeof(double));
+  double *dist = gv_calloc(n, sizeof(double));
+  double *dd = gv_calloc(n, sizeof(double));
+  float *df = gv_calloc(n, sizeof(float));
+  unsigned *du = gv_calloc(n, sizeof(unsigned));
+  size_t *pred = gv_calloc(n, sizeof(size_t));
+  size_t *order = gv_calloc(n, sizeof(size_t));
+
+  for (unsigned long seed = 1; seed <= 20; ++seed) {
+    graph_t g = make_graph(n, degree, max_weight, seed);
+    for (size_t source = 0; source < n; source += 1 + n / 10) {
+      reference(&g, source, expected);
+
+      size_t reached = gv_sssp_d(s, &g.csr, g.wd, source, dd, pred, order);
+      check(&g, source, expected, dd, pred, order, reached, max_weight > 0);
+
+      // `float` sums are only exact while they fit in its significand
+      if (max_weight * n < 1u << 22) {
+        reached = gv_sssp_f(s, &g.csr, g.wf, source, df, pred, order);
+        for (size_t v = 0; v < n; ++v) {
+          assert(expected[v] != HUGE_VAL || df[v] == FLT_MAX);
+          dist[v] = df[v] == FLT_MAX ? HUGE_VAL : df[v];
+        }
+        check(&g, source, expected, dist, pred, order, reached,
+              max_weight > 0);
+      }
+
+      reached = gv_sssp_u(s, &g.csr, g.wu, source, du, pred, order);
+      for (size_t v = 0; v < n; ++v) {
+        assert(expected[v] != HUGE_VAL || du[v] == UINT_MAX);
+        dist[v] = du[v] == UINT_MAX ? HUGE_VAL : du[v] / 4.0;
+      }
+      check(&g, source, expected, dist, pred, order, reached, false);
+    }
+    free_graph(&g);
+  }
+
+  free(order);
+  free(pred);
+  free(du);
+  free(df);
+  free(dd);
+  free(dist);
+  free(expected);
+  gv_sssp_free(s);
+}
+
+static void test_single(void) { random_graphs(1, 1, 10); }
+static void test_sparse(void) { random_graphs(50, 1, 10); }
+static void test_dense(void) { random_graphs(100, 8, 1000); }
+static void test_zero_weights(void) { random_graphs(60, 3, 0); }
+static void test_wide_weights(void) { random_graphs(60, 3, 1u << 24); }
+
+// a search of a graph smaller than the state’s capacity
+static void test_smaller_graph(void) {
+  const size_t off[] = {0, 1, 2, 2};
+  const size_t adj[] = {1, 2};
+  const unsigned w[] = {3, 4};
+  const gv_csr_t g = {.n = 3, .off = off, .adj = adj};
+  gv_sssp_t *s = gv_sssp_new(10);
+  unsigned dist[3];
+  assert(gv_sssp_u(s, &g, w, 0, dist, NULL, NULL) == 3);
+  assert(dist[0] == 0 && dist[1] == 3 && dist[2] == 7);
+  assert(gv_sssp_u(s, &g, w, 1, dist, NULL, NULL) == 2);
+  assert(dist[0] == UINT_MAX && dist[1] == 0 && dist[2] == 4);
+  gv_sssp_free(s);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(single);
+  RUN(sparse);
+  RUN(dense);
+  RUN(zero_weights);
+  RUN(wide_weights);
+  RUN(smaller_graph);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
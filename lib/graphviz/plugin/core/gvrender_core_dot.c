@@ -41,6 +41,7 @@ typedef enum {
 	FORMAT_XDOT,
 	FORMAT_XDOT12,
 	FORMAT_XDOT14,
+	FORMAT_GVB,
 } format_type;
 
 #define XDOTVERSION "1.7"
@@ -401,6 +402,7 @@ static void dot_begin_graph(GVJ_t *job)
 
     switch (job->render.id) {
 	case FORMAT_DOT:
+	case FORMAT_GVB:
 	    attach_attrs(g);
 	    break;
 	case FORMAT_CANON:
@@ -481,6 +483,14 @@ static void dot_end_graph(GVJ_t *job)
 	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
 		agwrite(g, job);
 	    break;
+	case FORMAT_GVB:
+	    if (!(job->flags & OUTPUT_NOT_REQUIRED)) {
+		size_t size;
+		char *snapshot = agsnapshot(g, &size);
+		gvwrite(job, snapshot, size);
+		free(snapshot);
+	    }
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -768,6 +778,13 @@ gvdevice_features_t device_features_dot = {
     {72.,72.},			/* default dpi */
 };
 
+gvdevice_features_t device_features_gvb = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_dot_types[] = {
     {FORMAT_DOT, "dot", 1, &dot_engine, &render_features_dot},
     {FORMAT_XDOT, "xdot", 1, &xdot_engine, &render_features_xdot},
@@ -783,5 +800,6 @@ gvplugin_installed_t gvdevice_dot_types[] = {
     {FORMAT_XDOT, "xdot:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT12, "xdot1.2:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT14, "xdot1.4:xdot", 1, NULL, &device_features_dot},
+    {FORMAT_GVB, "gvb:dot", 1, NULL, &device_features_gvb},
     {0, NULL, 0, NULL, NULL}
 };
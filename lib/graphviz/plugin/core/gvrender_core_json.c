@@ -10,14 +10,19 @@
 
 #include "config.h"
 
+#include <inttypes.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+#include <cgraph/agxbuf.h>
 #include <common/macros.h>
 #include <common/const.h>
+#include <common/geomprocs.h>
 #include <xdot/xdot.h>
 
 #include <gvc/gvplugin_render.h>
@@ -27,6 +32,7 @@
 #include <gvc/gvio.h>
 #include <gvc/gvcint.h>
 #include <util/alloc.h>
+#include <util/prisize_t.h>
 #include <util/startswith.h>
 #include <util/streq.h>
 #include <util/unreachable.h>
@@ -36,6 +42,7 @@ typedef enum {
 	FORMAT_JSON0,
 	FORMAT_DOT_JSON,
 	FORMAT_XDOT_JSON,
+	FORMAT_LOD_JSON,
 } format_type;
 
 typedef struct {
@@ -74,13 +81,13 @@ static void json_begin_graph(GVJ_t *job)
 #define LOCALNAMEPREFIX		'%'
 
 /** Convert dot string to a valid json string embedded in double quotes and
- *   output
+ *   append it to a buffer
  *
  * \param ins Input string
  * \param sp State, used to determine encoding of the input string
- * \param job Output job
+ * \param xb Buffer to append to
  */
-static void stoj(char *ins, state_t *sp, GVJ_t *job) {
+static void stoj_buf(char *ins, state_t *sp, agxbuf *xb) {
     char* s;
     char* input;
     char c;
@@ -90,44 +97,59 @@ static void stoj(char *ins, state_t *sp, GVJ_t *job) {
     else
 	input = ins;
 
-    gvputc(job, '"');
+    agxbputc(xb, '"');
     for (s = input; (c = *s); s++) {
 	switch (c) {
 	case '"' :
-	    gvputs(job, "\\\"");
+	    agxbput(xb, "\\\"");
 	    break;
 	case '\\' :
-	    gvputs(job, "\\\\");
+	    agxbput(xb, "\\\\");
 	    break;
 	case '/' :
-	    gvputs(job, "\\/");
+	    agxbput(xb, "\\/");
 	    break;
 	case '\b' :
-	    gvputs(job, "\\b");
+	    agxbput(xb, "\\b");
 	    break;
 	case '\f' :
-	    gvputs(job, "\\f");
+	    agxbput(xb, "\\f");
 	    break;
 	case '\n' :
-	    gvputs(job, "\\n");
+	    agxbput(xb, "\\n");
 	    break;
 	case '\r' :
-	    gvputs(job, "\\r");
+	    agxbput(xb, "\\r");
 	    break;
 	case '\t' :
-	    gvputs(job, "\\t");
+	    agxbput(xb, "\\t");
 	    break;
 	default :
-	    gvputc(job, c);
+	    agxbputc(xb, c);
 	    break;
 	}
     }
-    gvputc(job, '"');
+    agxbputc(xb, '"');
 
     if (sp->isLatin)
 	free (input);
 }
 
+/** Convert dot string to a valid json string embedded in double quotes and
+ *   output
+ *
+ * \param ins Input string
+ * \param sp State, used to determine encoding of the input string
+ * \param job Output job
+ */
+static void stoj(char *ins, state_t *sp, GVJ_t *job) {
+    agxbuf xb = {0};
+    stoj_buf(ins, sp, &xb);
+    const size_t len = agxblen(&xb);
+    gvwrite(job, agxbuse(&xb), len);
+    agxbfree(&xb);
+}
+
 static void indent(GVJ_t * job, int level)
 {
     int i;
@@ -708,15 +730,392 @@ static void write_graph(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
 	gvputs(job, "}");
 }
 
+/// nodes per cell at which the level-of-detail pyramid stops subdividing
+enum { LOD_LEAF_SIZE = 64 };
+
+/// deepest level of the level-of-detail pyramid, with 2^16 × 2^16 cells
+enum { LOD_MAX_DEPTH = 16 };
+
+/// an item sorted by a key, a node or edge by its cell or supernode
+typedef struct {
+    uint64_t key;
+    size_t index;
+} lod_item_t;
+
+static int lod_item_cmp(const void *x, const void *y) {
+    const lod_item_t *a = x;
+    const lod_item_t *b = y;
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    if (a->index != b->index)
+	return a->index < b->index ? -1 : 1;
+    return 0;
+}
+
+/// the laid out graph, as seen by the level-of-detail output
+typedef struct {
+    Agnode_t **nodes; ///< nodes, by `_gvid`
+    size_t n_nodes;
+    Agedge_t **edges;
+    size_t *tails; ///< `_gvid` of the tail of each edge
+    size_t *heads; ///< `_gvid` of the head of each edge
+    size_t n_edges;
+    boxf bb;
+    bool directed;
+} lod_graph_t;
+
+/// the nodes sorted by the cell of a grid that contains them, and the
+/// resulting supernode of each node
+typedef struct {
+    unsigned depth;     ///< the grid has 2^depth × 2^depth cells
+    lod_item_t *sorted; ///< nodes in order of their cells
+    size_t *super;      ///< supernode of each node, by `_gvid`
+    size_t n_super;
+} lod_level_t;
+
+static boxf lod_node_bb(Agnode_t *n) {
+    const pointf p = ND_coord(n);
+    return (boxf){{p.x - ND_lw(n), p.y - ND_ht(n) / 2},
+                  {p.x + ND_rw(n), p.y + ND_ht(n) / 2}};
+}
+
+/// cell of the grid with 2^depth cells per side that contains `p`
+static uint64_t lod_cell(const lod_graph_t *lg, unsigned depth, pointf p) {
+    const uint64_t side = (uint64_t)1 << depth;
+    const double w = fmax(lg->bb.UR.x - lg->bb.LL.x, 1);
+    const double h = fmax(lg->bb.UR.y - lg->bb.LL.y, 1);
+    const double fx = fmax((p.x - lg->bb.LL.x) / w, 0);
+    const double fy = fmax((p.y - lg->bb.LL.y) / h, 0);
+    const uint64_t x = (uint64_t)fmin(fx * (double)side, (double)(side - 1));
+    const uint64_t y = (uint64_t)fmin(fy * (double)side, (double)(side - 1));
+    return y * side + x;
+}
+
+static void lod_cell_print(agxbuf *xb, unsigned depth, uint64_t cell) {
+    const uint64_t side = (uint64_t)1 << depth;
+    agxbprint(xb, "[%" PRIu64 ", %" PRIu64 "]", cell % side, cell / side);
+}
+
+/// append a number as `gvprintdouble` writes it
+static void lod_double_print(agxbuf *xb, double num) {
+    // prevents values like -0
+    if (num > -0.005 && num < 0.005) {
+	agxbputc(xb, '0');
+	return;
+    }
+    agxbuf tmp = {0};
+    agxbprint(&tmp, "%.02f", num);
+    agxbuf_trim_zeros(&tmp);
+    const size_t len = agxblen(&tmp);
+    agxbput_n(xb, agxbuse(&tmp), len);
+    agxbfree(&tmp);
+}
+
+static void lod_bb_print(agxbuf *xb, boxf bb) {
+    agxbputc(xb, '[');
+    lod_double_print(xb, bb.LL.x);
+    agxbput(xb, ", ");
+    lod_double_print(xb, bb.LL.y);
+    agxbput(xb, ", ");
+    lod_double_print(xb, bb.UR.x);
+    agxbput(xb, ", ");
+    lod_double_print(xb, bb.UR.y);
+    agxbputc(xb, ']');
+}
+
+static void lod_point_print(agxbuf *xb, pointf p) {
+    agxbputc(xb, '[');
+    lod_double_print(xb, p.x);
+    agxbput(xb, ", ");
+    lod_double_print(xb, p.y);
+    agxbputc(xb, ']');
+}
+
+/// group the nodes by the cells of the grid at the given depth
+static void lod_level(const lod_graph_t *lg, unsigned depth, lod_level_t *lv) {
+    lv->depth = depth;
+    for (size_t i = 0; i < lg->n_nodes; i++) {
+	lv->sorted[i] = (lod_item_t){lod_cell(lg, depth, ND_coord(lg->nodes[i])), i};
+    }
+    qsort(lv->sorted, lg->n_nodes, sizeof(lv->sorted[0]), lod_item_cmp);
+    lv->n_super = 0;
+    for (size_t i = 0; i < lg->n_nodes; i++) {
+	if (i > 0 && lv->sorted[i].key != lv->sorted[i - 1].key)
+	    lv->n_super++;
+	lv->super[lv->sorted[i].index] = lv->n_super;
+    }
+    if (lg->n_nodes > 0)
+	lv->n_super++;
+}
+
+/// write the supernodes of a level, and the edges between them
+static void lod_level_write(agxbuf *xb, const lod_graph_t *lg,
+                            const lod_level_t *lv, lod_item_t *scratch) {
+    agxbprint(xb, "    {\"grid\": %" PRIu64 ",\n", (uint64_t)1 << lv->depth);
+    agxbput(xb, "     \"supernodes\": [");
+    for (size_t i = 0, s = 0; i < lg->n_nodes; s++) {
+	const uint64_t cell = lv->sorted[i].key;
+	boxf bb = lod_node_bb(lg->nodes[lv->sorted[i].index]);
+	pointf sum = {0, 0};
+	size_t count = 0;
+	for (; i < lg->n_nodes && lv->sorted[i].key == cell; i++, count++) {
+	    Agnode_t *n = lg->nodes[lv->sorted[i].index];
+	    const boxf nb = lod_node_bb(n);
+	    bb.LL.x = fmin(bb.LL.x, nb.LL.x);
+	    bb.LL.y = fmin(bb.LL.y, nb.LL.y);
+	    bb.UR.x = fmax(bb.UR.x, nb.UR.x);
+	    bb.UR.y = fmax(bb.UR.y, nb.UR.y);
+	    sum = add_pointf(sum, ND_coord(n));
+	}
+	agxbprint(xb, "%s\n      {\"_gvid\": %" PRISIZE_T ", \"cell\": ",
+	          s > 0 ? "," : "", s);
+	lod_cell_print(xb, lv->depth, cell);
+	agxbprint(xb, ", \"nodes\": %" PRISIZE_T ", \"pos\": ", count);
+	lod_point_print(xb, scale(1.0 / (double)count, sum));
+	agxbput(xb, ", \"bb\": ");
+	lod_bb_print(xb, bb);
+	agxbputc(xb, '}');
+    }
+    agxbput(xb, "\n     ],\n");
+
+    // edges between different supernodes, keyed by the supernodes they join
+    size_t n = 0;
+    for (size_t i = 0; i < lg->n_edges; i++) {
+	size_t t = lv->super[lg->tails[i]];
+	size_t h = lv->super[lg->heads[i]];
+	if (t == h)
+	    continue;
+	if (!lg->directed && t > h) {
+	    const size_t tmp = t;
+	    t = h;
+	    h = tmp;
+	}
+	scratch[n++] = (lod_item_t){(uint64_t)t << 32 | (uint64_t)h, i};
+    }
+    qsort(scratch, n, sizeof(scratch[0]), lod_item_cmp);
+    agxbput(xb, "     \"edges\": [");
+    for (size_t i = 0, written = 0; i < n; written++) {
+	const uint64_t key = scratch[i].key;
+	size_t weight = 0;
+	for (; i < n && scratch[i].key == key; i++)
+	    weight++;
+	agxbprint(xb, "%s\n      {\"tail\": %" PRIu64 ", \"head\": %" PRIu64
+	          ", \"weight\": %" PRISIZE_T "}", written > 0 ? "," : "",
+	          key >> 32, key & UINT32_MAX, weight);
+    }
+    agxbput(xb, "\n     ]}");
+}
+
+static void lod_edge_write(agxbuf *xb, const lod_graph_t *lg, size_t i) {
+    Agedge_t *e = lg->edges[i];
+    agxbprint(xb, "{\"tail\": %" PRISIZE_T ", \"head\": %" PRISIZE_T,
+              lg->tails[i], lg->heads[i]);
+    if (ED_spl(e) != NULL) {
+	agxbput(xb, ", \"splines\": [");
+	for (size_t j = 0; j < ED_spl(e)->size; j++) {
+	    const bezier bz = ED_spl(e)->list[j];
+	    agxbput(xb, j > 0 ? ", [" : "[");
+	    for (size_t k = 0; k < bz.size; k++) {
+		if (k > 0)
+		    agxbput(xb, ", ");
+		lod_point_print(xb, bz.list[k]);
+	    }
+	    agxbputc(xb, ']');
+	}
+	agxbputc(xb, ']');
+    }
+    agxbputc(xb, '}');
+}
+
+/// where a tile was written, relative to the start of the `"tiles"` key
+typedef struct {
+    uint64_t cell;
+    size_t offset;
+    size_t length;
+} lod_tile_t;
+
+/// write the tiles of the finest level, one per line, each with its nodes and
+/// the edges that have an end in it, and note where each was written
+static void lod_tiles_write(agxbuf *xb, const lod_graph_t *lg,
+                            const lod_level_t *lv, lod_item_t *scratch,
+                            lod_tile_t *tiles, state_t *sp) {
+    // edges, keyed by the tiles of their ends
+    size_t n = 0;
+    for (size_t i = 0; i < lg->n_edges; i++) {
+	const size_t t = lv->super[lg->tails[i]];
+	const size_t h = lv->super[lg->heads[i]];
+	scratch[n++] = (lod_item_t){t, i};
+	if (h != t)
+	    scratch[n++] = (lod_item_t){h, i};
+    }
+    qsort(scratch, n, sizeof(scratch[0]), lod_item_cmp);
+
+    agxbput(xb, "  \"tiles\": [");
+    for (size_t i = 0, j = 0, s = 0; i < lg->n_nodes; s++) {
+	const uint64_t cell = lv->sorted[i].key;
+	agxbput(xb, s > 0 ? ",\n" : "\n");
+	tiles[s].cell = cell;
+	tiles[s].offset = agxblen(xb);
+	agxbprint(xb, "{\"supernode\": %" PRISIZE_T ", \"cell\": ", s);
+	lod_cell_print(xb, lv->depth, cell);
+	agxbput(xb, ", \"nodes\": [");
+	for (bool first = true; i < lg->n_nodes && lv->sorted[i].key == cell;
+	     i++, first = false) {
+	    const size_t id = lv->sorted[i].index;
+	    Agnode_t *node = lg->nodes[id];
+	    agxbprint(xb, "%s{\"_gvid\": %" PRISIZE_T ", \"name\": ",
+	              first ? "" : ", ", id);
+	    stoj_buf(agnameof(node), sp, xb);
+	    agxbput(xb, ", \"pos\": ");
+	    lod_point_print(xb, ND_coord(node));
+	    agxbput(xb, ", \"bb\": ");
+	    lod_bb_print(xb, lod_node_bb(node));
+	    agxbputc(xb, '}');
+	}
+	agxbput(xb, "], \"edges\": [");
+	for (bool first = true; j < n && scratch[j].key == s; j++, first = false) {
+	    if (!first)
+		agxbput(xb, ", ");
+	    lod_edge_write(xb, lg, scratch[j].index);
+	}
+	agxbput(xb, "]}");
+	tiles[s].length = agxblen(xb) - tiles[s].offset;
+    }
+    agxbput(xb, "\n  ]\n");
+}
+
+/// write the byte offset and length in the output of each tile, given the
+/// offset of the `"tiles"` key
+static void lod_index_write(agxbuf *xb, const lod_level_t *lv,
+                            const lod_tile_t *tiles, size_t base) {
+    agxbput(xb, "  \"tile_index\": [");
+    for (size_t s = 0; s < lv->n_super; s++) {
+	agxbprint(xb, "%s\n{\"supernode\": %" PRISIZE_T ", \"cell\": ",
+	          s > 0 ? "," : "", s);
+	lod_cell_print(xb, lv->depth, tiles[s].cell);
+	agxbprint(xb, ", \"offset\": %" PRISIZE_T ", \"length\": %" PRISIZE_T
+	          "}", base + tiles[s].offset, tiles[s].length);
+    }
+    agxbput(xb, "\n  ],\n");
+}
+
+static void lod_flush(GVJ_t *job, agxbuf *xb) {
+    const size_t len = agxblen(xb);
+    gvwrite(job, agxbuse(xb), len);
+}
+
+/// write a pyramid of ever finer grids over the layout
+///
+/// Each level of the pyramid halves the cells of the one before in both
+/// directions, and aggregates the nodes of each occupied cell into a supernode
+/// and the edges between cells into weighted edges. The nodes and edges of the
+/// finest level are written as one tile per line, after an index of the byte
+/// offset and length of each tile in the output, so a client that has read up
+/// to the index can fetch only the tiles of the region it shows.
+static void write_lod(Agraph_t *g, GVJ_t *job, state_t *sp) {
+    lod_graph_t lg = {.bb = GD_bb(g), .directed = agisdirected(g)};
+
+    lg.n_nodes = (size_t)agnnodes(g);
+    lg.nodes = gv_calloc(lg.n_nodes, sizeof(lg.nodes[0]));
+    size_t max_seq = 0;
+    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if ((size_t)AGSEQ(n) > max_seq)
+	    max_seq = (size_t)AGSEQ(n);
+    }
+    size_t *gvid = gv_calloc(max_seq + 1, sizeof(gvid[0]));
+    {
+	size_t i = 0;
+	for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n), i++) {
+	    lg.nodes[i] = n;
+	    gvid[AGSEQ(n)] = i;
+	}
+    }
+
+    const size_t edges = (size_t)agnedges(g);
+    lg.edges = gv_calloc(edges, sizeof(lg.edges[0]));
+    lg.tails = gv_calloc(edges, sizeof(lg.tails[0]));
+    lg.heads = gv_calloc(edges, sizeof(lg.heads[0]));
+    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    lg.edges[lg.n_edges] = e;
+	    lg.tails[lg.n_edges] = gvid[AGSEQ(agtail(e))];
+	    lg.heads[lg.n_edges] = gvid[AGSEQ(aghead(e))];
+	    lg.n_edges++;
+	}
+    }
+
+    lod_level_t lv = {0};
+    lv.sorted = gv_calloc(lg.n_nodes, sizeof(lv.sorted[0]));
+    lv.super = gv_calloc(lg.n_nodes, sizeof(lv.super[0]));
+    lod_item_t *scratch = gv_calloc(2 * lg.n_edges, sizeof(scratch[0]));
+
+    // the offsets in the index depend on its own length, so everything is
+    // written to memory first
+    agxbuf head = {0};
+    agxbput(&head, "{\n  \"name\": ");
+    stoj_buf(agnameof(g), sp, &head);
+    agxbprint(&head, ",\n  \"directed\": %s,\n", lg.directed ? "true" : "false");
+    agxbput(&head, "  \"bb\": ");
+    lod_bb_print(&head, lg.bb);
+    agxbput(&head, ",\n  \"levels\": [");
+    for (unsigned depth = 0;; depth++) {
+	lod_level(&lg, depth, &lv);
+	agxbput(&head, depth > 0 ? ",\n" : "\n");
+	lod_level_write(&head, &lg, &lv, scratch);
+	if (lv.n_super * LOD_LEAF_SIZE >= lg.n_nodes || depth == LOD_MAX_DEPTH)
+	    break;
+    }
+    agxbput(&head, "\n  ],\n");
+
+    agxbuf body = {0};
+    lod_tile_t *tiles = gv_calloc(lv.n_super, sizeof(tiles[0]));
+    lod_tiles_write(&body, &lg, &lv, scratch, tiles, sp);
+
+    // a longer index only pushes the tiles further out, so starting from an
+    // empty one this settles on the first offset that it is consistent with
+    agxbuf index = {0};
+    size_t base = agxblen(&head);
+    for (;;) {
+	agxbclear(&index);
+	lod_index_write(&index, &lv, tiles, base);
+	if (agxblen(&head) + agxblen(&index) == base)
+	    break;
+	base = agxblen(&head) + agxblen(&index);
+    }
+
+    lod_flush(job, &head);
+    lod_flush(job, &index);
+    lod_flush(job, &body);
+    gvputs(job, "}\n");
+
+    agxbfree(&index);
+    free(tiles);
+    agxbfree(&body);
+    agxbfree(&head);
+    free(scratch);
+    free(lv.super);
+    free(lv.sorted);
+    free(lg.heads);
+    free(lg.tails);
+    free(lg.edges);
+    free(gvid);
+    free(lg.nodes);
+}
+
 typedef int (*putstrfn) (void *chan, const char *str);
 typedef int (*flushfn) (void *chan);
 
 static void json_end_graph(GVJ_t *job)
 {
     graph_t *g = job->obj->u.g;
-    state_t sp;
+    state_t sp = {.isLatin = GD_charset(g) == CHAR_LATIN1};
     static Agiodisc_t io;
 
+    if (job->render.id == FORMAT_LOD_JSON) {
+	write_lod(g, job, &sp);
+	return;
+    }
+
     if (io.afread == NULL) {
 	io.afread = AgIoDisc.afread;
 	io.putstr = (putstrfn)gvputs;
@@ -727,7 +1126,6 @@ static void json_end_graph(GVJ_t *job)
 
     set_attrwf(g, true, false);
     sp.Level = 0;
-    sp.isLatin = GD_charset(g) == CHAR_LATIN1;
     sp.doXDot = job->render.id == FORMAT_JSON || job->render.id == FORMAT_XDOT_JSON;
     write_graph(g, job, true, &sp);
 }
@@ -803,6 +1201,7 @@ gvplugin_installed_t gvrender_json_types[] = {
     {FORMAT_JSON0, "json0", 1, &json_engine, &render_features_json},
     {FORMAT_DOT_JSON, "dot_json", 1, &json_engine, &render_features_json},
     {FORMAT_XDOT_JSON, "xdot_json", 1, &json_engine, &render_features_json},
+    {FORMAT_LOD_JSON, "lod_json", 1, &json_engine, &render_features_json1},
     {0, NULL, 0, NULL, NULL}
 };
 
@@ -811,5 +1210,6 @@ gvplugin_installed_t gvdevice_json_types[] = {
     {FORMAT_JSON0, "json0:json", 1, NULL, &device_features_json},
     {FORMAT_DOT_JSON, "dot_json:json", 1, NULL, &device_features_json_nop},
     {FORMAT_XDOT_JSON, "xdot_json:json", 1, NULL, &device_features_json_nop},
+    {FORMAT_LOD_JSON, "lod_json:json", 1, NULL, &device_features_json},
     {0, NULL, 0, NULL, NULL}
 };
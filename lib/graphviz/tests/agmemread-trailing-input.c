@@ -0,0 +1,32 @@
+/// \file
+/// \brief agmemread() should not carry unread input over to the next read
+///
+/// see test_regression.py:test_agmemread_trailing_input()
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error "this code is not intended to be compiled with assertions disabled"
+#endif
+
+int main(void) {
+
+  // a string containing two graphs, of which only the first is read
+  Agraph_t *g = agmemread("digraph A { a -> b }\ndigraph B { c -> d -> e }");
+  assert(g != NULL);
+  assert(strcmp(agnameof(g), "A") == 0);
+  assert(agnnodes(g) == 2);
+
+  // reading a second string should see only that string’s graph
+  Agraph_t *h = agmemread("graph C { x -- y -- z -- w }");
+  assert(h != NULL);
+  assert(strcmp(agnameof(h), "C") == 0);
+  assert(agnnodes(h) == 4);
+
+  agclose(h);
+  agclose(g);
+
+  return 0;
+}
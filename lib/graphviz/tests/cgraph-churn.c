@@ -0,0 +1,185 @@
+/// \file
+/// \brief a graph built with heavy node and string churn should come out the
+/// same as one built directly
+///
+/// Node IDs of named nodes are addresses of interned strings and those of
+/// anonymous nodes are counters, so a large graph of both exercises the
+/// mixing of IDs in the node table. Setting many short lived attribute
+/// values exercises the reference counting of strings.
+///
+/// see test_regression.py:test_cgraph_churn()
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error "this code is not intended to be compiled with assertions disabled"
+#endif
+
+enum { N = 20000 };
+
+static void name_of(char *buf, size_t size, int i) {
+  snprintf(buf, size, "n%d", i);
+}
+
+/// node i, in an order unrelated to its name
+static int nth(int i) { return (int)(((long long)i * 7919) % N); }
+
+static bool recreated(int i) { return i % 3 == 0; }
+
+static void add_edges(Agraph_t *g, const int *order) {
+  for (int k = 0; k < N; ++k) {
+    char tail[32], head[32];
+    name_of(tail, sizeof(tail), order[k]);
+    name_of(head, sizeof(head), (order[k] * 13 + 1) % N);
+    Agnode_t *t = agnode(g, tail, 0);
+    Agnode_t *h = agnode(g, head, 0);
+    assert(t != NULL && h != NULL);
+    Agedge_t *e = agedge(g, t, h, NULL, 1);
+    assert(e != NULL);
+  }
+}
+
+static const char *value_of(char *buf, size_t size, int i) {
+  snprintf(buf, size, "v%d", i % 97);
+  return buf;
+}
+
+/// the final creation order of nodes: those kept, then those recreated
+static int *final_order(void) {
+  int *order = calloc(N, sizeof(order[0]));
+  assert(order != NULL);
+  int k = 0;
+  for (int i = 0; i < N; ++i) {
+    if (!recreated(nth(i)))
+      order[k++] = nth(i);
+  }
+  for (int i = 0; i < N; ++i) {
+    if (recreated(nth(i)))
+      order[k++] = nth(i);
+  }
+  assert(k == N);
+  return order;
+}
+
+static Agraph_t *churned(const int *order) {
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agsym_t *label = agattr(g, AGNODE, "label", "");
+  char name[32], value[32];
+
+  // named nodes interleaved with anonymous ones
+  Agnode_t **anon = calloc(N, sizeof(anon[0]));
+  assert(anon != NULL);
+  for (int i = 0; i < N; ++i) {
+    name_of(name, sizeof(name), nth(i));
+    assert(agnode(g, name, 1) != NULL);
+    anon[i] = agnode(g, NULL, 1);
+    assert(anon[i] != NULL);
+  }
+
+  // drop the anonymous nodes and a third of the named ones, then recreate
+  // the named ones
+  for (int i = 0; i < N; ++i)
+    agdelnode(g, anon[i]);
+  free(anon);
+  for (int i = 0; i < N; ++i) {
+    if (recreated(nth(i))) {
+      name_of(name, sizeof(name), nth(i));
+      agdelnode(g, agnode(g, name, 0));
+    }
+  }
+  assert(agnnodes(g) == N - (N + 2) / 3);
+  for (int i = 0; i < N; ++i) {
+    if (recreated(nth(i))) {
+      name_of(name, sizeof(name), nth(i));
+      assert(agnode(g, name, 0) == NULL);
+      assert(agnode(g, name, 1) != NULL);
+    }
+  }
+  assert(agnnodes(g) == N);
+
+  // every node is found by name and by ID
+  for (int i = 0; i < N; ++i) {
+    name_of(name, sizeof(name), i);
+    Agnode_t *n = agnode(g, name, 0);
+    assert(n != NULL);
+    assert(strcmp(agnameof(n), name) == 0);
+    assert(agidnode(g, AGID(n), 0) == n);
+  }
+
+  add_edges(g, order);
+
+  // cycle each label through values used nowhere else before settling
+  for (int i = 0; i < N; ++i) {
+    name_of(name, sizeof(name), i);
+    Agnode_t *n = agnode(g, name, 0);
+    for (int round = 0; round < 4; ++round) {
+      char tmp[48];
+      snprintf(tmp, sizeof(tmp), "tmp%d_%d", i, round);
+      agxset(n, label, tmp);
+    }
+    agxset(n, label, value_of(value, sizeof(value), i));
+  }
+
+  // the short lived values are no longer referenced, so have been released
+  for (int i = 0; i < N; i += 101) {
+    char tmp[48];
+    snprintf(tmp, sizeof(tmp), "tmp%d_%d", i, 3);
+    assert(agstrbind(g, tmp) == NULL);
+  }
+
+  return g;
+}
+
+static Agraph_t *direct(const int *order) {
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agsym_t *label = agattr(g, AGNODE, "label", "");
+  char name[32], value[32];
+  for (int k = 0; k < N; ++k) {
+    name_of(name, sizeof(name), order[k]);
+    Agnode_t *n = agnode(g, name, 1);
+    agxset(n, label, value_of(value, sizeof(value), order[k]));
+  }
+  add_edges(g, order);
+  return g;
+}
+
+/// DOT text of a graph
+static char *text_of(Agraph_t *g) {
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  assert(agwrite(g, f) == 0);
+  const long size = ftell(f);
+  assert(size > 0);
+  rewind(f);
+  char *text = calloc((size_t)size + 1, 1);
+  assert(text != NULL);
+  assert(fread(text, (size_t)size, 1, f) == 1);
+  fclose(f);
+  return text;
+}
+
+int main(void) {
+  int *order = final_order();
+
+  Agraph_t *a = churned(order);
+  Agraph_t *b = direct(order);
+  assert(agnnodes(a) == agnnodes(b));
+  assert(agnedges(a) == agnedges(b));
+
+  char *ta = text_of(a);
+  char *tb = text_of(b);
+  assert(strcmp(ta, tb) == 0);
+
+  free(tb);
+  free(ta);
+  agclose(b);
+  agclose(a);
+  free(order);
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+/// \file
+/// \brief a failed render should not affect later renders with the same context
+///
+/// see test_regression.py:test_gvrender_after_failure()
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#error "this code is not intended to be compiled with assertions disabled"
+#endif
+
+int main(void) {
+
+  GVC_t *gvc = gvContext();
+  assert(gvc != NULL);
+
+  Agraph_t *g = agmemread("digraph { a -> b }");
+  assert(g != NULL);
+
+  // rendering in an unknown format fails
+  assert(gvLayout(gvc, g, "dot") == 0);
+  char *result = NULL;
+  unsigned length = 0;
+  assert(gvRenderData(gvc, g, "unknown-format", &result, &length) != 0);
+  gvFreeLayout(gvc, g);
+
+  // rendering without a layout fails
+  assert(gvRenderData(gvc, g, "plain", &result, &length) != 0);
+
+  // a later render should still succeed, and produce only its own output
+  assert(gvLayout(gvc, g, "dot") == 0);
+  result = NULL;
+  length = 0;
+  assert(gvRenderData(gvc, g, "plain", &result, &length) == 0);
+  assert(result != NULL);
+  assert(strncmp(result, "graph ", strlen("graph ")) == 0);
+  assert(strlen(result) == length);
+  gvFreeRenderData(result);
+  gvFreeLayout(gvc, g);
+
+  agclose(g);
+  gvFreeContext(gvc);
+
+  return 0;
+}
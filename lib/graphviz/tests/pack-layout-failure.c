@@ -0,0 +1,134 @@
+/// \file
+/// \brief a component whose deferred layout fails should still be finished and
+/// packed
+///
+/// `layoutAndPackGraphs` runs the middle phase of each component’s layout on
+/// worker threads. neato’s stress majorization reports a failed solve from
+/// that phase, and only acts on it in the finish phase, which must still see
+/// every component.
+///
+/// see test_regression.py:test_pack_layout_failure()
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/pack.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#error "this code is not intended to be compiled with assertions disabled"
+#endif
+
+enum { COMPONENTS = 6, NODES = 3, FAILING = 2 };
+
+/// the layout of one component, between its phases
+typedef struct {
+  int index;
+  double x[NODES];
+  bool ran;
+  bool failed;
+} state_t;
+
+typedef struct {
+  int started;
+  int finished;
+  int aborted;
+} context_t;
+
+static void *start(Agraph_t *g, void *arg) {
+  (void)g;
+  context_t *ctx = arg;
+  state_t *s = calloc(1, sizeof(*s));
+  assert(s != NULL);
+  s->index = ctx->started++;
+  return s;
+}
+
+/// lay nodes out in a row, except in one component where this fails
+static void run(void *state) {
+  state_t *s = state;
+  s->ran = true;
+  if (s->index == FAILING) {
+    s->failed = true;
+    return;
+  }
+  for (int i = 0; i < NODES; ++i)
+    s->x[i] = i;
+}
+
+static void finish(Agraph_t *g, void *state, void *arg) {
+  context_t *ctx = arg;
+  state_t *s = state;
+  assert(s->ran);
+  assert(s->index == ctx->finished);
+  ++ctx->finished;
+
+  // as neato does, a failed layout leaves the nodes where they started
+  if (s->failed)
+    ++ctx->aborted;
+
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n), ++i) {
+    ND_pos(n)[0] = s->x[i];
+    ND_pos(n)[1] = 0;
+    ND_coord(n).x = POINTS(s->x[i]);
+    ND_coord(n).y = 0;
+  }
+  GD_bb(g) = (boxf){{-18, -18}, {POINTS(NODES - 1) + 18, 18}};
+  free(s);
+}
+
+int main(int argc, char **argv) {
+  assert(argc == 2);
+#ifdef _WIN32
+  _putenv_s("GV_THREADS", argv[1]);
+#else
+  setenv("GV_THREADS", argv[1], 1);
+#endif
+
+  Agraph_t *root = agopen("g", Agundirected, NULL);
+  agbindrec(root, "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+  Agraph_t *gs[COMPONENTS];
+  for (int c = 0; c < COMPONENTS; ++c) {
+    char name[32];
+    snprintf(name, sizeof(name), "c%d", c);
+    gs[c] = agsubg(root, name, 1);
+    agbindrec(gs[c], "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+    for (int i = 0; i < NODES; ++i) {
+      snprintf(name, sizeof(name), "c%d_%d", c, i);
+      Agnode_t *n = agnode(gs[c], name, 1);
+      agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);
+      ND_pos(n) = calloc(2, sizeof(double));
+      assert(ND_pos(n) != NULL);
+    }
+  }
+
+  pack_info pinfo = {.mode = l_graph, .margin = 8};
+  const pack_layout layout = {start, run, finish};
+  context_t ctx = {0};
+  const int rc = layoutAndPackGraphs(COMPONENTS, gs, root, &pinfo, &layout,
+                                     &ctx);
+  assert(rc == 0);
+  assert(ctx.started == COMPONENTS);
+  assert(ctx.finished == COMPONENTS);
+  assert(ctx.aborted == 1);
+
+  // every component, including the failed one, has been given a place apart
+  // from the others
+  for (int a = 0; a < COMPONENTS; ++a) {
+    for (int b = a + 1; b < COMPONENTS; ++b) {
+      const boxf p = GD_bb(gs[a]), q = GD_bb(gs[b]);
+      assert(p.UR.x <= q.LL.x || q.UR.x <= p.LL.x || p.UR.y <= q.LL.y ||
+             q.UR.y <= p.LL.y);
+    }
+  }
+
+  for (int c = 0; c < COMPONENTS; ++c) {
+    for (Agnode_t *n = agfstnode(gs[c]); n; n = agnxtnode(gs[c], n))
+      free(ND_pos(n));
+  }
+  agclose(root);
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include <cgraph++/AGraph.h>
+
+TEST_CASE("AGraph can be built without DOT source") {
+  CGraph::AGraph g{"G", Agdirected};
+  REQUIRE(g.c_struct() != nullptr);
+  REQUIRE(g.name() == "G");
+  REQUIRE(agisdirected(g.c_struct()));
+
+  const auto a = g.add_node("a");
+  const auto e = g.add_edge("a", "b");
+  REQUIRE(g.num_nodes() == 2);
+  REQUIRE(g.num_edges() == 1);
+  REQUIRE(g.find_node("a") == a);
+  REQUIRE(g.find_node("c") == nullptr);
+  REQUIRE(agtail(e) == a);
+  REQUIRE(g.name(aghead(e)) == "b");
+  REQUIRE(g.find_edge(a, g.find_node("b")) == e);
+  REQUIRE(g.find_edge(g.find_node("b"), a) == nullptr);
+
+  SECTION("adding a node again finds the existing one") {
+    REQUIRE(g.add_node("a") == a);
+    REQUIRE(g.num_nodes() == 2);
+  }
+}
+
+TEST_CASE("AGraph reports edges that cannot be created") {
+  Agdesc_t kind = Agstrictundirected;
+  kind.no_loop = 1;
+  CGraph::AGraph g{"G", kind};
+  const auto a = g.add_node("a");
+  const auto b = g.add_node("b");
+  REQUIRE(g.add_edge(a, b) == g.add_edge(b, a));
+  REQUIRE(g.num_edges() == 1);
+  REQUIRE_THROWS_AS(g.add_edge(a, a), std::runtime_error);
+}
+
+TEST_CASE("AGraph can add edges in bulk from index arrays") {
+  CGraph::AGraph g{"G", Agdirected};
+  const std::vector<std::string> names{"a", "b", "c"};
+  const auto nodes = g.add_nodes(names);
+  REQUIRE(nodes.size() == 3);
+
+  const std::vector<std::size_t> tails{0, 0, 1, 2};
+  const std::vector<std::size_t> heads{1, 2, 2, 0};
+  const auto edges = g.add_edges(nodes, tails, heads);
+  REQUIRE(edges.size() == 4);
+  REQUIRE(g.num_edges() == 4);
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    REQUIRE(agtail(edges[i]) == nodes[tails[i]]);
+    REQUIRE(aghead(edges[i]) == nodes[heads[i]]);
+  }
+
+  SECTION("bad indices are rejected before any edge is made") {
+    const std::vector<std::size_t> bad{0, 3};
+    REQUIRE_THROWS_AS(g.add_edges(nodes, bad, bad), std::out_of_range);
+    REQUIRE_THROWS_AS(g.add_edges(nodes, tails, bad), std::invalid_argument);
+    REQUIRE(g.num_edges() == 4);
+  }
+}
+
+TEST_CASE("AGraph can create many anonymous nodes") {
+  CGraph::AGraph g{"G", Agundirected};
+  const auto nodes = g.add_nodes(5000);
+  REQUIRE(g.num_nodes() == 5000);
+  std::vector<std::size_t> tails, heads;
+  for (std::size_t i = 1; i < nodes.size(); ++i) {
+    tails.push_back(i - 1);
+    heads.push_back(i);
+  }
+  g.add_edges(nodes, tails, heads);
+  REQUIRE(g.num_edges() == 4999);
+  REQUIRE(agdegree(g.c_struct(), nodes[42], 1, 1) == 2);
+}
+
+TEST_CASE("AGraph iterates over nodes and edges in order of creation") {
+  CGraph::AGraph g{"G", Agdirected};
+  g.add_edge("b", "a");
+  g.add_edge("a", "c");
+  g.add_edge("b", "c");
+
+  std::vector<std::string> nodes;
+  for (Agnode_t *n : g.nodes()) {
+    nodes.emplace_back(g.name(n));
+  }
+  REQUIRE(nodes == std::vector<std::string>{"b", "a", "c"});
+
+  std::vector<std::string> edges;
+  for (Agedge_t *e : g.edges()) {
+    edges.push_back(std::string{g.name(agtail(e))} + "->" +
+                    std::string{g.name(aghead(e))});
+  }
+  REQUIRE(edges == std::vector<std::string>{"b->a", "b->c", "a->c"});
+
+  SECTION("an empty graph has no nodes or edges") {
+    CGraph::AGraph empty{"empty", Agdirected};
+    REQUIRE(empty.nodes().empty());
+    REQUIRE(empty.edges().empty());
+  }
+}
+
+TEST_CASE("AGraph can build and iterate over subgraphs") {
+  CGraph::AGraph g{"G", Agdirected};
+  const auto e = g.add_edge("a", "b");
+  g.add_node("c");
+  const auto cluster = g.add_subgraph("cluster_0");
+  const auto inner = g.add_subgraph("inner", cluster);
+  g.add_to_subgraph(inner, e);
+  REQUIRE(g.find_subgraph("cluster_0") == cluster);
+  REQUIRE(agparent(inner) == cluster);
+  REQUIRE(agnnodes(cluster) == 2);
+  REQUIRE(std::ranges::distance(g.nodes(inner)) == 2);
+  REQUIRE(std::ranges::distance(g.edges(cluster)) == 1);
+}
+
+TEST_CASE("AGraph sets and reads typed attributes") {
+  CGraph::AGraph g{"G", Agdirected};
+  const auto n = g.add_node("a");
+  const auto e = g.add_edge("a", "b");
+  const auto color = g.declare_attr(AGNODE, "color", "black");
+  REQUIRE(g.get_attr(g.find_node("b"), color) == "black");
+
+  g.set_attr(n, color, "red");
+  REQUIRE(g.get_attr(n, color) == "red");
+  g.set_attr(n, color, std::string{"blue"});
+  REQUIRE(g.get_attr(n, "color") == "blue");
+
+  g.set_attr(n, "width", 1.5);
+  REQUIRE(g.get_attr(n, "width") == "1.5");
+  g.set_attr(e, "weight", 3);
+  REQUIRE(g.get_attr(e, "weight") == "3");
+  g.set_attr(g.c_struct(), "compound", true);
+  REQUIRE(g.get_attr(g.c_struct(), "compound") == "true");
+
+  REQUIRE(g.get_attr(n, "undeclared") == std::nullopt);
+}
+
+TEST_CASE("AGraph sets one attribute value on many objects") {
+  CGraph::AGraph g{"G", Agdirected};
+  const auto nodes = g.add_nodes(100);
+  const std::vector<std::size_t> tails{0, 1, 2};
+  const std::vector<std::size_t> heads{1, 2, 3};
+  const auto edges = g.add_edges(nodes, tails, heads);
+
+  const auto shape = g.declare_attr(AGNODE, "shape", "ellipse");
+  g.set_attr(nodes, shape, "box");
+  const auto style = g.declare_attr(AGEDGE, "style");
+  g.set_attr(edges, style, "dashed");
+
+  for (Agnode_t *n : g.nodes()) {
+    REQUIRE(g.get_attr(n, shape) == "box");
+  }
+  for (Agedge_t *e : g.edges()) {
+    REQUIRE(g.get_attr(e, style) == "dashed");
+  }
+  // the values are shared rather than copied
+  REQUIRE(agxget(nodes[0], shape) == agxget(nodes[99], shape));
+}
+
+TEST_CASE("a built AGraph matches the same graph parsed from DOT") {
+  CGraph::AGraph parsed{"digraph G { a -> b [color=red]; b -> c; }"};
+  CGraph::AGraph built{"G", Agdirected};
+  const auto e = built.add_edge("a", "b");
+  built.add_edge("b", "c");
+  built.set_attr(e, "color", "red");
+
+  REQUIRE(built.num_nodes() == parsed.num_nodes());
+  REQUIRE(built.num_edges() == parsed.num_edges());
+  for (Agedge_t *pe : parsed.edges()) {
+    const auto be =
+        built.find_edge(built.find_node(std::string{parsed.name(agtail(pe))}),
+                        built.find_node(std::string{parsed.name(aghead(pe))}));
+    REQUIRE(be != nullptr);
+    REQUIRE(built.get_attr(be, "color").value_or("") ==
+            parsed.get_attr(pe, "color").value_or(""));
+  }
+}
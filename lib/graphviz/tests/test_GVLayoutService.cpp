@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include <cgraph++/AGraph.h>
+#include <gvc++/GVContext.h>
+#include <gvc++/GVLayout.h>
+#include <gvc++/GVLayoutService.h>
+#include <gvc++/GVRenderData.h>
+
+namespace {
+
+/// a small graph that differs with `i`
+std::string example(std::size_t i) {
+  std::string dot = "digraph {";
+  for (std::size_t j = 0; j < 5 + i % 7; ++j) {
+    dot += "n" + std::to_string(j) + " -> n" + std::to_string((j * 3 + i) % 9) +
+           ";";
+  }
+  return dot + "}";
+}
+
+const std::vector<std::string> engines{"dot", "neato", "circo", "fdp"};
+
+} // namespace
+
+TEST_CASE("A layout service renders a submitted graph") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+  GVC::GVLayoutService service{gvc};
+
+  auto g = std::make_shared<CGraph::AGraph>("digraph {a -> b}");
+  auto result = service.submit(g, "dot", "svg").get();
+  REQUIRE(result.string_view().find("<!DOCTYPE svg") != std::string_view::npos);
+
+  SECTION("the layout is freed again, so the graph can be submitted again") {
+    const auto again = service.submit(g, "dot", "svg").get();
+    REQUIRE(again.string_view() == result.string_view());
+  }
+}
+
+TEST_CASE("A layout service reports failures through the future") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+  GVC::GVLayoutService service{gvc};
+
+  auto unknown_format = service.submit("digraph {a}", "dot", "UNKNOWN_FORMAT");
+  auto bad_source = service.submit("digraph {", "dot", "svg");
+  auto good = service.submit("digraph {a}", "dot", "svg");
+
+  REQUIRE_THROWS_AS(unknown_format.get(), std::runtime_error);
+  REQUIRE_THROWS_AS(bad_source.get(), std::runtime_error);
+  // earlier failures do not affect later jobs
+  REQUIRE(good.get().string_view().find("<!DOCTYPE svg") !=
+          std::string_view::npos);
+}
+
+TEST_CASE("A layout service gives the same results when used from many "
+          "threads") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  const std::size_t threads = 4;
+  const std::size_t graphs_per_thread = 12;
+
+  // lay out everything one at a time first
+  std::vector<std::string> expected;
+  for (std::size_t i = 0; i < threads * graphs_per_thread; ++i) {
+    auto g = std::make_shared<CGraph::AGraph>(example(i));
+    const GVC::GVLayout layout(gvc, g, engines[i % engines.size()]);
+    expected.emplace_back(layout.render("plain").string_view());
+  }
+
+  std::vector<std::string> actual(expected.size());
+  {
+    GVC::GVLayoutService service{gvc};
+    std::vector<std::thread> clients;
+    for (std::size_t t = 0; t < threads; ++t) {
+      clients.emplace_back([&, t] {
+        std::vector<std::future<GVC::GVRenderData>> results;
+        for (std::size_t j = 0; j < graphs_per_thread; ++j) {
+          const std::size_t i = t * graphs_per_thread + j;
+          results.push_back(
+              service.submit(example(i), engines[i % engines.size()], "plain"));
+        }
+        for (std::size_t j = 0; j < graphs_per_thread; ++j) {
+          actual[t * graphs_per_thread + j] = results[j].get().string_view();
+        }
+      });
+    }
+
+    // a graph parsed and laid out directly on this thread at the same time
+    auto direct = std::make_shared<CGraph::AGraph>("graph {a -- b -- c}");
+    const GVC::GVLayout layout(gvc, direct, "neato");
+    REQUIRE(layout.render("plain").length() > 0);
+
+    for (auto &client : clients) {
+      client.join();
+    }
+  }
+
+  REQUIRE(actual == expected);
+}
+
+TEST_CASE("A layout service closes graphs its callers have let go of while "
+          "other threads build and close graphs") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  std::vector<std::future<GVC::GVRenderData>> results;
+  {
+    GVC::GVLayoutService service{gvc};
+    for (std::size_t i = 0; i < 16; ++i) {
+      results.push_back(service.submit(
+          std::make_shared<CGraph::AGraph>(example(i)), "dot", "plain"));
+    }
+
+    // graphs parsed, built, laid out and closed on this thread while the
+    // service closes graphs
+    for (std::size_t i = 0; i < 8; ++i) {
+      auto parsed = std::make_shared<CGraph::AGraph>(example(i));
+      const GVC::GVLayout layout(gvc, parsed, "neato");
+      REQUIRE(layout.render("plain").length() > 0);
+
+      CGraph::AGraph built{"g", Agundirected};
+      built.add_edge("a", "b");
+      REQUIRE(built.num_edges() == 1);
+    }
+  }
+
+  for (auto &result : results) {
+    REQUIRE(result.get().length() > 0);
+  }
+}
+
+TEST_CASE("A layout service finishes outstanding jobs when destroyed") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  std::vector<std::future<GVC::GVRenderData>> results;
+  {
+    GVC::GVLayoutService service{gvc};
+    for (std::size_t i = 0; i < 8; ++i) {
+      results.push_back(service.submit(example(i), "dot", "svg"));
+    }
+  }
+
+  for (auto &result : results) {
+    REQUIRE(result.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready);
+    REQUIRE(result.get().length() > 0);
+  }
+}
@@ -8,7 +8,7 @@ from pathlib import Path
 import pytest
 
 sys.path.append(os.path.dirname(__file__))
-from gvtest import run_c  # pylint: disable=wrong-import-position
+from gvtest import ROOT, run_c  # pylint: disable=wrong-import-position
 
 
 @pytest.mark.parametrize("utility", ("list", "tokenize"))
@@ -48,6 +48,96 @@ def test_bitarray():
     _, _ = run_c(src, cflags=cflags)
 
 
+def test_gv_parallel():
+    """run gv_parallel’s unit tests"""
+
+    # locate the unit tests
+    src = Path(__file__).parent.resolve() / "../lib/util/test_gv_parallel.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror", "-pthread"]
+
+    _, _ = run_c(src, cflags=cflags)
+
+
+def test_gv_sssp():
+    """run gv_sssp’s unit tests"""
+
+    # locate the unit tests
+    src = Path(__file__).parent.resolve() / "../lib/util/test_gv_sssp.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror"]
+
+    _, _ = run_c(src, cflags=cflags)
+
+
+def test_sparse_matrix():
+    """run SparseMatrix’s unit tests"""
+
+    # locate the unit tests
+    src = Path(__file__).parent.resolve() / "../lib/sparse/test_SparseMatrix.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib]
+    for subdir in ("cdt", "cgraph", "common"):
+        cflags += ["-I", lib / subdir]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror", "-pthread", "-lm"]
+
+    _, _ = run_c(src, cflags=cflags)
+
+
+def test_blockpath():
+    """run circo’s block crossing count unit tests"""
+
+    # locate the unit tests
+    src = Path(__file__).parent.resolve() / "../lib/circogen/test_blockpath.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # the Graphviz headers want the config.h generated by the build, which is
+    # either at the root of an in-tree build, in build/ for CMake or in a
+    # directory the caller has put on the include path through $CFLAGS
+    includes = [ROOT, ROOT / "build"]
+    flags = os.environ.get("CFLAGS", "").split()
+    for i, flag in enumerate(flags):
+        if flag == "-I" and i + 1 < len(flags):
+            includes.append(Path(flags[i + 1]))
+        elif flag.startswith("-I"):
+            includes.append(Path(flag[2:]))
+    config = [d for d in includes if (d / "config.h").exists()]
+    if len(config) == 0:
+        pytest.skip("no generated config.h found")
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib, "-I", config[0]]
+    for subdir in ("cdt", "cgraph", "common", "gvc", "pathplan"):
+        cflags += ["-I", lib / subdir]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror", "-lm"]
+
+    _, _ = run_c(src, cflags=cflags, link=["cgraph"])
+
+
 @pytest.mark.parametrize("builtins", (False, True))
 def test_overflow_h(builtins: bool):
     """test ../lib/util/overflow.h"""
@@ -24,7 +24,7 @@ import textwrap
 import time
 import xml.etree.ElementTree as ET
 from pathlib import Path
-from typing import Iterator, List, Set
+from typing import Dict, Iterator, List, Set, Tuple
 
 import pexpect
 import pytest
@@ -5011,6 +5011,65 @@ def test_gvpr_s2f():
     assert result == "1.5\n", "incorrect GVPR float cast behavior"
 
 
+@pytest.mark.skipif(which("gvpr") is None, reason="gvpr not available")
+def test_gvpr_attribute_reuse():
+    """
+    GVPR attribute references should resolve correctly across graphs that are
+    repeatedly created and deleted
+    """
+
+    # a GVPR program that sets and reads the same attribute in a sequence of
+    # short lived graphs
+    program = (
+        "BEGIN { graph_t g; node_t n; int i;"
+        '  for (i = 0; i < 3; i++) {'
+        '    g = graph("g", "D");'
+        '    n = node(g, "a");'
+        '    n.color = sprintf("c%d", i);'
+        '    printf("%s\\n", n.color);'
+        "    delete(NULL, g);"
+        "  }"
+        "}"
+    )
+
+    # run this through GVPR with no input graph
+    gvpr_bin = which("gvpr")
+    result = subprocess.check_output(
+        [gvpr_bin, program], stdin=subprocess.DEVNULL, universal_newlines=True
+    )
+
+    # confirm each graph saw its own attribute
+    assert result == "c0\nc1\nc2\n", "incorrect GVPR attribute values"
+
+
+@pytest.mark.skipif(which("gvpr") is None, reason="gvpr not available")
+def test_gvpr_sprintf_reuse():
+    """
+    consecutive and nested GVPR `sprintf` calls should each give their own
+    result
+    """
+
+    # a longer result followed by shorter ones, and calls nested in the
+    # arguments of another
+    program = (
+        "BEGIN {"
+        '  printf("%s\\n", sprintf("%s-%d", "abcdef", 12345));'
+        '  printf("%s\\n", sprintf("%d", 7));'
+        '  printf("%s\\n", sprintf("<%s|%s>", sprintf("%d", 1),'
+        '                          sprintf("[%s]", sprintf("%d", 22))));'
+        '  printf("%s\\n", sprintf(""));'
+        "}"
+    )
+
+    # run this through GVPR with no input graph
+    gvpr_bin = which("gvpr")
+    result = subprocess.check_output(
+        [gvpr_bin, program], stdin=subprocess.DEVNULL, universal_newlines=True
+    )
+
+    assert result == "abcdef-12345\n7\n<1|[22]>\n\n", "incorrect sprintf results"
+
+
 def test_changelog():
     """
     sanity checks on ../CHANGELOG.md
@@ -5122,6 +5181,652 @@ def test_agxbuf_use_implicit_nul():
     run_c(c_src, cflags=cflags)
 
 
+def test_agmemread_trailing_input():
+    """
+    input after the end of a graph read by `agmemread` should not be seen by
+    a later `agmemread`
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agmemread-trailing-input.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # run the test
+    _, _ = run_c(c_src, link=["cgraph"])
+
+
+def test_cgraph_churn():
+    """
+    a large graph whose nodes and attribute values are repeatedly created and
+    deleted should be written the same as one built directly
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph-churn.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # run the test
+    _, _ = run_c(c_src, link=["cgraph"])
+
+
+def test_gvb_round_trip():
+    """
+    a graph written as a binary snapshot should read back the same as its DOT
+    equivalent
+    """
+
+    source = textwrap.dedent(
+        """\
+        digraph G {
+          graph [rankdir=LR];
+          node [shape=box];
+          a -> b [label=<x<b>y</b>>, color=red];
+          a -> c [key=k1];
+          a -> c [key=k2];
+          subgraph cluster_x { label=X; node [color=blue]; d; e -> f; }
+          { rank=same; a; b }
+          c:n -> d:s;
+        }
+        """
+    )
+
+    # lay the graph out once, as both DOT and as a snapshot
+    text = dot("dot", source=source)
+    snapshot = dot("gvb", source=source)
+    assert snapshot.startswith(b"\0GVB"), "unexpected snapshot header"
+
+    # both should describe the same graph
+    expected = subprocess.check_output(
+        ["dot", "-Tcanon"], input=text, universal_newlines=True
+    )
+    actual = subprocess.check_output(["dot", "-Tcanon"], input=snapshot)
+    assert actual.decode("utf-8") == expected, "snapshot did not round trip"
+
+    # concatenated snapshots should be read as separate graphs
+    both = subprocess.check_output(["dot", "-Tcanon"], input=snapshot + snapshot)
+    assert both.decode("utf-8") == expected + expected
+
+
+@pytest.mark.parametrize(
+    "payload",
+    (
+        # a header promising far more payload than follows
+        b"\0GVB\x01" + (1 << 62).to_bytes(8, "little") + b"\x00\x00",
+        # a root graph name beyond the end of an empty string table
+        b"\0GVB\x01" + (3).to_bytes(8, "little") + b"\x00\x00\x05",
+        # a root graph name that is not a complete integer
+        b"\0GVB\x01" + (3).to_bytes(8, "little") + b"\x00\x00\x80",
+    ),
+)
+def test_gvb_malformed(payload: bytes):
+    """
+    a malformed binary snapshot should be rejected without trusting its sizes
+    """
+    proc = subprocess.run(
+        ["dot", "-Tcanon"], input=payload, capture_output=True, check=False
+    )
+    assert proc.returncode != 0, "malformed snapshot was accepted"
+    assert b"malformed graph snapshot" in proc.stderr
+
+
+def test_gvb_truncated():
+    """
+    a binary snapshot cut short should be rejected
+    """
+    snapshot = dot("gvb", source="digraph { a -> b -> c; b -> d; }")
+    proc = subprocess.run(
+        ["dot", "-Tcanon"], input=snapshot[:-3], capture_output=True, check=False
+    )
+    assert proc.returncode != 0, "truncated snapshot was accepted"
+    assert b"malformed graph snapshot" in proc.stderr
+
+
+@pytest.mark.skipif(which("mingle") is None, reason="mingle not available")
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_mingle_threads():
+    """
+    mingle should give the same bundling whatever the number of threads, other
+    than force-directed bundling changing its update order when threaded
+    """
+
+    # a laid out graph to bundle
+    input = Path(__file__).parent / "../graphs/undirected/ngk10_4.gv"
+    assert input.exists(), "unexpectedly missing test case"
+    laid_out = subprocess.check_output(
+        ["neato", "-Tdot", input], universal_newlines=True
+    )
+
+    mingle = which("mingle")
+
+    def bundle(*args: str) -> str:
+        return subprocess.check_output(
+            [mingle, *args], input=laid_out, universal_newlines=True
+        )
+
+    # agglomerative bundling only uses threads to find nearest neighbors
+    assert bundle("-m", "1") == bundle("-m", "1", "-j", "4")
+
+    # threaded force-directed bundling should not depend on the thread count
+    assert bundle("-m", "0", "-j", "2") == bundle("-m", "0", "-j", "4")
+
+
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_pack_many_components():
+    """
+    packing many components should not place any two of them on top of each
+    other
+    """
+
+    # a graph of many small trees of varied shapes
+    lines = ["graph G {"]
+    for c in range(400):
+        size = 1 + c % 7
+        lines += [f"c{c}_0;"]
+        lines += [f"c{c}_{i} -- c{c}_{(c + i) % i};" for i in range(1, size)]
+    lines += ["}"]
+    source = "\n".join(lines)
+
+    plain = subprocess.check_output(
+        ["neato", "-Gpack=true", "-Tplain"], input=source, universal_newlines=True
+    )
+
+    # collect the bounding box of each node
+    boxes = []
+    for line in plain.splitlines():
+        fields = line.split()
+        if fields[0] != "node":
+            continue
+        component = fields[1].split("_")[0]
+        x, y, w, h = (float(f) for f in fields[2:6])
+        boxes += [(x - w / 2, x + w / 2, y - h / 2, y + h / 2, component)]
+    assert len(boxes) == sum(1 + c % 7 for c in range(400))
+
+    # nodes of different components should not overlap
+    boxes.sort()
+    for i, (l1, r1, b1, t1, c1) in enumerate(boxes):
+        for l2, r2, b2, t2, c2 in boxes[i + 1 :]:
+            if l2 >= r1:
+                break
+            if c1 != c2:
+                assert (
+                    b2 >= t1 or b1 >= t2
+                ), f"nodes of {c1} and {c2} overlap after packing"
+
+
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_pack_threads():
+    """
+    laying out the components of a graph on multiple threads before packing
+    them should give the same result as doing so on one
+    """
+
+    # many components, large enough for stress majorization to do real work
+    lines = ["graph G {"]
+    for c in range(200):
+        size = 2 + c % 23
+        lines += [f"c{c}_{i} -- c{c}_{(c + i // 2) % i};" for i in range(1, size)]
+        lines += [f"c{c}_{size - 1} -- c{c}_0;"]
+    lines += ["}"]
+    source = "\n".join(lines)
+
+    def layout(threads: str) -> str:
+        env = os.environ.copy()
+        env["GV_THREADS"] = threads
+        return subprocess.check_output(
+            ["neato", "-Gpack=true", "-Tplain"],
+            input=source,
+            env=env,
+            universal_newlines=True,
+        )
+
+    expected = layout("1")
+    for threads in ("2", "3", "8"):
+        assert layout(threads) == expected, f"GV_THREADS={threads} changed layout"
+
+
+def test_pack_layout_failure():
+    """
+    a component whose deferred layout fails should still be finished and packed
+    along with the others
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "pack-layout-failure.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # run the test with one thread and with several
+    for threads in ("1", "4"):
+        _, _ = run_c(c_src, args=[threads], link=["cgraph", "gvc"])
+
+
+@pytest.mark.skipif(which("tred") is None, reason="tred not available")
+def test_tred_dag():
+    """
+    tred should remove exactly the edges of a DAG implied by longer paths
+    """
+
+    source = textwrap.dedent(
+        """\
+        digraph G {
+          a -> b -> c -> d;
+          a -> c; a -> d; b -> d;
+          a -> e; e -> e; e -> d;
+          f -> g; f -> g;
+        }
+        """
+    )
+
+    tred = which("tred")
+    output = subprocess.check_output([tred], input=source, universal_newlines=True)
+
+    edges = sorted(re.findall(r"(\w+) -> (\w+)", output))
+    assert edges == [
+        ("a", "b"),
+        ("a", "e"),
+        ("b", "c"),
+        ("c", "d"),
+        ("e", "d"),
+        ("e", "e"),
+        ("f", "g"),
+    ], "incorrect transitive reduction"
+
+
+@pytest.mark.skipif(which("sccmap") is None, reason="sccmap not available")
+def test_sccmap_deep():
+    """
+    sccmap should handle components too deep for a recursive search
+    """
+
+    n = 200000
+    edges = "".join(f"n{i} -> n{(i + 1) % n};\n" for i in range(n))
+    source = f"digraph G {{\n{edges}}}\n"
+
+    sccmap = which("sccmap")
+    proc = subprocess.run(
+        [sccmap, "-o", os.devnull],
+        input=source,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    assert "1 strong components" in proc.stderr
+
+
+def test_dot_xalgo_bk():
+    """
+    Brandes-Köpf positioning should keep the order and separation of nodes that
+    network simplex positioning has
+    """
+
+    # a graph with nodes of varied widths, long edges, a self loop, and flat
+    # edges
+    lines = ["digraph G {", "nodesep=0.5;"]
+    for i in range(60):
+        lines += [f'n{i} [width={0.3 + (i % 5) * 0.4}];']
+        lines += [f"n{i // 2} -> n{i};", f"n{i // 7} -> n{i};"]
+    lines += ["n5 -> n5;", "{rank=same; n20 -> n21 -> n23;}", "}"]
+    source = "\n".join(lines)
+
+    def ranks(args: List[str]) -> Dict[float, List[Tuple[float, float, str]]]:
+        """map each rank to the position, width, and name of its nodes"""
+        plain = subprocess.check_output(
+            ["dot", "-Tplain"] + args, input=source, universal_newlines=True
+        )
+        by_y = {}
+        for line in plain.splitlines():
+            fields = line.split()
+            if fields[0] != "node":
+                continue
+            x, y, w = (float(f) for f in fields[2:5])
+            by_y.setdefault(y, []).append((x, w, fields[1]))
+        return by_y
+
+    ns = ranks([])
+    bk = ranks(["-Gxalgo=bk"])
+    assert ns.keys() == bk.keys(), "nodes were moved to different ranks"
+    for y, nodes in bk.items():
+        nodes.sort()
+        assert [n for _, _, n in nodes] == [
+            n for _, _, n in sorted(ns[y])
+        ], "order of nodes within a rank changed"
+        for (x1, w1, n1), (x2, w2, n2) in zip(nodes, nodes[1:]):
+            # allow for rounding to whole points
+            gap = (x2 - w2 / 2) - (x1 + w1 / 2)
+            assert gap >= 0.5 - 2 / 72, f"{n1} and {n2} are too close"
+
+
+def test_dot_xalgo_bk_clusters():
+    """
+    graphs with clusters should fall back to network simplex positioning
+    """
+
+    source = "digraph { subgraph cluster_a { a -> b; } b -> c; a -> c; }"
+    ns = subprocess.check_output(
+        ["dot", "-Tplain"], input=source, universal_newlines=True
+    )
+    proc = subprocess.run(
+        ["dot", "-Gxalgo=bk", "-Tplain"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    assert proc.stdout == ns, "cluster layout was not computed by network simplex"
+    assert "xalgo=bk does not support clusters" in proc.stderr
+
+
+def test_dot_warmstart():
+    """
+    laying out a graph again from its own output with `warmstart=true` should
+    not move anything, and an edit should not disturb the rest of the layout
+    """
+
+    def positions(plain: str) -> Dict[str, Tuple[float, float]]:
+        result: Dict[str, Tuple[float, float]] = {}
+        for line in plain.splitlines():
+            items = line.split()
+            if items[0] == "node":
+                result[items[1]] = (float(items[2]), float(items[3]))
+        return result
+
+    abstract = Path(__file__).parent / "graphs/abstract.gv"
+    first = dot("dot", abstract)
+    before = positions(
+        subprocess.check_output(["dot", "-Tplain", abstract], universal_newlines=True)
+    )
+
+    again = subprocess.check_output(
+        ["dot", "-Gwarmstart=true", "-Tplain"], input=first, universal_newlines=True
+    )
+    assert positions(again) == before, "warm start moved an unchanged graph"
+
+    edited = first.rstrip()[:-1] + "new -> 27; S8 -> new; }"
+    plain = subprocess.check_output(
+        ["dot", "-Gwarmstart=true", "-Tplain"], input=edited, universal_newlines=True
+    )
+    after = positions(plain)
+    for u, (ux, uy) in before.items():
+        for v, (vx, vy) in before.items():
+            if uy > vy:
+                assert after[u][1] > after[v][1], f"{u} is no longer above {v}"
+            elif uy == vy and ux < vx:
+                assert after[u][1] == after[v][1], f"{u} left the rank of {v}"
+                assert after[u][0] < after[v][0], f"{u} is no longer left of {v}"
+
+
+def test_dot_warmstart_clusters():
+    """
+    graphs with clusters should be laid out from scratch with `warmstart=true`
+    """
+
+    source = "digraph { subgraph cluster_a { a -> b; } b -> c; a -> c; }"
+    cold = subprocess.check_output(
+        ["dot", "-Tplain"], input=source, universal_newlines=True
+    )
+    proc = subprocess.run(
+        ["dot", "-Gwarmstart=true", "-Tplain"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    assert proc.stdout == cold, "cluster layout was changed by warmstart"
+    assert "warmstart does not support clusters" in proc.stderr
+
+
+def test_dot_warmstart_from_pos():
+    """
+    seeding a warm start from `pos` attributes should not touch the anchor nodes
+    it added after freeing them
+    """
+
+    # several nodes on the same rank, so more than one slack node has an edge
+    # into the shared origin node
+    source = (
+        "digraph {\n"
+        '  a [pos="27,90"]; b [pos="99,90"]; c [pos="171,90"];\n'
+        '  d [pos="27,18"]; e [pos="99,18"]; f [pos="171,18"];\n'
+        "  a -> d; a -> e; b -> e; c -> f;\n"
+        "}\n"
+    )
+    proc = subprocess.run(
+        ["dot", "-Gwarmstart=true", "-Tplain"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    assert proc.stderr == "", "warm start from pos produced warnings or errors"
+
+    # the layout of a larger graph, fed back in
+    abstract = Path(__file__).parent / "graphs/abstract.gv"
+    seeded = dot("dot", abstract)
+    proc = subprocess.run(
+        ["dot", "-Gwarmstart=true", "-Tplain"],
+        input=seeded,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    assert proc.stderr == "", "warm start from pos produced warnings or errors"
+
+
+@pytest.mark.skipif(which("sfdp") is None, reason="sfdp not available")
+def test_sfdp_start_self():
+    """
+    `start=self` in sfdp should refine the layout it is given, rather than
+    starting over
+    """
+
+    def layout(
+        source: str, *args: str
+    ) -> Tuple[Dict[str, Tuple[float, float]], List[Tuple[str, str]]]:
+        proc = subprocess.run(
+            ["sfdp", "-Goverlap=true", "-Tplain", *args],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        # without libgts, sfdp complains but still lays the graph out
+        no_gts_error = (
+            "remove_overlap: Graphviz not built with triangulation library"
+        )
+        if no_gts_error not in proc.stderr:
+            proc.check_returncode()
+        pos: Dict[str, Tuple[float, float]] = {}
+        edges: List[Tuple[str, str]] = []
+        for line in proc.stdout.splitlines():
+            fields = line.split()
+            if fields[0] == "node":
+                pos[fields[1]] = (float(fields[2]), float(fields[3]))
+            elif fields[0] == "edge":
+                edges.append((fields[1], fields[2]))
+        return pos, edges
+
+    def with_pos(source: str, pos: Dict[str, Tuple[float, float]]) -> str:
+        nodes = "".join(f'{n} [pos="{x},{y}"];\n' for n, (x, y) in pos.items())
+        return source.rstrip().rstrip("}") + nodes + "}\n"
+
+    heawood = Path(__file__).parent / "graphs/Heawood.gv"
+    source = heawood.read_text(encoding="utf-8")
+    prior, edges = layout(source)
+    edge_length = sum(math.dist(prior[u], prior[v]) for u, v in edges) / len(edges)
+
+    # laying out from scratch ignores the positions given
+    scratch, _ = layout(with_pos(source, prior))
+    assert scratch == prior, "sfdp used input positions without start=self"
+
+    # refining an unchanged layout leaves it about where it was, up to the
+    # translation of the drawing
+    refined, _ = layout(with_pos(source, prior), "-Gstart=self")
+    dx = sum(refined[n][0] - prior[n][0] for n in prior) / len(prior)
+    dy = sum(refined[n][1] - prior[n][1] for n in prior) / len(prior)
+    for n, (x, y) in prior.items():
+        moved = math.dist((x + dx, y + dy), refined[n])
+        assert moved < 0.5 * edge_length, f"node {n} was moved by refinement"
+
+    # a new node goes next to its neighbor
+    edited = with_pos(source, prior).rstrip().rstrip("}") + "0 -- new;\n}\n"
+    refined, _ = layout(edited, "-Gstart=self")
+    assert (
+        math.dist(refined["new"], refined["0"]) < 2 * edge_length
+    ), "new node was not placed beside its neighbor"
+
+
+def test_gvrender_after_failure():
+    """
+    a render that fails, for example for an unknown format, should not leave
+    its job behind to disturb later renders with the same context
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvrender-after-failure.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # run the test
+    _, _ = run_c(c_src, link=["cgraph", "gvc"])
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows", reason="plugins are found beside dot.exe"
+)
+def test_stale_plugin_config(tmp_path: Path):
+    """
+    a plugin configuration file older than one of the plugin libraries should
+    not be trusted
+    """
+
+    # find where the plugins are installed
+    verbose = subprocess.run(
+        ["dot", "-v", "-Tsvg", "-o", os.devnull],
+        input="digraph { a }",
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    ).stderr
+    m = re.search(r'^libdir = "(.*)"$', verbose, flags=re.MULTILINE)
+    assert m is not None, "dot -v did not report a libdir"
+
+    # make a copy of them we can modify, and point Graphviz at it
+    libdir = tmp_path / "plugins"
+    shutil.copytree(m.group(1), libdir, symlinks=True)
+    env = os.environ.copy()
+    env["GVBINDIR"] = str(libdir)
+    subprocess.check_call(["dot", "-c"], env=env)
+
+    def status() -> str:
+        return subprocess.run(
+            ["dot", "-v", "-Tsvg", "-o", os.devnull],
+            input="digraph { a -> b }",
+            stderr=subprocess.PIPE,
+            check=True,
+            env=env,
+            universal_newlines=True,
+        ).stderr
+
+    stderr = status()
+    assert "was successfully loaded" in stderr, "fresh config was not used"
+    assert re.search(r"^Plugins configured in \d+\.\d+ msec$", stderr, re.MULTILINE)
+
+    # make a plugin library look like it was updated after the configuration
+    # was written, by backdating the configuration
+    library = next(libdir.glob("libgvplugin_core.*")).resolve()
+    library_time = library.stat().st_mtime
+    os.utime(libdir / "config6", (library_time - 60, library_time - 60))
+
+    stderr = status()
+    assert "is older than a plugin library" in stderr, "stale config was used"
+
+    # reconfiguring should make it usable again
+    subprocess.check_call(["dot", "-c"], env=env)
+    stderr = status()
+    assert "was successfully loaded" in stderr, "refreshed config was not used"
+
+
+def test_lod_json():
+    """
+    `-Tlod_json` should aggregate a layout into a pyramid of ever finer grids
+    that accounts for every node and edge
+    """
+
+    # a grid graph, large enough to be split into several levels
+    side = 30
+    edges = []
+    for i in range(side):
+        for j in range(side):
+            if i + 1 < side:
+                edges.append(f"n{i}_{j} -> n{i + 1}_{j}")
+            if j + 1 < side:
+                edges.append(f"n{i}_{j} -> n{i}_{j + 1}")
+    source = "digraph { node[shape=point]; " + "; ".join(edges) + " }"
+
+    output = subprocess.check_output(
+        ["dot", "-Kneato", "-Tlod_json"], input=source, universal_newlines=True
+    )
+    data = json.loads(output)
+    assert data["directed"]
+
+    levels = data["levels"]
+    assert len(levels) > 1, "graph was not subdivided"
+    assert levels[0]["grid"] == 1
+    assert levels[0]["supernodes"][0]["nodes"] == side * side
+
+    for level in levels:
+        supernodes = level["supernodes"]
+        assert sum(s["nodes"] for s in supernodes) == side * side
+        for s in supernodes:
+            assert all(0 <= c < level["grid"] for c in s["cell"])
+        # edges within a supernode are not listed
+        for e in level["edges"]:
+            assert e["tail"] != e["head"]
+            assert 0 <= e["tail"] < len(supernodes)
+            assert 0 <= e["head"] < len(supernodes)
+    assert [l["grid"] for l in levels] == [2**i for i in range(len(levels))]
+
+    # the tiles of the finest level hold every node exactly once
+    tiles = data["tiles"]
+    assert len(tiles) == len(levels[-1]["supernodes"])
+    ids = sorted(n["_gvid"] for t in tiles for n in t["nodes"])
+    assert ids == list(range(side * side))
+
+    # every edge is in the tiles of its ends, and is counted by the finest level
+    # when these differ
+    tile_of = {n["_gvid"]: t["supernode"] for t in tiles for n in t["nodes"]}
+    crossing = 0
+    for t in tiles:
+        for e in t["edges"]:
+            assert t["supernode"] in (tile_of[e["tail"]], tile_of[e["head"]])
+            if tile_of[e["tail"]] != tile_of[e["head"]]:
+                crossing += 1
+    assert sum(len(t["edges"]) for t in tiles) == len(edges) + crossing // 2
+    assert sum(e["weight"] for e in levels[-1]["edges"]) == crossing // 2
+
+    # each tile is on a line of its own
+    lines = [
+        l
+        for l in output.splitlines()
+        if l.startswith('{"supernode"') and '"offset"' not in l
+    ]
+    assert len(lines) == len(tiles)
+    for line in lines:
+        json.loads(line.rstrip(","))
+
+    # the index locates each tile in the output
+    index = data["tile_index"]
+    assert len(index) == len(tiles)
+    raw = output.encode("utf-8")
+    for entry, tile in zip(index, tiles):
+        assert entry["supernode"] == tile["supernode"]
+        assert entry["cell"] == tile["cell"]
+        start = entry["offset"]
+        assert json.loads(raw[start : start + entry["length"]]) == tile
+
+
 @pytest.mark.skipif(which("edgepaint") is None, reason="edgepaint not available")
 def test_edgepaint_error_message():
     """